@@ -0,0 +1,105 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <cstddef>
+#include <limits>
+#include "Record.h"
+
+/**
+ * @brief Agregat jednej wielkości pomiarowej: suma, liczba próbek, minimum i maksimum.
+ *
+ * Agregaty są łączne (`merge`), więc agregat węzła drzewa można złożyć z agregatów
+ * jego dzieci, a wynik zapytania o przedział - z agregatów w pełni pokrytych węzłów.
+ */
+struct Aggregate {
+    /**
+     * @brief Suma wartości.
+     */
+    double sum = 0.0;
+
+    /**
+     * @brief Liczba zagregowanych wartości.
+     */
+    std::size_t count = 0;
+
+    /**
+     * @brief Najmniejsza wartość (+nieskończoność dla pustego agregatu).
+     */
+    double min = std::numeric_limits<double>::infinity();
+
+    /**
+     * @brief Największa wartość (-nieskończoność dla pustego agregatu).
+     */
+    double max = -std::numeric_limits<double>::infinity();
+
+    /**
+     * @brief Dodaje pojedynczą wartość do agregatu.
+     *
+     * @param value Wartość pomiaru.
+     */
+    void add(double value) {
+        sum += value;
+        ++count;
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+
+    /**
+     * @brief Łączy agregat z innym agregatem.
+     *
+     * @param other Agregat do dołączenia.
+     */
+    void merge(const Aggregate& other) {
+        sum += other.sum;
+        count += other.count;
+        if (other.min < min) min = other.min;
+        if (other.max > max) max = other.max;
+    }
+
+    /**
+     * @brief Zwraca średnią wartość (0 dla pustego agregatu).
+     */
+    double average() const { return count == 0 ? 0.0 : sum / static_cast<double>(count); }
+};
+
+/**
+ * @brief Zestaw agregatów dla wszystkich pięciu wielkości pomiarowych rekordu.
+ *
+ * Indeksy odpowiadają `Record::fieldIndex`: 0 - autokonsumpcja, 1 - eksport, 2 - import,
+ * 3 - pobór, 4 - produkcja.
+ */
+struct Aggregates {
+    /**
+     * @brief Agregaty kolejnych wielkości pomiarowych.
+     */
+    Aggregate fields[Record::fieldCount];
+
+    /**
+     * @brief Dodaje wartości rekordu do agregatów.
+     *
+     * @param record Rekord pomiarowy.
+     */
+    void add(const Record& record) {
+        fields[0].add(record.autokonsumpcja);
+        fields[1].add(record.eksport);
+        fields[2].add(record.import_);
+        fields[3].add(record.pobor);
+        fields[4].add(record.produkcja);
+    }
+
+    /**
+     * @brief Łączy zestaw agregatów z innym zestawem.
+     *
+     * @param other Zestaw do dołączenia.
+     */
+    void merge(const Aggregates& other) {
+        for (int i = 0; i < Record::fieldCount; ++i) fields[i].merge(other.fields[i]);
+    }
+
+    /**
+     * @brief Zwraca agregat wielkości o podanym indeksie.
+     */
+    const Aggregate& operator[](int field) const { return fields[field]; }
+};
+
+#endif // AGGREGATE_H
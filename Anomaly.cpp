@@ -0,0 +1,104 @@
+#include "Anomaly.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Sprawdza, czy wartość może trafić do kopca.
+ *
+ * Wartość równa najgorszej zachowanej też jest dopuszczana - rekord o wcześniejszym
+ * znaczniku czasu wygrywa remis (ostatecznie rozstrzyga `offer`).
+ *
+ * @param value Wartość wielkości.
+ * @return true, jeśli kopiec nie jest pełny lub wartość nie jest gorsza od najgorszej zachowanej.
+ */
+bool TopK::admits(double value) const {
+    if (k == 0 || std::isnan(value)) return false;
+    if (heap.size() < k) return true;
+    const double worst = heap.front().field(field);
+    return largest ? value >= worst : value <= worst;
+}
+
+/**
+ * @brief Sprawdza, czy rekord `a` jest lepszy od `b` (wartość, a przy remisie wcześniejszy czas).
+ */
+bool TopK::better(const Record& a, const Record& b) const {
+    const double x = a.field(field), y = b.field(field);
+    if (x != y) return largest ? x > y : x < y;
+    return a.timestamp < b.timestamp;
+}
+
+/**
+ * @brief Dodaje rekord do kopca, usuwając najgorszy, jeśli kopiec jest pełny.
+ *
+ * @param record Rekord.
+ */
+void TopK::offer(const Record& record) {
+    if (!admits(record.field(field))) return;
+    const auto worse = [this](const Record& a, const Record& b) { return better(a, b); };
+    if (heap.size() < k) {
+        heap.push_back(record);
+        std::push_heap(heap.begin(), heap.end(), worse);
+        return;
+    }
+    if (!better(record, heap.front())) return;
+    std::pop_heap(heap.begin(), heap.end(), worse);
+    heap.back() = record;
+    std::push_heap(heap.begin(), heap.end(), worse);
+}
+
+/**
+ * @brief Zwraca zachowane rekordy od najlepszego.
+ */
+std::vector<Record> TopK::sorted() const {
+    std::vector<Record> result = heap;
+    std::sort(result.begin(), result.end(), [this](const Record& a, const Record& b) { return better(a, b); });
+    return result;
+}
+
+/**
+ * @brief Tworzy puste okno.
+ *
+ * @param window Liczba wartości w oknie (co najmniej 2).
+ * @param sigmas Próg odchylenia w odchyleniach standardowych.
+ */
+RollingDeviation::RollingDeviation(std::size_t window, double sigmas)
+    : values(std::max<std::size_t>(window, 2)), sigmas(sigmas) {}
+
+/**
+ * @brief Porównuje wartość z oknem poprzednich wartości i dodaje ją do okna.
+ *
+ * @param value Nowa wartość.
+ * @param mean Średnia okna przed dodaniem wartości.
+ * @param sigma Odchylenie standardowe okna przed dodaniem wartości.
+ * @return true, jeśli wartość jest odchyleniem.
+ */
+bool RollingDeviation::push(double value, double& mean, double& sigma) {
+    const std::size_t window = values.size();
+    const std::size_t filled = std::min(pushed, window);
+    mean = filled == 0 ? 0.0 : sum / static_cast<double>(filled);
+    const double variance = filled == 0 ? 0.0 : squares / static_cast<double>(filled) - mean * mean;
+    sigma = variance > 0.0 ? std::sqrt(variance) : 0.0;
+    const bool deviates = filled == window && sigma > 0.0 && std::fabs(value - mean) > sigmas * sigma;
+
+    double& slot = values[pushed % window];
+    if (pushed >= window) {
+        sum -= slot;
+        squares -= slot * slot;
+    }
+    slot = value;
+    sum += value;
+    squares += value * value;
+    ++pushed;
+
+    // Okresowe przeliczenie sum od nowa (bez kumulacji błędów odejmowania)
+    if (pushed % window == 0) {
+        sum = 0.0;
+        squares = 0.0;
+        for (double v : values) {
+            sum += v;
+            squares += v * v;
+        }
+    }
+    return deviates;
+}
@@ -0,0 +1,174 @@
+#ifndef ANOMALY_H
+#define ANOMALY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Aggregate.h"
+#include "Record.h"
+
+/**
+ * @brief Statystyki przeglądu danych przez zapytania z przycinaniem (`TopK`, dni bez produkcji).
+ */
+struct ScanStats {
+    /**
+     * @brief Liczba przejrzanych rekordów.
+     */
+    std::size_t visited = 0;
+
+    /**
+     * @brief Liczba rekordów pominiętych dzięki minimum i maksimum węzłów (dni, bloków).
+     */
+    std::size_t skipped = 0;
+};
+
+/**
+ * @brief K rekordów o największych (lub najmniejszych) wartościach jednej wielkości - ograniczony kopiec.
+ *
+ * Kopiec trzyma najwyżej `k` rekordów; jego korzeń to najgorszy z zachowanych. Po zapełnieniu
+ * `admits` odrzuca całe węzły drzewa (lub dni i bloki snapshotu), których maksimum (minimum)
+ * nie przekracza najgorszej zachowanej wartości, więc większość danych nie jest przeglądana.
+ *
+ * Równe wartości są rozstrzygane na korzyść wcześniejszego znacznika czasu, dzięki czemu wynik
+ * nie zależy od kolejności przeglądania źródeł.
+ */
+class TopK {
+public:
+    /**
+     * @brief Tworzy pusty kopiec.
+     *
+     * @param k Liczba zachowywanych rekordów.
+     * @param field Indeks wielkości (patrz `Record::fieldIndex`).
+     * @param largest true - największe wartości, false - najmniejsze.
+     */
+    TopK(std::size_t k, int field, bool largest) : k(k), field(field), largest(largest) {}
+
+    /**
+     * @brief Zwraca indeks porządkowanej wielkości.
+     */
+    int fieldIndex() const { return field; }
+
+    /**
+     * @brief Sprawdza, czy wartość może trafić do kopca.
+     */
+    bool admits(double value) const;
+
+    /**
+     * @brief Sprawdza, czy węzeł o podanym agregacie może zawierać rekord trafiający do kopca.
+     */
+    bool admits(const Aggregate& stats) const { return stats.count > 0 && admits(largest ? stats.max : stats.min); }
+
+    /**
+     * @brief Zwraca najlepszą możliwą wartość rekordu węzła (klucz kolejności przeglądania węzłów).
+     */
+    double bound(const Aggregate& stats) const { return largest ? stats.max : -stats.min; }
+
+    /**
+     * @brief Dodaje rekord, jeśli jest lepszy od najgorszego zachowanego (lub kopiec nie jest pełny).
+     */
+    void offer(const Record& record);
+
+    /**
+     * @brief Zwraca zachowane rekordy od najlepszego (przy równych wartościach - chronologicznie).
+     */
+    std::vector<Record> sorted() const;
+
+private:
+    /**
+     * @brief Sprawdza, czy rekord `a` jest lepszy od `b`.
+     */
+    bool better(const Record& a, const Record& b) const;
+
+    /**
+     * @brief Liczba zachowywanych rekordów.
+     */
+    std::size_t k;
+
+    /**
+     * @brief Indeks wielkości.
+     */
+    int field;
+
+    /**
+     * @brief Kierunek: największe lub najmniejsze wartości.
+     */
+    bool largest;
+
+    /**
+     * @brief Kopiec z najgorszym rekordem w korzeniu.
+     */
+    std::vector<Record> heap;
+};
+
+/**
+ * @brief Średnia i odchylenie standardowe z przesuwnego okna ostatnich `window` wartości.
+ *
+ * Suma i suma kwadratów okna są aktualizowane przy każdej wartości (stały czas), a co `window`
+ * wartości liczone od nowa z bufora, aby błędy zaokrągleń się nie kumulowały.
+ */
+class RollingDeviation {
+public:
+    /**
+     * @brief Tworzy puste okno.
+     *
+     * @param window Liczba wartości w oknie (np. 96 - doba pomiarów 15-minutowych).
+     * @param sigmas Próg odchylenia w odchyleniach standardowych.
+     */
+    RollingDeviation(std::size_t window, double sigmas);
+
+    /**
+     * @brief Porównuje wartość z oknem poprzednich wartości, a następnie dodaje ją do okna.
+     *
+     * Wartość jest odchyleniem, jeśli okno jest pełne, jego odchylenie standardowe jest dodatnie
+     * i `|value - mean| > sigmas * sigma`.
+     *
+     * @param value Nowa wartość.
+     * @param mean Średnia okna przed dodaniem wartości.
+     * @param sigma Odchylenie standardowe okna przed dodaniem wartości.
+     * @return true, jeśli wartość jest odchyleniem.
+     */
+    bool push(double value, double& mean, double& sigma);
+
+private:
+    /**
+     * @brief Bufor pierścieniowy okna.
+     */
+    std::vector<double> values;
+
+    /**
+     * @brief Próg odchylenia.
+     */
+    double sigmas;
+
+    /**
+     * @brief Liczba wartości dodanych od początku.
+     */
+    std::size_t pushed = 0;
+
+    /**
+     * @brief Suma i suma kwadratów wartości w oknie.
+     */
+    double sum = 0.0, squares = 0.0;
+};
+
+/**
+ * @brief Rekord odbiegający od średniej przesuwnego okna (wynik `Program::findDeviations`).
+ */
+struct Deviation {
+    /**
+     * @brief Rekord.
+     */
+    Record record;
+
+    /**
+     * @brief Średnia okna poprzedzającego rekord.
+     */
+    double mean = 0.0;
+
+    /**
+     * @brief Odchylenie standardowe okna poprzedzającego rekord.
+     */
+    double sigma = 0.0;
+};
+
+#endif // ANOMALY_H
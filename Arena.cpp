@@ -0,0 +1,77 @@
+#include "Arena.h"
+#include "Metrics.h"
+
+/**
+ * @brief Tworzy pustą arenę.
+ *
+ * @param initialBlock Rozmiar pierwszego bloku w bajtach (kolejne bloki są coraz większe).
+ */
+Arena::Arena(std::size_t initialBlock) : buffer(initialBlock, &upstream) {}
+
+/**
+ * @brief Zwraca liczbę bajtów przydzielonych z areny.
+ */
+std::size_t Arena::allocatedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return allocated;
+}
+
+/**
+ * @brief Zwraca liczbę bajtów pobranych z systemu.
+ */
+std::size_t Arena::reservedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return upstream.bytes;
+}
+
+/**
+ * @brief Zwraca liczbę bloków pobranych z systemu.
+ */
+std::size_t Arena::blockCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return upstream.blocks;
+}
+
+/**
+ * @brief Przydziela pamięć z bieżącego bloku (lub z nowego bloku, jeśli bieżący się zapełnił).
+ *
+ * @param size Rozmiar w bajtach.
+ * @param alignment Wyrównanie.
+ * @return void* Przydzielona pamięć.
+ */
+void* Arena::do_allocate(std::size_t size, std::size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex);
+    allocated += size;
+    return buffer.allocate(size, alignment);
+}
+
+/**
+ * @brief Nic nie robi - pamięć areny jest zwalniana w całości w destruktorze.
+ */
+void Arena::do_deallocate(void*, std::size_t, std::size_t) {}
+
+/**
+ * @brief Pobiera blok z systemu.
+ *
+ * @param size Rozmiar bloku.
+ * @param alignment Wyrównanie.
+ * @return void* Blok pamięci.
+ */
+void* Arena::Upstream::do_allocate(std::size_t size, std::size_t alignment) {
+    ++blocks;
+    bytes += size;
+    Metrics::addMemory(MemoryPool::Tree, static_cast<std::int64_t>(size));
+    return std::pmr::new_delete_resource()->allocate(size, alignment);
+}
+
+/**
+ * @brief Oddaje blok do systemu.
+ *
+ * @param pointer Blok pamięci.
+ * @param size Rozmiar bloku.
+ * @param alignment Wyrównanie.
+ */
+void Arena::Upstream::do_deallocate(void* pointer, std::size_t size, std::size_t alignment) {
+    Metrics::addMemory(MemoryPool::Tree, -static_cast<std::int64_t>(size));
+    std::pmr::new_delete_resource()->deallocate(pointer, size, alignment);
+}
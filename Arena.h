@@ -0,0 +1,88 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+
+/**
+ * @brief Arena pamięci dla węzłów i kolumn drzewa (`Tree`).
+ *
+ * Pamięć jest pobierana z systemu dużymi, rosnącymi geometrycznie blokami
+ * (`std::pmr::monotonic_buffer_resource`), a pojedyncze alokacje są tylko przesunięciem wskaźnika
+ * w bieżącym bloku. Zwolnienie pojedynczej alokacji nic nie robi - cała pamięć jest oddawana
+ * naraz przy zniszczeniu areny, więc usunięcie drzewa z milionami rekordów to kilka wywołań `free`.
+ *
+ * Alokacje są chronione muteksem, dzięki czemu z jednej areny może korzystać kilka drzew
+ * wypełnianych równolegle (np. fragmenty pliku w `Program::loadCSV`) - takie drzewa można
+ * potem scalać bez kopiowania danych. Drzewo alokuje rzadko (kolumny ćwiartki są rezerwowane
+ * od razu na całą ćwiartkę), więc muteks nie jest wąskim gardłem.
+ */
+class Arena : public std::pmr::memory_resource {
+public:
+    /**
+     * @brief Tworzy pustą arenę (pierwszy blok jest pobierany przy pierwszej alokacji).
+     *
+     * @param initialBlock Rozmiar pierwszego bloku w bajtach.
+     */
+    explicit Arena(std::size_t initialBlock = 1 << 16);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    /**
+     * @brief Zwraca liczbę bajtów przydzielonych z areny.
+     */
+    std::size_t allocatedBytes() const;
+
+    /**
+     * @brief Zwraca liczbę bajtów pobranych z systemu (suma rozmiarów bloków).
+     */
+    std::size_t reservedBytes() const;
+
+    /**
+     * @brief Zwraca liczbę bloków pobranych z systemu.
+     */
+    std::size_t blockCount() const;
+
+private:
+    /**
+     * @brief Źródło bloków areny: `new`/`delete` ze zliczaniem bloków i bajtów.
+     */
+    class Upstream : public std::pmr::memory_resource {
+    public:
+        std::size_t blocks = 0;
+        std::size_t bytes = 0;
+
+    private:
+        void* do_allocate(std::size_t size, std::size_t alignment) override;
+        void do_deallocate(void* pointer, std::size_t size, std::size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    void* do_allocate(std::size_t size, std::size_t alignment) override;
+    void do_deallocate(void* pointer, std::size_t size, std::size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    /**
+     * @brief Muteks chroniący alokacje.
+     */
+    mutable std::mutex mutex;
+
+    /**
+     * @brief Źródło bloków (musi być zniszczone po `buffer`).
+     */
+    Upstream upstream;
+
+    /**
+     * @brief Bufor monotoniczny przydzielający pamięć z kolejnych bloków.
+     */
+    std::pmr::monotonic_buffer_resource buffer;
+
+    /**
+     * @brief Liczba bajtów przydzielonych z areny.
+     */
+    std::size_t allocated = 0;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,499 @@
+#include "BatchQuery.h"
+#include "Metrics.h"
+#include "Program.h"
+#include "ThreadPool.h"
+#include "Timestamp.h"
+
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <tuple>
+
+namespace {
+
+/**
+ * @brief Parsuje liczbę zmiennoprzecinkową zajmującą całe słowo.
+ */
+bool parseNumber(const std::string& text, double& value) {
+    const char* end = text.data() + text.size();
+    return !text.empty() && std::from_chars(text.data(), end, value).ptr == end;
+}
+
+/**
+ * @brief Parsuje przedział zapisany jako cztery słowa: data i godzina początku, data i godzina końca.
+ */
+bool parseRange(const std::vector<std::string>& words, std::size_t offset, std::int32_t& from, std::int32_t& to,
+                std::string& error) {
+    if (!Timestamp::parse(words[offset], words[offset + 1], from)) {
+        error = "Niepoprawna data lub godzina początkowa: " + words[offset] + " " + words[offset + 1];
+        return false;
+    }
+    if (!Timestamp::parse(words[offset + 2], words[offset + 3], to)) {
+        error = "Niepoprawna data lub godzina końcowa: " + words[offset + 2] + " " + words[offset + 3];
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parsuje jeden wiersz pliku zapytań (słowa rozdzielone białymi znakami).
+ */
+void parseQuery(const std::vector<std::string>& words, BatchQuery::Query& query) {
+    const std::string& command = words[0];
+    std::size_t expected = 0;
+    if (command == "sum") {
+        query.kind = BatchQuery::Kind::Sum;
+        expected = 6;
+    } else if (command == "avg") {
+        query.kind = BatchQuery::Kind::Average;
+        expected = 6;
+    } else if (command == "compare") {
+        query.kind = BatchQuery::Kind::Compare;
+        expected = 10;
+    } else if (command == "search") {
+        query.kind = BatchQuery::Kind::Search;
+        expected = 8;
+    } else {
+        query.error = "Nieznane zapytanie: " + command;
+        return;
+    }
+    if (words.size() != expected) {
+        query.error = "Niepoprawna liczba argumentów zapytania " + command;
+        return;
+    }
+
+    query.field = Record::fieldIndex(words[1]);
+    if (query.field < 0) {
+        query.error = "Nieznany typ danych: " + words[1];
+        return;
+    }
+
+    switch (query.kind) {
+        case BatchQuery::Kind::Sum:
+        case BatchQuery::Kind::Average:
+            parseRange(words, 2, query.from, query.to, query.error);
+            break;
+        case BatchQuery::Kind::Compare:
+            if (parseRange(words, 2, query.from, query.to, query.error)) {
+                parseRange(words, 6, query.from2, query.to2, query.error);
+            }
+            break;
+        case BatchQuery::Kind::Search:
+            if (!parseNumber(words[2], query.value) || !parseNumber(words[3], query.tolerance) || query.tolerance < 0) {
+                query.error = "Niepoprawna wartość lub tolerancja: " + words[2] + " " + words[3];
+                break;
+            }
+            parseRange(words, 4, query.from, query.to, query.error);
+            break;
+    }
+}
+
+/**
+ * @brief Zwraca nazwę rodzaju zapytania (słowo kluczowe pliku zapytań).
+ */
+const char* kindName(BatchQuery::Kind kind) {
+    switch (kind) {
+        case BatchQuery::Kind::Sum: return "sum";
+        case BatchQuery::Kind::Average: return "avg";
+        case BatchQuery::Kind::Compare: return "compare";
+        default: return "search";
+    }
+}
+
+/**
+ * @brief Zapisuje liczbę w najkrótszej postaci odtwarzającej dokładnie tę samą wartość.
+ *
+ * Wartości nieskończone (minimum i maksimum pustego przedziału) są zapisywane jako `empty`.
+ */
+void writeNumber(std::ostream& output, double value, const char* empty) {
+    if (!std::isfinite(value)) {
+        output << empty;
+        return;
+    }
+    char buffer[32];
+    const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    output.write(buffer, result.ptr - buffer);
+}
+
+/**
+ * @brief Zapisuje znacznik czasu jako "YYYY-MM-DD HH:MM".
+ */
+std::string formatTimestamp(std::int32_t timestamp) {
+    return Timestamp::formatDate(timestamp) + " " + Timestamp::formatTime(timestamp);
+}
+
+/**
+ * @brief Zapisuje pole CSV, ujmując je w cudzysłowy, jeśli zawiera przecinek, cudzysłów lub znak nowego wiersza.
+ */
+void writeCsvText(std::ostream& output, const std::string& text) {
+    if (text.find_first_of(",\"\n") == std::string::npos) {
+        output << text;
+        return;
+    }
+    output << '"';
+    for (char c : text) {
+        if (c == '"') output << '"';
+        output << c;
+    }
+    output << '"';
+}
+
+/**
+ * @brief Zapisuje napis JSON w cudzysłowach (ze znakami sterującymi zapisanymi jako sekwencje ucieczki).
+ */
+void writeJsonText(std::ostream& output, const std::string& text) {
+    output << '"';
+    for (char c : text) {
+        switch (c) {
+            case '"': output << "\\\""; break;
+            case '\\': output << "\\\\"; break;
+            case '\n': output << "\\n"; break;
+            case '\t': output << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    const char* digits = "0123456789abcdef";
+                    output << "\\u00" << digits[(c >> 4) & 0xf] << digits[c & 0xf];
+                } else {
+                    output << c;
+                }
+        }
+    }
+    output << '"';
+}
+
+/**
+ * @brief Zapisuje agregat jako pola obiektu JSON (bez nawiasów klamrowych).
+ */
+void writeJsonAggregate(std::ostream& output, const Aggregate& aggregate) {
+    output << "\"suma\": ";
+    writeNumber(output, aggregate.sum, "null");
+    output << ", \"liczba\": " << aggregate.count << ", \"srednia\": ";
+    writeNumber(output, aggregate.average(), "null");
+    output << ", \"min\": ";
+    writeNumber(output, aggregate.min, "null");
+    output << ", \"max\": ";
+    writeNumber(output, aggregate.max, "null");
+}
+
+/**
+ * @brief Wypisuje sposób użycia trybu wsadowego.
+ */
+int usage(const char* program) {
+    std::cerr << "Użycie: " << program
+              << " --batch <plik zapytań> (--csv <plik> | --binary <plik>)... [--format csv|json]"
+                 " [--output <plik>] [--threads <n>] [--metrics <plik .prom|.json>] [--snapshot-memory <MiB>]"
+              << std::endl;
+    return 2;
+}
+
+} // namespace
+
+/**
+ * @brief Parsuje plik zapytań (jedno zapytanie w wierszu).
+ *
+ * @param input Strumień z zapytaniami.
+ * @param queries Sparsowane zapytania.
+ * @return true, jeśli wszystkie zapytania są poprawne.
+ */
+bool BatchQuery::parse(std::istream& input, std::vector<Query>& queries) {
+    queries.clear();
+    bool valid = true;
+    std::string line;
+    std::vector<std::string> words;
+    for (int number = 1; std::getline(input, line); ++number) {
+        std::istringstream stream(line);
+        words.clear();
+        for (std::string word; stream >> word;) words.push_back(word);
+        if (words.empty() || words[0][0] == '#') continue;
+
+        Query query;
+        query.line = number;
+        parseQuery(words, query);
+        valid = valid && query.error.empty();
+        queries.push_back(std::move(query));
+    }
+    return valid;
+}
+
+/**
+ * @brief Wykonuje zapytania: unikalne przedziały agregujące, a następnie wyszukiwania, równolegle.
+ *
+ * Agregaty z drzewa są składane z zapamiętanych agregatów węzłów, więc przedziały nakładające
+ * się odczytują te same węzły miesięcy i dni bez ponownego przeglądania rekordów. Przedziały
+ * identyczne są liczone jeden raz, a cały wsad korzysta z jednej przypiętej wersji danych.
+ *
+ * @param program Program z wczytanymi danymi.
+ * @param queries Zapytania.
+ * @param results Wyniki w kolejności zapytań.
+ * @param threadCount Liczba wątków (0 - liczba dostępnych rdzeni).
+ * @return Stats Statystyki wykonania.
+ */
+BatchQuery::Stats BatchQuery::execute(const Program& program, const std::vector<Query>& queries,
+                                      std::vector<Result>& results, unsigned threadCount) {
+    ThreadPool pool(threadCount);
+    const auto start = std::chrono::steady_clock::now();
+
+    results.assign(queries.size(), Result());
+    // Indeksy unikalnych przedziałów dla pierwszego i drugiego zakresu każdego zapytania
+    std::vector<RangeQuery> ranges;
+    std::map<std::tuple<std::int32_t, std::int32_t, int>, std::size_t> unique;
+    std::vector<std::size_t> first(queries.size()), second(queries.size());
+    std::vector<std::size_t> searches;
+    const auto rangeFor = [&ranges, &unique](std::int32_t from, std::int32_t to, int field) {
+        const auto [it, inserted] = unique.emplace(std::make_tuple(from, to, field), ranges.size());
+        if (inserted) ranges.push_back(RangeQuery{ from, to, field });
+        return it->second;
+    };
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        const Query& query = queries[i];
+        if (!query.error.empty()) {
+            results[i].error = query.error;
+            continue;
+        }
+        if (query.kind == Kind::Search) {
+            searches.push_back(i);
+            continue;
+        }
+        first[i] = rangeFor(query.from, query.to, query.field);
+        if (query.kind == Kind::Compare) second[i] = rangeFor(query.from2, query.to2, query.field);
+    }
+
+    std::vector<Aggregate> aggregates;
+    program.aggregateRanges(ranges, aggregates, pool);
+    pool.parallelFor(searches.size(), [&program, &queries, &results, &searches](std::size_t i) {
+        const Query& query = queries[searches[i]];
+        // Zapytania są już rozdzielone między wątki puli, więc miesiące są przeszukiwane kolejno
+        results[searches[i]].matches =
+            program.findRecords(query.value, query.tolerance, query.from, query.to, query.field, false);
+    });
+
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        if (!queries[i].error.empty() || queries[i].kind == Kind::Search) continue;
+        results[i].first = aggregates[first[i]];
+        if (queries[i].kind == Kind::Compare) results[i].second = aggregates[second[i]];
+    }
+
+    Stats stats;
+    stats.queries = queries.size();
+    stats.uniqueRanges = ranges.size();
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return stats;
+}
+
+/**
+ * @brief Zapisuje wyniki jako CSV.
+ *
+ * Kolumny: numer wiersza zapytania, rodzaj, wielkość, przedział(y), suma, liczba, średnia,
+ * minimum i maksimum pierwszego przedziału, suma i liczba drugiego przedziału oraz różnica
+ * (drugi minus pierwszy) dla `compare`, liczba znalezionych rekordów dla `search` i opis błędu
+ * (wiersz błędnego zapytania zawiera tylko numer wiersza i opis błędu).
+ *
+ * @param output Strumień wyjściowy.
+ * @param queries Zapytania.
+ * @param results Wyniki w kolejności zapytań.
+ */
+void BatchQuery::writeCsv(std::ostream& output, const std::vector<Query>& queries, const std::vector<Result>& results) {
+    output << "linia,zapytanie,wielkosc,od,do,od2,do2,suma,liczba,srednia,min,max,suma2,liczba2,roznica,rekordy,blad\n";
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        const Query& query = queries[i];
+        const Result& result = results[i];
+        output << query.line << ',';
+        if (!result.error.empty()) {
+            output << ",,,,,,,,,,,,,,,";
+            writeCsvText(output, result.error);
+            output << '\n';
+            continue;
+        }
+        const bool compare = query.kind == Kind::Compare;
+        output << kindName(query.kind) << ',' << Record::fieldName(query.field) << ',' << formatTimestamp(query.from) << ',' << formatTimestamp(query.to)
+               << ',';
+        if (compare) output << formatTimestamp(query.from2) << ',' << formatTimestamp(query.to2);
+        else output << ',';
+        output << ',';
+
+        if (query.kind == Kind::Search) {
+            output << ",,,,,,,," << result.matches.size() << ",\n";
+            continue;
+        }
+        writeNumber(output, result.first.sum, "");
+        output << ',' << result.first.count << ',';
+        writeNumber(output, result.first.average(), "");
+        output << ',';
+        writeNumber(output, result.first.min, "");
+        output << ',';
+        writeNumber(output, result.first.max, "");
+        output << ',';
+        if (compare) {
+            writeNumber(output, result.second.sum, "");
+            output << ',' << result.second.count << ',';
+            writeNumber(output, result.second.sum - result.first.sum, "");
+        } else {
+            output << ",,";
+        }
+        output << ",,\n";
+    }
+}
+
+/**
+ * @brief Zapisuje wyniki jako tablicę JSON.
+ *
+ * @param output Strumień wyjściowy.
+ * @param queries Zapytania.
+ * @param results Wyniki w kolejności zapytań.
+ */
+void BatchQuery::writeJson(std::ostream& output, const std::vector<Query>& queries, const std::vector<Result>& results) {
+    output << "[";
+    for (std::size_t i = 0; i < queries.size(); ++i) {
+        const Query& query = queries[i];
+        const Result& result = results[i];
+        output << (i == 0 ? "\n" : ",\n") << "  {\"linia\": " << query.line;
+        if (!result.error.empty()) {
+            output << ", \"blad\": ";
+            writeJsonText(output, result.error);
+            output << "}";
+            continue;
+        }
+        output << ", \"zapytanie\": \"" << kindName(query.kind) << "\", \"wielkosc\": \"" << Record::fieldName(query.field) << "\", \"od\": \""
+               << formatTimestamp(query.from) << "\", \"do\": \"" << formatTimestamp(query.to) << "\"";
+
+        switch (query.kind) {
+            case Kind::Sum:
+            case Kind::Average:
+                output << ", ";
+                writeJsonAggregate(output, result.first);
+                break;
+            case Kind::Compare:
+                output << ", \"od2\": \"" << formatTimestamp(query.from2) << "\", \"do2\": \""
+                       << formatTimestamp(query.to2) << "\", \"zakres1\": {";
+                writeJsonAggregate(output, result.first);
+                output << "}, \"zakres2\": {";
+                writeJsonAggregate(output, result.second);
+                output << "}, \"roznica\": ";
+                writeNumber(output, result.second.sum - result.first.sum, "null");
+                break;
+            case Kind::Search:
+                output << ", \"wartosc\": ";
+                writeNumber(output, query.value, "null");
+                output << ", \"tolerancja\": ";
+                writeNumber(output, query.tolerance, "null");
+                output << ", \"rekordy\": [";
+                for (std::size_t m = 0; m < result.matches.size(); ++m) {
+                    const Record& record = result.matches[m];
+                    output << (m == 0 ? "" : ", ") << "{\"data\": ";
+                    writeJsonText(output, record.date());
+                    output << ", \"godzina\": ";
+                    writeJsonText(output, record.time());
+                    output << ", \"wartosc\": ";
+                    writeNumber(output, record.field(query.field), "null");
+                    output << "}";
+                }
+                output << "]";
+                break;
+        }
+        output << "}";
+    }
+    output << (queries.empty() ? "]\n" : "\n]\n");
+}
+
+/**
+ * @brief Tryb wsadowy wiersza poleceń: wczytuje dane, wykonuje plik zapytań i zapisuje wyniki.
+ *
+ * Komunikaty wczytywania danych są przekierowywane na standardowe wyjście błędów, więc
+ * na standardowym wyjściu pojawiają się tylko wyniki (np. do dalszego przetwarzania potokiem).
+ *
+ * @param argc Liczba argumentów.
+ * @param argv Argumenty.
+ * @return int Kod wyjścia procesu.
+ */
+int BatchQuery::commandLine(int argc, char* argv[]) {
+    std::string batchFile, format = "csv", outputFile, metricsFile;
+    std::vector<std::pair<bool, std::string>> inputs; // (plik binarny, nazwa)
+    unsigned threadCount = 0;
+    std::size_t snapshotMemory = Snapshot::defaultResidentLimit >> 20;
+    for (int i = 1; i < argc; ++i) {
+        const std::string option = argv[i];
+        if (i + 1 >= argc) return usage(argv[0]);
+        const std::string value = argv[++i];
+        if (option == "--batch") {
+            batchFile = value;
+        } else if (option == "--csv" || option == "--binary") {
+            inputs.emplace_back(option == "--binary", value);
+        } else if (option == "--format" && (value == "csv" || value == "json")) {
+            format = value;
+        } else if (option == "--output") {
+            outputFile = value;
+        } else if (option == "--metrics") {
+            metricsFile = value;
+        } else if (option == "--threads") {
+            const char* end = value.data() + value.size();
+            if (std::from_chars(value.data(), end, threadCount).ptr != end) return usage(argv[0]);
+        } else if (option == "--snapshot-memory") {
+            const char* end = value.data() + value.size();
+            if (std::from_chars(value.data(), end, snapshotMemory).ptr != end) return usage(argv[0]);
+        } else {
+            return usage(argv[0]);
+        }
+    }
+    if (batchFile.empty() || inputs.empty()) return usage(argv[0]);
+
+    std::ifstream batch(batchFile);
+    if (!batch) {
+        std::cerr << "Nie można otworzyć pliku zapytań: " << batchFile << std::endl;
+        return 1;
+    }
+    std::vector<Query> queries;
+    if (!parse(batch, queries)) {
+        for (const Query& query : queries) {
+            if (!query.error.empty()) std::cerr << batchFile << ":" << query.line << ": " << query.error << std::endl;
+        }
+    }
+
+    Program program;
+    program.setLogLevel(LogLevel::None);
+    program.setSnapshotMemoryLimit(snapshotMemory << 20);
+    // Raport metryk co sekundę w trakcie wczytywania i zapytań oraz raport końcowy przy wyjściu
+    // (przed zniszczeniem danych programu, więc zawiera ich zajętość pamięci)
+    std::unique_ptr<MetricsReporter> reporter;
+    if (!metricsFile.empty()) reporter = std::make_unique<MetricsReporter>(metricsFile);
+    std::streambuf* const console = std::cout.rdbuf(std::cerr.rdbuf());
+    for (const auto& [binary, fileName] : inputs) {
+        if (!std::ifstream(fileName)) {
+            std::cout.rdbuf(console);
+            std::cerr << "Nie można otworzyć pliku: " << fileName << std::endl;
+            return 1;
+        }
+        if (binary) program.loadFromBinary(fileName);
+        else program.loadCSV(fileName, threadCount);
+    }
+    std::cout.rdbuf(console);
+
+    std::vector<Result> results;
+    const Stats stats = execute(program, queries, results, threadCount);
+
+    std::ofstream file;
+    if (!outputFile.empty()) {
+        file.open(outputFile);
+        if (!file) {
+            std::cerr << "Nie można utworzyć pliku: " << outputFile << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& output = outputFile.empty() ? std::cout : file;
+    if (format == "json") writeJson(output, queries, results);
+    else writeCsv(output, queries, results);
+    output.flush();
+
+    std::cerr << "Zapytań: " << stats.queries << " (unikalnych przedziałów: " << stats.uniqueRanges
+              << "), czas: " << stats.seconds << " s, "
+              << (stats.seconds > 0 ? static_cast<double>(stats.queries) / stats.seconds : 0.0) << " zapytań/s"
+              << std::endl;
+
+    bool failed = !output;
+    for (const Result& result : results) failed = failed || !result.error.empty();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+#ifndef BATCHQUERY_H
+#define BATCHQUERY_H
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+#include "Aggregate.h"
+#include "Record.h"
+
+class Program;
+
+/**
+ * @brief Tryb wsadowy: wykonanie pliku zapytań analitycznych bez interakcji z użytkownikiem.
+ *
+ * Plik zapytań zawiera jedno zapytanie w wierszu (puste wiersze i wiersze zaczynające się od `#`
+ * są pomijane):
+ *
+ *     sum <typ> <data od> <godzina od> <data do> <godzina do>
+ *     avg <typ> <data od> <godzina od> <data do> <godzina do>
+ *     compare <typ> <przedział 1> <przedział 2>
+ *     search <typ> <wartość> <tolerancja> <data od> <godzina od> <data do> <godzina do>
+ *
+ * Wszystkie zapytania są parsowane przed wykonaniem; przedziały są zamieniane na znaczniki czasu
+ * jeden raz, a identyczne przedziały (ten sam zakres i wielkość - także oba zakresy `compare`)
+ * są liczone tylko raz. Unikalne przedziały są liczone równolegle w wątkach puli z jednej
+ * wersji danych (`Program::aggregateRanges`), wyszukiwania - równolegle po jednym na iterację.
+ *
+ * Wyniki są zapisywane jako CSV lub JSON w kolejności zapytań. Błędne zapytanie nie przerywa
+ * wsadu - jego wynik zawiera opis błędu.
+ */
+class BatchQuery {
+public:
+    /**
+     * @brief Rodzaj zapytania.
+     */
+    enum class Kind { Sum, Average, Compare, Search };
+
+    /**
+     * @brief Sparsowane zapytanie.
+     */
+    struct Query {
+        /**
+         * @brief Rodzaj zapytania.
+         */
+        Kind kind = Kind::Sum;
+
+        /**
+         * @brief Indeks wielkości (patrz `Record::fieldIndex`).
+         */
+        int field = 0;
+
+        /**
+         * @brief Początek przedziału (minuty od 2000-01-01, włącznie).
+         */
+        std::int32_t from = 0;
+
+        /**
+         * @brief Koniec przedziału (włącznie).
+         */
+        std::int32_t to = 0;
+
+        /**
+         * @brief Początek drugiego przedziału (tylko `compare`).
+         */
+        std::int32_t from2 = 0;
+
+        /**
+         * @brief Koniec drugiego przedziału (tylko `compare`).
+         */
+        std::int32_t to2 = 0;
+
+        /**
+         * @brief Szukana wartość (tylko `search`).
+         */
+        double value = 0.0;
+
+        /**
+         * @brief Tolerancja wyszukiwania (tylko `search`).
+         */
+        double tolerance = 0.0;
+
+        /**
+         * @brief Numer wiersza w pliku zapytań.
+         */
+        int line = 0;
+
+        /**
+         * @brief Opis błędu parsowania (pusty dla poprawnego zapytania).
+         */
+        std::string error;
+    };
+
+    /**
+     * @brief Wynik zapytania.
+     */
+    struct Result {
+        /**
+         * @brief Agregat przedziału (dla `compare` - pierwszego przedziału).
+         */
+        Aggregate first;
+
+        /**
+         * @brief Agregat drugiego przedziału (tylko `compare`).
+         */
+        Aggregate second;
+
+        /**
+         * @brief Znalezione rekordy (tylko `search`).
+         */
+        std::vector<Record> matches;
+
+        /**
+         * @brief Opis błędu (pusty, jeśli zapytanie zostało wykonane).
+         */
+        std::string error;
+    };
+
+    /**
+     * @brief Statystyki wykonania wsadu.
+     */
+    struct Stats {
+        /**
+         * @brief Liczba zapytań (razem z błędnymi).
+         */
+        std::size_t queries = 0;
+
+        /**
+         * @brief Liczba unikalnych przedziałów agregujących faktycznie policzonych.
+         */
+        std::size_t uniqueRanges = 0;
+
+        /**
+         * @brief Czas wykonania zapytań w sekundach (bez parsowania i zapisu wyników).
+         */
+        double seconds = 0.0;
+    };
+
+    /**
+     * @brief Parsuje plik zapytań.
+     *
+     * @param input Strumień z zapytaniami.
+     * @param queries Sparsowane zapytania (błędne wiersze mają ustawione `Query::error`).
+     * @return true, jeśli wszystkie zapytania są poprawne.
+     */
+    static bool parse(std::istream& input, std::vector<Query>& queries);
+
+    /**
+     * @brief Wykonuje zapytania na danych programu.
+     *
+     * @param program Program z wczytanymi danymi.
+     * @param queries Zapytania.
+     * @param results Wyniki w kolejności zapytań.
+     * @param threadCount Liczba wątków (0 - liczba dostępnych rdzeni).
+     * @return Stats Liczba zapytań, unikalnych przedziałów i czas wykonania.
+     */
+    static Stats execute(const Program& program, const std::vector<Query>& queries, std::vector<Result>& results,
+                         unsigned threadCount = 0);
+
+    /**
+     * @brief Zapisuje wyniki jako CSV (nagłówek i jeden wiersz na zapytanie).
+     *
+     * @param output Strumień wyjściowy.
+     * @param queries Zapytania.
+     * @param results Wyniki w kolejności zapytań.
+     */
+    static void writeCsv(std::ostream& output, const std::vector<Query>& queries, const std::vector<Result>& results);
+
+    /**
+     * @brief Zapisuje wyniki jako tablicę JSON (jeden obiekt na zapytanie, z listą znalezionych rekordów).
+     *
+     * @param output Strumień wyjściowy.
+     * @param queries Zapytania.
+     * @param results Wyniki w kolejności zapytań.
+     */
+    static void writeJson(std::ostream& output, const std::vector<Query>& queries, const std::vector<Result>& results);
+
+    /**
+     * @brief Uruchamia program w trybie wsadowym na podstawie argumentów wiersza poleceń.
+     *
+     * Argumenty: `--batch <plik zapytań>`, `--csv <plik>` lub `--binary <plik>` (można powtarzać),
+     * opcjonalnie `--format csv|json`, `--output <plik>` (domyślnie standardowe wyjście)
+     * i `--threads <n>`. Liczba zapytań i przepustowość są wypisywane na standardowe wyjście błędów.
+     * `--metrics <plik>` zapisuje co sekundę stan `Metrics` (JSON dla rozszerzenia `.json`,
+     * w przeciwnym razie format Prometheus). `--snapshot-memory <MiB>` ogranicza pamięć danych
+     * snapshotu wczytanego przez `--binary` (patrz `Program::setSnapshotMemoryLimit`).
+     *
+     * @param argc Liczba argumentów.
+     * @param argv Argumenty.
+     * @return int 0 - sukces, 1 - błąd danych lub zapytań, 2 - niepoprawne argumenty.
+     */
+    static int commandLine(int argc, char* argv[]);
+};
+
+#endif // BATCHQUERY_H
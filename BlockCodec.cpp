@@ -0,0 +1,512 @@
+#include "BlockCodec.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Tryb strumienia wartości: XOR z poprzednią wartością (Gorilla).
+ *
+ * Tryb dziesiętny z wykładnikiem `e` jest zapisywany jako `kDecimalMode + e`, a bit
+ * `kResidualFlag` oznacza, że zapisane są odchylenia od przewidywanych wartości.
+ */
+const unsigned kXorMode = 0;
+const unsigned kDecimalMode = 1;
+const unsigned kResidualFlag = 0x80;
+
+/**
+ * @brief Zapis strumienia bitów (od najstarszego bitu) na koniec bufora bajtów.
+ */
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<std::uint8_t>& out) : out(out) {}
+
+    /**
+     * @brief Zapisuje `bits` najmłodszych bitów wartości (0..64).
+     */
+    void write(std::uint64_t value, unsigned bits) {
+        if (bits > 32) {
+            write(value >> 32, bits - 32);
+            bits = 32;
+        }
+        if (bits == 0) return;
+        buffer = (buffer << bits) | (value & (~0ull >> (64 - bits)));
+        filled += bits;
+        while (filled >= 8) {
+            filled -= 8;
+            out.push_back(static_cast<std::uint8_t>(buffer >> filled));
+        }
+    }
+
+    /**
+     * @brief Dopisuje niepełny ostatni bajt (uzupełniony zerami).
+     */
+    void flush() {
+        if (filled > 0) out.push_back(static_cast<std::uint8_t>(buffer << (8 - filled)));
+        filled = 0;
+    }
+
+private:
+    std::vector<std::uint8_t>& out;
+    std::uint64_t buffer = 0;
+    unsigned filled = 0;
+};
+
+/**
+ * @brief Odczyt strumienia bitów z kontrolą końca danych.
+ *
+ * Bity są pobierane do 64-bitowego bufora po całych bajtach. Odczyt poza końcem strumienia
+ * zwraca zera i ustawia flagę `failed`.
+ */
+class BitReader {
+public:
+    BitReader(const std::uint8_t* data, std::size_t bytes) : next(data), end(data + bytes) {}
+
+    /**
+     * @brief Odczytuje `bits` bitów (0..64).
+     */
+    std::uint64_t read(unsigned bits) {
+        if (bits > 32) {
+            const std::uint64_t high = read(bits - 32);
+            return (high << 32) | read(32);
+        }
+        if (bits == 0) return 0;
+        if (available < bits) {
+            while (available <= 56 && next != end) {
+                buffer |= static_cast<std::uint64_t>(*next++) << (56 - available);
+                available += 8;
+            }
+            if (available < bits) {
+                failed = true;
+                buffer = 0;
+                available = 0;
+                return 0;
+            }
+        }
+        const std::uint64_t value = buffer >> (64 - bits);
+        buffer <<= bits;
+        available -= bits;
+        return value;
+    }
+
+    /**
+     * @brief Odczytuje jeden bit.
+     */
+    bool bit() { return read(1) != 0; }
+
+    /**
+     * @brief Informacja, czy nastąpiła próba odczytu poza końcem strumienia.
+     */
+    bool failed = false;
+
+private:
+    const std::uint8_t* next;
+    const std::uint8_t* end;
+    std::uint64_t buffer = 0;
+    unsigned available = 0;
+};
+
+/**
+ * @brief Liczba bitów potrzebna do zapisania wartości (0 dla zera).
+ */
+unsigned bitLength(std::uint64_t value) {
+    unsigned length = 0;
+    while (value != 0) {
+        value >>= 1;
+        ++length;
+    }
+    return length;
+}
+
+/**
+ * @brief Liczba zerowych bitów na najstarszych pozycjach (wartość niezerowa).
+ */
+unsigned leadingZeros(std::uint64_t value) {
+    return 64 - bitLength(value);
+}
+
+/**
+ * @brief Liczba zerowych bitów na najmłodszych pozycjach (wartość niezerowa).
+ */
+unsigned trailingZeros(std::uint64_t value) {
+    unsigned count = 0;
+    while ((value & 1u) == 0) {
+        value >>= 1;
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * @brief Kodowanie zigzag: liczby ze znakiem o małej wartości bezwzględnej na małe liczby bez znaku.
+ */
+std::uint64_t zigzag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+/**
+ * @brief Odwrotność `zigzag`.
+ */
+std::int64_t unzigzag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1u);
+}
+
+/**
+ * @brief Zapisuje liczbę dodatnią kodem Eliasa-gamma.
+ */
+void writeGamma(BitWriter& writer, std::uint64_t value) {
+    const unsigned length = bitLength(value);
+    writer.write(0, length - 1);
+    writer.write(value, length);
+}
+
+/**
+ * @brief Odczytuje liczbę zapisaną kodem Eliasa-gamma (0 dla uszkodzonego strumienia).
+ */
+std::uint64_t readGamma(BitReader& reader) {
+    unsigned zeros = 0;
+    while (!reader.bit()) {
+        if (reader.failed || ++zeros >= 64) {
+            reader.failed = true;
+            return 0;
+        }
+    }
+    return (1ull << zeros) | reader.read(zeros);
+}
+
+/**
+ * @brief Bity wartości zmiennoprzecinkowej.
+ */
+std::uint64_t toBits(double value) {
+    std::uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+/**
+ * @brief Wartość zmiennoprzecinkowa o podanych bitach.
+ */
+double fromBits(std::uint64_t bits) {
+    double value = 0.0;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Potęgi 10 używane w trybie dziesiętnym (dokładnie reprezentowalne).
+ */
+const double kPowersOf10[BlockCodec::maxDecimalExponent + 1] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6 };
+
+/**
+ * @brief Największa wartość bezwzględna przeskalowanej liczby w trybie dziesiętnym.
+ */
+const double kMaxScaled = 1125899906842624.0; // 2^50
+
+/**
+ * @brief Zaokrągla do najbliższej liczby całkowitej (połówki od zera), bez wywołania funkcji biblioteki.
+ *
+ * Koder i dekoder muszą używać tej samej funkcji - wartość jest odwracalna tylko wtedy,
+ * gdy sprawdzenie w `decimalExponent` przeszło z tym samym zaokrągleniem.
+ */
+inline std::int64_t roundToInteger(double value) {
+    return static_cast<std::int64_t>(value < 0.0 ? value - 0.5 : value + 0.5);
+}
+
+/**
+ * @brief Wyznacza najmniejszy wykładnik, przy którym wszystkie wartości są odwracalnie
+ * przeskalowywane do liczb całkowitych (-1, jeśli taki nie istnieje).
+ */
+int decimalExponent(const double* values, std::size_t count) {
+    for (int exponent = 0; exponent <= BlockCodec::maxDecimalExponent; ++exponent) {
+        const double scale = kPowersOf10[exponent];
+        bool exact = true;
+        for (std::size_t i = 0; i < count && exact; ++i) {
+            const double scaled = values[i] * scale;
+            exact = std::fabs(scaled) < kMaxScaled &&
+                    toBits(static_cast<double>(roundToInteger(scaled)) / scale) == toBits(values[i]);
+        }
+        if (exact) return exponent;
+    }
+    return -1;
+}
+
+/**
+ * @brief Sprawdza, czy przewidywane wartości można przeskalować do liczb całkowitych.
+ */
+bool scalable(const double* values, std::size_t count, double scale) {
+    for (std::size_t i = 0; i < count; ++i) {
+        if (!(std::fabs(values[i] * scale) < kMaxScaled)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Koduje wartości w trybie dziesiętnym.
+ *
+ * Kodowany jest ciąg liczb całkowitych `x[i] = round(values[i] * 10^e) - round(prediction[i] * 10^e)`
+ * (bez przewidywania - same przeskalowane wartości). Kody: `0` - ta sama liczba co poprzednia,
+ * `10` + 6 bitów (długość - 1) + różnica względem poprzedniej (zigzag), `11` + gamma - seria zer.
+ */
+void encodeDecimal(const double* values, const double* prediction, std::size_t count, int exponent,
+                   std::vector<std::uint8_t>& out) {
+    BitWriter writer(out);
+    writer.write((kDecimalMode + static_cast<unsigned>(exponent)) | (prediction != nullptr ? kResidualFlag : 0u), 8);
+    const double scale = kPowersOf10[exponent];
+    const auto residual = [&](std::size_t i) {
+        const std::int64_t scaled = roundToInteger(values[i] * scale);
+        return prediction == nullptr ? scaled : scaled - roundToInteger(prediction[i] * scale);
+    };
+    std::int64_t previous = 0;
+    for (std::size_t i = 0; i < count;) {
+        std::size_t run = 0;
+        while (i + run < count && residual(i + run) == 0) ++run;
+        if (run > 0) {
+            writer.write(0x3, 2);
+            writeGamma(writer, run);
+            previous = 0;
+            i += run;
+            continue;
+        }
+        const std::int64_t current = residual(i);
+        const std::uint64_t delta = zigzag(current - previous);
+        previous = current;
+        if (delta == 0) {
+            writer.write(0, 1);
+        } else {
+            const unsigned length = bitLength(delta);
+            writer.write(0x2, 2);
+            writer.write(length - 1, 6);
+            writer.write(delta, length);
+        }
+        ++i;
+    }
+    writer.flush();
+}
+
+/**
+ * @brief Zwraca długość serii zer (bitowo +0.0) zaczynającej się na pozycji `index`.
+ */
+std::size_t zeroRun(const double* values, std::size_t count, std::size_t index) {
+    std::size_t end = index;
+    while (end < count && toBits(values[end]) == 0) ++end;
+    return end - index;
+}
+
+} // namespace
+
+/**
+ * @brief Koduje znaczniki czasu metodą delta-of-delta.
+ *
+ * Pierwszy znacznik jest zapisywany w 32 bitach, a dla kolejnych zapisywana jest zmiana
+ * odstępu względem poprzedniego odstępu (kod zigzag) w jednym z przedziałów:
+ * `0` - bez zmiany, `10` + 7 bitów, `110` + 9 bitów, `1110` + 12 bitów, `1111` + 64 bity.
+ *
+ * @param timestamps Znaczniki czasu.
+ * @param count Liczba znaczników.
+ * @param out Bufor wyjściowy.
+ */
+void BlockCodec::encodeTimestamps(const std::int32_t* timestamps, std::size_t count, std::vector<std::uint8_t>& out) {
+    BitWriter writer(out);
+    if (count > 0) writer.write(static_cast<std::uint32_t>(timestamps[0]), 32);
+    std::int64_t previousDelta = 0;
+    for (std::size_t i = 1; i < count; ++i) {
+        const std::int64_t delta = static_cast<std::int64_t>(timestamps[i]) - timestamps[i - 1];
+        const std::uint64_t value = zigzag(delta - previousDelta);
+        previousDelta = delta;
+        if (value == 0) {
+            writer.write(0, 1);
+        } else if (value < (1u << 7)) {
+            writer.write(0x2, 2);
+            writer.write(value, 7);
+        } else if (value < (1u << 9)) {
+            writer.write(0x6, 3);
+            writer.write(value, 9);
+        } else if (value < (1u << 12)) {
+            writer.write(0xE, 4);
+            writer.write(value, 12);
+        } else {
+            writer.write(0xF, 4);
+            writer.write(value, 64);
+        }
+    }
+    writer.flush();
+}
+
+/**
+ * @brief Dekoduje znaczniki czasu zapisane przez `encodeTimestamps`.
+ *
+ * @param data Początek strumienia.
+ * @param bytes Rozmiar strumienia.
+ * @param count Liczba znaczników.
+ * @param timestamps Bufor wyjściowy.
+ * @return true, jeśli strumień był poprawny.
+ */
+bool BlockCodec::decodeTimestamps(const std::uint8_t* data, std::size_t bytes, std::size_t count, std::int32_t* timestamps) {
+    BitReader reader(data, bytes);
+    if (count == 0) return true;
+    std::int64_t current = static_cast<std::int32_t>(static_cast<std::uint32_t>(reader.read(32)));
+    timestamps[0] = static_cast<std::int32_t>(current);
+    std::int64_t delta = 0;
+    for (std::size_t i = 1; i < count; ++i) {
+        std::uint64_t value = 0;
+        if (reader.bit()) {
+            if (!reader.bit()) {
+                value = reader.read(7);
+            } else if (!reader.bit()) {
+                value = reader.read(9);
+            } else if (!reader.bit()) {
+                value = reader.read(12);
+            } else {
+                value = reader.read(64);
+            }
+        }
+        delta += unzigzag(value);
+        current += delta;
+        timestamps[i] = static_cast<std::int32_t>(current);
+    }
+    return !reader.failed;
+}
+
+/**
+ * @brief Koduje kolumnę wartości.
+ *
+ * Strumień zaczyna się od 8-bitowego trybu. Jeśli wartości mają skończone rozwinięcie dziesiętne,
+ * używany jest tryb dziesiętny (`encodeDecimal`) - z przewidywaniem lub bez, zależnie od tego,
+ * który wariant daje krótszy strumień. W przeciwnym razie używany jest tryb XOR z kodami:
+ * `0` - ta sama wartość co poprzednia, `10` - XOR mieszczący się w poprzednim oknie znaczących bitów,
+ * `110` + 5 bitów (wiodące zera) + 6 bitów (długość okna - 1) - XOR z nowym oknem, `111` + gamma - seria zer.
+ *
+ * @param values Wartości.
+ * @param count Liczba wartości.
+ * @param prediction Przewidywane wartości (lub nullptr).
+ * @param out Bufor wyjściowy.
+ */
+void BlockCodec::encodeValues(const double* values, std::size_t count, const double* prediction,
+                              std::vector<std::uint8_t>& out) {
+    const int exponent = decimalExponent(values, count);
+    if (exponent >= 0) {
+        const std::size_t start = out.size();
+        encodeDecimal(values, nullptr, count, exponent, out);
+        if (prediction != nullptr && scalable(prediction, count, kPowersOf10[exponent])) {
+            std::vector<std::uint8_t> residuals;
+            encodeDecimal(values, prediction, count, exponent, residuals);
+            if (residuals.size() < out.size() - start) {
+                out.resize(start);
+                out.insert(out.end(), residuals.begin(), residuals.end());
+            }
+        }
+        return;
+    }
+
+    BitWriter writer(out);
+    writer.write(kXorMode, 8);
+    std::uint64_t previous = 0;
+    unsigned windowLeading = 64, windowTrailing = 0;
+    for (std::size_t i = 0; i < count;) {
+        if (const std::size_t run = zeroRun(values, count, i)) {
+            writer.write(0x7, 3);
+            writeGamma(writer, run);
+            previous = 0;
+            i += run;
+            continue;
+        }
+        const std::uint64_t bits = toBits(values[i]);
+        const std::uint64_t difference = bits ^ previous;
+        previous = bits;
+        ++i;
+        if (difference == 0) {
+            writer.write(0, 1);
+            continue;
+        }
+        unsigned leading = leadingZeros(difference);
+        if (leading > 31) leading = 31;
+        const unsigned trailing = trailingZeros(difference);
+        if (windowLeading != 64 && leading >= windowLeading && trailing >= windowTrailing) {
+            writer.write(0x2, 2);
+            writer.write(difference >> windowTrailing, 64 - windowLeading - windowTrailing);
+        } else {
+            const unsigned length = 64 - leading - trailing;
+            writer.write(0x6, 3);
+            writer.write(leading, 5);
+            writer.write(length - 1, 6);
+            writer.write(difference >> trailing, length);
+            windowLeading = leading;
+            windowTrailing = trailing;
+        }
+    }
+    writer.flush();
+}
+
+/**
+ * @brief Dekoduje kolumnę wartości zapisaną przez `encodeValues`.
+ *
+ * @param data Początek strumienia.
+ * @param bytes Rozmiar strumienia.
+ * @param count Liczba wartości (może być mniejsza niż przy kodowaniu - dekodowany jest początek strumienia).
+ * @param prediction Przewidywane wartości podane przy kodowaniu (lub nullptr).
+ * @param values Bufor wyjściowy.
+ * @return true, jeśli strumień był poprawny.
+ */
+bool BlockCodec::decodeValues(const std::uint8_t* data, std::size_t bytes, std::size_t count,
+                              const double* prediction, double* values) {
+    BitReader reader(data, bytes);
+    unsigned mode = static_cast<unsigned>(reader.read(8));
+    const bool residual = (mode & kResidualFlag) != 0;
+    mode &= ~kResidualFlag;
+    if (residual && (prediction == nullptr || mode < kDecimalMode)) return false;
+
+    std::size_t i = 0;
+    if (mode >= kDecimalMode) {
+        const unsigned exponent = mode - kDecimalMode;
+        if (exponent > static_cast<unsigned>(maxDecimalExponent)) return false;
+        const double scale = kPowersOf10[exponent];
+        const auto store = [&](std::int64_t current) {
+            if (residual) current += roundToInteger(prediction[i] * scale);
+            values[i++] = static_cast<double>(current) / scale;
+        };
+        std::int64_t previous = 0;
+        while (i < count && !reader.failed) {
+            if (reader.bit()) {
+                if (reader.bit()) {
+                    const std::uint64_t run = readGamma(reader);
+                    if (run == 0) return false;
+                    // Seria może sięgać za `count`, jeśli dekodowany jest tylko początek strumienia
+                    const std::uint64_t stored = run < count - i ? run : count - i;
+                    for (std::uint64_t k = 0; k < stored; ++k) store(0);
+                    previous = 0;
+                    continue;
+                }
+                const unsigned length = static_cast<unsigned>(reader.read(6)) + 1;
+                previous += unzigzag(reader.read(length));
+            }
+            store(previous);
+        }
+        return i == count && !reader.failed;
+    }
+
+    std::uint64_t previous = 0;
+    unsigned windowLeading = 0, windowTrailing = 0;
+    while (i < count && !reader.failed) {
+        if (reader.bit()) {
+            if (!reader.bit()) {
+                previous ^= reader.read(64 - windowLeading - windowTrailing) << windowTrailing;
+            } else if (!reader.bit()) {
+                windowLeading = static_cast<unsigned>(reader.read(5));
+                const unsigned length = static_cast<unsigned>(reader.read(6)) + 1;
+                if (windowLeading + length > 64) return false;
+                windowTrailing = 64 - windowLeading - length;
+                previous ^= reader.read(length) << windowTrailing;
+            } else {
+                const std::uint64_t run = readGamma(reader);
+                if (run == 0) return false;
+                const std::uint64_t stored = run < count - i ? run : count - i;
+                for (std::uint64_t k = 0; k < stored; ++k) values[i++] = 0.0;
+                previous = 0;
+                continue;
+            }
+        }
+        values[i++] = fromBits(previous);
+    }
+    return i == count && !reader.failed;
+}
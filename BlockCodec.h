@@ -0,0 +1,81 @@
+#ifndef BLOCKCODEC_H
+#define BLOCKCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Kodowanie bloków szeregów czasowych do skompresowanego snapshotu.
+ *
+ * Każda kolumna bloku jest kodowana jako osobny strumień bitów, który można zdekodować
+ * niezależnie od pozostałych (zapytanie o jedną wielkość dekoduje tylko jej kolumnę).
+ *
+ * - Znaczniki czasu: kodowanie delta-of-delta (jak w Gorilli) - dla równych odstępów
+ *   15-minutowych każdy kolejny znacznik zajmuje 1 bit.
+ * - Wartości: serie zer (noc, brak eksportu) są kodowane długością serii (kod Eliasa-gamma).
+ *   Pozostałe wartości są kodowane jednym z dwóch trybów, wybieranym dla każdego strumienia:
+ *   - tryb dziesiętny: jeśli wszystkie wartości mają co najwyżej `maxDecimalExponent` cyfr
+ *     po przecinku (jak w eksporcie CSV), zapisywane są różnice kolejnych wartości
+ *     przeskalowanych do liczb całkowitych; opcjonalnie wartości są najpierw pomniejszane
+ *     o przewidywanie wyliczone z innych kolumn (np. pobór = autokonsumpcja + import),
+ *     co dla bilansujących się wielkości daje prawie same serie zer,
+ *   - tryb XOR (Gorilla): XOR z poprzednią wartością z zapisem tylko znaczących bitów.
+ *
+ * Dekodowanie odtwarza wartości bit w bit (również w trybie dziesiętnym - tryb jest wybierany
+ * tylko wtedy, gdy konwersja jest odwracalna dla każdej wartości strumienia).
+ */
+class BlockCodec {
+public:
+    /**
+     * @brief Największa obsługiwana liczba cyfr po przecinku w trybie dziesiętnym.
+     */
+    static constexpr int maxDecimalExponent = 6;
+
+    /**
+     * @brief Koduje niemalejący ciąg znaczników czasu.
+     *
+     * @param timestamps Znaczniki czasu.
+     * @param count Liczba znaczników.
+     * @param out Bufor, na którego końcu zostanie dopisany strumień.
+     */
+    static void encodeTimestamps(const std::int32_t* timestamps, std::size_t count, std::vector<std::uint8_t>& out);
+
+    /**
+     * @brief Dekoduje strumień znaczników czasu.
+     *
+     * @param data Początek strumienia.
+     * @param bytes Rozmiar strumienia w bajtach.
+     * @param count Liczba znaczników do odczytania.
+     * @param timestamps Bufor wyjściowy na `count` znaczników.
+     * @return true, jeśli strumień był poprawny (nie skończył się przedwcześnie).
+     */
+    static bool decodeTimestamps(const std::uint8_t* data, std::size_t bytes, std::size_t count, std::int32_t* timestamps);
+
+    /**
+     * @brief Koduje kolumnę wartości.
+     *
+     * @param values Wartości.
+     * @param count Liczba wartości.
+     * @param prediction Przewidywane wartości (lub nullptr); używane tylko, jeśli skracają strumień.
+     * @param out Bufor, na którego końcu zostanie dopisany strumień.
+     */
+    static void encodeValues(const double* values, std::size_t count, const double* prediction,
+                             std::vector<std::uint8_t>& out);
+
+    /**
+     * @brief Dekoduje strumień wartości.
+     *
+     * @param data Początek strumienia.
+     * @param bytes Rozmiar strumienia w bajtach.
+     * @param count Liczba wartości do odczytania.
+     * @param prediction Te same przewidywane wartości co przy kodowaniu (lub nullptr).
+     * @param values Bufor wyjściowy na `count` wartości.
+     * @return true, jeśli strumień był poprawny (i, jeśli był zapisany względem przewidywania,
+     *         przewidywanie zostało podane).
+     */
+    static bool decodeValues(const std::uint8_t* data, std::size_t bytes, std::size_t count,
+                             const double* prediction, double* values);
+};
+
+#endif // BLOCKCODEC_H
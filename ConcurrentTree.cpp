@@ -0,0 +1,557 @@
+#include "ConcurrentTree.h"
+#include "Anomaly.h"
+
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Liczba stałych miejsc czytelników (jednocześnie czytających wątków bez blokad).
+ */
+const std::size_t kReaderSlots = 256;
+
+/**
+ * @brief Wartość epoki miejsca, którego wątek nie ma przypiętej wersji.
+ */
+const std::uint64_t kIdle = std::numeric_limits<std::uint64_t>::max();
+
+/**
+ * @brief Miejsce czytelnika: epoka przypiętej wersji (lub `kIdle`) i znacznik zajętości.
+ *
+ * Każde miejsce zajmuje osobną linię pamięci podręcznej, więc przypinanie wersji przez
+ * różne wątki nie powoduje wzajemnego unieważniania linii.
+ */
+struct alignas(64) ReaderSlot {
+    std::atomic<std::uint64_t> epoch{ kIdle };
+    std::atomic<bool> used{ false };
+};
+
+/**
+ * @brief Miejsca czytelników (wspólne dla wszystkich drzew).
+ */
+ReaderSlot readerSlots[kReaderSlots];
+
+/**
+ * @brief Dodatkowe miejsca wątków, dla których zabrakło stałych miejsc, i ich synchronizacja.
+ *
+ * Muteks jest zajmowany tylko przy przydzieleniu i zwolnieniu takiego miejsca (raz na wątek)
+ * oraz przez piszącego przy wyznaczaniu najstarszej epoki - przypinanie wersji go nie używa.
+ */
+std::mutex overflowMutex;
+std::vector<ReaderSlot*> overflowSlots;
+
+/**
+ * @brief Globalna epoka, zwiększana przy każdym wycofaniu wersji.
+ */
+std::atomic<std::uint64_t> globalEpoch{ 1 };
+
+/**
+ * @brief Miejsce czytelnika przydzielone wątkowi i głębokość zagnieżdżenia widoków.
+ *
+ * Miejsce jest przydzielane przy pierwszym widoku w wątku i zwalniane po zakończeniu wątku.
+ */
+struct ThreadSlot {
+    ReaderSlot* slot = nullptr;
+    bool overflow = false;
+    int depth = 0;
+
+    ~ThreadSlot() {
+        if (slot == nullptr) return;
+        if (!overflow) {
+            slot->used.store(false, std::memory_order_release);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(overflowMutex);
+            overflowSlots.erase(std::find(overflowSlots.begin(), overflowSlots.end(), slot));
+        }
+        delete slot;
+    }
+};
+
+thread_local ThreadSlot threadSlot;
+
+/**
+ * @brief Przydziela wolne stałe miejsce czytelnika, a gdy wszystkie są zajęte - miejsce dodatkowe.
+ *
+ * @param overflow Ustawiane na true, jeśli przydzielono miejsce dodatkowe.
+ */
+ReaderSlot* acquireSlot(bool& overflow) {
+    for (ReaderSlot& slot : readerSlots) {
+        bool expected = false;
+        if (!slot.used.load(std::memory_order_relaxed) &&
+            slot.used.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            overflow = false;
+            return &slot;
+        }
+    }
+    ReaderSlot* slot = new ReaderSlot();
+    slot->used.store(true, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    overflowSlots.push_back(slot);
+    overflow = true;
+    return slot;
+}
+
+/**
+ * @brief Zwraca najmniejszą epokę przypiętą przez czytelników (`kIdle`, jeśli nikt nie czyta).
+ */
+std::uint64_t oldestPinnedEpoch() {
+    std::uint64_t oldest = kIdle;
+    for (const ReaderSlot& slot : readerSlots) {
+        const std::uint64_t epoch = slot.epoch.load();
+        if (epoch < oldest) oldest = epoch;
+    }
+    std::lock_guard<std::mutex> lock(overflowMutex);
+    for (const ReaderSlot* slot : overflowSlots) {
+        const std::uint64_t epoch = slot->epoch.load();
+        if (epoch < oldest) oldest = epoch;
+    }
+    return oldest;
+}
+
+/**
+ * @brief Buduje indeks sum prefiksowych jednomiesięcznego drzewa.
+ */
+std::shared_ptr<const PrefixSumIndex> indexMonth(const Tree& month) {
+    std::shared_ptr<PrefixSumIndex> index = std::make_shared<PrefixSumIndex>();
+    index->build(month);
+    return index;
+}
+
+/**
+ * @brief Klucz miesiąca znacznika czasu (`rok * 12 + miesiąc - 1`).
+ */
+int monthKey(std::int32_t timestamp) {
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    Timestamp::toDateTime(timestamp, year, month, day, hour, minute);
+    return year * 12 + month - 1;
+}
+
+} // namespace
+
+/**
+ * @brief Przypina bieżącą wersję drzewa.
+ *
+ * Epoka jest zapisywana w miejscu wątku przed odczytem wskaźnika wersji; piszący, który
+ * wycofa tę wersję później, zobaczy epokę i nie zwolni wersji przed odpięciem widoku.
+ * Zagnieżdżone widoki w tym samym wątku korzystają z epoki najstarszego widoku.
+ *
+ * @param tree Drzewo, którego wersja zostanie przypięta.
+ */
+ConcurrentTree::View::View(const ConcurrentTree& tree) : tree(&tree) {
+    ThreadSlot& local = threadSlot;
+    if (local.depth++ == 0) {
+        if (local.slot == nullptr) local.slot = acquireSlot(local.overflow);
+        local.slot->epoch.store(globalEpoch.load());
+    }
+    version = tree.current.load();
+}
+
+/**
+ * @brief Odpina wersję (po zniszczeniu ostatniego widoku wątku) i próbuje zwolnić wycofane wersje drzewa.
+ *
+ * Bez tego wersja wycofana w czasie życia widoku czekałaby na następny zapis - po ostatnim
+ * dopisaniu danych pozostałaby w pamięci na stałe.
+ */
+ConcurrentTree::View::~View() {
+    ThreadSlot& local = threadSlot;
+    if (--local.depth != 0) return;
+    local.slot->epoch.store(kIdle, std::memory_order_release);
+    if (tree->pendingRetired.load(std::memory_order_acquire)) tree->reclaim(false);
+}
+
+/**
+ * @brief Oblicza agregat wielkości w przedziale, łącząc wyniki miesięcy z przedziału.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @return Aggregate Suma, liczba, minimum i maksimum.
+ */
+Aggregate ConcurrentTree::View::aggregate(std::int32_t from, std::int32_t to, int field) const {
+    Aggregate result;
+    if (to < from) return result;
+    const int last = monthKey(to);
+    for (auto it = version->months.lower_bound(monthKey(from)); it != version->months.end() && it->first <= last; ++it) {
+        result.merge(it->second->aggregate(from, to, field));
+    }
+    return result;
+}
+
+/**
+ * @brief Oblicza agregaty wszystkich wielkości w przedziale, łącząc wyniki miesięcy z przedziału.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @return Aggregates Agregaty wszystkich wielkości.
+ */
+Aggregates ConcurrentTree::View::aggregate(std::int32_t from, std::int32_t to) const {
+    Aggregates result;
+    if (to < from) return result;
+    const int last = monthKey(to);
+    for (auto it = version->months.lower_bound(monthKey(from)); it != version->months.end() && it->first <= last; ++it) {
+        result.merge(it->second->aggregate(from, to));
+    }
+    return result;
+}
+
+/**
+ * @brief Oblicza sumę i liczbę wartości w przedziale z sum narastających na jego krańcach.
+ *
+ * Suma narastająca do chwili `t` (włącznie) to `totals[i]` miesięcy przed ostatnim miesiącem
+ * o kluczu nie większym niż miesiąc `t` plus suma prefiksowa tego miesiąca do `t` (cały
+ * miesiąc, jeśli jest wcześniejszy niż miesiąc `t`). Wynik to różnica sum narastających do `to`
+ * i do `from - 1`: najpierw różnica skompensowanych sum miesięcy, potem części miesięcy krańców.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @return Aggregate Suma i liczba wartości.
+ */
+Aggregate ConcurrentTree::View::prefixAggregate(std::int32_t from, std::int32_t to, int field) const {
+    Aggregate result;
+    if (to < from || field < 0 || field >= Record::fieldCount || version->totalKeys.empty()) return result;
+    const std::vector<int>& keys = version->totalKeys;
+    const std::int32_t first = std::numeric_limits<std::int32_t>::min();
+
+    // Suma narastająca do `t`: pełne miesiące (`totals`) i część miesiąca krańca (`partial`, `partialCount`)
+    struct Edge {
+        const RunningTotal* months = nullptr;
+        double partial = 0.0;
+        std::size_t partialCount = 0;
+    };
+    const auto edge = [this, &keys, first, field](std::int32_t t) {
+        Edge result;
+        const int key = monthKey(t);
+        const std::size_t after = static_cast<std::size_t>(std::upper_bound(keys.begin(), keys.end(), key) - keys.begin());
+        if (after == 0) {
+            result.months = &version->totals[0];
+        } else if (keys[after - 1] != key) {
+            result.months = &version->totals[after];
+        } else {
+            result.months = &version->totals[after - 1];
+            const PrefixSumIndex& month = *version->prefixes.find(key)->second;
+            result.partial = month.sum(first, t, field);
+            result.partialCount = month.count(first, t);
+        }
+        return result;
+    };
+
+    const Edge upper = edge(to);
+    const Edge lower = from == first ? Edge{ &version->totals[0], 0.0, 0 } : edge(from - 1);
+    result.sum = ((upper.months->sum[field] - lower.months->sum[field]) +
+                  (upper.months->compensation[field] - lower.months->compensation[field])) +
+                 (upper.partial - lower.partial);
+    result.count = (upper.months->count + upper.partialCount) - (lower.months->count + lower.partialCount);
+    return result;
+}
+
+/**
+ * @brief Wyszukuje rekordy z tolerancją w miesiącach z przedziału.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @param value Szukana wartość.
+ * @param tolerance Tolerancja.
+ * @param matches Lista, na której końcu zostaną dopisane pasujące rekordy.
+ */
+void ConcurrentTree::View::search(std::int32_t from, std::int32_t to, int field, double value, double tolerance,
+                                  std::vector<Record>& matches) const {
+    if (to < from) return;
+    const int last = monthKey(to);
+    for (auto it = version->months.lower_bound(monthKey(from)); it != version->months.end() && it->first <= last; ++it) {
+        it->second->search(from, to, field, value, tolerance, matches);
+    }
+}
+
+/**
+ * @brief Dodaje do kopca najlepsze rekordy przedziału z miesięcy przeglądanych od najlepszego maksimum.
+ *
+ * Miesiąc, którego agregat nie może pobić najgorszego rekordu pełnego kopca, jest pomijany.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param top Kopiec wyników.
+ * @param stats Liczniki przejrzanych i pominiętych rekordów.
+ */
+void ConcurrentTree::View::top(std::int32_t from, std::int32_t to, TopK& top, ScanStats& stats) const {
+    const int field = top.fieldIndex();
+    if (to < from || field < 0 || field >= Record::fieldCount) return;
+    const int last = monthKey(to);
+    std::vector<const Tree*> months;
+    for (auto it = version->months.lower_bound(monthKey(from)); it != version->months.end() && it->first <= last; ++it) {
+        months.push_back(it->second.get());
+    }
+    std::sort(months.begin(), months.end(), [&top, field](const Tree* a, const Tree* b) {
+        return top.bound(a->stats[field]) > top.bound(b->stats[field]);
+    });
+    for (const Tree* month : months) {
+        if (top.admits(month->stats[field])) month->top(from, to, top, stats);
+        else stats.skipped += month->stats[field].count;
+    }
+}
+
+/**
+ * @brief Wyznacza dni bez wartości powyżej `limit` w oknie doby w miesiącach z przedziału.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @param limit Największa wartość uznawana za zerową.
+ * @param firstMinute Początek okna doby (włącznie).
+ * @param lastMinute Koniec okna doby (włącznie).
+ * @param days Początki znalezionych dni (chronologicznie).
+ * @param stats Liczniki przejrzanych i pominiętych rekordów.
+ */
+void ConcurrentTree::View::flatDays(std::int32_t from, std::int32_t to, int field, double limit, int firstMinute,
+                                    int lastMinute, std::vector<std::int32_t>& days, ScanStats& stats) const {
+    if (to < from) return;
+    const int last = monthKey(to);
+    for (auto it = version->months.lower_bound(monthKey(from)); it != version->months.end() && it->first <= last; ++it) {
+        it->second->flatDays(from, to, field, limit, firstMinute, lastMinute, days, stats);
+    }
+}
+
+/**
+ * @brief Dopisuje rekordy przedziału chronologicznie (miesiące w kolejności kluczy).
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param records Lista wyjściowa.
+ */
+void ConcurrentTree::View::records(std::int32_t from, std::int32_t to, std::vector<Record>& records) const {
+    if (to < from) return;
+    const int last = monthKey(to);
+    for (auto it = version->months.lower_bound(monthKey(from)); it != version->months.end() && it->first <= last; ++it) {
+        it->second->records(from, to, records);
+    }
+}
+
+/**
+ * @brief Sprawdza, czy miesiąc znacznika zawiera rekord o tym znaczniku.
+ *
+ * @param timestamp Znacznik czasu.
+ * @return true, jeśli rekord istnieje.
+ */
+bool ConcurrentTree::View::contains(std::int32_t timestamp) const {
+    const auto it = version->months.find(monthKey(timestamp));
+    return it != version->months.end() && it->second->contains(timestamp);
+}
+
+/**
+ * @brief Wyznacza zakres czasu widoku z pierwszego i ostatniego miesiąca.
+ *
+ * @param first Wyjściowy najmniejszy znacznik czasu.
+ * @param last Wyjściowy największy znacznik czasu.
+ * @return false, jeśli widok jest pusty.
+ */
+bool ConcurrentTree::View::timeSpan(std::int32_t& first, std::int32_t& last) const {
+    if (version->months.empty()) return false;
+    std::int32_t unused = 0;
+    return version->months.begin()->second->timeSpan(first, unused) &&
+           version->months.rbegin()->second->timeSpan(unused, last);
+}
+
+/**
+ * @brief Tworzy zwykłe drzewo z kopią danych wszystkich miesięcy widoku.
+ *
+ * @return Tree Kopia danych.
+ */
+Tree ConcurrentTree::View::copy() const {
+    Tree result;
+    for (const auto& [key, month] : version->months) {
+        // Kopia miesiąca od razu w arenie wyniku - scalanie tylko przenosi węzły
+        Tree part(result.resource());
+        part = *month;
+        result.merge(std::move(part));
+    }
+    return result;
+}
+
+/**
+ * @brief Tworzy drzewo z pustą wersją.
+ */
+ConcurrentTree::ConcurrentTree() : current(new Version()) {}
+
+/**
+ * @brief Zwalnia bieżącą i wycofane wersje.
+ */
+ConcurrentTree::~ConcurrentTree() {
+    delete current.load();
+    for (const auto& [version, epoch] : retired) delete version;
+}
+
+/**
+ * @brief Dodaje rekordy drzewa `batch`, kopiując tylko zmieniane miesiące, i publikuje nową wersję.
+ *
+ * @param batch Drzewo z nowymi rekordami.
+ */
+void ConcurrentTree::merge(Tree&& batch) {
+    if (batch.years.empty()) return;
+    std::lock_guard<std::mutex> lock(writer);
+    std::unique_ptr<Version> next(new Version(*current.load()));
+
+    // Arena paczki może zostać współdzielona tylko przez miesiące, które zawierają wszystkie jej rekordy
+    bool onlyNewMonths = true;
+    for (const auto& [y, year] : batch.years) {
+        for (const auto& [m, month] : year.months) onlyNewMonths &= next->months.count(y * 12 + m - 1) == 0;
+    }
+
+    int firstKey = std::numeric_limits<int>::max();
+    for (auto& [y, year] : batch.years) {
+        for (auto& [m, month] : year.months) {
+            // Jednomiesięczne drzewo z rekordami paczki (w arenie paczki - bez kopiowania)
+            Tree part(batch.resource());
+            part.stats = month.stats;
+            Tree::Year& partYear = part.years[y];
+            partYear.stats = month.stats;
+            partYear.months[m] = std::move(month);
+            next->records += partYear.months[m].stats[0].count;
+
+            const int key = y * 12 + m - 1;
+            firstKey = std::min(firstKey, key);
+            std::shared_ptr<const Tree>& slot = next->months[key];
+            if (slot) {
+                // Kopia istniejącego miesiąca - poprzednie wersje nadal widzą oryginał
+                std::shared_ptr<Tree> copy = std::make_shared<Tree>(*slot);
+                copy->merge(std::move(part));
+                slot = std::move(copy);
+            } else if (onlyNewMonths) {
+                slot = std::make_shared<const Tree>(std::move(part));
+            } else {
+                // Kopia do własnej areny miesiąca - arena paczki zawiera też rekordy istniejących miesięcy
+                slot = std::make_shared<const Tree>(part);
+            }
+            if (next->indexed) next->prefixes[key] = indexMonth(*slot);
+        }
+    }
+    if (next->indexed) updateTotals(*next, firstKey);
+    batch.years.clear();
+    batch.stats = Aggregates();
+    publish(next.release());
+}
+
+/**
+ * @brief Dodaje pojedynczy rekord.
+ *
+ * @param record Rekord do dodania.
+ */
+void ConcurrentTree::add(const Record& record) {
+    Tree batch;
+    batch.addRecord(record);
+    merge(std::move(batch));
+}
+
+/**
+ * @brief Publikuje pustą wersję (z tym samym ustawieniem indeksów).
+ */
+void ConcurrentTree::clear() {
+    std::lock_guard<std::mutex> lock(writer);
+    Version* next = new Version();
+    next->indexed = current.load()->indexed;
+    publish(next);
+}
+
+/**
+ * @brief Publikuje wersję z tymi samymi miesiącami i zbudowanymi (lub usuniętymi) indeksami.
+ *
+ * @param enabled true - zbuduj indeksy wszystkich miesięcy, false - usuń indeksy.
+ */
+void ConcurrentTree::enablePrefixIndex(bool enabled) {
+    std::lock_guard<std::mutex> lock(writer);
+    std::unique_ptr<Version> next(new Version(*current.load()));
+    next->indexed = enabled;
+    next->prefixes.clear();
+    next->totalKeys.clear();
+    next->totals.clear();
+    if (enabled) {
+        for (const auto& [key, month] : next->months) next->prefixes[key] = indexMonth(*month);
+        updateTotals(*next, std::numeric_limits<int>::min());
+    }
+    publish(next.release());
+}
+
+/**
+ * @brief Przelicza narastające sumy miesięcy od miesiąca `firstKey`.
+ *
+ * Sumy miesięcy przed `firstKey` są zachowywane; od pierwszego zmienionego miesiąca każda
+ * kolejna suma to poprzednia powiększona (z kompensacją) o sumę całego miesiąca z jego indeksu.
+ * Dopisanie do ostatnich miesięcy przelicza więc tylko kilka sum.
+ *
+ * @param version Budowana wersja.
+ * @param firstKey Klucz pierwszego zmienionego miesiąca.
+ */
+void ConcurrentTree::updateTotals(Version& version, int firstKey) {
+    const std::int32_t first = std::numeric_limits<std::int32_t>::min();
+    const std::int32_t last = std::numeric_limits<std::int32_t>::max();
+    const std::size_t kept = static_cast<std::size_t>(
+        std::lower_bound(version.totalKeys.begin(), version.totalKeys.end(), firstKey) - version.totalKeys.begin());
+    version.totalKeys.resize(kept);
+    version.totals.resize(kept + 1);
+    RunningTotal running = version.totals[kept];
+    for (auto it = version.prefixes.lower_bound(firstKey); it != version.prefixes.end(); ++it) {
+        const PrefixSumIndex& month = *it->second;
+        for (int f = 0; f < Record::fieldCount; ++f) {
+            PrefixSumIndex::compensatedAdd(running.sum[f], running.compensation[f], month.sum(first, last, f));
+        }
+        running.count += month.size();
+        version.totalKeys.push_back(it->first);
+        version.totals.push_back(running);
+    }
+}
+
+/**
+ * @brief Zwraca liczbę wycofanych, jeszcze niezwolnionych wersji.
+ *
+ * @return std::size_t Liczba wersji.
+ */
+std::size_t ConcurrentTree::retiredVersions() const {
+    std::lock_guard<std::mutex> lock(writer);
+    return retired.size();
+}
+
+/**
+ * @brief Zamienia bieżącą wersję i zwalnia wycofane wersje bez przypiętych widoków.
+ *
+ * Wycofana wersja dostaje epokę sprzed zwiększenia licznika epok. Czytelnik, który mógł
+ * ją przypiąć, zapisał epokę nie większą niż ta wartość, więc wersja jest zwalniana dopiero,
+ * gdy wszystkie przypięte epoki są od niej większe.
+ *
+ * @param next Nowa wersja.
+ */
+void ConcurrentTree::publish(const Version* next) {
+    const Version* previous = current.exchange(next);
+    retired.emplace_back(previous, globalEpoch.fetch_add(1));
+    pendingRetired.store(true, std::memory_order_release);
+    reclaim(true);
+}
+
+/**
+ * @brief Zwalnia wycofane wersje, których epoka jest mniejsza od najstarszej przypiętej.
+ *
+ * Czytelnik (`locked == false`) tylko próbuje zająć muteks piszącego - jeśli trwa zapis,
+ * wycofane wersje zwolni piszący.
+ *
+ * @param locked true, jeśli wywołujący już trzyma muteks piszącego.
+ */
+void ConcurrentTree::reclaim(bool locked) const {
+    std::unique_lock<std::mutex> lock(writer, std::defer_lock);
+    if (!locked && !lock.try_lock()) return;
+
+    const std::uint64_t oldest = oldestPinnedEpoch();
+    std::size_t kept = 0;
+    for (const auto& entry : retired) {
+        if (entry.second < oldest) {
+            delete entry.first;
+        } else {
+            retired[kept++] = entry;
+        }
+    }
+    retired.resize(kept);
+    pendingRetired.store(kept > 0, std::memory_order_release);
+}
@@ -0,0 +1,294 @@
+#ifndef CONCURRENTTREE_H
+#define CONCURRENTTREE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "Aggregate.h"
+#include "PrefixSumIndex.h"
+#include "Record.h"
+#include "Tree.h"
+
+/**
+ * @brief Drzewo danych pomiarowych z równoczesnym odczytem i zapisem (copy-on-write, RCU).
+ *
+ * Dane są podzielone na miesiące - każdy miesiąc to osobne, niezmienne drzewo (`Tree`) z jednym
+ * rokiem i jednym miesiącem. Wersja danych (`Version`) to mapa miesięcy publikowana przez
+ * atomowy wskaźnik:
+ * - zapis (`merge`, `add`, `clear`) kopiuje tylko zmieniane miesiące, buduje nową wersję
+ *   współdzielącą pozostałe miesiące z poprzednią i publikuje ją jedną operacją atomową,
+ * - odczyt (`View`) przypina bieżącą wersję i widzi spójny stan danych aż do zniszczenia
+ *   widoku, niezależnie od równoległych zapisów.
+ *
+ * Czytelnicy nie zajmują blokad ani nie modyfikują wspólnych liczników referencji: przypięcie
+ * wersji to zapis bieżącej epoki do własnego (osobna linia pamięci podręcznej) miejsca wątku.
+ * Pierwsze 256 wątków dostaje stałe miejsca; kolejne - miejsca dodatkowe, przydzielane raz
+ * na wątek pod muteksem. Poprzednie wersje są zwalniane dopiero wtedy, gdy żaden widok
+ * przypięty przed ich wycofaniem już nie istnieje (odzyskiwanie pamięci oparte na epokach) -
+ * przez piszącego przy publikacji albo przez czytelnika przy zniszczeniu ostatniego widoku.
+ *
+ * Zapisy są szeregowane muteksem piszącego (czytelnicy go nie używają). Koszt zapisu to
+ * kopia zmienianych miesięcy, dlatego rekordy najlepiej dodawać paczkami (`merge`).
+ *
+ * Opcjonalne indeksy sum prefiksowych (`enablePrefixIndex`) są częścią wersji - po jednym na
+ * miesiąc, odbudowywanym tylko dla zmienianych miesięcy, oraz narastające sumy całych miesięcy,
+ * przeliczane od pierwszego zmienionego miesiąca - więc suma z indeksu zawsze odpowiada danym
+ * przypiętego widoku, a jej koszt nie zależy od długości przedziału.
+ */
+class ConcurrentTree {
+private:
+    /**
+     * @brief Narastająca suma miesięcy: skompensowane sumy wielkości (Neumaier) i liczba wartości.
+     */
+    struct RunningTotal {
+        double sum[Record::fieldCount] = {};
+        double compensation[Record::fieldCount] = {};
+        std::size_t count = 0;
+    };
+
+    /**
+     * @brief Niezmienna wersja danych.
+     */
+    struct Version {
+        /**
+         * @brief Miesiące (klucz: `rok * 12 + miesiąc - 1`), każdy jako drzewo z jednym miesiącem.
+         */
+        std::map<int, std::shared_ptr<const Tree>> months;
+
+        /**
+         * @brief Indeksy sum prefiksowych miesięcy (te same klucze co `months`, puste bez `indexed`).
+         */
+        std::map<int, std::shared_ptr<const PrefixSumIndex>> prefixes;
+
+        /**
+         * @brief Klucze miesięcy z indeksami (rosnąco) i narastające sumy miesięcy (puste bez `indexed`).
+         *
+         * `totals[i]` obejmuje wszystkie wartości miesięcy `totalKeys[0..i-1]`, więc wektor ma
+         * `totalKeys.size() + 1` elementów (pierwszy to zero).
+         */
+        std::vector<int> totalKeys;
+        std::vector<RunningTotal> totals;
+
+        /**
+         * @brief Liczba rekordów we wszystkich miesiącach.
+         */
+        std::size_t records = 0;
+
+        /**
+         * @brief Informacja, czy wersja ma indeksy sum prefiksowych.
+         */
+        bool indexed = false;
+    };
+
+public:
+    /**
+     * @brief Spójny widok danych (przypięta wersja) do wykonywania zapytań.
+     *
+     * Widok musi zostać zniszczony w wątku, który go utworzył. Dopóki widok istnieje, jego
+     * wersja nie jest zwalniana - długo żyjące widoki opóźniają zwalnianie pamięci starych wersji.
+     */
+    class View {
+    public:
+        /**
+         * @brief Przypina bieżącą wersję drzewa.
+         *
+         * @param tree Drzewo, którego wersja zostanie przypięta.
+         */
+        explicit View(const ConcurrentTree& tree);
+
+        /**
+         * @brief Odpina wersję.
+         */
+        ~View();
+
+        View(const View&) = delete;
+        View& operator=(const View&) = delete;
+
+        /**
+         * @brief Zwraca liczbę rekordów w widoku.
+         */
+        std::size_t size() const { return version->records; }
+
+        /**
+         * @brief Oblicza agregat wybranej wielkości w przedziale `[from, to]` (patrz `Tree::aggregate`).
+         */
+        Aggregate aggregate(std::int32_t from, std::int32_t to, int field) const;
+
+        /**
+         * @brief Oblicza agregaty wszystkich wielkości w przedziale `[from, to]` (patrz `Tree::aggregate`).
+         */
+        Aggregates aggregate(std::int32_t from, std::int32_t to) const;
+
+        /**
+         * @brief Wyszukuje rekordy z tolerancją (patrz `Tree::search`); wyniki chronologicznie po miesiącach.
+         */
+        void search(std::int32_t from, std::int32_t to, int field, double value, double tolerance,
+                    std::vector<Record>& matches) const;
+
+        /**
+         * @brief Informacja, czy widok ma indeksy sum prefiksowych (patrz `ConcurrentTree::enablePrefixIndex`).
+         */
+        bool indexed() const { return version->indexed; }
+
+        /**
+         * @brief Oblicza sumę i liczbę wartości w przedziale `[from, to]` z indeksów sum prefiksowych miesięcy.
+         *
+         * Wynik to różnica sum narastających na obu krańcach przedziału: narastająca suma miesięcy
+         * przed miesiącem krańca plus suma prefiksowa z indeksu tego miesiąca. Koszt (wyszukiwania
+         * miesięcy krańców i w ich indeksach) nie zależy od długości przedziału. Minimum i maksimum
+         * nie są wyznaczane. Bez indeksów (`indexed() == false`) wynik jest pusty.
+         */
+        Aggregate prefixAggregate(std::int32_t from, std::int32_t to, int field) const;
+
+        /**
+         * @brief Dodaje do kopca najlepsze rekordy przedziału (patrz `Tree::top`); miesiące od najlepszego maksimum.
+         */
+        void top(std::int32_t from, std::int32_t to, TopK& top, ScanStats& stats) const;
+
+        /**
+         * @brief Wyznacza dni bez wartości powyżej `limit` w oknie doby (patrz `Tree::flatDays`).
+         */
+        void flatDays(std::int32_t from, std::int32_t to, int field, double limit, int firstMinute, int lastMinute,
+                      std::vector<std::int32_t>& days, ScanStats& stats) const;
+
+        /**
+         * @brief Dopisuje rekordy przedziału chronologicznie (patrz `Tree::records`).
+         */
+        void records(std::int32_t from, std::int32_t to, std::vector<Record>& records) const;
+
+        /**
+         * @brief Sprawdza, czy widok zawiera rekord o podanym znaczniku czasu.
+         */
+        bool contains(std::int32_t timestamp) const;
+
+        /**
+         * @brief Wyznacza najmniejszy i największy znacznik czasu widoku (patrz `Tree::timeSpan`).
+         */
+        bool timeSpan(std::int32_t& first, std::int32_t& last) const;
+
+        /**
+         * @brief Tworzy zwykłe drzewo z kopią wszystkich danych widoku (np. do zapisu snapshotu).
+         */
+        Tree copy() const;
+
+    private:
+        /**
+         * @brief Drzewo widoku (do zwolnienia wycofanych wersji po odpięciu).
+         */
+        const ConcurrentTree* tree;
+
+        /**
+         * @brief Przypięta wersja.
+         */
+        const Version* version;
+    };
+
+    /**
+     * @brief Tworzy puste drzewo.
+     */
+    ConcurrentTree();
+
+    /**
+     * @brief Zwalnia wszystkie wersje (nie może istnieć żaden widok).
+     */
+    ~ConcurrentTree();
+
+    ConcurrentTree(const ConcurrentTree&) = delete;
+    ConcurrentTree& operator=(const ConcurrentTree&) = delete;
+
+    /**
+     * @brief Przypina bieżącą wersję i zwraca widok do zapytań.
+     */
+    View view() const { return View(*this); }
+
+    /**
+     * @brief Dodaje wszystkie rekordy drzewa `batch` i publikuje nową wersję.
+     *
+     * Istniejące miesiące są kopiowane, a rekordy z `batch` dopisywane na końcu ich ćwiartek
+     * (jak w `Tree::merge`). Jeśli paczka zawiera tylko nowe miesiące (np. pierwsze wczytanie
+     * pliku), są one przenoszone bez kopiowania i współdzielą arenę `batch`, która zawiera wtedy
+     * wyłącznie ich rekordy. W przeciwnym razie nowe miesiące są kopiowane do własnych aren, bo
+     * arena paczki zawiera też rekordy skopiowane już do istniejących miesięcy - mały nowy
+     * miesiąc utrzymywałby ją przy życiu, a pamięć rosłaby z liczbą dopisań.
+     *
+     * @param batch Drzewo z nowymi rekordami (po operacji puste).
+     */
+    void merge(Tree&& batch);
+
+    /**
+     * @brief Dodaje pojedynczy rekord (nowa wersja dla każdego rekordu - do paczek służy `merge`).
+     *
+     * @param record Rekord do dodania.
+     */
+    void add(const Record& record);
+
+    /**
+     * @brief Usuwa wszystkie dane (publikuje pustą wersję z tym samym ustawieniem indeksów).
+     */
+    void clear();
+
+    /**
+     * @brief Włącza lub wyłącza indeksy sum prefiksowych miesięcy i publikuje nową wersję.
+     *
+     * Po włączeniu każdy zapis odbudowuje indeksy zmienianych miesięcy (koszt proporcjonalny
+     * do liczby ich rekordów), a niezmienione indeksy są współdzielone z poprzednią wersją.
+     *
+     * @param enabled true - zbuduj indeksy wszystkich miesięcy, false - usuń indeksy.
+     */
+    void enablePrefixIndex(bool enabled);
+
+    /**
+     * @brief Zwraca liczbę wycofanych wersji, które czekają na zniszczenie przypinających je widoków.
+     */
+    std::size_t retiredVersions() const;
+
+private:
+    /**
+     * @brief Publikuje nową wersję i zwalnia wersje, których nie używa już żaden widok.
+     *
+     * @param next Nowa wersja (przejmowana na własność).
+     */
+    void publish(const Version* next);
+
+    /**
+     * @brief Zwalnia wycofane wersje, których nie używa już żaden widok.
+     *
+     * @param locked true - wywołujący trzyma `writer`, false - próba zajęcia `writer` bez czekania.
+     */
+    void reclaim(bool locked) const;
+
+    /**
+     * @brief Przelicza narastające sumy miesięcy wersji od miesiąca `firstKey` (wcześniejsze się nie zmieniają).
+     *
+     * @param version Budowana wersja z aktualnymi indeksami miesięcy.
+     * @param firstKey Klucz pierwszego zmienionego miesiąca.
+     */
+    static void updateTotals(Version& version, int firstKey);
+
+    /**
+     * @brief Bieżąca wersja.
+     */
+    std::atomic<const Version*> current;
+
+    /**
+     * @brief Wycofane wersje z epoką wycofania, czekające na zwolnienie (chronione przez `writer`).
+     */
+    mutable std::vector<std::pair<const Version*, std::uint64_t>> retired;
+
+    /**
+     * @brief Informacja, czy są wycofane wersje (sprawdzana przez czytelników bez blokady).
+     */
+    mutable std::atomic<bool> pendingRetired{ false };
+
+    /**
+     * @brief Muteks szeregujący zapisy i zwalnianie wycofanych wersji.
+     */
+    mutable std::mutex writer;
+};
+
+#endif // CONCURRENTTREE_H
@@ -0,0 +1,169 @@
+#include "FlatTree.h"
+#include "Tree.h"
+
+#include <algorithm>
+
+/**
+ * @brief Tworzy płaski magazyn z zawartości drzewa.
+ *
+ * Drzewo jest przechodzone w kolejności rok -> miesiąc -> dzień -> ćwiartka, więc rekordy
+ * trafiają do magazynu niemal zawsze w kolejności chronologicznej (dopisywanie na końcu).
+ *
+ * @param tree Drzewo źródłowe.
+ * @return FlatTree Magazyn z rekordami drzewa.
+ */
+FlatTree FlatTree::fromTree(const Tree& tree) {
+    FlatTree flat;
+    for (const auto& [yearKey, year] : tree.years)
+        for (const auto& [monthKey, month] : year.months)
+            for (const auto& [dayKey, day] : month.days)
+                for (const auto& [quarterKey, quarter] : day.quarters)
+                    for (std::size_t i = 0; i < quarter.size(); ++i)
+                        flat.addRecord(Record(quarter.timestamps[i], quarter.autokonsumpcja[i], quarter.eksport[i],
+                                              quarter.import_[i], quarter.pobor[i], quarter.produkcja[i]));
+    return flat;
+}
+
+/**
+ * @brief Dodaje rekord, zachowując posortowanie kolumn według `Record::timestamp`.
+ *
+ * @param record Rekord do dodania.
+ */
+void FlatTree::addRecord(const Record& record) {
+    const std::int32_t timestamp = record.timestamp;
+    if (timestamps.empty() || timestamps.back() <= timestamp) {
+        // Typowy przypadek: dane chronologiczne - dopisanie na końcu
+        timestamps.push_back(timestamp);
+        autokonsumpcja.push_back(record.autokonsumpcja);
+        eksport.push_back(record.eksport);
+        import_.push_back(record.import_);
+        pobor.push_back(record.pobor);
+        produkcja.push_back(record.produkcja);
+        return;
+    }
+
+    // Rekord spoza kolejności - wstawienie za rekordami o tym samym znaczniku czasu
+    const std::size_t index = static_cast<std::size_t>(
+        std::upper_bound(timestamps.begin(), timestamps.end(), timestamp) - timestamps.begin());
+    const std::ptrdiff_t offset = static_cast<std::ptrdiff_t>(index);
+    timestamps.insert(timestamps.begin() + offset, timestamp);
+    autokonsumpcja.insert(autokonsumpcja.begin() + offset, record.autokonsumpcja);
+    eksport.insert(eksport.begin() + offset, record.eksport);
+    import_.insert(import_.begin() + offset, record.import_);
+    pobor.insert(pobor.begin() + offset, record.pobor);
+    produkcja.insert(produkcja.begin() + offset, record.produkcja);
+}
+
+/**
+ * @brief Odtwarza rekord o podanym indeksie.
+ *
+ * @param index Indeks rekordu.
+ * @return Record Odtworzony rekord.
+ */
+Record FlatTree::record(std::size_t index) const {
+    return Record(timestamps[index], autokonsumpcja[index], eksport[index], import_[index], pobor[index],
+                  produkcja[index]);
+}
+
+/**
+ * @brief Wyszukuje indeks pierwszego rekordu o podanym znaczniku czasu.
+ *
+ * Dla gęstych danych (pomiar co 15 minut bez luk) pozycja `(timestamp - timestamps[0]) / 15`
+ * jest trafiona od razu. Jeśli pod wyliczoną pozycją jest inny znacznik czasu albo poprzedni
+ * rekord ma ten sam znacznik (duplikat), wykonywane jest wyszukiwanie binarne.
+ *
+ * @param timestamp Szukany znacznik czasu.
+ * @return std::size_t Indeks rekordu albo `size()`, jeśli nie znaleziono.
+ */
+std::size_t FlatTree::find(std::int32_t timestamp) const {
+    if (timestamps.empty() || timestamp < timestamps.front() || timestamp > timestamps.back()) return size();
+
+    const std::int32_t offset = timestamp - timestamps.front();
+    if (offset % slotMinutes == 0) {
+        const std::size_t slot = static_cast<std::size_t>(offset / slotMinutes);
+        if (slot < size() && timestamps[slot] == timestamp && (slot == 0 || timestamps[slot - 1] != timestamp)) {
+            return slot;
+        }
+    }
+
+    const auto it = std::lower_bound(timestamps.begin(), timestamps.end(), timestamp);
+    if (it == timestamps.end() || *it != timestamp) return size();
+    return static_cast<std::size_t>(it - timestamps.begin());
+}
+
+/**
+ * @brief Wyznacza przedział rekordów o znacznikach czasu z zakresu `[from, to]`.
+ *
+ * @param from Początek zakresu (włącznie).
+ * @param to Koniec zakresu (włącznie).
+ * @return Range Przedział indeksów `[first, last)`.
+ */
+FlatTree::Range FlatTree::range(std::int32_t from, std::int32_t to) const {
+    if (to < from) return Range(0, 0);
+    return halfOpenRange(from, to + 1);
+}
+
+/**
+ * @brief Wyznacza przedział rekordów o znacznikach czasu z zakresu `[from, to)`.
+ *
+ * @param from Początek zakresu (włącznie).
+ * @param to Koniec zakresu (wyłącznie).
+ * @return Range Przedział indeksów `[first, last)`.
+ */
+FlatTree::Range FlatTree::halfOpenRange(std::int32_t from, std::int32_t to) const {
+    const auto first = std::lower_bound(timestamps.begin(), timestamps.end(), from);
+    const auto last = std::lower_bound(first, timestamps.end(), to);
+    return Range(static_cast<std::size_t>(first - timestamps.begin()),
+                 static_cast<std::size_t>(last - timestamps.begin()));
+}
+
+/**
+ * @brief Przedział rekordów danego roku.
+ *
+ * @param year Rok.
+ * @return Range Przedział indeksów `[first, last)`.
+ */
+FlatTree::Range FlatTree::yearRange(int year) const {
+    return halfOpenRange(Timestamp::fromDateTime(year, 1, 1, 0, 0), Timestamp::fromDateTime(year + 1, 1, 1, 0, 0));
+}
+
+/**
+ * @brief Przedział rekordów danego miesiąca.
+ *
+ * @param year Rok.
+ * @param month Miesiąc (1-12).
+ * @return Range Przedział indeksów `[first, last)`.
+ */
+FlatTree::Range FlatTree::monthRange(int year, int month) const {
+    const int nextYear = month == 12 ? year + 1 : year;
+    const int nextMonth = month == 12 ? 1 : month + 1;
+    return halfOpenRange(Timestamp::fromDateTime(year, month, 1, 0, 0),
+                         Timestamp::fromDateTime(nextYear, nextMonth, 1, 0, 0));
+}
+
+/**
+ * @brief Przedział rekordów danego dnia.
+ *
+ * @param year Rok.
+ * @param month Miesiąc (1-12).
+ * @param day Dzień miesiąca.
+ * @return Range Przedział indeksów `[first, last)`.
+ */
+FlatTree::Range FlatTree::dayRange(int year, int month, int day) const {
+    const std::int32_t start = Timestamp::fromDateTime(year, month, day, 0, 0);
+    return halfOpenRange(start, start + Timestamp::minutesPerDay);
+}
+
+/**
+ * @brief Przedział rekordów danej ćwiartki dnia.
+ *
+ * @param year Rok.
+ * @param month Miesiąc (1-12).
+ * @param day Dzień miesiąca.
+ * @param quarter Numer ćwiartki (0-3, po 6 godzin).
+ * @return Range Przedział indeksów `[first, last)`.
+ */
+FlatTree::Range FlatTree::quarterRange(int year, int month, int day, int quarter) const {
+    const std::int32_t start = Timestamp::fromDateTime(year, month, day, quarter * 6, 0);
+    return halfOpenRange(start, start + 6 * 60);
+}
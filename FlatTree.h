@@ -0,0 +1,146 @@
+#ifndef FLATTREE_H
+#define FLATTREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "Record.h"
+#include "Timestamp.h"
+
+class Tree;
+
+/**
+ * @brief Płaski, indeksowany czasem magazyn danych pomiarowych (alternatywa dla `Tree`).
+ *
+ * Wszystkie rekordy są przechowywane w jednej posortowanej kolekcji kolumn (znaczniki czasu
+ * oraz po jednej tablicy na każdą wielkość pomiarową). Dane z falownika są gęste i regularne
+ * (co 15 minut), dlatego pozycję rekordu o danym znaczniku czasu można zwykle wyliczyć wprost
+ * z różnicy czasu (O(1)); w przypadku luk lub duplikatów używane jest wyszukiwanie binarne.
+ *
+ * Nawigacja rok -> miesiąc -> dzień -> ćwiartka jest dostępna jako widok wyliczany:
+ * funkcje `yearRange`, `monthRange`, `dayRange` i `quarterRange` zwracają przedział indeksów
+ * `[first, last)` rekordów należących do danego węzła.
+ */
+class FlatTree {
+public:
+    /**
+     * @brief Przedział indeksów rekordów `[first, last)`.
+     */
+    using Range = std::pair<std::size_t, std::size_t>;
+
+    /**
+     * @brief Odstęp między kolejnymi pomiarami w minutach.
+     */
+    static constexpr std::int32_t slotMinutes = 15;
+
+    /**
+     * @brief Znaczniki czasu rekordów (rosnąco, minuty od 2000-01-01 00:00).
+     */
+    std::vector<std::int32_t> timestamps;
+
+    /**
+     * @brief Kolumna wartości autokonsumpcji [W].
+     */
+    std::vector<double> autokonsumpcja;
+
+    /**
+     * @brief Kolumna wartości eksportu [W].
+     */
+    std::vector<double> eksport;
+
+    /**
+     * @brief Kolumna wartości importu [W].
+     */
+    std::vector<double> import_;
+
+    /**
+     * @brief Kolumna wartości poboru [W].
+     */
+    std::vector<double> pobor;
+
+    /**
+     * @brief Kolumna wartości produkcji [W].
+     */
+    std::vector<double> produkcja;
+
+    /**
+     * @brief Tworzy płaski magazyn z zawartości drzewa.
+     *
+     * @param tree Drzewo źródłowe.
+     * @return FlatTree Magazyn z tymi samymi rekordami, posortowanymi według czasu.
+     */
+    static FlatTree fromTree(const Tree& tree);
+
+    /**
+     * @brief Dodaje rekord pomiarowy.
+     *
+     * Rekordy dodawane w kolejności chronologicznej są dopisywane na końcu (O(1)).
+     * Rekord starszy od ostatniego jest wstawiany na właściwe miejsce, za rekordami
+     * o tym samym znaczniku czasu.
+     *
+     * @param record Rekord (pozycja wyznaczana ze znacznika czasu `Record::timestamp`).
+     */
+    void addRecord(const Record& record);
+
+    /**
+     * @brief Zwraca liczbę rekordów.
+     */
+    std::size_t size() const { return timestamps.size(); }
+
+    /**
+     * @brief Odtwarza rekord o podanym indeksie.
+     *
+     * @param index Indeks rekordu.
+     * @return Record Rekord ze znacznikiem czasu i wartościami pomiarów.
+     */
+    Record record(std::size_t index) const;
+
+    /**
+     * @brief Wyszukuje indeks pierwszego rekordu o podanym znaczniku czasu.
+     *
+     * Najpierw sprawdzana jest pozycja wyliczona z odstępu 15 minut od pierwszego rekordu (O(1)),
+     * a dopiero gdy się nie zgadza (luki, duplikaty) - wyszukiwanie binarne.
+     *
+     * @param timestamp Szukany znacznik czasu.
+     * @return std::size_t Indeks rekordu albo `size()`, jeśli brak takiego rekordu.
+     */
+    std::size_t find(std::int32_t timestamp) const;
+
+    /**
+     * @brief Wyznacza przedział rekordów o znacznikach czasu z zakresu `[from, to]`.
+     *
+     * @param from Początek zakresu (włącznie).
+     * @param to Koniec zakresu (włącznie).
+     * @return Range Przedział indeksów `[first, last)`.
+     */
+    Range range(std::int32_t from, std::int32_t to) const;
+
+    /**
+     * @brief Przedział rekordów danego roku.
+     */
+    Range yearRange(int year) const;
+
+    /**
+     * @brief Przedział rekordów danego miesiąca.
+     */
+    Range monthRange(int year, int month) const;
+
+    /**
+     * @brief Przedział rekordów danego dnia.
+     */
+    Range dayRange(int year, int month, int day) const;
+
+    /**
+     * @brief Przedział rekordów danej ćwiartki dnia (0-3, patrz `Tree::getQuarter`).
+     */
+    Range quarterRange(int year, int month, int day, int quarter) const;
+
+private:
+    /**
+     * @brief Wyznacza przedział `[from, to)` (koniec wyłącznie) wyszukiwaniem binarnym.
+     */
+    Range halfOpenRange(std::int32_t from, std::int32_t to) const;
+};
+
+#endif // FLATTREE_H
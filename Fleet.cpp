@@ -0,0 +1,186 @@
+#include "Fleet.h"
+#include "Arena.h"
+#include "Logger.h"
+#include "MappedFile.h"
+#include "Program.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <system_error>
+
+/**
+ * @brief Tworzy pustą flotę z pulą wątków.
+ *
+ * @param threadCount Liczba wątków (0 - liczba dostępnych rdzeni).
+ */
+Fleet::Fleet(unsigned threadCount) : pool(threadCount) {}
+
+/**
+ * @brief Wczytuje plik CSV do instalacji.
+ *
+ * Plik jest parsowany do lokalnego drzewa (jak w `Program::loadCSV`) i publikowany jedną nową
+ * wersją drzewa instalacji. Pierwszy blok areny lokalnego drzewa ma półtora rozmiaru pliku
+ * (drzewo eksportu zajmuje ok. 1,1 rozmiaru tekstu CSV), więc zwykle wystarcza jeden blok,
+ * a nieużyta końcówka bloku nie zajmuje pamięci rezydentnej.
+ *
+ * @param siteId Identyfikator instalacji.
+ * @param fileName Nazwa pliku CSV.
+ * @param error Opis błędu.
+ * @return true, jeśli plik został wczytany.
+ */
+bool Fleet::loadSite(const std::string& siteId, const std::string& fileName, std::string& error) {
+    MappedFile file(fileName);
+    if (!file.isOpen()) {
+        error = "Nie można otworzyć pliku: " + fileName;
+        return false;
+    }
+
+    Logger logger("", "", LogLevel::None);
+    Tree loaded(std::make_shared<Arena>(std::max<std::size_t>(file.size() + file.size() / 2, 4096)));
+    int valid = 0, invalid = 0;
+    Program::parseChunk(file.data(), file.data() + file.size(), loaded, valid, invalid, logger);
+
+    Site& target = siteFor(siteId);
+    target.tree.merge(std::move(loaded));
+    target.validRecords += valid;
+    target.invalidRecords += invalid;
+    return true;
+}
+
+/**
+ * @brief Wczytuje równolegle wszystkie pliki `*.csv` z katalogu (jeden plik na iterację puli).
+ *
+ * @param directory Katalog z eksportami.
+ * @param error Lista plików, których nie udało się wczytać.
+ * @return true, jeśli wczytano wszystkie pliki.
+ */
+bool Fleet::loadDirectory(const std::string& directory, std::string& error) {
+    std::error_code code;
+    std::vector<std::filesystem::path> files;
+    for (std::filesystem::directory_iterator it(directory, code), end; !code && it != end; it.increment(code)) {
+        if (it->path().extension() == ".csv" && it->is_regular_file(code)) files.push_back(it->path());
+    }
+    if (code) {
+        error = "Nie można odczytać katalogu: " + directory;
+        return false;
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<std::string> errors(files.size());
+    pool.parallelFor(files.size(), [this, &files, &errors](std::size_t i) {
+        loadSite(files[i].stem().string(), files[i].string(), errors[i]);
+    });
+
+    error.clear();
+    for (const std::string& message : errors) {
+        if (message.empty()) continue;
+        if (!error.empty()) error += '\n';
+        error += message;
+    }
+    return error.empty();
+}
+
+/**
+ * @brief Zwraca liczbę instalacji.
+ */
+std::size_t Fleet::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return sites.size();
+}
+
+/**
+ * @brief Zwraca identyfikatory instalacji.
+ */
+std::vector<std::string> Fleet::siteIds() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> ids;
+    ids.reserve(sites.size());
+    for (const auto& [id, site] : sites) ids.push_back(id);
+    return ids;
+}
+
+/**
+ * @brief Zwraca instalację o podanym identyfikatorze.
+ *
+ * @param siteId Identyfikator instalacji.
+ * @return const Site* Instalacja lub nullptr.
+ */
+const Fleet::Site* Fleet::site(const std::string& siteId) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = sites.find(siteId);
+    return it == sites.end() ? nullptr : it->second.get();
+}
+
+/**
+ * @brief Oblicza łączny agregat floty.
+ *
+ * Instalacje są dzielone na ciągłe porcje (kilka na wątek); agregaty porcji są łączone
+ * w kolejności porcji, więc suma jest taka sama przy każdej liczbie wątków.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @return Aggregate Agregat wszystkich instalacji.
+ */
+Aggregate Fleet::aggregate(std::int32_t from, std::int32_t to, int field) const {
+    const std::vector<std::pair<const std::string*, const Site*>> all = snapshotSites();
+    // Stały rozmiar porcji - podział nie zależy od liczby wątków
+    const std::size_t chunk = 16;
+    std::vector<Aggregate> partial((all.size() + chunk - 1) / chunk);
+    pool.parallelFor(partial.size(), [&all, &partial, from, to, field](std::size_t i) {
+        const std::size_t last = std::min(all.size(), (i + 1) * chunk);
+        for (std::size_t s = i * chunk; s < last; ++s) {
+            partial[i].merge(all[s].second->tree.view().aggregate(from, to, field));
+        }
+    });
+
+    Aggregate result;
+    for (const Aggregate& part : partial) result.merge(part);
+    return result;
+}
+
+/**
+ * @brief Oblicza agregaty poszczególnych instalacji (równolegle).
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @return std::map<std::string, Aggregate> Agregaty według identyfikatora instalacji.
+ */
+std::map<std::string, Aggregate> Fleet::aggregateBySite(std::int32_t from, std::int32_t to, int field) const {
+    const std::vector<std::pair<const std::string*, const Site*>> all = snapshotSites();
+    std::vector<Aggregate> partial(all.size());
+    pool.parallelFor(all.size(), [&all, &partial, from, to, field](std::size_t i) {
+        partial[i] = all[i].second->tree.view().aggregate(from, to, field);
+    });
+
+    std::map<std::string, Aggregate> result;
+    for (std::size_t i = 0; i < all.size(); ++i) result.emplace_hint(result.end(), *all[i].first, partial[i]);
+    return result;
+}
+
+/**
+ * @brief Zwraca instalację, tworząc ją przy pierwszym użyciu.
+ *
+ * @param siteId Identyfikator instalacji.
+ * @return Site& Instalacja.
+ */
+Fleet::Site& Fleet::siteFor(const std::string& siteId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::unique_ptr<Site>& slot = sites[siteId];
+    if (!slot) slot = std::make_unique<Site>();
+    return *slot;
+}
+
+/**
+ * @brief Zwraca wskaźniki identyfikatorów i instalacji w kolejności identyfikatorów.
+ *
+ * Węzły mapy nie są usuwane, więc wskaźniki pozostają ważne po zwolnieniu muteksu.
+ */
+std::vector<std::pair<const std::string*, const Fleet::Site*>> Fleet::snapshotSites() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::pair<const std::string*, const Site*>> all;
+    all.reserve(sites.size());
+    for (const auto& [id, site] : sites) all.emplace_back(&id, site.get());
+    return all;
+}
@@ -0,0 +1,152 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Aggregate.h"
+#include "ConcurrentTree.h"
+#include "ThreadPool.h"
+
+/**
+ * @brief Flota instalacji: wiele serii pomiarowych (jedna na falownik) w jednym procesie.
+ *
+ * Każda instalacja jest identyfikowana nazwą (np. nazwą pliku eksportu bez rozszerzenia)
+ * i ma własne drzewo `ConcurrentTree`. Katalog eksportów jest wczytywany równolegle
+ * (`loadDirectory`), a zapytania obejmujące całą flotę (`aggregate`) są rozdzielane między
+ * wątki puli (`ThreadPool`) - każdy wątek liczy agregaty części instalacji, a wyniki
+ * częściowe są łączone w kolejności identyfikatorów, więc wynik nie zależy od liczby wątków.
+ *
+ * Narzut pamięci instalacji to praktycznie tylko jej dane: arena drzewa (`Arena`) jest
+ * rozmiarowana według wielkości pliku, więc typowy eksport mieści się w jednym bloku pamięci
+ * (roczny eksport ChartExport.csv to ok. 380 KB pamięci rezydentnej na instalację).
+ *
+ * Zapytania mogą być wykonywane równocześnie z `loadSite`; zbiór instalacji tylko rośnie,
+ * a dane instalacji są publikowane jako nowe wersje jej drzewa. `loadDirectory` zajmuje pulę
+ * wątków, więc zapytania floty zlecone w trakcie czekają na koniec wczytywania katalogu.
+ */
+class Fleet {
+public:
+    /**
+     * @brief Dane jednej instalacji.
+     */
+    struct Site {
+        /**
+         * @brief Dane pomiarowe instalacji.
+         */
+        ConcurrentTree tree;
+
+        /**
+         * @brief Liczba poprawnych rekordów wczytanych dla instalacji.
+         */
+        std::atomic<int> validRecords{ 0 };
+
+        /**
+         * @brief Liczba błędnych rekordów pominiętych przy wczytywaniu.
+         */
+        std::atomic<int> invalidRecords{ 0 };
+    };
+
+    /**
+     * @brief Tworzy pustą flotę.
+     *
+     * @param threadCount Liczba wątków wczytywania i zapytań (0 - liczba dostępnych rdzeni).
+     */
+    explicit Fleet(unsigned threadCount = 0);
+
+    Fleet(const Fleet&) = delete;
+    Fleet& operator=(const Fleet&) = delete;
+
+    /**
+     * @brief Wczytuje plik CSV eksportu i dopisuje jego rekordy do instalacji `siteId`.
+     *
+     * Instalacja jest tworzona, jeśli jeszcze nie istnieje. Błędne rekordy są tylko zliczane
+     * (bez plików logów - przy setkach instalacji logi `Program::loadCSV` byłyby nieczytelne).
+     *
+     * @param siteId Identyfikator instalacji.
+     * @param fileName Nazwa pliku CSV.
+     * @param error Opis błędu.
+     * @return true, jeśli plik został wczytany.
+     */
+    bool loadSite(const std::string& siteId, const std::string& fileName, std::string& error);
+
+    /**
+     * @brief Równolegle wczytuje wszystkie pliki `*.csv` z katalogu; identyfikatorem instalacji
+     * jest nazwa pliku bez rozszerzenia.
+     *
+     * Pliki, których nie udało się wczytać, są wymieniane w `error`; pozostałe zostają wczytane.
+     *
+     * @param directory Katalog z eksportami.
+     * @param error Opis błędów.
+     * @return true, jeśli wczytano wszystkie pliki.
+     */
+    bool loadDirectory(const std::string& directory, std::string& error);
+
+    /**
+     * @brief Zwraca liczbę instalacji.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Zwraca identyfikatory instalacji w kolejności alfabetycznej.
+     */
+    std::vector<std::string> siteIds() const;
+
+    /**
+     * @brief Zwraca instalację o podanym identyfikatorze (nullptr, jeśli nie istnieje).
+     */
+    const Site* site(const std::string& siteId) const;
+
+    /**
+     * @brief Oblicza agregat wielkości w przedziale `[from, to]` łącznie dla wszystkich instalacji.
+     *
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości (patrz `Record::fieldIndex`).
+     * @return Aggregate Suma, liczba, minimum i maksimum wszystkich instalacji.
+     */
+    Aggregate aggregate(std::int32_t from, std::int32_t to, int field) const;
+
+    /**
+     * @brief Oblicza agregat wielkości w przedziale osobno dla każdej instalacji.
+     *
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości.
+     * @return std::map<std::string, Aggregate> Agregaty instalacji według identyfikatora.
+     */
+    std::map<std::string, Aggregate> aggregateBySite(std::int32_t from, std::int32_t to, int field) const;
+
+private:
+    /**
+     * @brief Zwraca instalację o podanym identyfikatorze, tworząc ją w razie potrzeby.
+     */
+    Site& siteFor(const std::string& siteId);
+
+    /**
+     * @brief Zwraca identyfikatory i instalacje w kolejności identyfikatorów (stan z chwili wywołania).
+     */
+    std::vector<std::pair<const std::string*, const Site*>> snapshotSites() const;
+
+    /**
+     * @brief Instalacje według identyfikatora (wskaźniki są stałe przez cały czas życia floty).
+     */
+    std::map<std::string, std::unique_ptr<Site>> sites;
+
+    /**
+     * @brief Muteks chroniący mapę instalacji.
+     */
+    mutable std::mutex mutex;
+
+    /**
+     * @brief Pula wątków wczytywania i zapytań.
+     */
+    mutable ThreadPool pool;
+};
+
+#endif // FLEET_H
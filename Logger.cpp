@@ -0,0 +1,222 @@
+#include "Logger.h"
+#include "Metrics.h"
+
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Rozmiar paczki, po przekroczeniu którego jest ona zapisywana do pliku.
+ */
+const std::size_t kBatchBytes = 1 << 16;
+
+} // namespace
+
+/**
+ * @brief Otwiera pliki logów i uruchamia wątek zapisujący.
+ *
+ * Dla poziomu `LogLevel::None` nie są tworzone ani pliki, ani wątek.
+ *
+ * @param dataFile Plik logu poprawnych rekordów.
+ * @param errorFile Plik logu błędnych rekordów.
+ * @param level Poziom szczegółowości.
+ * @param capacity Liczba miejsc w buforze.
+ * @param append Dopisywanie do istniejących plików.
+ */
+Logger::Logger(const std::string& dataFile, const std::string& errorFile, LogLevel level, std::size_t capacity,
+               bool append)
+    : logLevel(level) {
+    if (logLevel == LogLevel::None) return;
+    const std::ios::openmode mode = append ? std::ios::app : std::ios::trunc;
+    dataLog.open(dataFile, std::ios::out | mode);
+    errorLog.open(errorFile, std::ios::out | mode);
+
+    std::size_t size = 2;
+    while (size < capacity) size *= 2;
+    slots.reset(new Slot[size]);
+    Metrics::addMemory(MemoryPool::Logger, static_cast<std::int64_t>(size * sizeof(Slot)));
+    for (std::size_t i = 0; i < size; ++i) slots[i].sequence.store(i, std::memory_order_relaxed);
+    mask = size - 1;
+    dataBatch.reserve(kBatchBytes * 2);
+    errorBatch.reserve(kBatchBytes * 2);
+    writer = std::thread(&Logger::run, this);
+}
+
+/**
+ * @brief Zapisuje oczekujące wpisy i zatrzymuje wątek zapisujący.
+ */
+Logger::~Logger() {
+    if (slots) Metrics::addMemory(MemoryPool::Logger, -static_cast<std::int64_t>((mask + 1) * sizeof(Slot)));
+    if (!writer.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping.store(true);
+    }
+    wakeWriter.notify_one();
+    writer.join();
+}
+
+/**
+ * @brief Dodaje wpis do bufora pierścieniowego.
+ *
+ * Pozycja jest rezerwowana przez compare-exchange na `tail`; miejsce jest wolne, gdy jego numer
+ * sekwencyjny równa się pozycji. Po skopiowaniu treści numer jest ustawiany na pozycję + 1,
+ * co publikuje wpis dla wątku zapisującego. Przy pełnym buforze wątek ustępuje procesor
+ * do czasu zwolnienia miejsca.
+ *
+ * @param kind Rodzaj wpisu.
+ * @param text Treść wpisu.
+ * @param length Długość treści.
+ * @param lineNumber Numer linii błędnego rekordu (0 - brak).
+ * @param reason Powód odrzucenia błędnego rekordu (nullptr - brak).
+ */
+void Logger::push(EntryKind kind, const char* text, std::size_t length, std::size_t lineNumber, const char* reason) {
+    std::size_t position = tail.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+    for (;;) {
+        slot = &slots[position & mask];
+        const std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const std::ptrdiff_t difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+        if (difference == 0) {
+            if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        } else if (difference < 0) {
+            // Bufor pełny - wątek zapisujący musi zwolnić miejsce
+            wake();
+            std::this_thread::yield();
+            position = tail.load(std::memory_order_relaxed);
+        } else {
+            position = tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->kind = kind;
+    slot->length = static_cast<std::uint32_t>(length);
+    slot->lineNumber = lineNumber;
+    slot->reason = reason;
+    if (length <= inlineText) {
+        std::memcpy(slot->text, text, length);
+    } else {
+        slot->overflow.assign(text, length);
+    }
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    // Budzenie co pół bufora - wątek zapisujący zdąży go opróżnić, zanim producenci go zapełnią
+    if ((position & (mask >> 1)) == 0) wake();
+}
+
+/**
+ * @brief Budzi wątek zapisujący, jeśli czeka na nowe wpisy.
+ *
+ * Powiadomienie jest wysyłane pod muteksem, więc nie może zostać zgubione między sprawdzeniem
+ * bufora a zaśnięciem wątku zapisującego.
+ */
+void Logger::wake() {
+    if (!writerWaiting.load()) return;
+    std::lock_guard<std::mutex> lock(mutex);
+    wakeWriter.notify_one();
+}
+
+/**
+ * @brief Loguje podsumowanie wczytywania do logu poprawnych rekordów.
+ *
+ * @param valid Liczba poprawnych rekordów.
+ * @param invalid Liczba błędnych rekordów.
+ */
+void Logger::summary(int valid, int invalid) {
+    if (logLevel == LogLevel::None) return;
+    const std::string text = "Podsumowanie: poprawne rekordy: " + std::to_string(valid) +
+                             ", błędne rekordy: " + std::to_string(invalid);
+    push(EntryKind::DataMessage, text.data(), text.size());
+}
+
+/**
+ * @brief Czeka na zapisanie do plików wszystkich wpisów dodanych przed wywołaniem.
+ */
+void Logger::flush() {
+    if (!writer.joinable()) return;
+    const std::size_t target = tail.load(std::memory_order_acquire);
+    wake();
+    std::unique_lock<std::mutex> lock(mutex);
+    writtenChanged.wait(lock, [this, target] { return written.load(std::memory_order_acquire) >= target; });
+}
+
+/**
+ * @brief Zapisuje zebrane paczki do plików.
+ */
+void Logger::writeBatches() {
+    ScopedTimer timer(Metric::LogWrite, !dataBatch.empty() || !errorBatch.empty());
+    Metrics::add(Metric::LogWrite, dataBatch.size() + errorBatch.size());
+    if (!dataBatch.empty()) {
+        dataLog.write(dataBatch.data(), static_cast<std::streamsize>(dataBatch.size()));
+        dataBatch.clear();
+    }
+    if (!errorBatch.empty()) {
+        errorLog.write(errorBatch.data(), static_cast<std::streamsize>(errorBatch.size()));
+        errorBatch.clear();
+    }
+}
+
+/**
+ * @brief Pętla wątku zapisującego.
+ *
+ * Odbiera opublikowane wpisy w kolejności pozycji, dopisuje je (z prefiksem) do paczki
+ * odpowiedniego pliku i zapisuje paczki po przekroczeniu `kBatchBytes` lub gdy bufor jest pusty.
+ * Bez nowych wpisów wątek zasypia do powiadomienia (`wake`) lub najwyżej na 1 ms, co ogranicza
+ * opóźnienie zapisu pojedynczych wpisów.
+ */
+void Logger::run() {
+    for (;;) {
+        bool received = false;
+        for (;;) {
+            Slot& slot = slots[head & mask];
+            if (slot.sequence.load(std::memory_order_acquire) != head + 1) break;
+
+            std::string& batch = slot.kind == EntryKind::InvalidRecord ? errorBatch : dataBatch;
+            if (slot.kind == EntryKind::ValidRecord) batch += "Poprawny rekord: ";
+            if (slot.kind == EntryKind::InvalidRecord) {
+                batch += "Błędny rekord";
+                if (slot.lineNumber != 0) {
+                    batch += " (linia ";
+                    batch += std::to_string(slot.lineNumber);
+                    if (slot.reason != nullptr) {
+                        batch += ", ";
+                        batch += slot.reason;
+                    }
+                    batch += ')';
+                }
+                batch += ": ";
+            }
+            if (slot.length <= inlineText) {
+                batch.append(slot.text, slot.length);
+            } else {
+                batch += slot.overflow;
+                std::string().swap(slot.overflow);
+            }
+            batch += '\n';
+
+            slot.sequence.store(head + mask + 1, std::memory_order_release);
+            ++head;
+            received = true;
+            if (batch.size() >= kBatchBytes) writeBatches();
+        }
+        if (received) continue;
+
+        // Bufor pusty - zapis paczek i powiadomienie oczekujących w `flush`
+        writeBatches();
+        dataLog.flush();
+        errorLog.flush();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            written.store(head, std::memory_order_release);
+        }
+        writtenChanged.notify_all();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        writerWaiting.store(true);
+        const bool empty = slots[head & mask].sequence.load(std::memory_order_acquire) != head + 1;
+        if (empty && stopping.load()) break;
+        if (empty) wakeWriter.wait_for(lock, std::chrono::milliseconds(1));
+        writerWaiting.store(false);
+    }
+}
@@ -0,0 +1,249 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Poziom szczegółowości logów wczytywania danych.
+ */
+enum class LogLevel {
+    /**
+     * @brief Brak logów (pliki logów nie są tworzone).
+     */
+    None,
+
+    /**
+     * @brief Tylko podsumowanie (liczniki poprawnych i błędnych rekordów).
+     */
+    Summary,
+
+    /**
+     * @brief Błędne rekordy i podsumowanie.
+     */
+    Errors,
+
+    /**
+     * @brief Wszystkie rekordy (pełny log audytowy) i podsumowanie.
+     */
+    All
+};
+
+/**
+ * @brief Asynchroniczny logger wczytywania danych z buforem pierścieniowym bez blokad.
+ *
+ * Wątki parsujące (dowolna liczba) kopiują treść wpisu do wolnego miejsca w buforze pierścieniowym
+ * (kolejka ograniczona z numerami sekwencyjnymi miejsc - bez muteksów), a osobny wątek zapisujący
+ * zbiera wpisy w paczki i zapisuje je do plików dużymi blokami. Prefiksy wpisów ("Poprawny rekord: ")
+ * są dodawane dopiero w wątku zapisującym.
+ *
+ * Wpisy wyłączone przez poziom szczegółowości są odrzucane przed dotknięciem bufora, więc np. przy
+ * poziomie `LogLevel::Errors` zalogowanie poprawnego rekordu to jedno porównanie. Gdy bufor jest pełny,
+ * wątek parsujący czeka na zwolnienie miejsca - wpisy nie są gubione.
+ *
+ * Kolejność wpisów z jednego wątku jest zachowana; wpisy z różnych wątków mogą się przeplatać.
+ */
+class Logger {
+public:
+    /**
+     * @brief Otwiera pliki logów (jeśli poziom nie jest `LogLevel::None`) i uruchamia wątek zapisujący.
+     *
+     * @param dataFile Plik logu poprawnych rekordów i podsumowania.
+     * @param errorFile Plik logu błędnych rekordów.
+     * @param level Poziom szczegółowości.
+     * @param capacity Liczba miejsc w buforze pierścieniowym (zaokrąglana w górę do potęgi dwójki).
+     * @param append true - dopisywanie na końcu istniejących plików, false - zastąpienie ich zawartości.
+     */
+    Logger(const std::string& dataFile, const std::string& errorFile, LogLevel level, std::size_t capacity = 8192,
+           bool append = false);
+
+    /**
+     * @brief Zapisuje wszystkie oczekujące wpisy i zatrzymuje wątek zapisujący.
+     */
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /**
+     * @brief Zwraca poziom szczegółowości.
+     */
+    LogLevel level() const { return logLevel; }
+
+    /**
+     * @brief Informacja, czy poprawne rekordy trafiają do logu (poziom `LogLevel::All`).
+     */
+    bool logsValid() const { return logLevel >= LogLevel::All; }
+
+    /**
+     * @brief Informacja, czy błędne rekordy trafiają do logu (poziomy `LogLevel::Errors` i `LogLevel::All`).
+     */
+    bool logsInvalid() const { return logLevel >= LogLevel::Errors; }
+
+    /**
+     * @brief Loguje poprawny rekord (tylko na poziomie `LogLevel::All`).
+     *
+     * @param line Treść linii CSV.
+     * @param length Długość linii.
+     */
+    void validRecord(const char* line, std::size_t length) {
+        if (logsValid()) push(EntryKind::ValidRecord, line, length);
+    }
+
+    /**
+     * @brief Loguje błędny rekord (na poziomach `LogLevel::Errors` i `LogLevel::All`).
+     *
+     * @param line Treść linii CSV.
+     * @param length Długość linii.
+     */
+    void invalidRecord(const char* line, std::size_t length) {
+        if (logsInvalid()) push(EntryKind::InvalidRecord, line, length);
+    }
+
+    /**
+     * @brief Loguje błędny rekord z numerem linii i powodem odrzucenia (na poziomach `LogLevel::Errors` i `LogLevel::All`).
+     *
+     * Wpis ma postać `Błędny rekord (linia 12, ujemna moc): <linia>`.
+     *
+     * @param line Treść linii CSV.
+     * @param length Długość linii.
+     * @param lineNumber Numer linii w pliku (od 1).
+     * @param reason Opis powodu - napis stały, np. z `rejectReasonName`.
+     */
+    void invalidRecord(const char* line, std::size_t length, std::size_t lineNumber, const char* reason) {
+        if (logsInvalid()) push(EntryKind::InvalidRecord, line, length, lineNumber, reason);
+    }
+
+    /**
+     * @brief Loguje podsumowanie wczytywania (na wszystkich poziomach poza `LogLevel::None`).
+     *
+     * @param valid Liczba poprawnych rekordów.
+     * @param invalid Liczba błędnych rekordów.
+     */
+    void summary(int valid, int invalid);
+
+    /**
+     * @brief Czeka, aż wszystkie wpisy dodane przed wywołaniem zostaną zapisane do plików.
+     */
+    void flush();
+
+private:
+    /**
+     * @brief Rodzaj wpisu (wyznacza plik docelowy i prefiks).
+     */
+    enum class EntryKind : std::uint8_t { ValidRecord, InvalidRecord, DataMessage };
+
+    /**
+     * @brief Liczba znaków treści przechowywanych bezpośrednio w miejscu bufora.
+     *
+     * Dłuższe wpisy (rzadkie) są kopiowane do `Slot::overflow`.
+     */
+    static constexpr std::size_t inlineText = 104;
+
+    /**
+     * @brief Miejsce w buforze pierścieniowym.
+     *
+     * `sequence` wskazuje stan miejsca: równy pozycji zapisu - wolne, pozycja + 1 - zapełnione
+     * i gotowe do odczytu, pozycja + pojemność - zwolnione dla następnego okrążenia.
+     */
+    struct Slot {
+        std::atomic<std::size_t> sequence{ 0 };
+        EntryKind kind = EntryKind::DataMessage;
+        std::uint32_t length = 0;
+        std::size_t lineNumber = 0;
+        const char* reason = nullptr;
+        char text[inlineText];
+        std::string overflow;
+    };
+
+    /**
+     * @brief Dodaje wpis do bufora (wywoływane przez dowolny wątek).
+     */
+    void push(EntryKind kind, const char* text, std::size_t length, std::size_t lineNumber = 0,
+              const char* reason = nullptr);
+
+    /**
+     * @brief Budzi wątek zapisujący, jeśli czeka na nowe wpisy.
+     */
+    void wake();
+
+    /**
+     * @brief Pętla wątku zapisującego.
+     */
+    void run();
+
+    /**
+     * @brief Zapisuje zebrane paczki do plików.
+     */
+    void writeBatches();
+
+    /**
+     * @brief Poziom szczegółowości.
+     */
+    const LogLevel logLevel;
+
+    /**
+     * @brief Pliki logów.
+     */
+    std::ofstream dataLog, errorLog;
+
+    /**
+     * @brief Paczki wpisów oczekujące na zapis (używane tylko przez wątek zapisujący).
+     */
+    std::string dataBatch, errorBatch;
+
+    /**
+     * @brief Bufor pierścieniowy.
+     */
+    std::unique_ptr<Slot[]> slots;
+
+    /**
+     * @brief Maska pozycji (pojemność - 1).
+     */
+    std::size_t mask = 0;
+
+    /**
+     * @brief Następna pozycja zapisu (wspólna dla wątków parsujących).
+     */
+    alignas(64) std::atomic<std::size_t> tail{ 0 };
+
+    /**
+     * @brief Następna pozycja odczytu (tylko wątek zapisujący).
+     */
+    alignas(64) std::size_t head = 0;
+
+    /**
+     * @brief Liczba wpisów zapisanych do plików (dla `flush`).
+     */
+    std::atomic<std::size_t> written{ 0 };
+
+    /**
+     * @brief Informacja, czy wątek zapisujący czeka na nowe wpisy.
+     */
+    std::atomic<bool> writerWaiting{ false };
+
+    /**
+     * @brief Żądanie zakończenia wątku zapisującego.
+     */
+    std::atomic<bool> stopping{ false };
+
+    /**
+     * @brief Synchronizacja usypiania wątku zapisującego i oczekiwania w `flush`.
+     */
+    std::mutex mutex;
+    std::condition_variable wakeWriter, writtenChanged;
+
+    /**
+     * @brief Wątek zapisujący.
+     */
+    std::thread writer;
+};
+
+#endif // LOGGER_H
@@ -0,0 +1,134 @@
+#include "MappedFile.h"
+#include "Metrics.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Otwiera plik i mapuje go w całości do pamięci tylko do odczytu.
+ *
+ * W przypadku błędu (brak pliku, brak uprawnień, błąd mapowania) wszystkie uchwyty
+ * są zamykane, a obiekt pozostaje w stanie `isOpen() == false`.
+ *
+ * Na systemach POSIX dodatkowo zgłaszana jest wskazówka `MADV_SEQUENTIAL` (plik CSV jest
+ * czytany od początku do końca) lub `MADV_RANDOM` (snapshot, z którego zapytania czytają
+ * tylko potrzebne dni i bloki).
+ *
+ * @param fileName Nazwa pliku do zmapowania.
+ * @param sequential Sposób dostępu do pliku.
+ */
+MappedFile::MappedFile(const std::string& fileName, bool sequential) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return;
+    }
+
+    fileHandle = file;
+    length = static_cast<std::size_t>(fileSize.QuadPart);
+    if (length == 0) {
+        // Pustego pliku nie da się zmapować, ale jest on poprawnym (pustym) wejściem
+        opened = true;
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        CloseHandle(file);
+        fileHandle = nullptr;
+        length = 0;
+        return;
+    }
+    mappingHandle = mapping;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+        length = 0;
+        return;
+    }
+    begin = static_cast<const char*>(view);
+    opened = true;
+    Metrics::addMemory(MemoryPool::Mapped, static_cast<std::int64_t>(length));
+#else
+    fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) return;
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+
+    length = static_cast<std::size_t>(st.st_size);
+    if (length == 0) {
+        // Pustego pliku nie da się zmapować, ale jest on poprawnym (pustym) wejściem
+        opened = true;
+        return;
+    }
+
+    void* view = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view == MAP_FAILED) {
+        ::close(fd);
+        fd = -1;
+        length = 0;
+        return;
+    }
+    ::madvise(view, length, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+    begin = static_cast<const char*>(view);
+    opened = true;
+    Metrics::addMemory(MemoryPool::Mapped, static_cast<std::int64_t>(length));
+#endif
+}
+
+/**
+ * @brief Odmapowuje plik i zamyka wszystkie uchwyty systemowe.
+ */
+MappedFile::~MappedFile() {
+    if (begin != nullptr) Metrics::addMemory(MemoryPool::Mapped, -static_cast<std::int64_t>(length));
+#ifdef _WIN32
+    if (begin != nullptr) UnmapViewOfFile(begin);
+    if (mappingHandle != nullptr) CloseHandle(mappingHandle);
+    if (fileHandle != nullptr) CloseHandle(fileHandle);
+#else
+    if (begin != nullptr) ::munmap(const_cast<char*>(begin), length);
+    if (fd >= 0) ::close(fd);
+#endif
+}
+
+/**
+ * @brief Zwalnia strony pamięci w całości zawarte we fragmencie pliku.
+ *
+ * @param offset Początek fragmentu.
+ * @param bytes Długość fragmentu.
+ */
+void MappedFile::discard(std::size_t offset, std::size_t bytes) const {
+#ifndef _WIN32
+    if (begin == nullptr || offset >= length) return;
+    const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::size_t end = offset + bytes < length ? offset + bytes : length;
+    // Granice zaokrąglane do wnętrza fragmentu
+    const std::size_t first = (offset + page - 1) / page * page;
+    const std::size_t last = end == length ? end : end / page * page;
+    if (first >= last) return;
+    ::madvise(const_cast<char*>(begin) + first, last - first, MADV_DONTNEED);
+#else
+    (void)offset;
+    (void)bytes;
+#endif
+}
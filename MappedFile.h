@@ -0,0 +1,106 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+/**
+ * @brief Klasa odwzorowująca plik w pamięci (memory-mapped file) tylko do odczytu.
+ *
+ * Plik jest mapowany w całości przy konstrukcji obiektu i odmapowywany w destruktorze.
+ * Zawartość jest dostępna bezpośrednio przez wskaźnik `data()`, bez kopiowania do buforów
+ * pośrednich, co pozwala parsować duże pliki CSV bez alokacji na każdą linię.
+ *
+ * Na systemach POSIX wykorzystywane jest `mmap`, a na Windows `CreateFileMapping`/`MapViewOfFile`.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Otwiera i mapuje plik o podanej nazwie.
+     *
+     * Jeśli pliku nie da się otworzyć lub zmapować, obiekt pozostaje pusty,
+     * a `isOpen()` zwraca `false`.
+     *
+     * @param fileName Nazwa pliku do zmapowania.
+     * @param sequential true - plik będzie czytany od początku do końca (np. CSV),
+     *        false - dostęp do wybranych fragmentów (np. snapshot), bez czytania z wyprzedzeniem.
+     */
+    explicit MappedFile(const std::string& fileName, bool sequential = true);
+
+    /**
+     * @brief Odmapowuje plik i zwalnia uchwyty systemowe.
+     */
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Sprawdza, czy plik został poprawnie otwarty i zmapowany.
+     *
+     * Pusty plik (rozmiar 0) jest traktowany jako poprawnie otwarty.
+     *
+     * @return true, jeśli plik jest dostępny, false w przeciwnym razie.
+     */
+    bool isOpen() const { return opened; }
+
+    /**
+     * @brief Zwraca wskaźnik na początek zmapowanej zawartości pliku.
+     *
+     * @return const char* Wskaźnik na pierwszy bajt pliku (nullptr dla pustego pliku).
+     */
+    const char* data() const { return begin; }
+
+    /**
+     * @brief Zwraca rozmiar zmapowanego pliku w bajtach.
+     *
+     * @return std::size_t Rozmiar pliku.
+     */
+    std::size_t size() const { return length; }
+
+    /**
+     * @brief Zwalnia strony pamięci fragmentu pliku (przy następnym odczycie zostaną wczytane ponownie).
+     *
+     * Zwalniane są tylko strony w całości zawarte we fragmencie, więc sąsiednie fragmenty
+     * pozostają w pamięci. Na Windows strony zwalnia system, a funkcja nic nie robi.
+     *
+     * @param offset Początek fragmentu w bajtach od początku pliku.
+     * @param bytes Długość fragmentu w bajtach.
+     */
+    void discard(std::size_t offset, std::size_t bytes) const;
+
+private:
+    /**
+     * @brief Wskaźnik na początek zmapowanego obszaru.
+     */
+    const char* begin = nullptr;
+
+    /**
+     * @brief Rozmiar zmapowanego obszaru w bajtach.
+     */
+    std::size_t length = 0;
+
+    /**
+     * @brief Informacja, czy plik został poprawnie otwarty.
+     */
+    bool opened = false;
+
+#ifdef _WIN32
+    /**
+     * @brief Uchwyt pliku (HANDLE) w systemie Windows.
+     */
+    void* fileHandle = nullptr;
+
+    /**
+     * @brief Uchwyt obiektu mapowania (HANDLE) w systemie Windows.
+     */
+    void* mappingHandle = nullptr;
+#else
+    /**
+     * @brief Deskryptor pliku w systemach POSIX.
+     */
+    int fd = -1;
+#endif
+};
+
+#endif // MAPPEDFILE_H
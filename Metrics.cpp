@@ -0,0 +1,286 @@
+#include "Metrics.h"
+
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+/**
+ * @brief Liczniki jednego etapu (osobna linia pamięci podręcznej dla każdego etapu).
+ */
+struct alignas(64) Stage {
+    std::atomic<std::uint64_t> items{ 0 };
+    std::atomic<std::uint64_t> samples{ 0 };
+    std::atomic<std::uint64_t> nanoseconds{ 0 };
+    // Ostatni przedział zbiera czasy dłuższe niż granica przedostatniego
+    std::atomic<std::uint64_t> buckets[Metrics::bucketCount + 1] = {};
+};
+
+Stage stages[static_cast<int>(Metric::Count)];
+std::atomic<std::int64_t> pools[static_cast<int>(MemoryPool::Count)];
+const std::chrono::steady_clock::time_point processStart = std::chrono::steady_clock::now();
+
+const char* const stageNames[] = { "parse", "tree_insert", "logging", "log_write",
+                                   "load_csv", "aggregate", "search", "binary_io", "validate" };
+const char* const poolNames[] = { "tree", "mapped", "logger", "snapshot_cache" };
+static_assert(sizeof(stageNames) / sizeof(stageNames[0]) == static_cast<int>(Metric::Count));
+static_assert(sizeof(poolNames) / sizeof(poolNames[0]) == static_cast<int>(MemoryPool::Count));
+
+/**
+ * @brief Górna granica przedziału histogramu w nanosekundach.
+ */
+std::uint64_t bucketBound(int bucket) {
+    return std::uint64_t{ 64 } << bucket;
+}
+
+/**
+ * @brief Szacuje percentyl czasu etapu jako górną granicę przedziału, w którym wypada.
+ */
+std::uint64_t percentile(const Stage& stage, double fraction) {
+    const std::uint64_t total = stage.samples.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+    std::uint64_t seen = 0;
+    for (int b = 0; b < Metrics::bucketCount; ++b) {
+        seen += stage.buckets[b].load(std::memory_order_relaxed);
+        if (static_cast<double>(seen) >= fraction * static_cast<double>(total)) return bucketBound(b);
+    }
+    return bucketBound(Metrics::bucketCount - 1);
+}
+
+/**
+ * @brief Zwraca szczytową pamięć rezydentną procesu w bajtach (0, jeśli niedostępna).
+ */
+std::uint64_t peakResidentBytes() {
+#ifndef _WIN32
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+    return 0;
+}
+
+/**
+ * @brief Zwraca czas od uruchomienia procesu w sekundach.
+ */
+double uptimeSeconds() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - processStart).count();
+}
+
+} // namespace
+
+#if METRICS_ENABLED
+/**
+ * @brief Dodaje przetworzone elementy etapu.
+ *
+ * @param metric Etap.
+ * @param items Liczba elementów.
+ */
+void Metrics::add(Metric metric, std::uint64_t items) {
+    stages[static_cast<int>(metric)].items.fetch_add(items, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Dodaje próbkę czasu etapu do histogramu.
+ *
+ * @param metric Etap.
+ * @param duration Zmierzony czas.
+ */
+void Metrics::record(Metric metric, std::chrono::nanoseconds duration) {
+    Stage& stage = stages[static_cast<int>(metric)];
+    const std::uint64_t nanoseconds = duration.count() > 0 ? static_cast<std::uint64_t>(duration.count()) : 0;
+    int bucket = 0;
+    while (bucket < bucketCount && nanoseconds > bucketBound(bucket)) ++bucket;
+    stage.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    stage.samples.fetch_add(1, std::memory_order_relaxed);
+    stage.nanoseconds.fetch_add(nanoseconds, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Zmienia zajętość obszaru pamięci.
+ *
+ * @param pool Obszar pamięci.
+ * @param bytes Zmiana w bajtach (ujemna - zwolnienie).
+ */
+void Metrics::addMemory(MemoryPool pool, std::int64_t bytes) {
+    pools[static_cast<int>(pool)].fetch_add(bytes, std::memory_order_relaxed);
+}
+#endif
+
+/**
+ * @brief Zeruje liczniki i histogramy etapów.
+ */
+void Metrics::reset() {
+    for (Stage& stage : stages) {
+        stage.items.store(0, std::memory_order_relaxed);
+        stage.samples.store(0, std::memory_order_relaxed);
+        stage.nanoseconds.store(0, std::memory_order_relaxed);
+        for (std::atomic<std::uint64_t>& bucket : stage.buckets) bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Zwraca liczbę elementów etapu.
+ */
+std::uint64_t Metrics::items(Metric metric) {
+    return stages[static_cast<int>(metric)].items.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Zwraca liczbę próbek czasu etapu.
+ */
+std::uint64_t Metrics::samples(Metric metric) {
+    return stages[static_cast<int>(metric)].samples.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Zwraca bieżącą zajętość obszaru pamięci.
+ */
+std::int64_t Metrics::memory(MemoryPool pool) {
+    return pools[static_cast<int>(pool)].load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Zwraca stan w formacie tekstowym Prometheus.
+ *
+ * Czasy etapów są histogramami (`pv_stage_duration_seconds`), elementy - licznikami
+ * (`pv_stage_items_total`); przepustowość to np. `rate(pv_stage_items_total[1m])`.
+ *
+ * @return std::string Raport.
+ */
+std::string Metrics::prometheus() {
+    std::ostringstream out;
+    out << "# HELP pv_stage_items_total Przetworzone elementy etapu (linie, rekordy, bajty).\n"
+           "# TYPE pv_stage_items_total counter\n";
+    for (int s = 0; s < static_cast<int>(Metric::Count); ++s)
+        out << "pv_stage_items_total{stage=\"" << stageNames[s] << "\"} " << stages[s].items.load() << "\n";
+
+    out << "# HELP pv_stage_duration_seconds Czasy etapu (dla etapów liniowych - próbka co "
+        << sampleInterval << " linii).\n# TYPE pv_stage_duration_seconds histogram\n";
+    for (int s = 0; s < static_cast<int>(Metric::Count); ++s) {
+        const Stage& stage = stages[s];
+        std::uint64_t cumulative = 0;
+        for (int b = 0; b < bucketCount; ++b) {
+            cumulative += stage.buckets[b].load();
+            out << "pv_stage_duration_seconds_bucket{stage=\"" << stageNames[s] << "\",le=\""
+                << static_cast<double>(bucketBound(b)) * 1e-9 << "\"} " << cumulative << "\n";
+        }
+        out << "pv_stage_duration_seconds_bucket{stage=\"" << stageNames[s] << "\",le=\"+Inf\"} "
+            << stage.samples.load() << "\n";
+        out << "pv_stage_duration_seconds_sum{stage=\"" << stageNames[s] << "\"} "
+            << static_cast<double>(stage.nanoseconds.load()) * 1e-9 << "\n";
+        out << "pv_stage_duration_seconds_count{stage=\"" << stageNames[s] << "\"} " << stage.samples.load() << "\n";
+    }
+
+    out << "# HELP pv_memory_bytes Zajętość pamięci podsystemu.\n# TYPE pv_memory_bytes gauge\n";
+    for (int p = 0; p < static_cast<int>(MemoryPool::Count); ++p)
+        out << "pv_memory_bytes{pool=\"" << poolNames[p] << "\"} " << pools[p].load() << "\n";
+    out << "# HELP pv_process_peak_rss_bytes Szczytowa pamięć rezydentna procesu.\n"
+           "# TYPE pv_process_peak_rss_bytes gauge\npv_process_peak_rss_bytes "
+        << peakResidentBytes() << "\n";
+    out << "# HELP pv_uptime_seconds Czas od uruchomienia procesu.\n# TYPE pv_uptime_seconds gauge\n"
+           "pv_uptime_seconds "
+        << uptimeSeconds() << "\n";
+    return out.str();
+}
+
+/**
+ * @brief Zwraca stan jako obiekt JSON.
+ *
+ * Dla każdego etapu: elementy, liczba próbek, suma czasów próbek, średni czas próbki
+ * oraz percentyle 50 i 99 (górne granice przedziałów histogramu).
+ *
+ * @return std::string Raport.
+ */
+std::string Metrics::json() {
+    std::ostringstream out;
+    out << "{\"enabled\":" << (enabled ? "true" : "false") << ",\"uptime_seconds\":" << uptimeSeconds()
+        << ",\"sample_interval\":" << sampleInterval << ",\"stages\":{";
+    for (int s = 0; s < static_cast<int>(Metric::Count); ++s) {
+        const Stage& stage = stages[s];
+        const std::uint64_t samples = stage.samples.load();
+        const std::uint64_t nanoseconds = stage.nanoseconds.load();
+        out << (s > 0 ? "," : "") << "\"" << stageNames[s] << "\":{\"items\":" << stage.items.load()
+            << ",\"samples\":" << samples << ",\"seconds\":" << static_cast<double>(nanoseconds) * 1e-9
+            << ",\"mean_ns\":" << (samples > 0 ? nanoseconds / samples : 0) << ",\"p50_ns\":" << percentile(stage, 0.5)
+            << ",\"p99_ns\":" << percentile(stage, 0.99) << "}";
+    }
+    out << "},\"memory_bytes\":{";
+    for (int p = 0; p < static_cast<int>(MemoryPool::Count); ++p)
+        out << (p > 0 ? "," : "") << "\"" << poolNames[p] << "\":" << pools[p].load();
+    out << "},\"peak_rss_bytes\":" << peakResidentBytes() << "}\n";
+    return out.str();
+}
+
+/**
+ * @brief Zapisuje stan do pliku (przez plik tymczasowy podmieniany po zapisie).
+ *
+ * @param fileName Nazwa pliku.
+ * @param error Opis błędu zapisu.
+ * @return true, jeśli plik został zapisany.
+ */
+bool Metrics::dump(const std::string& fileName, std::string& error) {
+    const bool asJson = fileName.size() >= 5 && fileName.compare(fileName.size() - 5, 5, ".json") == 0;
+    const std::string temporary = fileName + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        file << (asJson ? json() : prometheus());
+        if (!file) {
+            error = "Nie można zapisać pliku metryk: " + temporary;
+            return false;
+        }
+    }
+    // Na Windows rename nie zastępuje istniejącego pliku
+    std::remove(fileName.c_str());
+    if (std::rename(temporary.c_str(), fileName.c_str()) != 0) {
+        error = "Nie można zapisać pliku metryk: " + fileName;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Uruchamia wątek zapisujący raporty.
+ *
+ * @param fileName Nazwa pliku raportu.
+ * @param intervalMs Odstęp między raportami w milisekundach.
+ */
+MetricsReporter::MetricsReporter(const std::string& fileName, int intervalMs)
+    : fileName(fileName), interval(intervalMs > 0 ? intervalMs : 1000) {
+    writer = std::thread(&MetricsReporter::run, this);
+}
+
+/**
+ * @brief Zatrzymuje wątek i zapisuje raport końcowy.
+ */
+MetricsReporter::~MetricsReporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_one();
+    writer.join();
+}
+
+/**
+ * @brief Pętla wątku: raport co `interval` i raport końcowy po żądaniu zakończenia.
+ */
+void MetricsReporter::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    bool reported = false;
+    while (true) {
+        const bool stop = wakeup.wait_for(lock, interval, [this] { return stopping; });
+        std::string error;
+        if (!Metrics::dump(fileName, error) && !reported) {
+            // Błąd jest zgłaszany raz, a nie przy każdej próbie
+            std::cerr << error << std::endl;
+            reported = true;
+        }
+        if (stop) return;
+    }
+}
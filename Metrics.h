@@ -0,0 +1,311 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Przełącznik kompilacji: -DMETRICS_ENABLED=0 zamienia liczniki i stopery w puste funkcje inline
+#ifndef METRICS_ENABLED
+#define METRICS_ENABLED 1
+#endif
+
+/**
+ * @brief Etap przetwarzania mierzony przez `Metrics`.
+ */
+enum class Metric {
+    /**
+     * @brief Parsowanie linii CSV (`Program::parseLine`), czas na linię.
+     */
+    Parse,
+
+    /**
+     * @brief Dodanie rekordu do drzewa (`Tree::addRecord`), czas na rekord.
+     */
+    TreeInsert,
+
+    /**
+     * @brief Przekazanie rekordu do loggera w wątku parsującym, czas na rekord (elementy - wpisy
+     * dodane do bufora; rekordy wyłączone przez poziom logowania nie są liczone).
+     */
+    Logging,
+
+    /**
+     * @brief Zapis paczki logów do plików w wątku zapisującym, czas na paczkę (elementy - bajty).
+     */
+    LogWrite,
+
+    /**
+     * @brief Wczytanie całego pliku CSV (`Program::loadCSV`), elementy - linie.
+     */
+    LoadCSV,
+
+    /**
+     * @brief Zapytanie agregujące (suma, liczba, min i max w przedziale), czas na zapytanie.
+     */
+    Aggregate,
+
+    /**
+     * @brief Wyszukiwanie rekordów (`Program::findRecords`), elementy - znalezione rekordy.
+     */
+    Search,
+
+    /**
+     * @brief Zapis i wczytanie pliku binarnego, elementy - rekordy.
+     */
+    BinaryIO,
+
+    /**
+     * @brief Sprawdzanie paczki wierszy CSV (`RowValidator::validate`), czas na paczkę (elementy - wiersze).
+     */
+    Validate,
+
+    /**
+     * @brief Liczba etapów.
+     */
+    Count
+};
+
+/**
+ * @brief Obszar pamięci raportowany przez `Metrics`.
+ */
+enum class MemoryPool {
+    /**
+     * @brief Bloki aren drzew (`Arena`).
+     */
+    Tree,
+
+    /**
+     * @brief Zmapowane pliki (`MappedFile`: wczytywane CSV i snapshoty).
+     */
+    Mapped,
+
+    /**
+     * @brief Bufory pierścieniowe loggerów.
+     */
+    Logger,
+
+    /**
+     * @brief Pamięć podręczna snapshotów (`SnapshotCache`): zdekodowane bloki oraz odczytane
+     *        miesiące zmapowanych kolumn (te ostatnie są częścią `Mapped`).
+     */
+    SnapshotCache,
+
+    /**
+     * @brief Liczba obszarów.
+     */
+    Count
+};
+
+/**
+ * @brief Liczniki i histogramy czasów etapów oraz zajętość pamięci, wspólne dla całego procesu.
+ *
+ * Dla każdego etapu zliczane są przetworzone elementy (np. linie, rekordy, bajty) oraz próbki
+ * czasu w histogramie o przedziałach wykładniczych (64 ns, 128 ns, ... ok. 0,5 s). Etapy
+ * wykonywane dla każdej linii pliku (`Parse`, `TreeInsert`, `Logging`) są mierzone tylko
+ * dla co `sampleInterval`-tej linii, a elementy są dodawane raz na fragment pliku, więc koszt
+ * pomiaru w pętli parsowania to jedno porównanie na linię.
+ *
+ * Stan jest odczytywany jako tekst w formacie Prometheus (`prometheus`) lub JSON (`json`),
+ * np. okresowo przez `MetricsReporter`. Po kompilacji z `METRICS_ENABLED=0` wszystkie funkcje
+ * zapisujące są puste, a raporty zawierają same zera.
+ */
+class Metrics {
+public:
+    /**
+     * @brief Informacja, czy pomiary są wkompilowane.
+     */
+    static constexpr bool enabled = METRICS_ENABLED != 0;
+
+    /**
+     * @brief Co która linia pliku jest mierzona w etapach wykonywanych dla każdej linii (potęga dwójki).
+     */
+    static constexpr std::uint64_t sampleInterval = 64;
+
+    /**
+     * @brief Liczba przedziałów histogramu (przedział `i` obejmuje czasy do `64 << i` ns).
+     */
+    static constexpr int bucketCount = 24;
+
+    /**
+     * @brief Informacja, czy linia o danym numerze jest mierzona (`sampleInterval`).
+     *
+     * @param line Numer linii we fragmencie pliku.
+     */
+    static bool sampled(std::uint64_t line) { return enabled && (line & (sampleInterval - 1)) == 0; }
+
+#if METRICS_ENABLED
+    /**
+     * @brief Dodaje przetworzone elementy etapu.
+     */
+    static void add(Metric metric, std::uint64_t items);
+
+    /**
+     * @brief Dodaje próbkę czasu etapu do histogramu.
+     */
+    static void record(Metric metric, std::chrono::nanoseconds duration);
+
+    /**
+     * @brief Zmienia zajętość obszaru pamięci o `bytes` (ujemne - zwolnienie).
+     */
+    static void addMemory(MemoryPool pool, std::int64_t bytes);
+#else
+    static void add(Metric, std::uint64_t) {}
+    static void record(Metric, std::chrono::nanoseconds) {}
+    static void addMemory(MemoryPool, std::int64_t) {}
+#endif
+
+    /**
+     * @brief Zeruje liczniki i histogramy (zajętość pamięci pozostaje bez zmian).
+     */
+    static void reset();
+
+    /**
+     * @brief Zwraca liczbę elementów etapu.
+     */
+    static std::uint64_t items(Metric metric);
+
+    /**
+     * @brief Zwraca liczbę próbek czasu etapu.
+     */
+    static std::uint64_t samples(Metric metric);
+
+    /**
+     * @brief Zwraca bieżącą zajętość obszaru pamięci w bajtach.
+     */
+    static std::int64_t memory(MemoryPool pool);
+
+    /**
+     * @brief Zwraca stan w formacie tekstowym Prometheus (np. dla kolektora plików node_exporter).
+     */
+    static std::string prometheus();
+
+    /**
+     * @brief Zwraca stan jako obiekt JSON (z średnią i percentylami 50/99 szacowanymi z histogramów).
+     */
+    static std::string json();
+
+    /**
+     * @brief Zapisuje stan do pliku: JSON dla rozszerzenia `.json`, w pozostałych przypadkach Prometheus.
+     *
+     * Plik jest zapisywany pod nazwą tymczasową i podmieniany, więc czytelnik nie widzi niepełnego raportu.
+     *
+     * @param fileName Nazwa pliku.
+     * @param error Opis błędu zapisu.
+     * @return true, jeśli plik został zapisany.
+     */
+    static bool dump(const std::string& fileName, std::string& error);
+};
+
+/**
+ * @brief Mierzy czas od utworzenia do zniszczenia obiektu i dodaje go jako próbkę etapu.
+ *
+ * Nieaktywny stoper (`active == false`, np. linia spoza próbki) nie odczytuje zegara.
+ */
+class ScopedTimer {
+public:
+#if METRICS_ENABLED
+    /**
+     * @brief Rozpoczyna pomiar.
+     *
+     * @param metric Mierzony etap.
+     * @param active false - stoper nic nie mierzy.
+     */
+    explicit ScopedTimer(Metric metric, bool active = true)
+        : metric(metric), active(active),
+          start(active ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()) {}
+
+    /**
+     * @brief Kończy pomiar i zapisuje próbkę.
+     */
+    ~ScopedTimer() {
+        if (active) Metrics::record(metric, std::chrono::steady_clock::now() - start);
+    }
+#else
+    explicit ScopedTimer(Metric, bool = true) {}
+#endif
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+#if METRICS_ENABLED
+private:
+    /**
+     * @brief Mierzony etap.
+     */
+    const Metric metric;
+
+    /**
+     * @brief Informacja, czy stoper mierzy czas.
+     */
+    const bool active;
+
+    /**
+     * @brief Początek pomiaru.
+     */
+    const std::chrono::steady_clock::time_point start;
+#endif
+};
+
+/**
+ * @brief Okresowo zapisuje stan `Metrics` do pliku (wątek w tle).
+ *
+ * Raport jest zapisywany co `intervalMs` oraz ostatni raz w destruktorze, więc po zakończeniu
+ * programu plik zawiera stan końcowy. Format zależy od rozszerzenia pliku (patrz `Metrics::dump`).
+ */
+class MetricsReporter {
+public:
+    /**
+     * @brief Uruchamia wątek zapisujący raporty.
+     *
+     * @param fileName Nazwa pliku raportu.
+     * @param intervalMs Odstęp między raportami w milisekundach.
+     */
+    explicit MetricsReporter(const std::string& fileName, int intervalMs = 1000);
+
+    /**
+     * @brief Zatrzymuje wątek i zapisuje raport końcowy.
+     */
+    ~MetricsReporter();
+
+    MetricsReporter(const MetricsReporter&) = delete;
+    MetricsReporter& operator=(const MetricsReporter&) = delete;
+
+private:
+    /**
+     * @brief Pętla wątku zapisującego.
+     */
+    void run();
+
+    /**
+     * @brief Nazwa pliku raportu.
+     */
+    const std::string fileName;
+
+    /**
+     * @brief Odstęp między raportami.
+     */
+    const std::chrono::milliseconds interval;
+
+    /**
+     * @brief Synchronizacja zatrzymania wątku.
+     */
+    std::mutex mutex;
+    std::condition_variable wakeup;
+
+    /**
+     * @brief Żądanie zakończenia wątku.
+     */
+    bool stopping = false;
+
+    /**
+     * @brief Wątek zapisujący.
+     */
+    std::thread writer;
+};
+
+#endif // METRICS_H
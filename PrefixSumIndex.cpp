@@ -0,0 +1,192 @@
+#include "PrefixSumIndex.h"
+#include "Snapshot.h"
+#include "Tree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+/**
+ * @brief Buduje indeks na podstawie wszystkich rekordów snapshotu i drzewa.
+ *
+ * Rekordy są zbierane najpierw ze snapshotu (posortowane), a następnie w kolejności przechodzenia
+ * drzewa (chronologicznej). Jeśli całość nie jest posortowana (np. drzewo zawiera dane starsze
+ * niż snapshot), rekordy są dodatkowo stabilnie sortowane według czasu.
+ *
+ * @param tree Drzewo z danymi.
+ * @param snapshot Wczytany snapshot (lub nullptr).
+ */
+void PrefixSumIndex::build(const Tree& tree, const Snapshot* snapshot) {
+    clear();
+    std::vector<double> values[Record::fieldCount];
+    if (snapshot != nullptr) snapshot->copyTo(timestamps, values);
+    for (const auto& [yearKey, year] : tree.years)
+        for (const auto& [monthKey, month] : year.months)
+            for (const auto& [dayKey, day] : month.days)
+                for (const auto& [quarterKey, quarter] : day.quarters) {
+                    timestamps.insert(timestamps.end(), quarter.timestamps.begin(), quarter.timestamps.end());
+                    for (int f = 0; f < Record::fieldCount; ++f) {
+                        const std::pmr::vector<double>& column = quarter.column(f);
+                        values[f].insert(values[f].end(), column.begin(), column.end());
+                    }
+                }
+
+    // Stabilne sortowanie według czasu, jeśli zebrane rekordy nie są chronologiczne
+    std::vector<std::size_t> order;
+    if (!std::is_sorted(timestamps.begin(), timestamps.end())) {
+        order.resize(timestamps.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [this](std::size_t a, std::size_t b) { return timestamps[a] < timestamps[b]; });
+        std::vector<std::int32_t> sorted(order.size());
+        for (std::size_t i = 0; i < order.size(); ++i) sorted[i] = timestamps[order[i]];
+        timestamps.swap(sorted);
+    }
+
+    for (int f = 0; f < Record::fieldCount; ++f) {
+        std::vector<CompensatedSum>& sums = prefix[f];
+        sums.resize(timestamps.size() + 1);
+        CompensatedSum running;
+        for (std::size_t i = 0; i < timestamps.size(); ++i) {
+            compensatedAdd(running.sum, running.compensation, values[f][order.empty() ? i : order[i]]);
+            sums[i + 1] = running;
+        }
+    }
+}
+
+/**
+ * @brief Dopisuje pomiar do indeksu.
+ *
+ * @param timestamp Znacznik czasu pomiaru.
+ * @param record Rekord z wartościami pomiarowymi.
+ */
+void PrefixSumIndex::append(std::int32_t timestamp, const Record& record) {
+    if (timestamps.empty() || timestamps.back() <= timestamp) {
+        // Typowy przypadek: nowy pomiar na końcu - jedna nowa suma prefiksowa na wielkość
+        timestamps.push_back(timestamp);
+        for (int f = 0; f < Record::fieldCount; ++f) {
+            if (prefix[f].empty()) prefix[f].push_back(CompensatedSum());
+            CompensatedSum next = prefix[f].back();
+            compensatedAdd(next.sum, next.compensation, record.field(f));
+            prefix[f].push_back(next);
+        }
+        return;
+    }
+
+    // Pomiar spoza kolejności - wstawienie i doliczenie wartości do wszystkich późniejszych sum
+    const std::size_t index = static_cast<std::size_t>(
+        std::upper_bound(timestamps.begin(), timestamps.end(), timestamp) - timestamps.begin());
+    timestamps.insert(timestamps.begin() + static_cast<std::ptrdiff_t>(index), timestamp);
+    for (int f = 0; f < Record::fieldCount; ++f) {
+        std::vector<CompensatedSum>& sums = prefix[f];
+        const double value = record.field(f);
+        sums.insert(sums.begin() + static_cast<std::ptrdiff_t>(index) + 1, sums[index]);
+        for (std::size_t i = index + 1; i < sums.size(); ++i) {
+            compensatedAdd(sums[i].sum, sums[i].compensation, value);
+        }
+    }
+}
+
+/**
+ * @brief Usuwa zawartość indeksu.
+ */
+void PrefixSumIndex::clear() {
+    timestamps.clear();
+    for (int f = 0; f < Record::fieldCount; ++f) prefix[f].clear();
+}
+
+/**
+ * @brief Wyznacza przedział indeksów pomiarów z zakresu `[from, to]`.
+ *
+ * @param from Początek zakresu (włącznie).
+ * @param to Koniec zakresu (włącznie).
+ * @param first Wyjściowy indeks pierwszego pomiaru w zakresie.
+ * @param last Wyjściowy indeks za ostatnim pomiarem w zakresie.
+ */
+void PrefixSumIndex::bounds(std::int32_t from, std::int32_t to, std::size_t& first, std::size_t& last) const {
+    if (to < from) {
+        first = last = 0;
+        return;
+    }
+    const auto begin = std::lower_bound(timestamps.begin(), timestamps.end(), from);
+    const auto end = std::upper_bound(begin, timestamps.end(), to);
+    first = static_cast<std::size_t>(begin - timestamps.begin());
+    last = static_cast<std::size_t>(end - timestamps.begin());
+}
+
+/**
+ * @brief Zwraca liczbę pomiarów w przedziale `[from, to]`.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @return std::size_t Liczba pomiarów.
+ */
+std::size_t PrefixSumIndex::count(std::int32_t from, std::int32_t to) const {
+    std::size_t first = 0, last = 0;
+    bounds(from, to, first, last);
+    return last - first;
+}
+
+/**
+ * @brief Zwraca sumę wielkości `field` pomiarów o indeksach `[first, last)`.
+ *
+ * Wynik to różnica dwóch skompensowanych sum prefiksowych: `(S[last] - S[first]) + (C[last] - C[first])`.
+ *
+ * @param first Indeks pierwszego pomiaru.
+ * @param last Indeks za ostatnim pomiarem.
+ * @param field Indeks wielkości.
+ * @return double Suma wartości.
+ */
+double PrefixSumIndex::sumBetween(std::size_t first, std::size_t last, int field) const {
+    if (first == last) return 0.0;
+    const CompensatedSum& a = prefix[field][first];
+    const CompensatedSum& b = prefix[field][last];
+    return (b.sum - a.sum) + (b.compensation - a.compensation);
+}
+
+/**
+ * @brief Zwraca sumę wybranej wielkości w przedziale `[from, to]`.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @return double Suma wartości.
+ */
+double PrefixSumIndex::sum(std::int32_t from, std::int32_t to, int field) const {
+    if (field < 0 || field >= Record::fieldCount) return 0.0;
+    std::size_t first = 0, last = 0;
+    bounds(from, to, first, last);
+    return sumBetween(first, last, field);
+}
+
+/**
+ * @brief Dodaje wartość do sumy z kompensacją (wariant Neumaiera algorytmu Kahana).
+ *
+ * @param sum Suma (zwiększana).
+ * @param compensation Poprawka sumy (zwiększana o utracone zaokrągleniem bity).
+ * @param value Dodawana wartość.
+ */
+void PrefixSumIndex::compensatedAdd(double& sum, double& compensation, double value) {
+    const double total = sum + value;
+    if (std::fabs(sum) >= std::fabs(value)) {
+        compensation += (sum - total) + value;
+    } else {
+        compensation += (value - total) + sum;
+    }
+    sum = total;
+}
+
+/**
+ * @brief Zwraca średnią wybranej wielkości w przedziale `[from, to]`.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @return double Średnia wartość (0 dla pustego przedziału).
+ */
+double PrefixSumIndex::average(std::int32_t from, std::int32_t to, int field) const {
+    if (field < 0 || field >= Record::fieldCount) return 0.0;
+    std::size_t first = 0, last = 0;
+    bounds(from, to, first, last);
+    return first == last ? 0.0 : sumBetween(first, last, field) / static_cast<double>(last - first);
+}
@@ -0,0 +1,112 @@
+#ifndef PREFIXSUMINDEX_H
+#define PREFIXSUMINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Record.h"
+
+class Snapshot;
+class Tree;
+
+/**
+ * @brief Indeks sum prefiksowych do odpowiadania na zapytania o sumę w stałym czasie.
+ *
+ * Dla posortowanej chronologicznie sekwencji rekordów indeks przechowuje, dla każdej wielkości
+ * pomiarowej, sumę wszystkich wartości przed danym rekordem. Suma w dowolnym przedziale
+ * `[from, to]` to różnica dwóch sum prefiksowych, a pozycje obu krańców wyznacza wyszukiwanie
+ * binarne - koszt zapytania nie zależy od długości przedziału.
+ *
+ * Sumy prefiksowe są liczone z kompensacją błędu (algorytm Kahana-Neumaiera): obok sumy
+ * przechowywana jest poprawka, dzięki czemu błąd różnicy zależy od wartości w przedziale,
+ * a nie od wielkości całej sumy od początku historii.
+ */
+class PrefixSumIndex {
+public:
+    /**
+     * @brief Buduje indeks od nowa na podstawie wszystkich rekordów drzewa i snapshotu.
+     *
+     * @param tree Drzewo z danymi.
+     * @param snapshot Wczytany snapshot z danymi (lub nullptr).
+     */
+    void build(const Tree& tree, const Snapshot* snapshot = nullptr);
+
+    /**
+     * @brief Dopisuje pomiar do indeksu.
+     *
+     * Pomiar nowszy lub równy ostatniemu jest dopisywany w czasie O(1). Pomiar starszy jest
+     * wstawiany na właściwe miejsce, a jego wartość jest doliczana do wszystkich sum prefiksowych za nim.
+     *
+     * @param timestamp Znacznik czasu pomiaru (minuty od 2000-01-01 00:00).
+     * @param record Rekord z wartościami pomiarowymi.
+     */
+    void append(std::int32_t timestamp, const Record& record);
+
+    /**
+     * @brief Usuwa zawartość indeksu.
+     */
+    void clear();
+
+    /**
+     * @brief Zwraca liczbę pomiarów w indeksie.
+     */
+    std::size_t size() const { return timestamps.size(); }
+
+    /**
+     * @brief Zwraca liczbę pomiarów w przedziale `[from, to]`.
+     */
+    std::size_t count(std::int32_t from, std::int32_t to) const;
+
+    /**
+     * @brief Zwraca sumę wybranej wielkości w przedziale `[from, to]`.
+     *
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości (patrz `Record::fieldIndex`).
+     * @return double Suma wartości (0 dla pustego przedziału).
+     */
+    double sum(std::int32_t from, std::int32_t to, int field) const;
+
+    /**
+     * @brief Zwraca średnią wybranej wielkości w przedziale `[from, to]` (0 dla pustego przedziału).
+     */
+    double average(std::int32_t from, std::int32_t to, int field) const;
+
+    /**
+     * @brief Dodaje wartość do sumy z poprawką kompensującą błąd zaokrągleń (wariant Neumaiera algorytmu Kahana).
+     */
+    static void compensatedAdd(double& sum, double& compensation, double value);
+
+private:
+    /**
+     * @brief Suma prefiksowa z poprawką kompensującą błąd zaokrągleń.
+     */
+    struct CompensatedSum {
+        double sum = 0.0;
+        double compensation = 0.0;
+    };
+
+    /**
+     * @brief Znaczniki czasu pomiarów (rosnąco).
+     */
+    std::vector<std::int32_t> timestamps;
+
+    /**
+     * @brief Sumy prefiksowe: `prefix[f][i]` to suma wartości pomiarów `0..i-1` wielkości `f`.
+     *
+     * Każda kolumna ma `size() + 1` elementów (pierwszy to zero).
+     */
+    std::vector<CompensatedSum> prefix[Record::fieldCount];
+
+    /**
+     * @brief Zwraca sumę wielkości `field` pomiarów o indeksach `[first, last)`.
+     */
+    double sumBetween(std::size_t first, std::size_t last, int field) const;
+
+    /**
+     * @brief Wyznacza przedział indeksów `[first, last)` pomiarów z zakresu `[from, to]`.
+     */
+    void bounds(std::int32_t from, std::int32_t to, std::size_t& first, std::size_t& last) const;
+};
+
+#endif // PREFIXSUMINDEX_H
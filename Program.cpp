@@ -1,3 +1,209 @@
+#include "Program.h"
+#include "MappedFile.h"
+#include "Metrics.h"
+#include "Timestamp.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+/**
+ * @brief Sprawdza, czy linia jest nagłówkiem eksportu (`Time,Autokonsumpcja (W),...`).
+ *
+ * Eksport z falownika może zawierać nagłówek nie tylko w pierwszej linii, ale również
+ * w środku pliku (przy sklejaniu kilku eksportów), dlatego sprawdzana jest każda linia.
+ */
+bool isHeaderLine(const char* begin, const char* end) {
+    static const char prefix[] = "Time";
+    const std::size_t length = sizeof(prefix) - 1;
+    return static_cast<std::size_t>(end - begin) >= length && std::memcmp(begin, prefix, length) == 0;
+}
+
+/**
+ * @brief Czyta pojedynczą wartość liczbową (opcjonalnie w cudzysłowie) i przesuwa wskaźnik.
+ *
+ * Po wartości oczekiwany jest przecinek lub koniec linii.
+ */
+bool readValue(const char*& p, const char* end, double& value) {
+    const bool quoted = p < end && *p == '"';
+    if (quoted) ++p;
+
+    // Szybka ścieżka (Clinger): do 15 cyfr i do 22 miejsc po przecinku wynik dzielenia
+    // dwóch dokładnie reprezentowalnych liczb jest poprawnie zaokrąglony
+    static const double powersOf10[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+                                         1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+                                         1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    const char* q = p;
+    const bool negative = q < end && *q == '-';
+    if (negative) ++q;
+    std::uint64_t mantissa = 0;
+    int digits = 0, fractionDigits = 0;
+    while (q < end && *q >= '0' && *q <= '9') {
+        mantissa = mantissa * 10 + static_cast<std::uint64_t>(*q++ - '0');
+        ++digits;
+    }
+    if (q < end && *q == '.') {
+        ++q;
+        while (q < end && *q >= '0' && *q <= '9') {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(*q++ - '0');
+            ++digits;
+            ++fractionDigits;
+        }
+    }
+    const bool simple = digits > 0 && digits <= 15 && fractionDigits <= 22 &&
+                        (q == end || (*q != 'e' && *q != 'E'));
+    if (simple) {
+        value = static_cast<double>(mantissa) / powersOf10[fractionDigits];
+        if (negative) value = -value;
+        p = q;
+    } else {
+        // Pozostałe przypadki (wykładnik, długie liczby) obsługuje std::from_chars
+        const std::from_chars_result result = std::from_chars(p, end, value);
+        if (result.ec != std::errc() || result.ptr == p) return false;
+        p = result.ptr;
+    }
+
+    if (quoted) {
+        if (p == end || *p != '"') return false;
+        ++p;
+    }
+    return true;
+}
+
+/**
+ * @brief Dzieli przedział `[from, to]` na fragmenty w granicach miesięcy kalendarzowych.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param spans Lista, na której końcu zostaną dopisane fragmenty `[from, to]`, chronologicznie.
+ */
+void splitByMonths(std::int32_t from, std::int32_t to, std::vector<std::pair<std::int32_t, std::int32_t>>& spans) {
+    while (from <= to) {
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+        Timestamp::toDateTime(from, year, month, day, hour, minute);
+        const std::int32_t next = month == 12 ? Timestamp::fromDateTime(year + 1, 1, 1, 0, 0)
+                                              : Timestamp::fromDateTime(year, month + 1, 1, 0, 0);
+        if (next > to) {
+            spans.emplace_back(from, to);
+            return;
+        }
+        spans.emplace_back(from, next - 1);
+        from = next;
+    }
+}
+
+/**
+ * @brief Sprawdza paczkę wierszy, dodaje poprawne rekordy do drzewa, a odrzucone zapisuje w raporcie.
+ *
+ * @param batch Paczka wierszy (opróżniana).
+ * @param validator Walidator fragmentu.
+ * @param target Drzewo docelowe.
+ * @param report Raport fragmentu.
+ * @param logger Logger poprawnych rekordów.
+ * @param logValid false - poprawne rekordy nie są logowane (także gdy wyłącza je poziom logowania).
+ * @param rows Licznik wierszy do próbkowania czasów (`Metrics::sampled`).
+ */
+void commitBatch(RowBatch& batch, RowValidator& validator, Tree& target, LoadReport& report, Logger& logger,
+                 bool logValid, std::uint64_t& rows) {
+    {
+        ScopedTimer timer(Metric::Validate);
+        validator.validate(batch, target);
+    }
+    Metrics::add(Metric::Validate, batch.size);
+    for (std::size_t i = 0; i < batch.size; ++i) {
+        const bool sampled = Metrics::sampled(rows++);
+        const RejectReason reason = batch.reasons[i];
+        if (reason == RejectReason::None) {
+            {
+                ScopedTimer timer(Metric::TreeInsert, sampled);
+                target.addRecord(batch.record(i));
+            }
+            report.valid++;
+            if (logValid) {
+                ScopedTimer timer(Metric::Logging, sampled);
+                logger.validRecord(batch.lines[i], batch.lengths[i]);
+            }
+        } else {
+            report.invalid++;
+            report.rejected[static_cast<std::size_t>(reason)]++;
+            report.rejections.push_back(Rejection{ batch.lines[i], batch.lengths[i], batch.lineNumbers[i], reason });
+        }
+    }
+    batch.size = 0;
+}
+
+/**
+ * @brief Loguje odrzucone wiersze fragmentu z numerami linii w pliku.
+ *
+ * @param report Raport fragmentu.
+ * @param lineOffset Liczba linii pliku przed fragmentem.
+ * @param logger Logger błędnych rekordów.
+ */
+void logRejections(const LoadReport& report, std::size_t lineOffset, Logger& logger) {
+    if (!logger.logsInvalid()) return;
+    for (const Rejection& rejection : report.rejections) {
+        logger.invalidRecord(rejection.line, rejection.length, lineOffset + rejection.lineNumber,
+                             rejectReasonName(rejection.reason));
+    }
+    Metrics::add(Metric::Logging, report.rejections.size());
+}
+
+/**
+ * @brief Loguje poprawne wiersze fragmentu po ostatecznym sprawdzeniu (wczytywanie wielowątkowe).
+ *
+ * Poprawne są niepuste linie fragmentu poza nagłówkami, których nie ma wśród odrzuconych
+ * (`report.rejections` w kolejności linii), więc fragment nie jest ponownie parsowany.
+ *
+ * @param begin Wskaźnik na początek fragmentu (początek linii).
+ * @param end Wskaźnik za końcem fragmentu.
+ * @param report Raport fragmentu.
+ * @param logger Logger poprawnych rekordów.
+ */
+void logValidRows(const char* begin, const char* end, const LoadReport& report, Logger& logger) {
+    if (!logger.logsValid()) return;
+    auto rejection = report.rejections.begin();
+    std::size_t lineNumber = 0;
+    std::uint64_t rows = 0;
+    for (const char* p = begin; p < end; ++lineNumber) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        if (eol == nullptr) eol = end;
+        const char* lineEnd = eol;
+        if (lineEnd > p && lineEnd[-1] == '\r') --lineEnd;
+        if (rejection != report.rejections.end() && rejection->lineNumber == lineNumber + 1) {
+            ++rejection;
+        } else if (lineEnd != p && !isHeaderLine(p, lineEnd)) {
+            ScopedTimer timer(Metric::Logging, Metrics::sampled(rows++));
+            logger.validRecord(p, static_cast<std::size_t>(lineEnd - p));
+        }
+        p = eol + 1;
+    }
+    Metrics::add(Metric::Logging, static_cast<std::uint64_t>(report.valid));
+}
+
+/**
+ * @brief Sprawdza, czy drzewo fragmentu zawiera znacznik czasu obecny już w drzewie `loaded`.
+ *
+ * Rozłączne zakresy czasu (plik uporządkowany chronologicznie) są rozpoznawane bez przeglądania rekordów.
+ */
+bool sharesTimestamps(const Tree& chunk, const Tree& loaded) {
+    std::int32_t first = 0, last = 0, loadedFirst = 0, loadedLast = 0;
+    if (!chunk.timeSpan(first, last) || !loaded.timeSpan(loadedFirst, loadedLast)) return false;
+    if (last < loadedFirst || first > loadedLast) return false;
+    std::vector<Record> common;
+    chunk.records(std::max(first, loadedFirst), std::min(last, loadedLast), common);
+    return std::any_of(common.begin(), common.end(),
+                       [&loaded](const Record& record) { return loaded.contains(record.timestamp); });
+}
+
+} // namespace
+
 /**
  * @brief Wczytuje dane z pliku CSV i przetwarza je do struktury danych.
  * 
@@ -11,7 +217,23 @@
  * 
  * Po zakończeniu wczytywania pliku, funkcja wypisuje na ekranie liczbę poprawnych i błędnych rekordów.
  * 
+ * Przy `threadCount > 1` plik jest dzielony na `threadCount` fragmentów na granicach linii.
+ * Każdy wątek parsuje swój fragment do lokalnego drzewa, po czym wyniki są scalane
+ * w kolejności fragmentów. Dzięki temu kolejność rekordów w ćwiartkach i liczniki są takie same
+ * jak przy wczytywaniu jednowątkowym. Duplikat znacznika czasu z wcześniejszego fragmentu wykrywa
+ * dopiero scalanie - taki fragment (tylko w pliku nieuporządkowanym chronologicznie) jest parsowany
+ * ponownie. Dlatego wszystkie wiersze są logowane dopiero po scaleniu: błędne w kolejności linii,
+ * z numerem linii w pliku i powodem odrzucenia (`RowValidator`), a poprawne równolegle przez wątki
+ * fragmentów do wspólnego `Logger`, więc te wpisy mogą się przeplatać.
+ * 
+ * Wczytane rekordy są dodawane do `tree` jedną paczką (nowa wersja drzewa), więc równoległe
+ * zapytania widzą albo dane sprzed wczytania, albo cały wczytany plik.
+ * 
+ * Logi są zapisywane przez wątek w tle (`Logger`); zakres logowania określa `setLogLevel`.
+ * Na końcu logu poprawnych rekordów dopisywane jest podsumowanie wczytywania.
+ * 
  * @param fileName Nazwa pliku CSV, z którego mają zostać wczytane dane.
+ * @param threadCount Liczba wątków (1 - jednowątkowo, 0 - liczba dostępnych rdzeni).
  * 
  * @note Jeśli plik nie może zostać otwarty, funkcja wypisuje błąd na standardowe wyjście i kończy działanie.
  * 
@@ -20,73 +242,389 @@
  * na ekranie zostanie wypisane: 
  * "Wczytywanie zakończone. Poprawne: 100, Błędne: 5".
  * 
- * @see parseLine, logMessage
+ * @see parseChunk, parseLine
  */
-void Program::loadCSV(const std::string& ChartExport) {
-    // Otwarcie pliku CSV do odczytu
-    std::ifstream file(ChartExport);
-    if (!file.is_open()) {
-        std::cerr << "Nie można otworzyć pliku: " << ChartExport<< std:endl;
+void Program::loadCSV(const std::string& fileName, unsigned threadCount) {
+    // Zmapowanie pliku CSV do pamięci
+    MappedFile file(fileName);
+    if (!file.isOpen()) {
+        std::cerr << "Nie można otworzyć pliku: " << fileName << std::endl;
         return;
     }
+    ScopedTimer timer(Metric::LoadCSV);
 
-    // Otwarcie plików do logowania danych
-    std::ofstream log("log_data.txt");
-    std::ofstream errorLog("log_error_data.txt");
-
-    std::string line;
-    while (std::getline(file, line)) {
-        Record record;
-        // Parsowanie linii do obiektu Record
-        if (parseLine(line, record)) {
-            // Jeśli linia została poprawnie sparsowana, dodajemy rekord do drzewa
-            tree.addRecord(record);
-            validRecords++;
-            // Logowanie poprawnego rekordu
-            logMessage("Poprawny rekord: " + line, "log_data.txt");
-        } else {
-            // Jeśli linia jest błędna, inkrementujemy licznik błędnych rekordów
-            invalidRecords++;
-            // Logowanie błędnego rekordu
-            logMessage("Błędny rekord: " + line, "log_error_data.txt");
+    // Logger zapisujący pliki logów w tle
+    Logger logger("log_data.txt", "log_error_data.txt", logLevel);
+
+    const char* const begin = file.data();
+    const char* const end = begin + file.size();
+
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    // Fragmenty mniejsze niż ~1 MB nie opłacają się kosztem uruchomienia wątku
+    const std::size_t minChunk = 1 << 20;
+    threadCount = static_cast<unsigned>(std::min<std::size_t>(threadCount, file.size() / minChunk + 1));
+
+    // Rekordy są zbierane w lokalnym drzewie i publikowane jedną nową wersją; znaczniki czasu
+    // obecne już w drzewie lub snapshocie (np. ponowne wczytanie pliku) są duplikatami
+    Tree loaded;
+    LoadReport report;
+    const ConcurrentTree::View published = tree.view();
+    const EarlierData earlier{ nullptr, &published, snapshot.get() };
+    if (threadCount <= 1) {
+        parseChunk(begin, end, loaded, validation, report, logger, earlier);
+        logRejections(report, 0, logger);
+    } else {
+        // Podział pliku na fragmenty zaczynające się na początku linii
+        std::vector<const char*> bounds(threadCount + 1, end);
+        bounds[0] = begin;
+        for (unsigned i = 1; i < threadCount; ++i) {
+            const char* p = std::max(bounds[i - 1], begin + file.size() / threadCount * i);
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            bounds[i] = eol == nullptr ? end : eol + 1;
+        }
+
+        // Równoległe parsowanie fragmentów do lokalnych drzew współdzielących arenę
+        // drzewa `loaded`, dzięki czemu scalanie przenosi węzły bez kopiowania kolumn
+        struct Chunk {
+            Tree tree;
+            LoadReport report;
+        };
+        std::vector<Chunk> chunks;
+        chunks.reserve(threadCount);
+        for (unsigned i = 0; i < threadCount; ++i) chunks.push_back(Chunk{ Tree(loaded.resource()), LoadReport() });
+        std::vector<std::thread> workers;
+        workers.reserve(threadCount);
+        const ValidationRules rules = validation;
+        for (unsigned i = 0; i < threadCount; ++i) {
+            workers.emplace_back([&chunks, &bounds, &logger, &rules, &earlier, i] {
+                Chunk& chunk = chunks[i];
+                parseChunk(bounds[i], bounds[i + 1], chunk.tree, rules, chunk.report, logger, earlier, false);
+            });
+        }
+        for (std::thread& worker : workers) worker.join();
+
+        // Scalanie wyników w kolejności fragmentów w pliku; odrzucone wiersze są logowane
+        // z numerami linii przesuniętymi o liczbę linii poprzednich fragmentów
+        std::size_t lineOffset = 0;
+        for (unsigned i = 0; i < threadCount; ++i) {
+            Chunk& chunk = chunks[i];
+            if (rules.rejectDuplicates && i > 0 && sharesTimestamps(chunk.tree, loaded)) {
+                // Fragment zawiera znaczniki czasu wcześniejszych fragmentów (plik nieuporządkowany) -
+                // ponowne parsowanie z wykrywaniem duplikatów względem nich
+                Chunk again{ Tree(loaded.resource()), LoadReport() };
+                EarlierData previous = earlier;
+                previous.tree = &loaded;
+                parseChunk(bounds[i], bounds[i + 1], again.tree, rules, again.report, logger, previous, false);
+                chunk = std::move(again);
+            }
+            loaded.merge(std::move(chunk.tree));
+            logRejections(chunk.report, lineOffset, logger);
+            lineOffset += chunk.report.lines;
+            report.valid += chunk.report.valid;
+            report.invalid += chunk.report.invalid;
+            for (std::size_t r = 0; r < report.rejected.size(); ++r) report.rejected[r] += chunk.report.rejected[r];
+        }
+
+        // Poprawne wiersze są logowane dopiero teraz, gdy scalanie rozstrzygnęło duplikaty między fragmentami
+        if (logger.logsValid()) {
+            workers.clear();
+            for (unsigned i = 0; i < threadCount; ++i) {
+                workers.emplace_back([&chunks, &bounds, &logger, i] {
+                    logValidRows(bounds[i], bounds[i + 1], chunks[i].report, logger);
+                });
+            }
+            for (std::thread& worker : workers) worker.join();
         }
     }
+    std::int32_t first = 0, last = 0;
+    const bool added = loaded.timeSpan(first, last);
+    tree.merge(std::move(loaded));
+    if (added) rollups.invalidate(first, last);
+    validRecords += report.valid;
+    invalidRecords += report.invalid;
+    for (std::size_t r = 0; r < report.rejected.size(); ++r) rejectedRecords[r] += report.rejected[r];
+    Metrics::add(Metric::LoadCSV, static_cast<std::uint64_t>(report.valid + report.invalid));
 
-    // Zamknięcie plików
-    file.close();
-    log.close();
-    errorLog.close();
+    // Podsumowanie w logu i zapisanie wszystkich oczekujących wpisów
+    logger.summary(report.valid, report.invalid);
+    logger.flush();
 
     // Wypisanie podsumowania
     std::cout << "Wczytywanie zakończone. Poprawne: " << validRecords << ", Błędne: " << invalidRecords << std::endl;
 }
 
 /**
- * @brief Parsuje pojedynczą linię tekstu z pliku CSV na obiekt typu `Record`.
+ * @brief Parsuje fragment pliku CSV linia po linii.
+ * 
+ * Wygodna nakładka dla `Fleet`: domyślne reguły `ValidationRules`, odrzucone wiersze są logowane
+ * z numerem linii względem początku fragmentu.
+ * 
+ * @param begin Wskaźnik na początek fragmentu (początek linii).
+ * @param end Wskaźnik za końcem fragmentu.
+ * @param target Drzewo docelowe.
+ * @param valid Licznik poprawnych rekordów.
+ * @param invalid Licznik błędnych rekordów.
+ * @param logger Logger rekordów.
+ */
+void Program::parseChunk(const char* begin, const char* end, Tree& target, int& valid, int& invalid,
+                         Logger& logger) {
+    LoadReport report;
+    parseChunk(begin, end, target, ValidationRules(), report, logger);
+    logRejections(report, 0, logger);
+    valid += report.valid;
+    invalid += report.invalid;
+}
+
+/**
+ * @brief Parsuje fragment pliku CSV linia po linii i sprawdza wiersze paczkami.
+ * 
+ * Puste linie i nagłówki są pomijane. Sparsowane wiersze (także odrzucone przez parser, z powodem
+ * `RejectReason::Format` lub `RejectReason::Date`) są zbierane w paczce `RowBatch`; pełna paczka
+ * jest sprawdzana przez `RowValidator`, po czym poprawne rekordy trafiają do drzewa `target`
+ * i do loggera, a odrzucone - do `report.rejections` (logowane przez wywołującego, który zna
+ * numer pierwszej linii fragmentu w pliku). Czasy parsowania, wstawiania i logowania są mierzone
+ * dla co `Metrics::sampleInterval`-tej linii, sprawdzanie - dla każdej paczki.
+ * 
+ * @param begin Wskaźnik na początek fragmentu (początek linii).
+ * @param end Wskaźnik za końcem fragmentu.
+ * @param target Drzewo docelowe.
+ * @param rules Reguły sprawdzania wierszy.
+ * @param report Raport fragmentu (liczniki, liczba linii, odrzucone wiersze).
+ * @param logger Logger poprawnych rekordów.
+ * @param earlier Wcześniej przyjęte dane do wykrywania duplikatów.
+ * @param logValid false - poprawne rekordy nie są logowane.
+ */
+void Program::parseChunk(const char* begin, const char* end, Tree& target, const ValidationRules& rules,
+                         LoadReport& report, Logger& logger, const EarlierData& earlier, bool logValid) {
+    const char* p = begin;
+    Record record;
+    RowValidator validator(rules, earlier);
+    std::unique_ptr<RowBatch> batch(new RowBatch());
+    const int validBefore = report.valid;
+    std::uint64_t lines = 0, rows = 0;
+    // Poprawne rekordy wyłączone przez poziom logowania nie są przekazywane ani mierzone
+    logValid = logValid && logger.logsValid();
+    while (p < end) {
+        // Wyznaczenie granic bieżącej linii (bez znaków \r\n)
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        if (eol == nullptr) eol = end;
+        const char* lineEnd = eol;
+        if (lineEnd > p && lineEnd[-1] == '\r') --lineEnd;
+        ++report.lines;
+
+        // Pomijamy puste linie oraz nagłówki
+        if (lineEnd != p && !isHeaderLine(p, lineEnd)) {
+            // Czasy etapów są mierzone tylko dla próbki linii (`Metrics::sampleInterval`)
+            const bool sampled = Metrics::sampled(lines++);
+            // Parsowanie linii do obiektu Record
+            RejectReason reason;
+            {
+                ScopedTimer timer(Metric::Parse, sampled);
+                parseLine(p, lineEnd, record, reason);
+            }
+            batch->add(record, reason, p, static_cast<std::size_t>(lineEnd - p), report.lines);
+            if (batch->size == RowBatch::capacity) commitBatch(*batch, validator, target, report, logger, logValid, rows);
+        }
+        p = eol + 1;
+    }
+    if (batch->size > 0) commitBatch(*batch, validator, target, report, logger, logValid, rows);
+    const std::uint64_t added = static_cast<std::uint64_t>(report.valid - validBefore);
+    Metrics::add(Metric::Parse, lines);
+    Metrics::add(Metric::TreeInsert, added);
+    if (logValid) Metrics::add(Metric::Logging, added);
+}
+
+/**
+ * @brief Wczytuje rekordy dopisane do pliku CSV od poprzedniego wywołania.
+ * 
+ * Nowe pełne linie są odczytywane przez `TailFollower`, a następnie przetwarzane przez
+ * `appendChunk`, który pomija rekordy o znacznikach czasu obecnych już w danych.
+ * Zmiana śledzonego pliku rozpoczyna śledzenie od początku nowego pliku.
+ * 
+ * @param fileName Nazwa śledzonego pliku CSV.
+ * @param added Liczba dodanych rekordów.
+ * @param duplicates Liczba pominiętych duplikatów.
+ * @return true, jeśli plik udało się przeczytać.
+ * 
+ * @see followCSV
+ */
+bool Program::updateFromCSV(const std::string& fileName, int& added, int& duplicates) {
+    std::string error;
+    if (!readAppended(fileName, added, duplicates, error)) {
+        std::cerr << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Wczytuje rekordy dopisane do pliku CSV, zwracając ewentualny błąd zamiast go wypisywać.
+ * 
+ * @param fileName Nazwa śledzonego pliku CSV.
+ * @param added Liczba dodanych rekordów.
+ * @param duplicates Liczba pominiętych duplikatów.
+ * @param error Opis błędu odczytu.
+ * @return true, jeśli plik udało się przeczytać.
+ */
+bool Program::readAppended(const std::string& fileName, int& added, int& duplicates, std::string& error) {
+    added = 0;
+    duplicates = 0;
+    if (!follower || follower->fileName() != fileName) follower.reset(new TailFollower(fileName));
+
+    std::string lines;
+    if (!follower->read(lines, error)) return false;
+    if (lines.empty()) return true;
+
+    const int invalidBefore = invalidRecords;
+    Logger logger("log_data.txt", "log_error_data.txt", logLevel, 1024, true);
+    // Numer pierwszej nowej linii w pliku (licznik linii uwzględnia już przeczytane linie)
+    const std::size_t firstLine = static_cast<std::size_t>(follower->lineCount()) + 1 -
+                                  static_cast<std::size_t>(std::count(lines.begin(), lines.end(), '\n'));
+    appendChunk(lines.data(), lines.data() + lines.size(), firstLine, logger, added, duplicates);
+    logger.summary(added, invalidRecords - invalidBefore);
+    return true;
+}
+
+/**
+ * @brief Śledzi dopisywany plik CSV aż do ustawienia flagi `stop`.
+ * 
+ * Po każdej aktualizacji z nowymi danymi wypisywana jest liczba dodanych rekordów
+ * i pominiętych duplikatów. Błąd odczytu (np. chwilowy brak pliku podczas rotacji) jest
+ * wypisywany raz, a śledzenie jest kontynuowane.
  * 
- * Funkcja przetwarza pojedynczą linię z pliku CSV, dzieląc ją na odpowiednie części 
- * (datę, godzinę i wartości liczbowe odpowiadające różnym typom energii). Jeśli linia 
- * zawiera dane w poprawnym formacie, tworzy obiekt klasy `Record` i ustawia jego wartości.
+ * @param fileName Nazwa śledzonego pliku CSV.
+ * @param stop Flaga zakończenia śledzenia.
+ * @param intervalMs Maksymalny czas oczekiwania na zmianę pliku w milisekundach.
+ */
+void Program::followCSV(const std::string& fileName, const std::atomic<bool>& stop, int intervalMs) {
+    bool failed = false;
+    while (!stop.load()) {
+        int added = 0, duplicates = 0;
+        std::string error;
+        const bool ok = readAppended(fileName, added, duplicates, error);
+        if (!ok && !failed) std::cerr << error << std::endl;
+        failed = !ok;
+
+        if (added > 0 || duplicates > 0) {
+            std::cout << "Dopisano rekordów: " << added << " (pominięte duplikaty: " << duplicates << ")" << std::endl;
+        }
+        follower->wait(intervalMs);
+    }
+}
+
+/**
+ * @brief Dodaje nowe rekordy z fragmentu CSV, pomijając pomiary o znanych już znacznikach czasu.
+ * 
+ * Wiersze są sprawdzane paczkami przez `RowValidator` (bez reguły duplikatów - powtórzony znacznik
+ * czasu jest tu zwykłym, pomijanym duplikatem, a nie błędem), a odrzucone są logowane od razu,
+ * z numerem linii w śledzonym pliku.
+ * 
+ * @param begin Wskaźnik na początek fragmentu (początek linii).
+ * @param end Wskaźnik za końcem fragmentu.
+ * @param firstLine Numer pierwszej linii fragmentu w pliku (od 1).
+ * @param logger Logger rekordów.
+ * @param added Licznik dodanych rekordów.
+ * @param duplicates Licznik pominiętych duplikatów.
+ */
+void Program::appendChunk(const char* begin, const char* end, std::size_t firstLine, Logger& logger, int& added,
+                          int& duplicates) {
+    // Nowe rekordy trafiają do paczki publikowanej na końcu jako jedna nowa wersja drzewa
+    Tree batch;
+    int invalid = 0;
+    const int addedBefore = added;
+    ValidationRules rules = validation;
+    rules.rejectDuplicates = false;
+    RowValidator validator(rules);
+    std::unique_ptr<RowBatch> rows(new RowBatch());
+    std::uint64_t sampledRows = 0;
+
+    const auto commit = [&] {
+        {
+            ScopedTimer timer(Metric::Validate);
+            validator.validate(*rows, batch);
+        }
+        Metrics::add(Metric::Validate, rows->size);
+        for (std::size_t i = 0; i < rows->size; ++i) {
+            const RejectReason reason = rows->reasons[i];
+            if (reason != RejectReason::None) {
+                invalid++;
+                rejectedRecords[static_cast<std::size_t>(reason)]++;
+                logger.invalidRecord(rows->lines[i], rows->lengths[i], rows->lineNumbers[i], rejectReasonName(reason));
+                continue;
+            }
+            // Pomiar o tym znaczniku czasu może już być w drzewie, w paczce lub w snapshocie
+            const std::int32_t timestamp = rows->timestamps[i];
+            bool known = batch.contains(timestamp) || tree.view().contains(timestamp);
+            if (!known && snapshot) {
+                const std::pair<std::size_t, std::size_t> found = snapshot->range(timestamp, timestamp);
+                known = found.first != found.second;
+            }
+            if (known) {
+                duplicates++;
+                continue;
+            }
+            const Record record = rows->record(i);
+            {
+                ScopedTimer timer(Metric::TreeInsert, Metrics::sampled(sampledRows++));
+                batch.addRecord(record);
+            }
+            added++;
+            logger.validRecord(rows->lines[i], rows->lengths[i]);
+        }
+        rows->size = 0;
+    };
+
+    const char* p = begin;
+    Record record;
+    std::uint64_t lines = 0;
+    std::size_t lineNumber = firstLine;
+    for (; p < end; ++lineNumber) {
+        const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        if (eol == nullptr) eol = end;
+        const char* lineEnd = eol;
+        if (lineEnd > p && lineEnd[-1] == '\r') --lineEnd;
+
+        if (lineEnd != p && !isHeaderLine(p, lineEnd)) {
+            const bool sampled = Metrics::sampled(lines++);
+            RejectReason reason;
+            {
+                ScopedTimer timer(Metric::Parse, sampled);
+                parseLine(p, lineEnd, record, reason);
+            }
+            rows->add(record, reason, p, static_cast<std::size_t>(lineEnd - p), lineNumber);
+            if (rows->size == RowBatch::capacity) commit();
+        }
+        p = eol + 1;
+    }
+    if (rows->size > 0) commit();
+
+    std::int32_t first = 0, last = 0;
+    const bool changed = batch.timeSpan(first, last);
+    tree.merge(std::move(batch));
+    if (changed) rollups.invalidate(first, last);
+    validRecords += added;
+    invalidRecords += invalid;
+    Metrics::add(Metric::Parse, lines);
+    Metrics::add(Metric::TreeInsert, static_cast<std::uint64_t>(added - addedBefore));
+}
+
+/**
+ * @brief Parsuje pojedynczą linię tekstu z pliku CSV na obiekt typu `Record`.
  * 
- * Funkcja zakłada, że linia jest poprawnie sformatowana, w przeciwnym razie zwraca wartość 
- * `false`, co sygnalizuje, że linia jest niepoprawna i nie powinna być dodana do struktury danych.
+ * Wygodna nakładka na wersję parsującą bezpośrednio z bufora.
  * 
  * @param line Pojedyncza linia tekstu z pliku CSV, która ma zostać sparsowana.
  * @param record Obiekt typu `Record`, do którego zapisane będą dane, jeśli linia będzie poprawna.
  * 
- * @return `true` jeśli linia została poprawnie sparsowana i obiekt `record` został zaktualizowany, 
- *         w przeciwnym razie zwraca `false`.
- * 
- * @note Funkcja zakłada, że dane w linii są oddzielone spacjami lub tabulatorami.
+ * @return `true` jeśli linia została poprawnie sparsowana, w przeciwnym razie `false`.
  * 
  * Przykład:
  * Jeśli linia w pliku CSV wygląda następująco:
  * ```
- * 2021-10-15 12:00 10.5 2.3 3.1 4.0 6.2
+ * 15.10.2021 12:00,"10.5","2.3","3.1","4.0","6.2"
  * ```
  * Funkcja przetworzy ją na obiekt `Record`, w którym:
- * - `date = "2021-10-15"`,
- * - `time = "12:00"`,
+ * - `timestamp` = znacznik czasu 2021-10-15 12:00 (`date()` = "2021-10-15", `time()` = "12:00"),
  * - `autokonsumpcja = 10.5`,
  * - `eksport = 2.3`,
  * - `import_ = 3.1`,
@@ -96,15 +634,688 @@ void Program::loadCSV(const std::string& ChartExport) {
  * @see loadCSV
  */
 bool Program::parseLine(const std::string& line, Record& record) {
-    std::istringstream iss(line);
-    std::string date, time;
-    double autokonsumpcja, eksport, import_, pobor, produkcja;
+    return parseLine(line.data(), line.data() + line.size(), record);
+}
+
+/**
+ * @brief Parsuje linię CSV w formacie eksportu falownika bezpośrednio z bufora.
+ * 
+ * Wygodna nakładka na wersję zwracającą powód odrzucenia.
+ * 
+ * @param begin Wskaźnik na pierwszy znak linii.
+ * @param end Wskaźnik za ostatnim znakiem linii (bez znaku nowej linii).
+ * @param record Obiekt typu `Record`, do którego zapisane będą dane, jeśli linia będzie poprawna.
+ * 
+ * @return `true` jeśli linia została poprawnie sparsowana, w przeciwnym razie `false`.
+ */
+bool Program::parseLine(const char* begin, const char* end, Record& record) {
+    RejectReason reason;
+    return parseLine(begin, end, record, reason);
+}
+
+/**
+ * @brief Parsuje linię CSV w formacie eksportu falownika bezpośrednio z bufora.
+ * 
+ * Oczekiwany format linii:
+ * ```
+ * 01.10.2020 0:15,"0","0","403.5656","403.5656","0"
+ * ```
+ * Data `DD.MM.YYYY` i godzina `H:MM` są czytane parserem cyfr, sprawdzane z kalendarzem
+ * (`Timestamp::isValid` - np. 31.09 lub 29.02 roku nieprzestępnego są odrzucane) i zamieniane
+ * od razu na znacznik czasu rekordu (minuty od 2000-01-01), więc dalej ani drzewo, ani zapytania
+ * nie parsują napisów. Wartości liczbowe są konwertowane funkcją `std::from_chars` wprost z bufora,
+ * bez tworzenia tymczasowych obiektów `std::string` ani strumieni. Pozostałe reguły jakości danych
+ * (wartości ujemne i nieliczbowe, bilans, duplikaty) sprawdza paczkami `RowValidator`.
+ * 
+ * @param begin Wskaźnik na pierwszy znak linii.
+ * @param end Wskaźnik za ostatnim znakiem linii (bez znaku nowej linii).
+ * @param record Obiekt typu `Record`, do którego zapisane będą dane, jeśli linia będzie poprawna.
+ * @param reason Powód odrzucenia (`RejectReason::Format`, `RejectReason::Date`) lub `RejectReason::None`.
+ * 
+ * @return `true` jeśli linia została poprawnie sparsowana, w przeciwnym razie `false`
+ *         (obiekt `record` może wtedy zawierać częściowe dane).
+ * 
+ * @see loadCSV
+ */
+bool Program::parseLine(const char* begin, const char* end, Record& record, RejectReason& reason) {
+    const char* p = begin;
+    int day, month, year, hour, minute;
+    reason = RejectReason::Format;
+
+    // Data w formacie DD.MM.YYYY
+    if (!Timestamp::readNumber(p, end, 1, 2, day) || p == end || *p++ != '.') return false;
+    if (!Timestamp::readNumber(p, end, 1, 2, month) || p == end || *p++ != '.') return false;
+    if (!Timestamp::readNumber(p, end, 4, 4, year)) return false;
+
+    // Separator daty i godziny
+    if (p == end || *p != ' ') return false;
+    while (p < end && *p == ' ') ++p;
+
+    // Godzina w formacie H:MM lub HH:MM
+    if (!Timestamp::readNumber(p, end, 1, 2, hour) || p == end || *p++ != ':') return false;
+    if (!Timestamp::readNumber(p, end, 2, 2, minute)) return false;
+
+    // Pięć wartości pomiarowych oddzielonych przecinkami
+    double* const fields[] = { &record.autokonsumpcja, &record.eksport, &record.import_,
+                               &record.pobor, &record.produkcja };
+    for (double* field : fields) {
+        if (p == end || *p++ != ',') return false;
+        if (!readValue(p, end, *field)) return false;
+    }
+    if (p != end) return false; // Nadmiarowe dane na końcu linii
+
+    // Data spoza kalendarza przy poprawnym formacie linii
+    if (!Timestamp::isValid(year, month, day, hour, minute)) {
+        reason = RejectReason::Date;
+        return false;
+    }
+
+    // Znacznik czasu wyznaczany raz, przy parsowaniu - bez napisów daty i godziny
+    record.timestamp = Timestamp::fromDateTime(year, month, day, hour, minute);
+    reason = RejectReason::None;
+    return true;
+}
+
+/**
+ * @brief Zamienia parametry zapytania (daty, godziny, typ danych) na znaczniki czasu i indeks wielkości.
+ * 
+ * @param startDate Data początkowa w formacie YYYY-MM-DD.
+ * @param startTime Godzina początkowa w formacie HH:MM.
+ * @param endDate Data końcowa w formacie YYYY-MM-DD.
+ * @param endTime Godzina końcowa w formacie HH:MM.
+ * @param type Typ danych (np. "produkcja").
+ * @param from Wyjściowy początek przedziału.
+ * @param to Wyjściowy koniec przedziału.
+ * @param field Wyjściowy indeks wielkości pomiarowej.
+ * @return true, jeśli parametry są poprawne, false w przeciwnym razie (komunikat trafia na `std::cerr`).
+ */
+bool Program::parseQuery(const std::string& startDate, const std::string& startTime,
+                         const std::string& endDate, const std::string& endTime, const std::string& type,
+                         std::int32_t& from, std::int32_t& to, int& field) {
+    if (!Timestamp::parse(startDate, startTime, from)) {
+        std::cerr << "Niepoprawna data lub godzina początkowa: " << startDate << " " << startTime << std::endl;
+        return false;
+    }
+    if (!Timestamp::parse(endDate, endTime, to)) {
+        std::cerr << "Niepoprawna data lub godzina końcowa: " << endDate << " " << endTime << std::endl;
+        return false;
+    }
+    field = Record::fieldIndex(type);
+    if (field < 0) {
+        std::cerr << "Nieznany typ danych: " << type << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Oblicza i wypisuje sumę wartości wybranego typu w przedziale czasowym.
+ * 
+ * Suma jest składana z zapamiętanych agregatów węzłów drzewa (patrz `Tree::aggregate`),
+ * więc koszt zapytania nie zależy od liczby rekordów w przedziale.
+ * 
+ * @param startDate Data początkowa w formacie YYYY-MM-DD.
+ * @param startTime Godzina początkowa w formacie HH:MM.
+ * @param endDate Data końcowa w formacie YYYY-MM-DD.
+ * @param endTime Godzina końcowa w formacie HH:MM.
+ * @param type Typ danych.
+ */
+void Program::calculateSum(const std::string& startDate, const std::string& startTime,
+                           const std::string& endDate, const std::string& endTime, const std::string& type) {
+    std::int32_t from = 0, to = 0;
+    int field = 0;
+    if (!parseQuery(startDate, startTime, endDate, endTime, type, from, to, field)) return;
+
+    const Aggregate result = rangeAggregate(tree.view(), from, to, field);
+    std::cout << "Suma (" << type << ") od " << startDate << " " << startTime << " do " << endDate << " "
+              << endTime << ": " << result.sum << " (rekordów: " << result.count << ")" << std::endl;
+}
+
+/**
+ * @brief Oblicza i wypisuje średnią wartość wybranego typu w przedziale czasowym.
+ * 
+ * @param startDate Data początkowa w formacie YYYY-MM-DD.
+ * @param startTime Godzina początkowa w formacie HH:MM.
+ * @param endDate Data końcowa w formacie YYYY-MM-DD.
+ * @param endTime Godzina końcowa w formacie HH:MM.
+ * @param type Typ danych.
+ */
+void Program::calculateAverage(const std::string& startDate, const std::string& startTime,
+                               const std::string& endDate, const std::string& endTime, const std::string& type) {
+    std::int32_t from = 0, to = 0;
+    int field = 0;
+    if (!parseQuery(startDate, startTime, endDate, endTime, type, from, to, field)) return;
+
+    const Aggregate result = rangeAggregate(tree.view(), from, to, field);
+    if (result.count == 0) {
+        std::cout << "Brak rekordów w podanym przedziale." << std::endl;
+        return;
+    }
+    std::cout << "Średnia (" << type << ") od " << startDate << " " << startTime << " do " << endDate << " "
+              << endTime << ": " << result.average() << " (";
+    if (result.min <= result.max) std::cout << "min: " << result.min << ", max: " << result.max << ", ";
+    std::cout << "rekordów: " << result.count << ")" << std::endl;
+}
+
+/**
+ * @brief Porównuje sumy wartości wybranego typu w dwóch przedziałach czasowych.
+ * 
+ * Wypisuje sumy obu przedziałów oraz różnicę (drugi minus pierwszy).
+ * 
+ * @param startDate1 Data początkowa pierwszego zakresu.
+ * @param startTime1 Godzina początkowa pierwszego zakresu.
+ * @param endDate1 Data końcowa pierwszego zakresu.
+ * @param endTime1 Godzina końcowa pierwszego zakresu.
+ * @param startDate2 Data początkowa drugiego zakresu.
+ * @param startTime2 Godzina początkowa drugiego zakresu.
+ * @param endDate2 Data końcowa drugiego zakresu.
+ * @param endTime2 Godzina końcowa drugiego zakresu.
+ * @param type Typ danych.
+ */
+void Program::compareRanges(const std::string& startDate1, const std::string& startTime1,
+                            const std::string& endDate1, const std::string& endTime1,
+                            const std::string& startDate2, const std::string& startTime2,
+                            const std::string& endDate2, const std::string& endTime2, const std::string& type) {
+    std::int32_t from1 = 0, to1 = 0, from2 = 0, to2 = 0;
+    int field = 0;
+    if (!parseQuery(startDate1, startTime1, endDate1, endTime1, type, from1, to1, field)) return;
+    if (!parseQuery(startDate2, startTime2, endDate2, endTime2, type, from2, to2, field)) return;
+
+    // Oba przedziały z tej samej wersji drzewa, miesiące obu we wspólnej puli zadań
+    const std::vector<Aggregate> results = rangeAggregates(tree.view(), { { from1, to1 }, { from2, to2 } }, field, true);
+    const Aggregate& first = results[0];
+    const Aggregate& second = results[1];
+    std::cout << "Porównanie (" << type << "):" << std::endl
+              << "  Zakres 1: " << first.sum << " (rekordów: " << first.count << ")" << std::endl
+              << "  Zakres 2: " << second.sum << " (rekordów: " << second.count << ")" << std::endl
+              << "  Różnica (2 - 1): " << second.sum - first.sum << std::endl;
+}
+
+/**
+ * @brief Oblicza agregat wielkości w przedziale z indeksu sum prefiksowych albo z drzewa.
+ * 
+ * @param view Wersja drzewa.
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości pomiarowej.
+ * @param parallel false - bez puli zapytań.
+ * @return Aggregate Suma i liczba wartości (min/max tylko przy zapytaniu do drzewa).
+ */
+Aggregate Program::rangeAggregate(const ConcurrentTree::View& view, std::int32_t from, std::int32_t to, int field,
+                                  bool parallel) const {
+    return rangeAggregates(view, { { from, to } }, field, parallel).front();
+}
+
+/**
+ * @brief Oblicza agregaty przedziałów z indeksu sum prefiksowych albo z miesięcy drzewa i snapshotu.
+ * 
+ * Wynik miesiąca to agregat drzewa połączony z agregatem snapshotu; wyniki miesięcy są łączone
+ * od najwcześniejszego, więc kolejność dodawania nie zależy od przydziału miesięcy do wątków.
+ * 
+ * @param view Wersja drzewa.
+ * @param ranges Przedziały `[from, to]`.
+ * @param field Indeks wielkości pomiarowej.
+ * @param parallel false - bez puli zapytań.
+ * @return std::vector<Aggregate> Wyniki w kolejności przedziałów.
+ */
+std::vector<Aggregate> Program::rangeAggregates(const ConcurrentTree::View& view,
+                                                const std::vector<std::pair<std::int32_t, std::int32_t>>& ranges,
+                                                int field, bool parallel) const {
+    ScopedTimer timer(Metric::Aggregate);
+    Metrics::add(Metric::Aggregate, ranges.size());
+    std::vector<Aggregate> results(ranges.size());
+    if (prefixIndexEnabled && view.indexed()) {
+        // Sumy narastające miesięcy należą do przypiętej wersji; indeks snapshotu się nie zmienia
+        for (std::size_t r = 0; r < ranges.size(); ++r) {
+            results[r] = view.prefixAggregate(ranges[r].first, ranges[r].second, field);
+            if (snapshot) {
+                results[r].sum += prefixIndex.sum(ranges[r].first, ranges[r].second, field);
+                results[r].count += prefixIndex.count(ranges[r].first, ranges[r].second);
+            }
+        }
+        return results;
+    }
+
+    std::vector<std::pair<std::int32_t, std::int32_t>> spans;
+    std::vector<std::size_t> ends; // koniec fragmentów każdego przedziału w `spans`
+    for (const auto& [from, to] : ranges) {
+        splitByMonths(from, to, spans);
+        ends.push_back(spans.size());
+    }
+    std::vector<Aggregate> partials(spans.size());
+    const Snapshot* const data = snapshot.get();
+    forEachMonth(spans.size(), [&view, data, &spans, &partials, field](std::size_t i) {
+        partials[i] = view.aggregate(spans[i].first, spans[i].second, field);
+        if (data) partials[i].merge(data->aggregate(spans[i].first, spans[i].second, field));
+    }, parallel);
+
+    std::size_t span = 0;
+    for (std::size_t r = 0; r < ranges.size(); ++r) {
+        for (; span < ends[r]; ++span) results[r].merge(partials[span]);
+    }
+    return results;
+}
+
+/**
+ * @brief Wykonuje fragmenty zapytania w puli zapytań (tworzonej przy pierwszym użyciu) lub kolejno.
+ * 
+ * @param count Liczba fragmentów.
+ * @param body Obliczenie fragmentu.
+ * @param parallel false - zawsze kolejno.
+ */
+void Program::forEachMonth(std::size_t count, const std::function<void(std::size_t)>& body, bool parallel) const {
+    ThreadPool* pool = nullptr;
+    if (parallel && count >= minParallelMonths && queryThreads != 1) {
+        std::lock_guard<std::mutex> lock(queryPoolMutex);
+        if (!queryPool) queryPool.reset(new ThreadPool(queryThreads));
+        pool = queryPool.get();
+    }
+    if (pool) {
+        pool->parallelFor(count, body);
+        return;
+    }
+    for (std::size_t i = 0; i < count; ++i) body(i);
+}
+
+/**
+ * @brief Ustawia liczbę wątków zapytań; istniejąca pula jest zamykana i tworzona ponownie przy potrzebie.
+ * 
+ * @param threads Liczba wątków (0 - liczba dostępnych rdzeni, 1 - kolejno).
+ */
+void Program::setQueryThreads(unsigned threads) {
+    std::lock_guard<std::mutex> lock(queryPoolMutex);
+    queryThreads = threads;
+    queryPool.reset();
+}
+
+/**
+ * @brief Oblicza agregaty przedziałów z jednej wersji drzewa.
+ * 
+ * Widok jest przypinany w wątku wywołującym i tylko odczytywany przez wątki puli - wersja
+ * pozostaje przypięta do powrotu z `parallelFor`.
+ * 
+ * @param ranges Przedziały zapytań.
+ * @param results Wyniki w kolejności przedziałów.
+ * @param pool Pula wątków.
+ */
+void Program::aggregateRanges(const std::vector<RangeQuery>& ranges, std::vector<Aggregate>& results,
+                              ThreadPool& pool) const {
+    results.assign(ranges.size(), Aggregate());
+    const ConcurrentTree::View view = tree.view();
+    // Przedziały są już rozdzielone między wątki puli, więc ich miesiące są liczone kolejno
+    pool.parallelFor(ranges.size(), [this, &view, &ranges, &results](std::size_t i) {
+        results[i] = rangeAggregate(view, ranges[i].from, ranges[i].to, ranges[i].field, false);
+    });
+}
+
+/**
+ * @brief Włącza lub wyłącza indeks sum prefiksowych.
+ * 
+ * @param enabled true - zbuduj indeksy drzewa i snapshotu, false - usuń indeksy.
+ */
+void Program::enablePrefixIndex(bool enabled) {
+    prefixIndexEnabled = enabled;
+    tree.enablePrefixIndex(enabled);
+    if (enabled && snapshot) {
+        prefixIndex.build(Tree(), snapshot.get());
+    } else {
+        prefixIndex.clear();
+    }
+}
+
+/**
+ * @brief Zapisuje wszystkie dane (drzewo oraz wczytany snapshot) do pliku binarnego.
+ * 
+ * @param fileName Nazwa pliku docelowego.
+ * 
+ * @note W przypadku błędu zapisu funkcja wypisuje komunikat na standardowe wyjście błędów.
+ */
+void Program::saveToBinary(const std::string& fileName) {
+    ScopedTimer timer(Metric::BinaryIO);
+    std::string error;
+    const SnapshotEncoding encoding = compressionEnabled ? SnapshotEncoding::CompressedBlocks : SnapshotEncoding::Columns;
+    if (!Snapshot::write(fileName, tree.view().copy(), snapshot.get(), encoding, error)) {
+        std::cerr << error << std::endl;
+        return;
+    }
+    Metrics::add(Metric::BinaryIO, tree.view().size() + (snapshot ? snapshot->size() : 0));
+    std::cout << "Zapisano dane do pliku: " << fileName << std::endl;
+}
+
+/**
+ * @brief Wczytuje snapshot z pliku binarnego, zastępując dotychczasowe dane.
+ * 
+ * Snapshot jest najpierw otwierany i sprawdzany w osobnym obiekcie; dopiero gdy jest poprawny,
+ * zastępuje bieżące drzewo i poprzedni snapshot.
+ * 
+ * @param fileName Nazwa pliku binarnego.
+ */
+void Program::loadFromBinary(const std::string& fileName) {
+    ScopedTimer timer(Metric::BinaryIO);
+    std::unique_ptr<Snapshot> loaded(new Snapshot());
+    loaded->setResidentLimit(snapshotMemoryLimit);
+    std::string error;
+    if (!loaded->open(fileName, error)) {
+        std::cerr << error << std::endl;
+        return;
+    }
+
+    tree.clear();
+    snapshot = std::move(loaded);
+    rollups.clear();
+    validRecords = static_cast<int>(snapshot->size());
+    invalidRecords = 0;
+    if (prefixIndexEnabled) prefixIndex.build(Tree(), snapshot.get());
+    Metrics::add(Metric::BinaryIO, snapshot->size());
+
+    std::cout << "Wczytano dane z pliku: " << fileName << " (rekordów: " << snapshot->size() << ")" << std::endl;
+}
+
+/**
+ * @brief Ustawia limit pamięci danych snapshotu (bieżącego i wczytywanych później).
+ * 
+ * @param bytes Limit w bajtach.
+ */
+void Program::setSnapshotMemoryLimit(std::size_t bytes) {
+    snapshotMemoryLimit = bytes;
+    if (snapshot) snapshot->setResidentLimit(bytes);
+}
+
+/**
+ * @brief Wyszukuje i wypisuje rekordy, w których wartość danego typu mieści się w `value ± tolerance`.
+ * 
+ * @param value Szukana wartość.
+ * @param tolerance Tolerancja.
+ * @param startDate Data początkowa (YYYY-MM-DD).
+ * @param startTime Godzina początkowa (HH:MM).
+ * @param endDate Data końcowa (YYYY-MM-DD).
+ * @param endTime Godzina końcowa (HH:MM).
+ * @param type Typ danych.
+ * 
+ * Przykład:
+ * `searchRecords(400, 10, "2020-10-01", "00:00", "2020-10-01", "23:45", "pobor")` wypisze
+ * wszystkie rekordy z 1 października 2020, w których pobór wynosił od 390 do 410 W.
+ */
+void Program::searchRecords(double value, double tolerance, const std::string& startDate,
+                            const std::string& startTime, const std::string& endDate, const std::string& endTime,
+                            const std::string& type) {
+    std::int32_t from = 0, to = 0;
+    int field = 0;
+    if (!parseQuery(startDate, startTime, endDate, endTime, type, from, to, field)) return;
+
+    const std::vector<Record> matches = findRecords(value, tolerance, from, to, field);
+    std::cout << "Znaleziono rekordów (" << type << " = " << value << " ± " << tolerance << "): " << matches.size()
+              << std::endl;
+    for (const Record& record : matches) {
+        std::cout << record.date() << " " << record.time() << ": " << record.field(field) << std::endl;
+    }
+}
+
+/**
+ * @brief Zwraca rekordy ze snapshotu i drzewa spełniające warunek wyszukiwania.
+ * 
+ * Przedział jest dzielony w granicach miesięcy (równolegle od `minParallelMonths` miesięcy).
+ * W każdym miesiącu wyniki obu źródeł są już posortowane chronologicznie, więc wystarcza
+ * ich scalenie, a miesiące są łączone w kolejności czasu.
+ * 
+ * @param value Szukana wartość.
+ * @param tolerance Tolerancja.
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @param parallel false - bez puli zapytań.
+ * @return std::vector<Record> Pasujące rekordy.
+ */
+std::vector<Record> Program::findRecords(double value, double tolerance, std::int32_t from, std::int32_t to, int field,
+                                         bool parallel) const {
+    ScopedTimer timer(Metric::Search);
+    std::vector<std::pair<std::int32_t, std::int32_t>> spans;
+    splitByMonths(from, to, spans);
+    std::vector<std::vector<Record>> parts(spans.size());
+    const ConcurrentTree::View view = tree.view();
+    const Snapshot* const data = snapshot.get();
+    forEachMonth(spans.size(), [&](std::size_t i) {
+        std::vector<Record>& part = parts[i];
+        if (data) data->search(spans[i].first, spans[i].second, field, value, tolerance, part);
+        const std::size_t fromSnapshot = part.size();
+        view.search(spans[i].first, spans[i].second, field, value, tolerance, part);
+        if (fromSnapshot > 0 && fromSnapshot < part.size()) {
+            std::inplace_merge(part.begin(), part.begin() + static_cast<std::ptrdiff_t>(fromSnapshot), part.end(),
+                               [](const Record& a, const Record& b) {
+                                   return a.timestamp < b.timestamp;
+                               });
+        }
+    }, parallel);
+
+    // Miesiące są rozłączne i uporządkowane, więc wystarcza ich złączenie
+    std::size_t total = 0;
+    for (const std::vector<Record>& part : parts) total += part.size();
+    std::vector<Record> matches;
+    matches.reserve(total);
+    for (const std::vector<Record>& part : parts) matches.insert(matches.end(), part.begin(), part.end());
+    Metrics::add(Metric::Search, matches.size());
+    return matches;
+}
+
+/**
+ * @brief Zwraca `k` najlepszych rekordów przedziału ze wspólnego kopca drzewa i snapshotu.
+ * 
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @param k Liczba rekordów.
+ * @param largest true - największe wartości, false - najmniejsze.
+ * @param stats Opcjonalne liczniki przeglądu.
+ * @return std::vector<Record> Rekordy od najlepszego.
+ */
+std::vector<Record> Program::topRecords(std::int32_t from, std::int32_t to, int field, std::size_t k, bool largest,
+                                        ScanStats* stats) const {
+    ScopedTimer timer(Metric::Search);
+    if (field < 0 || field >= Record::fieldCount) return {};
+    TopK top(k, field, largest);
+    ScanStats scan;
+    tree.view().top(from, to, top, scan);
+    if (snapshot) snapshot->top(from, to, top, scan);
+    if (stats) *stats = scan;
+    Metrics::add(Metric::Search, scan.visited);
+    return top.sorted();
+}
+
+/**
+ * @brief Zwraca początki dni bez wartości powyżej `limit` w oknie doby.
+ * 
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @param limit Największa wartość uznawana za zerową.
+ * @param firstMinute Początek okna doby.
+ * @param lastMinute Koniec okna doby.
+ * @param stats Opcjonalne liczniki przeglądu.
+ * @return std::vector<std::int32_t> Początki dni.
+ */
+std::vector<std::int32_t> Program::flatDays(std::int32_t from, std::int32_t to, int field, double limit,
+                                            int firstMinute, int lastMinute, ScanStats* stats) const {
+    ScopedTimer timer(Metric::Search);
+    std::vector<std::int32_t> days;
+    if (field < 0 || field >= Record::fieldCount || lastMinute < firstMinute) return days;
+    ScanStats scan;
+    if (!snapshot) {
+        tree.view().flatDays(from, to, field, limit, firstMinute, lastMinute, days, scan);
+    } else {
+        // Dzień może mieć rekordy w obu źródłach, więc są one najpierw łączone
+        const std::vector<Record> records = mergedRecords(from, to);
+        scan.visited = records.size();
+        Record::withField(field, [&](auto f) {
+            std::int32_t current = 0;
+            bool measured = false, flat = true;
+            for (const Record& record : records) {
+                std::int32_t minute = record.timestamp % Timestamp::minutesPerDay;
+                if (minute < 0) minute += Timestamp::minutesPerDay;
+                const std::int32_t dayStart = record.timestamp - minute;
+                if (measured && dayStart != current) {
+                    if (flat) days.push_back(current);
+                    measured = false;
+                }
+                if (minute < firstMinute || minute > lastMinute) continue;
+                if (!measured) {
+                    current = dayStart;
+                    measured = true;
+                    flat = true;
+                }
+                // NaN nie jest wartością zerową
+                flat = flat && record.get<decltype(f)::value>() <= limit;
+            }
+            if (measured && flat) days.push_back(current);
+        });
+    }
+    if (stats) *stats = scan;
+    Metrics::add(Metric::Search, scan.visited);
+    return days;
+}
 
-    // Próba sparsowania danych z linii
-    if (iss >> date >> time >> autokonsumpcja >> eksport >> import_ >> pobor >> produkcja) {
-        // Jeśli parsowanie się powiodło, tworzymy obiekt Record
-        record = Record(date, time, autokonsumpcja, eksport, import_, pobor, produkcja);
-        return true; // Zwracamy true, jeśli linia została poprawnie sparsowana
+/**
+ * @brief Zwraca rekordy odbiegające od średniej przesuwnego okna poprzednich rekordów.
+ * 
+ * Przedział jest przeglądany kolejno miesiącami (`splitByMonths`, jak w `rangeAggregates`):
+ * rekordy miesiąca z przypiętej wersji drzewa i ze snapshotu trafiają do buforów używanych
+ * ponownie w kolejnych miesiącach i są podawane do okna w kolejności znaczników czasu,
+ * więc pamięć zależy od liczby rekordów miesiąca, a nie całego przedziału.
+ * 
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @param window Liczba poprzednich rekordów w oknie.
+ * @param sigmas Próg w odchyleniach standardowych.
+ * @return std::vector<Deviation> Odchylenia.
+ */
+std::vector<Deviation> Program::findDeviations(std::int32_t from, std::int32_t to, int field, std::size_t window,
+                                               double sigmas) const {
+    ScopedTimer timer(Metric::Search);
+    std::vector<Deviation> deviations;
+    if (field < 0 || field >= Record::fieldCount) return deviations;
+    std::vector<std::pair<std::int32_t, std::int32_t>> spans;
+    splitByMonths(from, to, spans);
+    const ConcurrentTree::View view = tree.view();
+    const Snapshot* const data = snapshot.get();
+    RollingDeviation rolling(window, sigmas);
+    std::vector<Record> fromTree, fromSnapshot;
+    std::size_t visited = 0;
+    Record::withField(field, [&](auto f) {
+        const auto push = [&](const Record& record) {
+            const double value = record.get<decltype(f)::value>();
+            if (std::isnan(value)) return;
+            double mean = 0.0, sigma = 0.0;
+            if (rolling.push(value, mean, sigma)) deviations.push_back(Deviation{ record, mean, sigma });
+        };
+        for (const auto& [begin, end] : spans) {
+            fromTree.clear();
+            fromSnapshot.clear();
+            view.records(begin, end, fromTree);
+            if (data) data->records(begin, end, fromSnapshot);
+            visited += fromTree.size() + fromSnapshot.size();
+
+            // Oba źródła są posortowane chronologicznie; przy równych znacznikach snapshot pierwszy
+            std::size_t t = 0, s = 0;
+            while (t < fromTree.size() || s < fromSnapshot.size()) {
+                if (t == fromTree.size() || (s < fromSnapshot.size() && fromSnapshot[s].timestamp <= fromTree[t].timestamp)) {
+                    push(fromSnapshot[s++]);
+                } else {
+                    push(fromTree[t++]);
+                }
+            }
+        }
+    });
+    Metrics::add(Metric::Search, visited);
+    return deviations;
+}
+
+/**
+ * @brief Zwraca rekordy drzewa i snapshotu z przedziału, scalone według znaczników czasu.
+ * 
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @return std::vector<Record> Rekordy, chronologicznie.
+ */
+std::vector<Record> Program::mergedRecords(std::int32_t from, std::int32_t to) const {
+    std::vector<Record> records;
+    if (snapshot) snapshot->records(from, to, records);
+    const std::size_t fromSnapshot = records.size();
+    tree.view().records(from, to, records);
+    if (fromSnapshot > 0 && fromSnapshot < records.size()) {
+        std::inplace_merge(records.begin(), records.begin() + static_cast<std::ptrdiff_t>(fromSnapshot), records.end(),
+                           [](const Record& a, const Record& b) {
+                               return a.timestamp < b.timestamp;
+                           });
+    }
+    return records;
+}
+
+/**
+ * @brief Zwraca szereg po resamplingu, licząc brakujące okna z agregatów drzewa i snapshotu.
+ * 
+ * Numer generacji pamięci okien jest odczytywany przed przypięciem wersji drzewa, więc okna
+ * policzone z wersji sprzed równoległego dopisania rekordów nie zostaną zapamiętane.
+ * Indeks sum prefiksowych nie jest używany, bo nie przechowuje minimum i maksimum.
+ * 
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param resolution Rozdzielczość.
+ * @return std::vector<RollupBucket> Okna chronologicznie.
+ */
+std::vector<RollupBucket> Program::resample(std::int32_t from, std::int32_t to, Resolution resolution) const {
+    const std::uint64_t generation = rollups.generation();
+    const ConcurrentTree::View view = tree.view();
+    const Snapshot* const data = snapshot.get();
+    return rollups.resample(from, to, resolution, [&view, data](std::int32_t begin, std::int32_t end) {
+        Aggregates result = view.aggregate(begin, end);
+        if (data != nullptr) result.merge(data->aggregate(begin, end));
+        return result;
+    }, generation);
+}
+
+/**
+ * @brief Wypisuje zestawienie wielkości w oknach wybranej rozdzielczości.
+ * 
+ * @param startDate Data początkowa w formacie YYYY-MM-DD.
+ * @param startTime Godzina początkowa w formacie HH:MM.
+ * @param endDate Data końcowa w formacie YYYY-MM-DD.
+ * @param endTime Godzina końcowa w formacie HH:MM.
+ * @param type Typ danych.
+ * @param resolution Nazwa rozdzielczości lub długość okna w minutach.
+ */
+void Program::showRollup(const std::string& startDate, const std::string& startTime, const std::string& endDate,
+                         const std::string& endTime, const std::string& type, const std::string& resolution) {
+    std::int32_t from = 0, to = 0;
+    int field = 0;
+    if (!parseQuery(startDate, startTime, endDate, endTime, type, from, to, field)) return;
+
+    Resolution window;
+    if (resolution == "godzina") {
+        window = Resolution::hourly();
+    } else if (resolution == "dzien") {
+        window = Resolution::daily();
+    } else if (resolution == "miesiac") {
+        window = Resolution::monthly();
+    } else {
+        int minutes = 0;
+        const char* const end = resolution.data() + resolution.size();
+        if (std::from_chars(resolution.data(), end, minutes).ptr != end || minutes <= 0) {
+            std::cerr << "Nieznana rozdzielczość: " << resolution << std::endl;
+            return;
+        }
+        window = Resolution::window(minutes);
+    }
+
+    std::cout << "Zestawienie (" << type << ", " << resolution << ") od " << startDate << " " << startTime << " do "
+              << endDate << " " << endTime << ":" << std::endl;
+    for (const RollupBucket& bucket : resample(from, to, window)) {
+        const Aggregate& values = bucket.stats[field];
+        std::cout << Timestamp::formatDate(bucket.start) << " " << Timestamp::formatTime(bucket.start) << ": ";
+        if (values.count == 0) {
+            std::cout << "brak danych" << std::endl;
+            continue;
+        }
+        std::cout << bucket.energy(field) << " kWh (średnia: " << values.average() << " W, min: " << values.min
+                  << " W, max: " << values.max << " W)" << std::endl;
     }
-    return false; // Zwracamy false, jeśli linia zawiera błędy
 }
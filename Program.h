@@ -1,32 +1,148 @@
 #ifndef PROGRAM_H
 #define PROGRAM_H
 
+#include <cstdint>
 #include <string>
+#include <vector>
+#include <atomic>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include "Anomaly.h"
+#include "ConcurrentTree.h"
+#include "Logger.h"
+#include "PrefixSumIndex.h"
+#include "Rollup.h"
+#include "RowValidator.h"
+#include "Snapshot.h"
+#include "TailFollower.h"
+#include "ThreadPool.h"
 #include "Tree.h"
 
+/**
+ * @brief Przedział zapytania agregującego: `[from, to]` i indeks wielkości pomiarowej.
+ */
+struct RangeQuery {
+    /**
+     * @brief Początek przedziału (minuty od 2000-01-01, włącznie).
+     */
+    std::int32_t from = 0;
+
+    /**
+     * @brief Koniec przedziału (włącznie).
+     */
+    std::int32_t to = 0;
+
+    /**
+     * @brief Indeks wielkości (patrz `Record::fieldIndex`).
+     */
+    int field = 0;
+};
+
 /**
  * @brief Klasa odpowiedzialna za zarządzanie logiką programu.
  * 
  * Klasa `Program` umożliwia wczytywanie danych z pliku CSV, zapisywanie i odczytywanie danych 
- * z plików binarnych, analizę danych oraz obsługę menu użytkownika.
+ * z plików binarnych oraz analizę danych - pojedynczymi zapytaniami lub wsadowo (`BatchQuery`).
+ * 
+ * Zapytania (`calculateSum`, `calculateAverage`, `compareRanges`, `searchRecords`, `findRecords`)
+ * mogą być wykonywane z wielu wątków równocześnie z jednym wątkiem wczytującym dane
+ * (`loadCSV`, `updateFromCSV`, `followCSV`) - każde zapytanie widzi spójną wersję drzewa
+ * (`ConcurrentTree`), razem z indeksami sum prefiksowych publikowanymi w tej samej wersji.
+ * `loadFromBinary`, `enablePrefixIndex` i ustawienia nie mogą być wywoływane równocześnie
+ * z innymi operacjami.
  */
 class Program {
 private:
     /**
      * @brief Drzewo przechowujące dane pomiarowe w strukturze hierarchicznej.
+     * 
+     * Wczytywane rekordy są dodawane paczkami i publikowane jako nowa wersja drzewa;
+     * zapytania czytają przypiętą wersję bez blokad.
      */
-    Tree tree; 
+    ConcurrentTree tree;
+
+    /**
+     * @brief Snapshot wczytany przez `loadFromBinary` (dane używane bezpośrednio ze zmapowanego pliku).
+     * 
+     * Rekordy snapshotu nie są kopiowane do drzewa; zapytania łączą wyniki z drzewa i ze snapshotu.
+     */
+    std::unique_ptr<Snapshot> snapshot;
+
+    /**
+     * @brief Stan śledzenia dopisywanego pliku CSV (`updateFromCSV`, `followCSV`).
+     */
+    std::unique_ptr<TailFollower> follower;
+
+    /**
+     * @brief Opcjonalny indeks sum prefiksowych rekordów snapshotu (suma i średnia w dowolnym przedziale w stałym czasie).
+     * 
+     * Snapshot się nie zmienia, więc indeks jest budowany tylko przy jego wczytaniu. Rekordy drzewa
+     * mają indeksy miesięcy publikowane razem z wersją drzewa (`ConcurrentTree::enablePrefixIndex`).
+     */
+    PrefixSumIndex prefixIndex;
+
+    /**
+     * @brief Informacja, czy indeks sum prefiksowych jest włączony i utrzymywany.
+     */
+    bool prefixIndexEnabled = false;
+
+    /**
+     * @brief Informacja, czy `saveToBinary` zapisuje dane w skompresowanych blokach.
+     */
+    bool compressionEnabled = false;
+
+    /**
+     * @brief Limit pamięci wczytanego snapshotu (patrz `Snapshot::setResidentLimit`).
+     */
+    std::size_t snapshotMemoryLimit = Snapshot::defaultResidentLimit;
+
+    /**
+     * @brief Liczba wątków zapytań o długie przedziały (0 - liczba dostępnych rdzeni).
+     */
+    unsigned queryThreads = 0;
+
+    /**
+     * @brief Pula wątków zapytań, tworzona przy pierwszym zapytaniu obejmującym kilka miesięcy.
+     */
+    mutable std::unique_ptr<ThreadPool> queryPool;
+
+    /**
+     * @brief Synchronizacja tworzenia puli zapytań.
+     */
+    mutable std::mutex queryPoolMutex;
+
+    /**
+     * @brief Zapamiętane szeregi po resamplingu (`resample`), unieważniane przy dopisywaniu rekordów.
+     */
+    mutable RollupCache rollups;
+
+    /**
+     * @brief Poziom szczegółowości logów zapisywanych przez `loadCSV`.
+     */
+    LogLevel logLevel = LogLevel::All;
 
     /**
      * @brief Liczba poprawnie przetworzonych rekordów.
      */
-    int validRecords = 0;   
+    std::atomic<int> validRecords{ 0 };
 
     /**
      * @brief Liczba błędnych rekordów.
      */
-    int invalidRecords = 0; 
+    std::atomic<int> invalidRecords{ 0 };
+
+    /**
+     * @brief Liczba błędnych rekordów według powodu odrzucenia (indeks - `RejectReason`).
+     */
+    std::atomic<int> rejectedRecords[static_cast<std::size_t>(RejectReason::Count)] = {};
+
+    /**
+     * @brief Reguły sprawdzania wierszy wczytywanych z CSV.
+     */
+    ValidationRules validation;
 
     /**
      * @brief Funkcja pomocnicza do parsowania linii z pliku CSV.
@@ -41,37 +157,321 @@ private:
     bool parseLine(const std::string& line, Record& record);
 
     /**
-     * @brief Funkcja pomocnicza do logowania komunikatów do pliku.
+     * @brief Dodaje do drzewa nowe rekordy z fragmentu CSV, pomijając duplikaty.
+     * 
+     * Rekord jest duplikatem, jeśli drzewo lub wczytany snapshot zawiera już pomiar o tym samym
+     * znaczniku czasu. Nowe rekordy są dodawane przez `Tree::addRecord` (agregaty węzłów)
+     * i dopisywane do indeksu sum prefiksowych, jeśli jest włączony.
+     * 
+     * @param begin Wskaźnik na początek fragmentu (początek linii).
+     * @param end Wskaźnik za końcem fragmentu.
+     * @param firstLine Numer pierwszej linii fragmentu w pliku (do logu błędnych rekordów).
+     * @param logger Logger rekordów.
+     * @param added Licznik dodanych rekordów (zwiększany).
+     * @param duplicates Licznik pominiętych duplikatów (zwiększany).
+     */
+    void appendChunk(const char* begin, const char* end, std::size_t firstLine, Logger& logger, int& added,
+                     int& duplicates);
+
+    /**
+     * @brief Wczytuje rekordy dopisane do śledzonego pliku (wspólna część `updateFromCSV` i `followCSV`).
+     * 
+     * @param fileName Nazwa śledzonego pliku CSV.
+     * @param added Liczba dodanych rekordów.
+     * @param duplicates Liczba pominiętych duplikatów.
+     * @param error Opis błędu odczytu.
+     * @return true, jeśli plik udało się przeczytać.
+     */
+    bool readAppended(const std::string& fileName, int& added, int& duplicates, std::string& error);
+
+    /**
+     * @brief Funkcja pomocnicza zamieniająca przedział dat i typ danych na postać używaną przez drzewo.
+     * 
+     * W przypadku niepoprawnej daty, godziny lub typu danych wypisuje komunikat błędu.
+     * 
+     * @param startDate Data początkowa w formacie YYYY-MM-DD.
+     * @param startTime Godzina początkowa w formacie HH:MM.
+     * @param endDate Data końcowa w formacie YYYY-MM-DD.
+     * @param endTime Godzina końcowa w formacie HH:MM.
+     * @param type Typ danych.
+     * @param from Wyjściowy początek przedziału (znacznik czasu).
+     * @param to Wyjściowy koniec przedziału (znacznik czasu).
+     * @param field Wyjściowy indeks wielkości pomiarowej.
+     * @return true, jeśli wszystkie parametry są poprawne, false w przeciwnym razie.
+     */
+    static bool parseQuery(const std::string& startDate, const std::string& startTime,
+                           const std::string& endDate, const std::string& endTime, const std::string& type,
+                           std::int32_t& from, std::int32_t& to, int& field);
+
+    /**
+     * @brief Oblicza sumę i liczbę wartości wybranej wielkości w przedziale czasu.
+     * 
+     * Jeśli indeks sum prefiksowych jest włączony, wynik pochodzi z indeksu (min/max pozostają
+     * nieokreślone), w przeciwnym razie z agregatów wersji drzewa (`ConcurrentTree::View::aggregate`)
+     * połączonych z agregatami wczytanego snapshotu (`Snapshot::aggregate`).
+     * 
+     * Bez indeksu przedział jest dzielony w granicach miesięcy kalendarzowych (`forEachMonth`);
+     * agregat każdego miesiąca łączy drzewo ze snapshotem, a wyniki miesięcy są łączone zawsze
+     * chronologicznie, więc suma jest identyczna bit w bit niezależnie od liczby wątków.
+     * 
+     * @param view Wersja drzewa, z której liczony jest wynik.
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości pomiarowej.
+     * @param parallel false - miesiące liczone w wątku wywołującym (np. wewnątrz innej puli).
+     * @return Aggregate Wynik zapytania.
+     */
+    Aggregate rangeAggregate(const ConcurrentTree::View& view, std::int32_t from, std::int32_t to, int field,
+                             bool parallel = true) const;
+
+    /**
+     * @brief Oblicza agregaty kilku przedziałów jednej wielkości (np. obu przedziałów `compareRanges`).
      * 
-     * @param message Treść komunikatu do zapisania.
-     * @param logFile Nazwa pliku logu, do którego zostanie zapisany komunikat.
+     * Miesiące wszystkich przedziałów trafiają do jednej puli zadań, a wyniki są łączone osobno
+     * dla każdego przedziału, tak jak w `rangeAggregate`.
+     * 
+     * @param view Wersja drzewa.
+     * @param ranges Przedziały `[from, to]`.
+     * @param field Indeks wielkości pomiarowej.
+     * @param parallel false - miesiące liczone w wątku wywołującym.
+     * @return std::vector<Aggregate> Wyniki w kolejności przedziałów.
      */
-    void logMessage(const std::string& message, const std::string& logFile);
+    std::vector<Aggregate> rangeAggregates(const ConcurrentTree::View& view,
+                                           const std::vector<std::pair<std::int32_t, std::int32_t>>& ranges, int field,
+                                           bool parallel) const;
+
+    /**
+     * @brief Wywołuje `body(i)` dla każdego z `count` fragmentów zapytania - równolegle w puli
+     *        zapytań, jeśli fragmentów jest co najmniej `minParallelMonths`, w przeciwnym razie kolejno.
+     * 
+     * @param count Liczba fragmentów.
+     * @param body Obliczenie fragmentu (wynik zapisywany pod indeksem fragmentu).
+     * @param parallel false - zawsze kolejno.
+     */
+    void forEachMonth(std::size_t count, const std::function<void(std::size_t)>& body, bool parallel) const;
+
+    /**
+     * @brief Zwraca rekordy drzewa i snapshotu z przedziału `[from, to]`, chronologicznie.
+     * 
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @return std::vector<Record> Rekordy obu źródeł.
+     */
+    std::vector<Record> mergedRecords(std::int32_t from, std::int32_t to) const;
 
 public:
+    /**
+     * @brief Parsuje linię CSV bezpośrednio z bufora (np. zmapowanego pliku).
+     * 
+     * Wersja bez alokacji pośrednich: pola są czytane wprost z bajtów w zakresie
+     * `[begin, end)`, a liczby konwertowane przez `std::from_chars`. Obsługiwany jest
+     * format eksportu falownika: `DD.MM.YYYY H:MM,"v1","v2","v3","v4","v5"`
+     * (cudzysłowy wokół wartości są opcjonalne).
+     * 
+     * @param begin Wskaźnik na pierwszy znak linii.
+     * @param end Wskaźnik za ostatnim znakiem linii (bez znaku nowej linii).
+     * @param record Obiekt klasy `Record`, który zostanie wypełniony danymi.
+     * @return true, jeśli parsowanie zakończyło się sukcesem, false w przeciwnym razie.
+     */
+    static bool parseLine(const char* begin, const char* end, Record& record);
+
+    /**
+     * @brief Parsuje linię CSV z bufora i podaje powód odrzucenia.
+     * 
+     * Oprócz formatu sprawdzana jest poprawność daty i godziny w kalendarzu (np. 31.09 jest
+     * odrzucane z powodem `RejectReason::Date`).
+     * 
+     * @param begin Wskaźnik na pierwszy znak linii.
+     * @param end Wskaźnik za ostatnim znakiem linii (bez znaku nowej linii).
+     * @param record Obiekt klasy `Record`, który zostanie wypełniony danymi.
+     * @param reason Powód odrzucenia (`RejectReason::None` dla poprawnej linii).
+     * @return true, jeśli parsowanie zakończyło się sukcesem, false w przeciwnym razie.
+     */
+    static bool parseLine(const char* begin, const char* end, Record& record, RejectReason& reason);
+
+    /**
+     * @brief Parsuje fragment zmapowanego pliku CSV i dodaje poprawne rekordy do drzewa.
+     * 
+     * Fragment musi zaczynać się na początku linii. Funkcja nie korzysta ze stanu obiektu,
+     * dzięki czemu może być wywoływana równolegle dla rozłącznych fragmentów pliku,
+     * z osobnym drzewem i licznikami dla każdego wątku i wspólnym loggerem (także przez `Fleet`).
+     * 
+     * @param begin Wskaźnik na początek fragmentu.
+     * @param end Wskaźnik za końcem fragmentu.
+     * @param target Drzewo, do którego dodawane są poprawne rekordy.
+     * @param valid Licznik poprawnych rekordów (zwiększany).
+     * @param invalid Licznik błędnych rekordów (zwiększany).
+     * @param logger Logger rekordów (poprawnych i błędnych).
+     */
+    static void parseChunk(const char* begin, const char* end, Tree& target, int& valid, int& invalid,
+                           Logger& logger);
+
+    /**
+     * @brief Parsuje fragment zmapowanego pliku CSV, sprawdza wiersze paczkami i dodaje poprawne rekordy do drzewa.
+     * 
+     * Wiersze są sprawdzane przez `RowValidator` według `rules`. Odrzucone wiersze nie są logowane,
+     * tylko zapisywane w `report.rejections` z numerami linii względem początku fragmentu -
+     * wywołujący loguje je po przesunięciu o numer pierwszej linii fragmentu w pliku.
+     * 
+     * @param begin Wskaźnik na początek fragmentu.
+     * @param end Wskaźnik za końcem fragmentu.
+     * @param target Drzewo, do którego dodawane są poprawne rekordy.
+     * @param rules Reguły sprawdzania wierszy.
+     * @param report Raport fragmentu (liczniki według powodu, liczba linii, odrzucone wiersze).
+     * @param logger Logger poprawnych rekordów.
+     * @param earlier Wcześniej przyjęte dane - znaczniki czasu ich rekordów są duplikatami.
+     * @param logValid false - poprawne rekordy nie są logowane.
+     */
+    static void parseChunk(const char* begin, const char* end, Tree& target, const ValidationRules& rules,
+                           LoadReport& report, Logger& logger, const EarlierData& earlier = EarlierData(),
+                           bool logValid = true);
+
     /**
      * @brief Wczytuje dane z pliku CSV do drzewa.
      * 
-     * Plik CSV jest analizowany linia po linii. Poprawne rekordy są dodawane do drzewa,
-     * natomiast błędne rekordy są logowane w plikach błędów.
+     * Plik CSV jest mapowany do pamięci i analizowany linia po linii bez kopiowania danych.
+     * Poprawne rekordy są dodawane do drzewa, natomiast błędne rekordy są logowane w plikach błędów.
+     * Linie nagłówka (`Time,...`) oraz puste linie są pomijane.
+     * 
+     * Każdy wiersz jest sprawdzany (`setValidationRules`): format, data i godzina, wartości
+     * nieliczbowe i ujemne, powtórzone znaczniki czasu (także względem danych wczytanych
+     * wcześniej do drzewa lub ze snapshotu) i opcjonalnie bilans mocy. Odrzucone
+     * wiersze trafiają do logu błędów z numerem linii i powodem, a ich liczby według powodu
+     * zwraca `getInvalidRecords(RejectReason)`.
+     * 
+     * Przy `threadCount > 1` plik jest dzielony na fragmenty na granicach linii, fragmenty są
+     * parsowane równolegle do lokalnych drzew, a następnie scalane do `tree` w kolejności
+     * występowania w pliku. Wynik (zawartość drzewa, liczniki) jest identyczny jak
+     * przy wczytywaniu jednowątkowym. Wiersze są logowane dopiero po scaleniu, gdy rozstrzygnięte
+     * są duplikaty między fragmentami: błędne w kolejności linii, a poprawne równolegle, więc wpisy
+     * z różnych fragmentów mogą się przeplatać.
+     * 
+     * Zakres logowania określa `setLogLevel`; logi są zapisywane asynchronicznie (`Logger`).
      * 
      * @param fileName Nazwa pliku CSV do wczytania.
+     * @param threadCount Liczba wątków (1 - wczytywanie jednowątkowe, 0 - liczba rdzeni).
+     */
+    void loadCSV(const std::string& fileName, unsigned threadCount = 1);
+
+    /**
+     * @brief Wczytuje z pliku CSV tylko rekordy dopisane od poprzedniego wywołania.
+     * 
+     * Program pamięta przesunięcie końca ostatniej przeczytanej pełnej linii śledzonego pliku
+     * (`TailFollower`); pierwsze wywołanie dla danego pliku czyta go od początku. Rekordy
+     * o znacznikach czasu obecnych już w danych są pomijane, więc wywołanie po `loadCSV` tego
+     * samego pliku lub po rotacji pliku nie dubluje danych ani liczników. Agregaty drzewa
+     * i indeks sum prefiksowych są aktualizowane przyrostowo. Logi są dopisywane na końcu plików logów.
+     * 
+     * @param fileName Nazwa śledzonego pliku CSV.
+     * @param added Liczba dodanych rekordów.
+     * @param duplicates Liczba pominiętych duplikatów.
+     * @return true, jeśli plik udało się przeczytać.
+     */
+    bool updateFromCSV(const std::string& fileName, int& added, int& duplicates);
+
+    /**
+     * @brief Śledzi dopisywany plik CSV i na bieżąco dodaje nowe rekordy (tryb `tail -f`).
+     * 
+     * W pętli wywołuje `updateFromCSV` i czeka na zmianę pliku (inotify na Linuksie, w pozostałych
+     * systemach odpytywanie co `intervalMs`). Nowe rekordy są widoczne w zapytaniach najpóźniej
+     * po `intervalMs`. Funkcja kończy działanie po ustawieniu `stop` (sprawdzanym co `intervalMs`).
+     * 
+     * @param fileName Nazwa śledzonego pliku CSV.
+     * @param stop Flaga zakończenia śledzenia.
+     * @param intervalMs Maksymalny czas oczekiwania na zmianę pliku w milisekundach.
+     */
+    void followCSV(const std::string& fileName, const std::atomic<bool>& stop, int intervalMs = 1000);
+
+    /**
+     * @brief Ustawia poziom szczegółowości logów wczytywania.
+     * 
+     * Domyślnie (`LogLevel::All`) logowany jest każdy rekord. `LogLevel::Errors` ogranicza log
+     * do błędnych rekordów, `LogLevel::Summary` do liczników, a `LogLevel::None` wyłącza logi.
+     * 
+     * @param level Poziom szczegółowości.
+     */
+    void setLogLevel(LogLevel level) { logLevel = level; }
+
+    /**
+     * @brief Ustawia reguły sprawdzania wierszy wczytywanych przez `loadCSV` i `updateFromCSV`.
+     * 
+     * Domyślnie odrzucane są wartości ujemne i powtórzone znaczniki czasu, a bilans mocy nie jest
+     * sprawdzany. W `updateFromCSV` powtórzone znaczniki są zawsze pomijane jako duplikaty.
+     * 
+     * @param rules Reguły sprawdzania.
+     */
+    void setValidationRules(const ValidationRules& rules) { validation = rules; }
+
+    /**
+     * @brief Włącza lub wyłącza indeks sum prefiksowych.
+     * 
+     * Po włączeniu indeks jest budowany z bieżącej zawartości drzewa i snapshotu; indeksy miesięcy
+     * drzewa zmienianych przez wczytywanie danych są odbudowywane w nowej wersji drzewa.
+     * Zapytania `calculateSum`, `calculateAverage` i `compareRanges` korzystają wtedy z indeksu
+     * (dwie sumy narastające na krańcach przedziału - koszt nie rośnie z długością przedziału).
+     * 
+     * @param enabled true - włącz indeks, false - wyłącz i zwolnij pamięć.
+     */
+    void enablePrefixIndex(bool enabled);
+
+    /**
+     * @brief Włącza lub wyłącza kompresję danych zapisywanych przez `saveToBinary`.
+     * 
+     * Skompresowany snapshot (`SnapshotEncoding::CompressedBlocks`) zajmuje kilkukrotnie mniej
+     * miejsca na dysku i w pamięci; zapytania dekodują tylko bloki na krawędziach przedziału.
+     * `loadFromBinary` rozpoznaje sposób zapisu automatycznie.
+     * 
+     * @param enabled true - zapis skompresowany, false - zapis nieskompresowanych kolumn.
+     */
+    void enableCompression(bool enabled) { compressionEnabled = enabled; }
+
+    /**
+     * @brief Najmniejsza liczba miesięcy przedziału, od której zapytanie jest wykonywane równolegle.
+     */
+    static constexpr std::size_t minParallelMonths = 4;
+
+    /**
+     * @brief Ustawia liczbę wątków zapytań o długie przedziały.
+     * 
+     * Agregaty (`calculateSum`, `calculateAverage`, `compareRanges`) i wyszukiwanie (`findRecords`)
+     * dzielą przedział w granicach miesięcy; od `minParallelMonths` miesięcy fragmenty są liczone
+     * w puli wątków (wolne wątki pobierają kolejne miesiące), a wyniki są łączone w kolejności
+     * miesięcy - niezależnie od liczby wątków.
+     * 
+     * @param threads Liczba wątków razem z wątkiem wywołującym (0 - liczba dostępnych rdzeni, 1 - kolejno).
+     */
+    void setQueryThreads(unsigned threads);
+
+    /**
+     * @brief Ustawia limit pamięci danych wczytanego (i każdego następnego) snapshotu.
+     * 
+     * Snapshot nie jest wczytywany w całości: zapytania czytają tylko potrzebne miesiące kolumn
+     * lub dekodują potrzebne bloki, a najdawniej używane są zwalniane po przekroczeniu limitu
+     * (patrz `Snapshot::setResidentLimit`).
+     * 
+     * @param bytes Limit w bajtach.
      */
-    void loadCSV(const std::string& fileName);
+    void setSnapshotMemoryLimit(std::size_t bytes);
 
     /**
      * @brief Zapisuje dane drzewa do pliku binarnego.
      * 
-     * Dane są zapisywane w formacie binarnym, co umożliwia szybki odczyt w przyszłości.
+     * Dane są zapisywane w wersjonowanym formacie kolumnowym (patrz `Snapshot`), który
+     * `loadFromBinary` mapuje do pamięci i używa bez deserializacji rekordów. Do pliku trafiają
+     * zarówno rekordy drzewa, jak i rekordy wcześniej wczytanego snapshotu.
      * 
      * @param fileName Nazwa pliku binarnego, do którego zostaną zapisane dane.
      */
     void saveToBinary(const std::string& fileName);
 
     /**
-     * @brief Wczytuje dane z pliku binarnego do drzewa.
+     * @brief Wczytuje dane z pliku binarnego.
      * 
      * Dane w pliku binarnym muszą być zgodne z formatem wygenerowanym przez `saveToBinary`.
+     * Plik jest mapowany do pamięci i sprawdzany jest tylko jego nagłówek, więc czas wczytania
+     * nie zależy od liczby rekordów. Wczytany snapshot zastępuje wszystkie dotychczasowe dane.
+     * Plik w nieobsługiwanej wersji lub uszkodzony jest odrzucany z komunikatem błędu,
+     * a dotychczasowe dane pozostają bez zmian.
      * 
      * @param fileName Nazwa pliku binarnego do wczytania.
      */
@@ -139,12 +539,149 @@ public:
                        const std::string& startTime, const std::string& endDate, const std::string& endTime, const std::string& type);
 
     /**
-     * @brief Wyświetla menu główne programu.
+     * @brief Oblicza agregaty wielu przedziałów na jednej wersji danych, równolegle w wątkach puli.
      * 
-     * Menu umożliwia użytkownikowi wybór opcji, takich jak wczytanie pliku CSV, analiza danych 
-     * lub zapis do pliku binarnego.
+     * Wszystkie przedziały są liczone z tej samej, przypiętej wersji drzewa (jak oba przedziały
+     * `compareRanges`), więc wyniki są spójne także przy równoległym dopisywaniu rekordów.
+     * 
+     * @param ranges Przedziały zapytań.
+     * @param results Wyniki (w kolejności przedziałów; min/max nieokreślone przy indeksie sum prefiksowych).
+     * @param pool Pula wątków.
+     */
+    void aggregateRanges(const std::vector<RangeQuery>& ranges, std::vector<Aggregate>& results, ThreadPool& pool) const;
+
+    /**
+     * @brief Zwraca agregat wielkości w przedziale (jak `calculateSum`, bez wypisywania).
+     * 
+     * @param from Początek przedziału (minuty od 2000-01-01, włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości (patrz `Record::fieldIndex`).
+     * @return Aggregate Suma, liczba, minimum i maksimum (min/max nieokreślone przy indeksie sum prefiksowych).
+     */
+    Aggregate aggregate(std::int32_t from, std::int32_t to, int field) const {
+        return rangeAggregate(tree.view(), from, to, field);
+    }
+
+    /**
+     * @brief Zwraca rekordy z przedziału `[from, to]`, w których `|wartość - value| <= tolerance`.
+     * 
+     * Wielkość jest wybierana raz na zapytanie (indeks kolumny), a kolumny drzewa i snapshotu
+     * są filtrowane wektorowo (`SearchKernel`).
+     * 
+     * @param value Szukana wartość.
+     * @param tolerance Tolerancja.
+     * @param from Początek przedziału (minuty od 2000-01-01, włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości (patrz `Record::fieldIndex`).
+     * @param parallel false - miesiące przeszukiwane w wątku wywołującym (np. wewnątrz innej puli).
+     * @return std::vector<Record> Pasujące rekordy, chronologicznie.
+     */
+    std::vector<Record> findRecords(double value, double tolerance, std::int32_t from, std::int32_t to, int field,
+                                    bool parallel = true) const;
+
+    /**
+     * @brief Zwraca `k` rekordów przedziału o największych (lub najmniejszych) wartościach wielkości.
+     * 
+     * Rekordy drzewa i snapshotu trafiają do wspólnego ograniczonego kopca (`TopK`); węzły drzewa
+     * oraz dni (bloki) snapshotu, których maksimum (minimum) nie pobije najgorszego zachowanego
+     * rekordu, nie są przeglądane. Np. szczyt importu z sieci to `field = Record::fieldIndex("import")`, `largest = true`.
+     * 
+     * @param from Początek przedziału (minuty od 2000-01-01, włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości (patrz `Record::fieldIndex`).
+     * @param k Liczba rekordów.
+     * @param largest true - największe wartości, false - najmniejsze.
+     * @param stats Opcjonalne liczniki przejrzanych i pominiętych rekordów.
+     * @return std::vector<Record> Rekordy od najlepszego (równe wartości - chronologicznie).
+     */
+    std::vector<Record> topRecords(std::int32_t from, std::int32_t to, int field, std::size_t k, bool largest,
+                                   ScanStats* stats = nullptr) const;
+
+    /**
+     * @brief Zwraca początki dni, w których wielkość w oknie doby nie przekracza `limit` (np. dni bez produkcji).
+     * 
+     * Bez wczytanego snapshotu dni są wyznaczane z przycinaniem po minimach i maksimach węzłów
+     * drzewa (`Tree::flatDays`); ze snapshotem - z połączonych chronologicznie rekordów obu źródeł.
+     * 
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości.
+     * @param limit Największa wartość uznawana za zerową.
+     * @param firstMinute Początek okna doby (minuta doby, włącznie).
+     * @param lastMinute Koniec okna doby (minuta doby, włącznie).
+     * @param stats Opcjonalne liczniki przejrzanych i pominiętych rekordów.
+     * @return std::vector<std::int32_t> Znaczniki czasu północy znalezionych dni, chronologicznie.
+     */
+    std::vector<std::int32_t> flatDays(std::int32_t from, std::int32_t to, int field, double limit, int firstMinute,
+                                       int lastMinute, ScanStats* stats = nullptr) const;
+
+    /**
+     * @brief Zwraca rekordy odbiegające o więcej niż `sigmas` odchyleń standardowych od średniej
+     *        `window` poprzednich rekordów (np. skoki eksportu do sieci).
+     * 
+     * Statystyki przesuwnego okna (`RollingDeviation`) zależą od każdego rekordu, więc przedział
+     * jest zawsze przeglądany w całości, w kolejności znaczników czasu.
+     * 
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości.
+     * @param window Liczba poprzednich rekordów w oknie.
+     * @param sigmas Próg w odchyleniach standardowych (np. 3).
+     * @return std::vector<Deviation> Odchylenia, chronologicznie.
+     */
+    std::vector<Deviation> findDeviations(std::int32_t from, std::int32_t to, int field, std::size_t window,
+                                          double sigmas) const;
+
+    /**
+     * @brief Zwraca szereg danych po resamplingu do podanej rozdzielczości.
+     * 
+     * Każde okno zawiera sumę, liczbę, minimum i maksimum wszystkich wielkości (z drzewa
+     * i snapshotu) oraz energię w kWh (`RollupBucket::energy`). Okna są zapamiętywane, a dopisanie
+     * rekordów unieważnia tylko okna obejmujące nowe znaczniki czasu.
+     * 
+     * @param from Początek przedziału (minuty od 2000-01-01, włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param resolution Rozdzielczość (np. `Resolution::daily()`).
+     * @return std::vector<RollupBucket> Okna pokrywające przedział, chronologicznie.
+     */
+    std::vector<RollupBucket> resample(std::int32_t from, std::int32_t to, Resolution resolution) const;
+
+    /**
+     * @brief Wypisuje zestawienie wybranej wielkości w oknach podanej rozdzielczości.
+     * 
+     * Dla każdego okna wypisywane są energia [kWh], średnia, minimum i maksimum mocy [W].
+     * 
+     * @param startDate Data początkowa w formacie YYYY-MM-DD.
+     * @param startTime Godzina początkowa w formacie HH:MM.
+     * @param endDate Data końcowa w formacie YYYY-MM-DD.
+     * @param endTime Godzina końcowa w formacie HH:MM.
+     * @param type Typ danych.
+     * @param resolution Rozdzielczość: "godzina", "dzien", "miesiac" lub długość okna w minutach.
+     */
+    void showRollup(const std::string& startDate, const std::string& startTime, const std::string& endDate,
+                    const std::string& endTime, const std::string& type, const std::string& resolution);
+
+    /**
+     * @brief Zwraca kopię bieżącej wersji drzewa z wczytanymi danymi.
+     * 
+     * @return Tree Kopia danych drzewa (bez rekordów snapshotu).
+     */
+    Tree getTree() const { return tree.view().copy(); }
+
+    /**
+     * @brief Zwraca liczbę poprawnie przetworzonych rekordów.
+     */
+    int getValidRecords() const { return validRecords; }
+
+    /**
+     * @brief Zwraca liczbę błędnych rekordów.
+     */
+    int getInvalidRecords() const { return invalidRecords; }
+
+    /**
+     * @brief Zwraca liczbę błędnych rekordów odrzuconych z podanego powodu.
      */
-    void menu();
+    int getInvalidRecords(RejectReason reason) const { return rejectedRecords[static_cast<std::size_t>(reason)]; }
 };
 
 #endif // PROGRAM_H
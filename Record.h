@@ -1,27 +1,27 @@
 #ifndef RECORD_H
 #define RECORD_H
 
+#include <cstdint>
 #include <string>
 #include <sstream>
 #include <iomanip>
+#include <type_traits>
+#include "Timestamp.h"
 
 /**
  * @brief Klasa reprezentująca pojedynczy punkt pomiarowy (rekord danych).
  * 
- * Klasa przechowuje dane z jednego pomiaru energetycznego, w tym datę, godzinę,
- * oraz wartości takie jak autokonsumpcja, eksport, import, pobór i produkcja energii.
+ * Klasa przechowuje dane z jednego pomiaru energetycznego: znacznik czasu (minuty od
+ * 2000-01-01 00:00, wyznaczany raz przy parsowaniu) oraz wartości takie jak autokonsumpcja,
+ * eksport, import, pobór i produkcja energii. Data i godzina są formatowane tylko na potrzeby
+ * wyjścia (`date`, `time`, `toString`).
  */
 class Record {
 public:
     /**
-     * @brief Data pomiaru w formacie YYYY-MM-DD.
+     * @brief Znacznik czasu pomiaru (minuty od 2000-01-01 00:00, patrz `Timestamp`).
      */
-    std::string date;
-
-    /**
-     * @brief Godzina pomiaru w formacie HH:MM.
-     */
-    std::string time;
+    std::int32_t timestamp;
 
     /**
      * @brief Wartość autokonsumpcji energii w watach [W].
@@ -51,11 +51,119 @@ public:
      */
     double produkcja;
 
+    /**
+     * @brief Liczba wielkości pomiarowych w rekordzie.
+     */
+    static constexpr int fieldCount = 5;
+
+    /**
+     * @brief Zamienia nazwę typu danych na indeks wielkości pomiarowej.
+     * 
+     * @param type Typ danych: "autokonsumpcja", "eksport", "import", "pobor" lub "produkcja".
+     * @return int Indeks 0-4 albo -1 dla nieznanego typu.
+     */
+    static int fieldIndex(const std::string& type) {
+        for (int i = 0; i < fieldCount; ++i) {
+            if (type == fieldName(i)) return i;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Zwraca nazwę typu danych wielkości o podanym indeksie (odwrotność `fieldIndex`).
+     * 
+     * @param index Indeks wielkości 0-4.
+     * @return const char* Nazwa typu danych.
+     */
+    static const char* fieldName(int index) {
+        static const char* const names[fieldCount] = { "autokonsumpcja", "eksport", "import", "pobor", "produkcja" };
+        return names[index];
+    }
+
+    /**
+     * @brief Zwraca wartość wielkości pomiarowej o podanym indeksie.
+     * 
+     * @param index Indeks wielkości (patrz `fieldIndex`).
+     * @return double Wartość pomiaru.
+     */
+    double field(int index) const {
+        switch (index) {
+            case 0: return autokonsumpcja;
+            case 1: return eksport;
+            case 2: return import_;
+            case 3: return pobor;
+            default: return produkcja;
+        }
+    }
+
+    /**
+     * @brief Zwraca wartość wielkości `Field` wybranej w czasie kompilacji (bez `switch` w pętli po rekordach).
+     * 
+     * @tparam Field Indeks wielkości (patrz `fieldIndex`).
+     */
+    template <int Field>
+    double get() const {
+        static_assert(Field >= 0 && Field < fieldCount, "niepoprawny indeks wielkości");
+        if constexpr (Field == 0) return autokonsumpcja;
+        else if constexpr (Field == 1) return eksport;
+        else if constexpr (Field == 2) return import_;
+        else if constexpr (Field == 3) return pobor;
+        else return produkcja;
+    }
+
+    /**
+     * @brief Wywołuje `body` z indeksem wielkości jako stałą czasu kompilacji.
+     * 
+     * Indeks z zapytania jest zamieniany na typ `std::integral_constant<int, Field>` raz na
+     * zapytanie, a `body` (zwykle lambda z parametrem `auto`) jest konkretyzowane osobno dla
+     * każdej wielkości - pętle w jego wnętrzu korzystają z `get<Field>()` lub kolumny `Field`.
+     * 
+     * @param field Indeks wielkości 0-4 (inne wartości - produkcja, jak w `field`).
+     * @param body Wywoływana funkcja.
+     * @return Wynik `body`.
+     */
+    template <typename Body>
+    static decltype(auto) withField(int field, Body&& body) {
+        switch (field) {
+            case 0: return body(std::integral_constant<int, 0>());
+            case 1: return body(std::integral_constant<int, 1>());
+            case 2: return body(std::integral_constant<int, 2>());
+            case 3: return body(std::integral_constant<int, 3>());
+            default: return body(std::integral_constant<int, 4>());
+        }
+    }
+
+    /**
+     * @brief Konstruktor domyślny klasy Record.
+     * 
+     * Tworzy pusty rekord (wszystkie wartości równe 0), który może zostać następnie
+     * wypełniony przez parser (np. `Program::parseLine`).
+     */
+    Record()
+        : timestamp(0), autokonsumpcja(0.0), eksport(0.0), import_(0.0), pobor(0.0), produkcja(0.0) {}
+
     /**
      * @brief Konstruktor klasy Record.
      * 
      * Inicjalizuje obiekt klasy Record danymi z jednego punktu pomiarowego.
      * 
+     * @param timestamp Znacznik czasu pomiaru (minuty od 2000-01-01 00:00).
+     * @param autokonsumpcja Wartość autokonsumpcji energii w watach [W].
+     * @param eksport Wartość energii wyeksportowanej do sieci w watach [W].
+     * @param import_ Wartość energii zaimportowanej z sieci w watach [W].
+     * @param pobor Wartość energii pobranej przez odbiorniki w watach [W].
+     * @param produkcja Wartość energii wyprodukowanej przez falownik w watach [W].
+     */
+    Record(std::int32_t timestamp, double autokonsumpcja, double eksport, double import_, double pobor, double produkcja)
+        : timestamp(timestamp), autokonsumpcja(autokonsumpcja), eksport(eksport),
+          import_(import_), pobor(pobor), produkcja(produkcja) {}
+
+    /**
+     * @brief Konstruktor klasy Record z datą i godziną zapisanymi tekstowo.
+     * 
+     * Data i godzina są parsowane raz (`Timestamp::parse`); niepoprawny napis daje znacznik 0
+     * (2000-01-01 00:00). Parsery plików wypełniają `timestamp` bezpośrednio.
+     * 
      * @param date Data pomiaru w formacie YYYY-MM-DD.
      * @param time Godzina pomiaru w formacie HH:MM.
      * @param autokonsumpcja Wartość autokonsumpcji energii w watach [W].
@@ -67,8 +175,19 @@ public:
     Record(const std::string& date, const std::string& time, 
            double autokonsumpcja, double eksport, 
            double import_, double pobor, double produkcja)
-        : date(date), time(time), autokonsumpcja(autokonsumpcja), eksport(eksport),
-          import_(import_), pobor(pobor), produkcja(produkcja) {}
+        : Record(0, autokonsumpcja, eksport, import_, pobor, produkcja) {
+        Timestamp::parse(date, time, timestamp);
+    }
+
+    /**
+     * @brief Zwraca datę pomiaru w formacie YYYY-MM-DD.
+     */
+    std::string date() const { return Timestamp::formatDate(timestamp); }
+
+    /**
+     * @brief Zwraca godzinę pomiaru w formacie HH:MM.
+     */
+    std::string time() const { return Timestamp::formatTime(timestamp); }
 
     /**
      * @brief Funkcja zwracająca tekstową reprezentację rekordu.
@@ -80,7 +199,7 @@ public:
      */
     std::string toString() const {
         std::ostringstream oss;
-        oss << "Record(date=" << date << ", time=" << time
+        oss << "Record(date=" << date() << ", time=" << time()
             << ", autokonsumpcja=" << autokonsumpcja
             << ", eksport=" << eksport << ", import=" << import_
             << ", pobor=" << pobor << ", produkcja=" << produkcja << ")";
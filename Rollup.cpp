@@ -0,0 +1,127 @@
+#include "Rollup.h"
+#include "Timestamp.h"
+
+/**
+ * @brief Zwraca początek okna zawierającego znacznik czasu.
+ *
+ * @param timestamp Znacznik czasu (minuty od 2000-01-01 00:00).
+ * @return std::int32_t Początek okna.
+ */
+std::int32_t Resolution::bucketStart(std::int32_t timestamp) const {
+    if (minutes <= 0) {
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+        Timestamp::toDateTime(timestamp, year, month, day, hour, minute);
+        return Timestamp::fromDateTime(year, month, 1, 0, 0);
+    }
+    // Zaokrąglenie w dół także dla znaczników sprzed 2000 roku
+    std::int32_t index = timestamp / minutes;
+    if (timestamp % minutes < 0) --index;
+    return index * minutes;
+}
+
+/**
+ * @brief Zwraca początek następnego okna.
+ *
+ * @param start Początek okna.
+ * @return std::int32_t Początek następnego okna (koniec bieżącego).
+ */
+std::int32_t Resolution::bucketEnd(std::int32_t start) const {
+    if (minutes > 0) return start + minutes;
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    Timestamp::toDateTime(start, year, month, day, hour, minute);
+    return month == 12 ? Timestamp::fromDateTime(year + 1, 1, 1, 0, 0) : Timestamp::fromDateTime(year, month + 1, 1, 0, 0);
+}
+
+/**
+ * @brief Zwraca numer generacji danych.
+ */
+std::uint64_t RollupCache::generation() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return current;
+}
+
+/**
+ * @brief Zwraca okna pokrywające przedział, licząc tylko okna nieobecne w pamięci.
+ *
+ * Okna są liczone bez blokady (funkcja źródłowa może być kosztowna), a zapisywane tylko wtedy,
+ * gdy w międzyczasie nie było unieważnienia - inaczej mogłyby pochodzić ze starszej wersji danych.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param resolution Rozdzielczość.
+ * @param source Funkcja źródłowa.
+ * @param generation Numer generacji odczytany przed przypięciem danych źródła.
+ * @return std::vector<RollupBucket> Okna chronologicznie.
+ */
+std::vector<RollupBucket> RollupCache::resample(std::int32_t from, std::int32_t to, Resolution resolution,
+                                                const Source& source, std::uint64_t generation) {
+    std::vector<RollupBucket> result;
+    if (to < from) return result;
+
+    // Okna z pamięci i lista brakujących
+    std::vector<std::size_t> missing;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const std::map<std::int32_t, RollupBucket>& cached = series[resolution.minutes];
+        for (std::int32_t start = resolution.bucketStart(from); start <= to; start = resolution.bucketEnd(start)) {
+            const auto it = cached.find(start);
+            if (it != cached.end()) {
+                result.push_back(it->second);
+                continue;
+            }
+            missing.push_back(result.size());
+            RollupBucket bucket;
+            bucket.start = start;
+            bucket.end = resolution.bucketEnd(start);
+            result.push_back(bucket);
+        }
+    }
+    if (missing.empty()) return result;
+
+    for (std::size_t index : missing) {
+        RollupBucket& bucket = result[index];
+        bucket.stats = source(bucket.start, bucket.end - 1);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (current == generation) {
+        std::map<std::int32_t, RollupBucket>& cached = series[resolution.minutes];
+        for (std::size_t index : missing) cached.emplace(result[index].start, result[index]);
+    }
+    return result;
+}
+
+/**
+ * @brief Usuwa okna wszystkich rozdzielczości, które obejmują przedział `[from, to]`.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ */
+void RollupCache::invalidate(std::int32_t from, std::int32_t to) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++current;
+    if (to < from) return;
+    for (auto& [minutes, buckets] : series) {
+        const Resolution resolution{ minutes };
+        buckets.erase(buckets.lower_bound(resolution.bucketStart(from)), buckets.upper_bound(to));
+    }
+}
+
+/**
+ * @brief Usuwa wszystkie zapamiętane okna.
+ */
+void RollupCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++current;
+    series.clear();
+}
+
+/**
+ * @brief Zwraca liczbę zapamiętanych okien.
+ */
+std::size_t RollupCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::size_t count = 0;
+    for (const auto& [minutes, buckets] : series) count += buckets.size();
+    return count;
+}
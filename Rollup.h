@@ -0,0 +1,170 @@
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+#include "Aggregate.h"
+#include "Record.h"
+
+/**
+ * @brief Rozdzielczość resamplingu: okno o stałej liczbie minut albo miesiąc kalendarzowy.
+ *
+ * Okna stałej długości są wyrównane do 2000-01-01 00:00 (okno dobowe zaczyna się o północy,
+ * godzinowe o pełnej godzinie).
+ */
+struct Resolution {
+    /**
+     * @brief Długość okna w minutach (0 - miesiąc kalendarzowy).
+     */
+    int minutes = 60;
+
+    /**
+     * @brief Okna godzinowe.
+     */
+    static Resolution hourly() { return Resolution{ 60 }; }
+
+    /**
+     * @brief Okna dobowe.
+     */
+    static Resolution daily() { return Resolution{ 24 * 60 }; }
+
+    /**
+     * @brief Miesiące kalendarzowe.
+     */
+    static Resolution monthly() { return Resolution{ 0 }; }
+
+    /**
+     * @brief Okna o dowolnej długości (np. 15 minut, 6 godzin, tydzień).
+     *
+     * @param minutes Długość okna w minutach (dodatnia).
+     */
+    static Resolution window(int minutes) { return Resolution{ minutes }; }
+
+    /**
+     * @brief Zwraca początek okna zawierającego znacznik czasu.
+     */
+    std::int32_t bucketStart(std::int32_t timestamp) const;
+
+    /**
+     * @brief Zwraca początek okna następującego po oknie zaczynającym się w `start`.
+     */
+    std::int32_t bucketEnd(std::int32_t start) const;
+};
+
+/**
+ * @brief Jedno okno szeregu po resamplingu: agregaty wszystkich wielkości w przedziale `[start, end)`.
+ */
+struct RollupBucket {
+    /**
+     * @brief Początek okna (minuty od 2000-01-01 00:00, włącznie).
+     */
+    std::int32_t start = 0;
+
+    /**
+     * @brief Koniec okna (wyłącznie).
+     */
+    std::int32_t end = 0;
+
+    /**
+     * @brief Suma, liczba, minimum i maksimum każdej wielkości w oknie (średnia - `Aggregate::average`).
+     */
+    Aggregates stats;
+
+    /**
+     * @brief Energia wielkości w oknie w kWh.
+     *
+     * Każdy pomiar mocy [W] reprezentuje 15-minutowy interwał eksportu, więc energia to
+     * suma mocy razy 0,25 h; braki w danych nie są interpolowane.
+     *
+     * @param field Indeks wielkości (patrz `Record::fieldIndex`).
+     */
+    double energy(int field) const { return stats[field].sum * kSampleHours / 1000.0; }
+
+    /**
+     * @brief Czas reprezentowany przez jeden pomiar w godzinach.
+     */
+    static constexpr double kSampleHours = 0.25;
+};
+
+/**
+ * @brief Pamięć podręczna szeregów po resamplingu z unieważnianiem fragmentów przy nowych danych.
+ *
+ * Okna są liczone przez funkcję źródłową (agregaty wszystkich wielkości w przedziale - w programie
+ * jeden przegląd agregatów węzłów drzewa i snapshotu), więc okna dobowe i miesięczne są odczytem zapamiętanych agregatów
+ * dni i miesięcy, bez przeglądania 15-minutowych pomiarów. Policzone okna są zapamiętywane dla
+ * każdej rozdzielczości; wykres wieloletni po pierwszym zapytaniu jest składany wyłącznie z pamięci.
+ *
+ * Po dopisaniu danych wystarczy unieważnić przedział nowych znaczników (`invalidate`) - usuwane
+ * są tylko okna, które go obejmują. Zapytania mogą być wykonywane równocześnie z unieważnianiem:
+ * okna policzone z wersji danych sprzed unieważnienia nie trafiają do pamięci (numer generacji).
+ */
+class RollupCache {
+public:
+    /**
+     * @brief Funkcja źródłowa: agregaty wszystkich wielkości w przedziale `[from, to]` (jedno wywołanie na okno).
+     */
+    using Source = std::function<Aggregates(std::int32_t from, std::int32_t to)>;
+
+    /**
+     * @brief Zwraca numer generacji danych (zwiększany przez `invalidate` i `clear`).
+     *
+     * Numer należy odczytać przed przypięciem wersji danych, z której liczy funkcja źródłowa.
+     */
+    std::uint64_t generation() const;
+
+    /**
+     * @brief Zwraca okna rozdzielczości `resolution` pokrywające przedział `[from, to]`.
+     *
+     * Brakujące okna są liczone przez `source` i zapamiętywane, jeśli od odczytu `generation`
+     * dane nie zostały unieważnione. Zwracane są także okna bez rekordów (z zerową liczbą próbek).
+     *
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param resolution Rozdzielczość.
+     * @param source Funkcja źródłowa.
+     * @param generation Numer generacji odczytany przed przypięciem danych źródła.
+     * @return std::vector<RollupBucket> Okna w kolejności chronologicznej.
+     */
+    std::vector<RollupBucket> resample(std::int32_t from, std::int32_t to, Resolution resolution,
+                                       const Source& source, std::uint64_t generation);
+
+    /**
+     * @brief Usuwa zapamiętane okna obejmujące przedział `[from, to]` (np. dopisane rekordy).
+     *
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     */
+    void invalidate(std::int32_t from, std::int32_t to);
+
+    /**
+     * @brief Usuwa wszystkie zapamiętane okna.
+     */
+    void clear();
+
+    /**
+     * @brief Zwraca liczbę zapamiętanych okien (wszystkich rozdzielczości).
+     */
+    std::size_t size() const;
+
+private:
+    /**
+     * @brief Muteks chroniący pamięć okien.
+     */
+    mutable std::mutex mutex;
+
+    /**
+     * @brief Zapamiętane okna według rozdzielczości (klucz: `Resolution::minutes`) i początku okna.
+     */
+    std::map<int, std::map<std::int32_t, RollupBucket>> series;
+
+    /**
+     * @brief Numer generacji danych.
+     */
+    std::uint64_t current = 0;
+};
+
+#endif // ROLLUP_H
@@ -0,0 +1,161 @@
+#include "RowValidator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/**
+ * @brief Zwraca opis powodu odrzucenia używany w logu błędnych rekordów.
+ *
+ * @param reason Powód odrzucenia.
+ * @return Napis stały (ważny przez cały czas działania programu).
+ */
+const char* rejectReasonName(RejectReason reason) {
+    switch (reason) {
+    case RejectReason::None: return "poprawny";
+    case RejectReason::Format: return "niepoprawny format";
+    case RejectReason::Date: return "niepoprawna data lub godzina";
+    case RejectReason::NotANumber: return "wartość nieliczbowa";
+    case RejectReason::Negative: return "ujemna moc";
+    case RejectReason::Balance: return "niezgodny bilans mocy";
+    case RejectReason::Duplicate: return "powtórzony znacznik czasu";
+    case RejectReason::Count: break;
+    }
+    return "nieznany powód";
+}
+
+/**
+ * @brief Tworzy walidator, pomija puste źródła `earlier` i zapamiętuje łączny zakres czasu pozostałych.
+ *
+ * @param rules Sprawdzane reguły.
+ * @param earlier Wcześniej przyjęte dane.
+ */
+RowValidator::RowValidator(const ValidationRules& rules, const EarlierData& earlier) : rules(rules), earlier(earlier) {
+    std::int32_t first = 0, last = 0;
+    // Zwraca false dla pustego źródła, a zakres niepustego dołącza do łącznego zakresu
+    const auto widen = [this, &first, &last](bool found) {
+        if (!found) return false;
+        const bool empty = earlierFirst > earlierLast;
+        earlierFirst = empty ? first : std::min(earlierFirst, first);
+        earlierLast = empty ? last : std::max(earlierLast, last);
+        return true;
+    };
+    if (earlier.tree != nullptr && !widen(earlier.tree->timeSpan(first, last))) this->earlier.tree = nullptr;
+    if (earlier.view != nullptr && !widen(earlier.view->timeSpan(first, last))) this->earlier.view = nullptr;
+    if (earlier.snapshot != nullptr && !widen(earlier.snapshot->timeSpan(first, last))) this->earlier.snapshot = nullptr;
+}
+
+/**
+ * @brief Ustawia powody odrzucenia wierszy paczki.
+ *
+ * Reguły wartości są sprawdzane pętlą bez rozgałęzień o stałej liczbie przebiegów
+ * (`RowBatch::capacity` - także dla niepełnej paczki), którą kompilator wektoryzuje już przy `-O2`.
+ * Wartość nieliczbowa lub nieskończona jest wykrywana jednym porównaniem: `x - x` to 0 dla liczb
+ * skończonych i NaN w pozostałych przypadkach, więc suma takich różnic jest NaN, jeśli choć jedna
+ * wartość wiersza nie jest liczbą skończoną. Priorytet powodów: błąd parsowania, wartość
+ * nieliczbowa, ujemna moc, bilans, duplikat.
+ *
+ * @param batch Paczka wierszy.
+ * @param accepted Drzewo z wierszami przyjętymi z poprzednich paczek.
+ */
+void RowValidator::validate(RowBatch& batch, const Tree& accepted) {
+    const double* const autokonsumpcja = batch.values[0];
+    const double* const eksport = batch.values[1];
+    const double* const import_ = batch.values[2];
+    const double* const pobor = batch.values[3];
+    const double* const produkcja = batch.values[4];
+    // Wyłączona reguła daje kod 0 (`RejectReason::None`), więc pętla nie zależy od ustawień
+    const std::uint8_t negativeCode = rules.rejectNegative ? static_cast<std::uint8_t>(RejectReason::Negative) : 0;
+    const std::uint8_t balanceCode = rules.checkBalance ? static_cast<std::uint8_t>(RejectReason::Balance) : 0;
+    const std::uint8_t notANumberCode = static_cast<std::uint8_t>(RejectReason::NotANumber);
+    const double tolerance = rules.balanceTolerance;
+    std::uint8_t codes[RowBatch::capacity];
+    for (std::size_t i = 0; i < RowBatch::capacity; ++i) {
+        const double a = autokonsumpcja[i], e = eksport[i], m = import_[i], c = pobor[i], p = produkcja[i];
+        const double poison = (a - a) + (e - e) + (m - m) + (c - c) + (p - p);
+        const double lowest = std::min(std::min(a, e), std::min(std::min(m, c), p));
+        const double gap = std::max(std::fabs(c - (a + m)), std::fabs(p - (a + e)));
+        std::uint8_t code = gap > tolerance ? balanceCode : 0;
+        code = lowest < 0.0 ? negativeCode : code;
+        code = poison != poison ? notANumberCode : code;
+        codes[i] = code;
+    }
+    for (std::size_t i = 0; i < RowBatch::capacity; ++i) {
+        const RejectReason parsed = batch.reasons[i];
+        batch.reasons[i] = parsed != RejectReason::None ? parsed : static_cast<RejectReason>(codes[i]);
+    }
+
+    if (rules.rejectDuplicates) markDuplicates(batch, accepted);
+
+    // Największy przyjęty znacznik czasu dla szybkiej ścieżki następnej paczki
+    for (std::size_t i = 0; i < batch.size; ++i) {
+        if (batch.reasons[i] != RejectReason::None) continue;
+        if (!anyAccepted || batch.timestamps[i] > last) last = batch.timestamps[i];
+        anyAccepted = true;
+    }
+}
+
+/**
+ * @brief Oznacza duplikaty wśród poprawnych wierszy paczki.
+ *
+ * Jeśli znaczniki czasu poprawnych wierszy rosną ściśle i pierwszy jest większy od największego
+ * przyjętego, w paczce i w `accepted` nie ma duplikatów. W przeciwnym razie wiersze są sortowane
+ * według znacznika (i numeru w paczce - pierwszy wiersz zostaje), a znaczniki nie większe od
+ * największego przyjętego są szukane w `accepted`. Dane `earlier` są przeszukiwane tylko
+ * dla znaczników z łącznego zakresu ich czasu.
+ *
+ * @param batch Paczka wierszy.
+ * @param accepted Drzewo z wierszami przyjętymi z poprzednich paczek.
+ */
+void RowValidator::markDuplicates(RowBatch& batch, const Tree& accepted) {
+    const std::size_t n = batch.size;
+    bool ordered = true;
+    std::int32_t previous = last;
+    bool havePrevious = anyAccepted;
+    for (std::size_t i = 0; i < n; ++i) {
+        const bool valid = batch.reasons[i] == RejectReason::None;
+        ordered &= !valid || !havePrevious || batch.timestamps[i] > previous;
+        previous = valid ? batch.timestamps[i] : previous;
+        havePrevious |= valid;
+    }
+
+    if (!ordered) {
+        std::pair<std::int32_t, std::size_t> rows[RowBatch::capacity];
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (batch.reasons[i] == RejectReason::None) rows[count++] = { batch.timestamps[i], i };
+        }
+        std::sort(rows, rows + count);
+        for (std::size_t k = 0; k < count; ++k) {
+            const std::int32_t timestamp = rows[k].first;
+            const bool repeated = k > 0 && rows[k - 1].first == timestamp;
+            if (repeated || (anyAccepted && timestamp <= last && accepted.contains(timestamp))) {
+                batch.reasons[rows[k].second] = RejectReason::Duplicate;
+            }
+        }
+    }
+
+    if (earlierFirst <= earlierLast) {
+        for (std::size_t i = 0; i < n; ++i) {
+            const std::int32_t timestamp = batch.timestamps[i];
+            if (batch.reasons[i] == RejectReason::None && timestamp >= earlierFirst && timestamp <= earlierLast &&
+                earlierContains(timestamp)) {
+                batch.reasons[i] = RejectReason::Duplicate;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Sprawdza, czy któreś ze źródeł `earlier` zawiera rekord o podanym znaczniku czasu.
+ *
+ * @param timestamp Znacznik czasu.
+ * @return true, jeśli rekord istnieje.
+ */
+bool RowValidator::earlierContains(std::int32_t timestamp) const {
+    if (earlier.tree != nullptr && earlier.tree->contains(timestamp)) return true;
+    if (earlier.view != nullptr && earlier.view->contains(timestamp)) return true;
+    if (earlier.snapshot == nullptr) return false;
+    const std::pair<std::size_t, std::size_t> found = earlier.snapshot->range(timestamp, timestamp);
+    return found.first != found.second;
+}
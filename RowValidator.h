@@ -0,0 +1,289 @@
+#ifndef ROWVALIDATOR_H
+#define ROWVALIDATOR_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "ConcurrentTree.h"
+#include "Record.h"
+#include "Snapshot.h"
+#include "Tree.h"
+
+/**
+ * @brief Powód odrzucenia wiersza CSV.
+ */
+enum class RejectReason : std::uint8_t {
+    /**
+     * @brief Wiersz poprawny.
+     */
+    None,
+
+    /**
+     * @brief Niepoprawny format linii (brakujące lub nadmiarowe pola, znaki spoza liczby).
+     */
+    Format,
+
+    /**
+     * @brief Data lub godzina spoza kalendarza (np. 31.09, 24:00).
+     */
+    Date,
+
+    /**
+     * @brief Wartość nieliczbowa lub nieskończona (NaN, inf).
+     */
+    NotANumber,
+
+    /**
+     * @brief Ujemna moc.
+     */
+    Negative,
+
+    /**
+     * @brief Niezgodny bilans mocy (`pobor != autokonsumpcja + import` lub `produkcja != autokonsumpcja + eksport`).
+     */
+    Balance,
+
+    /**
+     * @brief Znacznik czasu występujący już we wcześniejszym wierszu.
+     */
+    Duplicate,
+
+    /**
+     * @brief Liczba powodów.
+     */
+    Count
+};
+
+/**
+ * @brief Zwraca opis powodu odrzucenia używany w logu błędnych rekordów (np. "powtórzony znacznik czasu").
+ */
+const char* rejectReasonName(RejectReason reason);
+
+/**
+ * @brief Reguły sprawdzane dla wierszy wczytywanych z CSV (poza formatem i datą, sprawdzanymi zawsze).
+ */
+struct ValidationRules {
+    /**
+     * @brief Odrzucanie wierszy z ujemną mocą.
+     */
+    bool rejectNegative = true;
+
+    /**
+     * @brief Odrzucanie wierszy o znaczniku czasu występującym już wcześniej (pierwszy wiersz zostaje).
+     */
+    bool rejectDuplicates = true;
+
+    /**
+     * @brief Sprawdzanie bilansu mocy (domyślnie wyłączone - eksporty falowników mają chwilowe rozbieżności).
+     */
+    bool checkBalance = false;
+
+    /**
+     * @brief Dopuszczalna różnica bilansu mocy w watach.
+     */
+    double balanceTolerance = 1.0;
+};
+
+/**
+ * @brief Odrzucony wiersz CSV (wskazuje tekst linii w buforze pliku).
+ */
+struct Rejection {
+    /**
+     * @brief Początek linii.
+     */
+    const char* line = nullptr;
+
+    /**
+     * @brief Długość linii.
+     */
+    std::size_t length = 0;
+
+    /**
+     * @brief Numer linii (od 1, względem początku przetwarzanego fragmentu).
+     */
+    std::size_t lineNumber = 0;
+
+    /**
+     * @brief Powód odrzucenia.
+     */
+    RejectReason reason = RejectReason::None;
+};
+
+/**
+ * @brief Wynik przetworzenia fragmentu CSV (`Program::parseChunk`).
+ */
+struct LoadReport {
+    /**
+     * @brief Liczba poprawnych rekordów.
+     */
+    int valid = 0;
+
+    /**
+     * @brief Liczba odrzuconych wierszy.
+     */
+    int invalid = 0;
+
+    /**
+     * @brief Liczba odrzuconych wierszy według powodu (indeks - `RejectReason`).
+     */
+    std::array<int, static_cast<std::size_t>(RejectReason::Count)> rejected{};
+
+    /**
+     * @brief Liczba wszystkich linii fragmentu (także pustych i nagłówków).
+     */
+    std::size_t lines = 0;
+
+    /**
+     * @brief Odrzucone wiersze w kolejności linii.
+     */
+    std::vector<Rejection> rejections;
+};
+
+/**
+ * @brief Paczka sparsowanych wierszy w układzie kolumnowym, sprawdzana jednym wywołaniem `RowValidator::validate`.
+ *
+ * Pętle sprawdzające zawsze obejmują `capacity` wierszy (stała liczba przebiegów), więc paczkę
+ * należy tworzyć z zerowaniem pól (`new RowBatch()`, `RowBatch batch{}`). Ok. 16 KB - zwykle na stercie.
+ */
+struct RowBatch {
+    /**
+     * @brief Maksymalna liczba wierszy paczki.
+     */
+    static constexpr std::size_t capacity = 256;
+
+    /**
+     * @brief Liczba wierszy w paczce.
+     */
+    std::size_t size = 0;
+
+    /**
+     * @brief Znaczniki czasu wierszy.
+     */
+    std::int32_t timestamps[capacity];
+
+    /**
+     * @brief Kolumny wartości w kolejności `Record::fieldIndex`.
+     */
+    double values[Record::fieldCount][capacity];
+
+    /**
+     * @brief Powody odrzucenia (`RejectReason::None` - wiersz poprawny).
+     */
+    RejectReason reasons[capacity];
+
+    /**
+     * @brief Tekst i numer linii wierszy (do logowania).
+     */
+    const char* lines[capacity];
+    std::uint32_t lengths[capacity];
+    std::size_t lineNumbers[capacity];
+
+    /**
+     * @brief Dodaje wiersz; wiersz z `reason != RejectReason::None` (błąd parsowania) nie jest dalej sprawdzany.
+     */
+    void add(const Record& record, RejectReason reason, const char* line, std::size_t length, std::size_t lineNumber) {
+        const std::size_t i = size++;
+        timestamps[i] = record.timestamp;
+        values[0][i] = record.autokonsumpcja;
+        values[1][i] = record.eksport;
+        values[2][i] = record.import_;
+        values[3][i] = record.pobor;
+        values[4][i] = record.produkcja;
+        reasons[i] = reason;
+        lines[i] = line;
+        lengths[i] = static_cast<std::uint32_t>(length);
+        lineNumbers[i] = lineNumber;
+    }
+
+    /**
+     * @brief Odtwarza rekord wiersza.
+     */
+    Record record(std::size_t i) const {
+        return Record(timestamps[i], values[0][i], values[1][i], values[2][i], values[3][i], values[4][i]);
+    }
+};
+
+/**
+ * @brief Wcześniej przyjęte dane - znaczniki czasu ich rekordów są duplikatami sprawdzanych wierszy.
+ *
+ * Każde źródło jest opcjonalne (nullptr - brak).
+ */
+struct EarlierData {
+    /**
+     * @brief Drzewo rekordów przyjętych wcześniej w tym samym wczytywaniu (np. z poprzednich fragmentów pliku).
+     */
+    const Tree* tree = nullptr;
+
+    /**
+     * @brief Opublikowana wersja danych programu sprzed wczytywania.
+     */
+    const ConcurrentTree::View* view = nullptr;
+
+    /**
+     * @brief Wczytany snapshot.
+     */
+    const Snapshot* snapshot = nullptr;
+};
+
+/**
+ * @brief Sprawdzanie jakości danych paczkami wierszy w układzie kolumnowym.
+ *
+ * Format oraz data i godzina są sprawdzane już przy parsowaniu (`Program::parseLine`), bo tylko
+ * tam dostępne są pola daty. `validate` sprawdza pozostałe reguły dla całej paczki naraz:
+ * wartości skończone, nieujemne i bilans mocy to jedna pętla po kolumnach bez rozgałęzień
+ * (kompilator zamienia ją na instrukcje wektorowe), dająca jeden kod powodu na wiersz.
+ *
+ * Duplikaty są wykrywane względem wierszy przyjętych wcześniej przez ten sam walidator
+ * (drzewo `accepted`) i opcjonalnie danych `earlier`. W typowym eksporcie znaczniki czasu rosną,
+ * więc wystarcza jedno porównanie z poprzednim wierszem; dopiero paczka z cofnięciem czasu jest
+ * sortowana i sprawdzana w drzewie.
+ */
+class RowValidator {
+public:
+    /**
+     * @brief Tworzy walidator.
+     *
+     * @param rules Sprawdzane reguły.
+     * @param earlier Wcześniej przyjęte dane do wykrywania duplikatów.
+     */
+    explicit RowValidator(const ValidationRules& rules, const EarlierData& earlier = EarlierData());
+
+    /**
+     * @brief Ustawia powody odrzucenia wierszy paczki, które przeszły parsowanie.
+     *
+     * @param batch Paczka wierszy.
+     * @param accepted Drzewo z wierszami przyjętymi z poprzednich paczek tego walidatora.
+     */
+    void validate(RowBatch& batch, const Tree& accepted);
+
+private:
+    /**
+     * @brief Oznacza duplikaty wśród poprawnych wierszy paczki.
+     */
+    void markDuplicates(RowBatch& batch, const Tree& accepted);
+
+    /**
+     * @brief Sprawdza, czy któreś ze źródeł `earlier` zawiera rekord o podanym znaczniku czasu.
+     */
+    bool earlierContains(std::int32_t timestamp) const;
+
+    /**
+     * @brief Sprawdzane reguły.
+     */
+    ValidationRules rules;
+
+    /**
+     * @brief Niepuste źródła wcześniej przyjętych danych i łączny zakres ich czasu.
+     */
+    EarlierData earlier;
+    std::int32_t earlierFirst = 0, earlierLast = -1;
+
+    /**
+     * @brief Największy przyjęty znacznik czasu (ważny, jeśli `anyAccepted`).
+     */
+    std::int32_t last = 0;
+    bool anyAccepted = false;
+};
+
+#endif // ROWVALIDATOR_H
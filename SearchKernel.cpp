@@ -0,0 +1,269 @@
+#include "SearchKernel.h"
+
+#include <bitset>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SEARCHKERNEL_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Funkcje z instrukcjami AVX2 są kompilowane dla tego zestawu instrukcji niezależnie od flag
+// całego programu (GCC/Clang); MSVC pozwala używać intrinsics bez dodatkowych flag.
+#if defined(SEARCHKERNEL_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SEARCHKERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SEARCHKERNEL_TARGET(isa)
+#endif
+
+namespace {
+
+/**
+ * @brief Liczba ustawionych bitów słowa.
+ */
+std::size_t popcount(std::uint64_t word) {
+    return std::bitset<64>(word).count();
+}
+
+/**
+ * @brief Wersja skalarna: słowa mapy bitowej dla wszystkich `count` wartości.
+ */
+std::size_t matchScalar(const double* values, std::size_t count, double value, double tolerance, std::uint64_t* bitmap) {
+    std::size_t matches = 0;
+    for (std::size_t base = 0; base < count; base += 64) {
+        const std::size_t end = count - base < 64 ? count - base : 64;
+        std::uint64_t word = 0;
+        for (std::size_t k = 0; k < end; ++k) {
+            word |= static_cast<std::uint64_t>(std::fabs(values[base + k] - value) <= tolerance) << k;
+        }
+        bitmap[base / 64] = word;
+        matches += popcount(word);
+    }
+    return matches;
+}
+
+#if defined(SEARCHKERNEL_X86)
+
+/**
+ * @brief Wersja SSE2: po 2 wartości na instrukcję, także w niepełnym ostatnim słowie mapy.
+ *
+ * Nieparzysta ostatnia wartość jest ładowana do dolnej połowy rejestru (`_mm_load_sd`),
+ * a bit górnej połowy jest odrzucany, więc krótkie kolumny (np. ćwiartki drzewa) nie
+ * przechodzą do pętli skalarnej.
+ */
+SEARCHKERNEL_TARGET("sse2")
+std::size_t matchSse2(const double* values, std::size_t count, double value, double tolerance, std::uint64_t* bitmap) {
+    const __m128d target = _mm_set1_pd(value);
+    const __m128d limit = _mm_set1_pd(tolerance);
+    const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFll));
+    std::size_t matches = 0;
+    for (std::size_t base = 0; base < count; base += 64) {
+        const std::size_t end = count - base < 64 ? count - base : 64;
+        const double* const block = values + base;
+        std::uint64_t word = 0;
+        std::size_t k = 0;
+        for (; k + 2 <= end; k += 2) {
+            const __m128d distance = _mm_and_pd(_mm_sub_pd(_mm_loadu_pd(block + k), target), absMask);
+            word |= static_cast<std::uint64_t>(_mm_movemask_pd(_mm_cmple_pd(distance, limit))) << k;
+        }
+        if (k < end) {
+            const __m128d distance = _mm_and_pd(_mm_sub_pd(_mm_load_sd(block + k), target), absMask);
+            word |= static_cast<std::uint64_t>(_mm_movemask_pd(_mm_cmple_pd(distance, limit)) & 1) << k;
+        }
+        bitmap[base / 64] = word;
+        matches += popcount(word);
+    }
+    return matches;
+}
+
+/**
+ * @brief Wersja AVX2: po 4 wartości na instrukcję, także w niepełnym ostatnim słowie mapy.
+ *
+ * Ostatnie 1-3 wartości są ładowane z maską (`_mm256_maskload_pd` nie czyta pamięci za kolumną),
+ * a bity pustych pozycji są odrzucane, więc krótkie kolumny (np. ćwiartki drzewa) nie
+ * przechodzą do pętli skalarnej.
+ */
+SEARCHKERNEL_TARGET("avx2")
+std::size_t matchAvx2(const double* values, std::size_t count, double value, double tolerance, std::uint64_t* bitmap) {
+    const __m256d target = _mm256_set1_pd(value);
+    const __m256d limit = _mm256_set1_pd(tolerance);
+    const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7FFFFFFFFFFFFFFFll));
+    std::size_t matches = 0;
+    for (std::size_t base = 0; base < count; base += 64) {
+        const std::size_t end = count - base < 64 ? count - base : 64;
+        const double* const block = values + base;
+        std::uint64_t word = 0;
+        std::size_t k = 0;
+        for (; k + 4 <= end; k += 4) {
+            const __m256d distance = _mm256_and_pd(_mm256_sub_pd(_mm256_loadu_pd(block + k), target), absMask);
+            word |= static_cast<std::uint64_t>(_mm256_movemask_pd(_mm256_cmp_pd(distance, limit, _CMP_LE_OQ))) << k;
+        }
+        if (k < end) {
+            const long long rest = static_cast<long long>(end - k);
+            const __m256i lanes = _mm256_cmpgt_epi64(_mm256_set1_epi64x(rest), _mm256_set_epi64x(3, 2, 1, 0));
+            const __m256d loaded = _mm256_maskload_pd(block + k, lanes);
+            const __m256d distance = _mm256_and_pd(_mm256_sub_pd(loaded, target), absMask);
+            const int hits = _mm256_movemask_pd(_mm256_cmp_pd(distance, limit, _CMP_LE_OQ)) & ((1 << rest) - 1);
+            word |= static_cast<std::uint64_t>(hits) << k;
+        }
+        bitmap[base / 64] = word;
+        matches += popcount(word);
+    }
+    return matches;
+}
+
+/**
+ * @brief Wykrywa obsługę AVX2 przez procesor i system operacyjny.
+ */
+bool detectAvx2() {
+#if defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    const bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+    __cpuidex(info, 7, 0);
+    return osSavesAvx && (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+/**
+ * @brief Wykrywa obsługę SSE2 (zawsze dostępne na x86-64).
+ */
+bool detectSse2() {
+#if defined(__x86_64__) || defined(_M_X64)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4] = {};
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+#endif // SEARCHKERNEL_X86
+
+} // namespace
+
+/**
+ * @brief Sprawdza, czy procesor obsługuje daną implementację.
+ *
+ * @param isa Implementacja.
+ * @return true, jeśli implementacja może zostać użyta.
+ */
+bool SearchKernel::supported(Isa isa) {
+#if defined(SEARCHKERNEL_X86)
+    static const bool sse2 = detectSse2();
+    static const bool avx2 = detectAvx2();
+    switch (isa) {
+    case Isa::Avx2: return avx2;
+    case Isa::Sse2: return sse2;
+    default: return true;
+    }
+#else
+    return isa == Isa::Scalar;
+#endif
+}
+
+/**
+ * @brief Zwraca najszybszą implementację obsługiwaną przez procesor.
+ *
+ * @return Isa AVX2, SSE2 lub skalarna.
+ */
+SearchKernel::Isa SearchKernel::best() {
+    static const Isa isa = supported(Isa::Avx2) ? Isa::Avx2 : supported(Isa::Sse2) ? Isa::Sse2 : Isa::Scalar;
+    return isa;
+}
+
+/**
+ * @brief Zwraca nazwę implementacji.
+ *
+ * @param isa Implementacja.
+ * @return const char* "avx2", "sse2" lub "scalar".
+ */
+const char* SearchKernel::name(Isa isa) {
+    switch (isa) {
+    case Isa::Avx2: return "avx2";
+    case Isa::Sse2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+/**
+ * @brief Wyznacza mapę bitową wartości spełniających `|x - value| <= tolerance`.
+ *
+ * @param values Kolumna wartości.
+ * @param count Liczba wartości.
+ * @param value Szukana wartość.
+ * @param tolerance Tolerancja.
+ * @param bitmap Wyjściowa mapa bitowa.
+ * @param isa Implementacja.
+ * @return std::size_t Liczba pasujących wartości.
+ */
+std::size_t SearchKernel::match(const double* values, std::size_t count, double value, double tolerance,
+                                std::vector<std::uint64_t>& bitmap, Isa isa) {
+    bitmap.assign((count + 63) / 64, 0);
+    if (count == 0) return 0;
+    return match(values, count, value, tolerance, bitmap.data(), supported(isa) ? isa : Isa::Scalar);
+}
+
+/**
+ * @brief Wyznacza mapę bitową w buforze wywołującego.
+ *
+ * @param values Kolumna wartości.
+ * @param count Liczba wartości.
+ * @param value Szukana wartość.
+ * @param tolerance Tolerancja.
+ * @param bitmap Wyjściowa mapa bitowa (co najmniej `(count + 63) / 64` słów).
+ * @param isa Obsługiwana implementacja.
+ * @return std::size_t Liczba pasujących wartości.
+ */
+std::size_t SearchKernel::match(const double* values, std::size_t count, double value, double tolerance,
+                                std::uint64_t* bitmap, Isa isa) {
+#if defined(SEARCHKERNEL_X86)
+    if (isa == Isa::Avx2) return matchAvx2(values, count, value, tolerance, bitmap);
+    if (isa == Isa::Sse2) return matchSse2(values, count, value, tolerance, bitmap);
+#else
+    (void)isa;
+#endif
+    return matchScalar(values, count, value, tolerance, bitmap);
+}
+
+/**
+ * @brief Dopisuje indeksy ustawionych bitów mapy do listy.
+ *
+ * @param bitmap Mapa bitowa.
+ * @param offset Wartość dodawana do każdego indeksu.
+ * @param indices Lista wyjściowa.
+ */
+void SearchKernel::indices(const std::vector<std::uint64_t>& bitmap, std::size_t offset, std::vector<std::size_t>& indices) {
+    SearchKernel::indices(bitmap.data(), bitmap.size(), offset, indices);
+}
+
+/**
+ * @brief Dopisuje indeksy ustawionych bitów pierwszych `words` słów mapy do listy.
+ *
+ * @param bitmap Mapa bitowa.
+ * @param words Liczba słów mapy.
+ * @param offset Wartość dodawana do każdego indeksu.
+ * @param indices Lista wyjściowa.
+ */
+void SearchKernel::indices(const std::uint64_t* bitmap, std::size_t words, std::size_t offset,
+                           std::vector<std::size_t>& indices) {
+    for (std::size_t w = 0; w < words; ++w) {
+        std::uint64_t word = bitmap[w];
+        while (word != 0) {
+            const std::uint64_t lowest = word & (~word + 1);
+            indices.push_back(offset + w * 64 + popcount(lowest - 1));
+            word ^= lowest;
+        }
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef SEARCHKERNEL_H
+#define SEARCHKERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Wektorowy filtr kolumny wartości dla wyszukiwania z tolerancją (`Program::searchRecords`).
+ *
+ * Dla ciągłej kolumny jednej wielkości wyznacza, które wartości spełniają warunek
+ * `|x - value| <= tolerance`. Wynikiem jest mapa bitowa (bit `i % 64` słowa `i / 64`
+ * odpowiada wartości `i`), którą można zamienić na listę indeksów (`indices`).
+ *
+ * Dostępne są trzy implementacje - AVX2 (4 wartości na instrukcję), SSE2 (2 wartości) i skalarna.
+ * Wersje wektorowe obsługują też niepełne słowa mapy (kolumny krótsze niż 64 wartości, np.
+ * ćwiartki drzewa), ładując ostatnie wartości z maską.
+ * Najszybsza obsługiwana przez procesor jest wybierana w czasie działania programu (`best`),
+ * więc program nie wymaga kompilacji z flagami dla konkretnego procesora. Wszystkie
+ * implementacje dają identyczne wyniki (ta sama arytmetyka, NaN nigdy nie pasuje).
+ */
+class SearchKernel {
+public:
+    /**
+     * @brief Implementacja filtra (zestaw instrukcji).
+     */
+    enum class Isa {
+        /**
+         * @brief Pętla skalarna.
+         */
+        Scalar,
+
+        /**
+         * @brief Instrukcje SSE2 (128 bitów).
+         */
+        Sse2,
+
+        /**
+         * @brief Instrukcje AVX2 (256 bitów).
+         */
+        Avx2
+    };
+
+    /**
+     * @brief Zwraca najszybszą implementację obsługiwaną przez procesor (wykrywaną raz).
+     */
+    static Isa best();
+
+    /**
+     * @brief Sprawdza, czy procesor obsługuje daną implementację.
+     */
+    static bool supported(Isa isa);
+
+    /**
+     * @brief Zwraca nazwę implementacji (do komunikatów i benchmarków).
+     */
+    static const char* name(Isa isa);
+
+    /**
+     * @brief Wyznacza mapę bitową wartości spełniających `|x - value| <= tolerance`.
+     *
+     * @param values Kolumna wartości.
+     * @param count Liczba wartości.
+     * @param value Szukana wartość.
+     * @param tolerance Tolerancja.
+     * @param bitmap Wyjściowa mapa bitowa (rozmiar zmieniany na `(count + 63) / 64` słów).
+     * @param isa Implementacja (domyślnie `best()`; nieobsługiwana jest zastępowana skalarną).
+     * @return std::size_t Liczba pasujących wartości.
+     */
+    static std::size_t match(const double* values, std::size_t count, double value, double tolerance,
+                             std::vector<std::uint64_t>& bitmap, Isa isa = best());
+
+    /**
+     * @brief Wyznacza mapę bitową w buforze wywołującego (bez zmiany rozmiaru i sprawdzania `isa`).
+     *
+     * Wariant dla wielu krótkich kolumn (np. ćwiartek drzewa): implementacja jest wybierana raz
+     * na zapytanie, a bufor mapy używany ponownie.
+     *
+     * @param values Kolumna wartości.
+     * @param count Liczba wartości.
+     * @param value Szukana wartość.
+     * @param tolerance Tolerancja.
+     * @param bitmap Wyjściowa mapa bitowa (co najmniej `(count + 63) / 64` słów).
+     * @param isa Implementacja obsługiwana przez procesor (`supported(isa)`).
+     * @return std::size_t Liczba pasujących wartości.
+     */
+    static std::size_t match(const double* values, std::size_t count, double value, double tolerance,
+                             std::uint64_t* bitmap, Isa isa);
+
+    /**
+     * @brief Dopisuje indeksy ustawionych bitów mapy (powiększone o `offset`) do listy.
+     *
+     * @param bitmap Mapa bitowa wyznaczona przez `match`.
+     * @param offset Wartość dodawana do każdego indeksu (np. indeks pierwszej wartości kolumny).
+     * @param indices Lista, na której końcu zostaną dopisane indeksy (rosnąco).
+     */
+    static void indices(const std::vector<std::uint64_t>& bitmap, std::size_t offset, std::vector<std::size_t>& indices);
+
+    /**
+     * @brief Dopisuje indeksy ustawionych bitów pierwszych `words` słów mapy (patrz wyżej).
+     */
+    static void indices(const std::uint64_t* bitmap, std::size_t words, std::size_t offset,
+                        std::vector<std::size_t>& indices);
+};
+
+#endif // SEARCHKERNEL_H
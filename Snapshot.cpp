@@ -0,0 +1,1011 @@
+#include "Snapshot.h"
+#include "Anomaly.h"
+#include "BlockCodec.h"
+#include "SearchKernel.h"
+#include "Timestamp.h"
+#include "Tree.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+const char kMagic[8] = { 'P', 'V', 'S', 'N', 'A', 'P', 0, 0 };
+const std::uint32_t kByteOrder = 0x01020304;
+const std::size_t kAlignment = 64;
+const char* const kFieldNames[Record::fieldCount] = { "autokonsumpcja", "eksport", "import", "pobor", "produkcja" };
+
+/**
+ * @brief Kolumny, których suma przewiduje wartości danej kolumny w skompresowanych blokach (-1 - brak).
+ *
+ * Wynika z bilansu energii: pobór = autokonsumpcja + import, produkcja = autokonsumpcja + eksport.
+ * Kolumna zapisana względem przewidywania wymaga przy odczycie zdekodowania obu kolumn bazowych.
+ */
+const int kPredictors[Record::fieldCount][2] = { { -1, -1 }, { -1, -1 }, { -1, -1 }, { 0, 2 }, { 0, 1 } };
+
+/**
+ * @brief Zaokrągla przesunięcie w górę do wielokrotności `kAlignment`.
+ */
+std::uint64_t alignUp(std::uint64_t offset) {
+    return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+/**
+ * @brief Przyrostowa suma kontrolna (FNV-1a liczona na słowach 64-bitowych).
+ *
+ * Dane podawane w kolejnych wywołaniach `update` są traktowane jak jeden ciągły strumień
+ * bajtów, więc wynik nie zależy od podziału na fragmenty.
+ */
+class Checksum {
+public:
+    void update(const void* data, std::size_t bytes) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        while (bytes > 0 && pendingBytes > 0) {
+            pending[pendingBytes++] = *p++;
+            --bytes;
+            if (pendingBytes == sizeof(pending)) {
+                mix(pending);
+                pendingBytes = 0;
+            }
+        }
+        for (; bytes >= 8; bytes -= 8, p += 8) mix(p);
+        if (bytes > 0) {
+            // Tu pendingBytes == 0, a bytes < 8
+            std::memcpy(pending, p, bytes);
+            pendingBytes = bytes;
+        }
+    }
+
+    std::uint64_t value() const {
+        std::uint64_t result = hash;
+        for (std::size_t i = 0; i < pendingBytes; ++i) result = (result ^ pending[i]) * kPrime;
+        return result;
+    }
+
+private:
+    static constexpr std::uint64_t kPrime = 1099511628211ull;
+
+    void mix(const unsigned char* word) {
+        std::uint64_t value = 0;
+        std::memcpy(&value, word, sizeof(value));
+        hash = (hash ^ value) * kPrime;
+    }
+
+    std::uint64_t hash = 14695981039346656037ull;
+    unsigned char pending[8] = {};
+    std::size_t pendingBytes = 0;
+};
+
+/**
+ * @brief Zapisuje sekcję danych, uzupełniając ją zerami do wyrównania, i aktualizuje sumę kontrolną.
+ */
+void writeSection(std::ofstream& out, Checksum& checksum, const void* data, std::size_t bytes) {
+    static const char zeros[kAlignment] = {};
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+    checksum.update(data, bytes);
+    const std::size_t padding = static_cast<std::size_t>(alignUp(bytes) - bytes);
+    out.write(zeros, static_cast<std::streamsize>(padding));
+    checksum.update(zeros, padding);
+}
+
+/**
+ * @brief Liczy sumę kontrolną nagłówka (wszystkie pola przed `headerChecksum`).
+ */
+std::uint64_t headerChecksum(const SnapshotHeader& header) {
+    Checksum checksum;
+    checksum.update(&header, offsetof(SnapshotHeader, headerChecksum));
+    return checksum.value();
+}
+
+/**
+ * @brief Dzień (liczba dni od 2000-01-01) zawierający podany znacznik czasu.
+ */
+std::int32_t dayOf(std::int32_t timestamp) {
+    std::int32_t day = timestamp / Timestamp::minutesPerDay;
+    if (timestamp % Timestamp::minutesPerDay < 0) --day;
+    return day;
+}
+
+/**
+ * @brief Wypełnia sumy, minima i maksima podsumowania (dnia lub bloku) wartościami rekordów `[first, last)`.
+ */
+template <typename Summary>
+void summarize(Summary& summary, const std::vector<double> (&columns)[Record::fieldCount], std::size_t first, std::size_t last) {
+    for (int f = 0; f < Record::fieldCount; ++f) {
+        Aggregate aggregate;
+        for (std::size_t i = first; i < last; ++i) aggregate.add(columns[f][i]);
+        summary.sum[f] = aggregate.sum;
+        summary.min[f] = aggregate.min;
+        summary.max[f] = aggregate.max;
+    }
+}
+
+/**
+ * @brief Agregat wielkości `field` z zapisanego podsumowania dnia lub bloku.
+ */
+template <typename Summary>
+Aggregate summaryAggregate(const Summary& summary, int field) {
+    Aggregate aggregate;
+    aggregate.sum = summary.sum[field];
+    aggregate.count = static_cast<std::size_t>(summary.count);
+    aggregate.min = summary.min[field];
+    aggregate.max = summary.max[field];
+    return aggregate;
+}
+
+} // namespace
+
+/**
+ * @brief Zapisuje dane drzewa (i opcjonalnie wcześniejszego snapshotu) do pliku snapshotu.
+ *
+ * Kolejne kroki:
+ * 1. zebranie rekordów z `base` i z drzewa do kolumn,
+ * 2. stabilne sortowanie według znacznika czasu (tylko jeśli rekordy nie są już posortowane),
+ * 3. wyliczenie tabeli podsumowań dni (kolumny) lub zakodowanie bloków po `blockRecords` rekordów,
+ * 4. zapis nagłówka i sekcji wyrównanych do 64 bajtów wraz z sumami kontrolnymi do pliku
+ *    tymczasowego, który na końcu zastępuje plik docelowy.
+ *
+ * @param fileName Nazwa pliku docelowego.
+ * @param tree Drzewo z danymi.
+ * @param base Wcześniej wczytany snapshot (lub nullptr).
+ * @param encoding Sposób zapisu rekordów.
+ * @param error Opis błędu w przypadku niepowodzenia.
+ * @return true, jeśli zapis się powiódł.
+ */
+bool Snapshot::write(const std::string& fileName, const Tree& tree, const Snapshot* base,
+                     SnapshotEncoding encoding, std::string& error) {
+    // Zebranie rekordów do kolumn
+    std::vector<std::int32_t> timestamps;
+    std::vector<double> columns[Record::fieldCount];
+    if (base != nullptr) base->copyTo(timestamps, columns);
+    for (const auto& [yearKey, year] : tree.years)
+        for (const auto& [monthKey, month] : year.months)
+            for (const auto& [dayKey, day] : month.days)
+                for (const auto& [quarterKey, quarter] : day.quarters) {
+                    timestamps.insert(timestamps.end(), quarter.timestamps.begin(), quarter.timestamps.end());
+                    for (int f = 0; f < Record::fieldCount; ++f) {
+                        const std::pmr::vector<double>& column = quarter.column(f);
+                        columns[f].insert(columns[f].end(), column.begin(), column.end());
+                    }
+                }
+
+    // Sortowanie według czasu (stabilne - rekordy o tym samym czasie zachowują kolejność)
+    if (!std::is_sorted(timestamps.begin(), timestamps.end())) {
+        std::vector<std::size_t> order(timestamps.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&timestamps](std::size_t a, std::size_t b) { return timestamps[a] < timestamps[b]; });
+        std::vector<std::int32_t> sortedTimestamps(order.size());
+        for (std::size_t i = 0; i < order.size(); ++i) sortedTimestamps[i] = timestamps[order[i]];
+        timestamps.swap(sortedTimestamps);
+        for (int f = 0; f < Record::fieldCount; ++f) {
+            std::vector<double> sorted(order.size());
+            for (std::size_t i = 0; i < order.size(); ++i) sorted[i] = columns[f][order[i]];
+            columns[f].swap(sorted);
+        }
+    }
+
+    // Nagłówek
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = formatVersion;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.byteOrder = kByteOrder;
+    header.fieldCount = Record::fieldCount;
+    for (int f = 0; f < Record::fieldCount; ++f) {
+        std::strncpy(header.fieldNames[f], kFieldNames[f], sizeof(header.fieldNames[f]) - 1);
+    }
+    header.encoding = static_cast<std::uint32_t>(encoding);
+    header.recordCount = timestamps.size();
+    std::uint64_t offset = alignUp(sizeof(SnapshotHeader));
+
+    std::vector<SnapshotDay> days;
+    std::vector<SnapshotBlock> blockTable;
+    std::vector<std::uint8_t> blockData;
+    if (encoding == SnapshotEncoding::Columns) {
+        // Tabela podsumowań dni
+        for (std::size_t first = 0; first < timestamps.size();) {
+            const std::int32_t day = dayOf(timestamps[first]);
+            std::size_t last = first + 1;
+            while (last < timestamps.size() && dayOf(timestamps[last]) == day) ++last;
+            SnapshotDay entry = {};
+            entry.day = day;
+            entry.first = first;
+            entry.count = last - first;
+            summarize(entry, columns, first, last);
+            days.push_back(entry);
+            first = last;
+        }
+
+        header.dayCount = days.size();
+        header.timestampsOffset = offset;
+        offset += alignUp(timestamps.size() * sizeof(std::int32_t));
+        for (int f = 0; f < Record::fieldCount; ++f) {
+            header.columnOffsets[f] = offset;
+            offset += alignUp(columns[f].size() * sizeof(double));
+        }
+        header.daysOffset = offset;
+        offset += alignUp(days.size() * sizeof(SnapshotDay));
+    } else {
+        // Bloki: każdy strumień kodowany osobno, przesunięcia najpierw względem początku danych bloków
+        std::vector<double> prediction;
+        for (std::size_t first = 0; first < timestamps.size(); first += blockRecords) {
+            const std::size_t count = std::min<std::size_t>(blockRecords, timestamps.size() - first);
+            SnapshotBlock block = {};
+            block.firstTimestamp = timestamps[first];
+            block.lastTimestamp = timestamps[first + count - 1];
+            block.first = first;
+            block.count = count;
+            block.offsets[0] = blockData.size();
+            BlockCodec::encodeTimestamps(&timestamps[first], count, blockData);
+            for (int f = 0; f < Record::fieldCount; ++f) {
+                block.offsets[f + 1] = blockData.size();
+                const int a = kPredictors[f][0], b = kPredictors[f][1];
+                if (a >= 0) {
+                    prediction.resize(count);
+                    for (std::size_t i = 0; i < count; ++i) prediction[i] = columns[a][first + i] + columns[b][first + i];
+                }
+                BlockCodec::encodeValues(&columns[f][first], count, a >= 0 ? prediction.data() : nullptr, blockData);
+            }
+            block.offsets[Record::fieldCount + 1] = blockData.size();
+            summarize(block, columns, first, first + count);
+            blockTable.push_back(block);
+        }
+
+        header.blockRecords = blockRecords;
+        header.blockCount = blockTable.size();
+        header.blocksOffset = offset;
+        offset += alignUp(blockTable.size() * sizeof(SnapshotBlock));
+        for (SnapshotBlock& block : blockTable) {
+            for (std::uint64_t& streamOffset : block.offsets) streamOffset += offset;
+        }
+        offset += alignUp(blockData.size());
+    }
+    header.fileSize = offset;
+
+    // Zapis do pliku tymczasowego - docelowy plik może być właśnie zmapowany jako `base`.
+    // Nagłówek jest zapisywany na końcu, gdy znana jest suma kontrolna danych.
+    const std::string temporaryName = fileName + ".tmp";
+    std::ofstream out(temporaryName, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        error = "Nie można utworzyć pliku: " + temporaryName;
+        return false;
+    }
+    Checksum headerPadding;
+    writeSection(out, headerPadding, &header, sizeof(header));
+    Checksum payload;
+    if (encoding == SnapshotEncoding::Columns) {
+        writeSection(out, payload, timestamps.data(), timestamps.size() * sizeof(std::int32_t));
+        for (int f = 0; f < Record::fieldCount; ++f) {
+            writeSection(out, payload, columns[f].data(), columns[f].size() * sizeof(double));
+        }
+        writeSection(out, payload, days.data(), days.size() * sizeof(SnapshotDay));
+    } else {
+        writeSection(out, payload, blockTable.data(), blockTable.size() * sizeof(SnapshotBlock));
+        writeSection(out, payload, blockData.data(), blockData.size());
+    }
+
+    header.payloadChecksum = payload.value();
+    header.headerChecksum = headerChecksum(header);
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        std::remove(temporaryName.c_str());
+        error = "Błąd zapisu pliku: " + temporaryName;
+        return false;
+    }
+
+    // Podmiana pliku docelowego (na Windows rename nie nadpisuje istniejącego pliku)
+    if (std::rename(temporaryName.c_str(), fileName.c_str()) != 0) {
+        std::remove(fileName.c_str());
+        if (std::rename(temporaryName.c_str(), fileName.c_str()) != 0) {
+            error = "Nie można zastąpić pliku: " + fileName;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Otwiera i mapuje plik snapshotu, sprawdzając jego nagłówek.
+ *
+ * Najpierw sprawdzana jest sygnatura i wersja (te pola mają stałe położenie we wszystkich
+ * wersjach formatu), dzięki czemu plik w innej wersji jest odrzucany z czytelnym komunikatem,
+ * zanim nastąpi próba interpretacji reszty nagłówka. Dla skompresowanych bloków sprawdzany
+ * jest też katalog bloków (jeden wpis na `blockRecords` rekordów).
+ *
+ * @param fileName Nazwa pliku snapshotu.
+ * @param error Opis błędu, jeśli pliku nie da się użyć.
+ * @return true, jeśli snapshot jest gotowy do zapytań.
+ */
+bool Snapshot::open(const std::string& fileName, std::string& error) {
+    header = nullptr;
+    days = nullptr;
+    blocks = nullptr;
+    timestampColumn = nullptr;
+    for (int f = 0; f < Record::fieldCount; ++f) columns[f] = nullptr;
+    cache.reset();
+    file.reset(new MappedFile(fileName, false));
+    if (!file->isOpen()) {
+        error = "Nie można otworzyć pliku: " + fileName;
+        return false;
+    }
+
+    const char* base = file->data();
+    const std::size_t size = file->size();
+    if (size < offsetof(SnapshotHeader, headerSize) || std::memcmp(base, kMagic, sizeof(kMagic)) != 0) {
+        error = "Plik nie jest snapshotem danych: " + fileName;
+        return false;
+    }
+    std::uint32_t version = 0;
+    std::memcpy(&version, base + offsetof(SnapshotHeader, version), sizeof(version));
+    if (version != formatVersion) {
+        error = "Nieobsługiwana wersja snapshotu: " + std::to_string(version) +
+                " (obsługiwana wersja: " + std::to_string(formatVersion) + ")";
+        return false;
+    }
+    if (size < sizeof(SnapshotHeader)) {
+        error = "Uszkodzony snapshot (za krótki nagłówek): " + fileName;
+        return false;
+    }
+
+    const SnapshotHeader* candidate = reinterpret_cast<const SnapshotHeader*>(base);
+    if (candidate->byteOrder != kByteOrder) {
+        error = "Snapshot zapisany na maszynie o innym porządku bajtów: " + fileName;
+        return false;
+    }
+    if (candidate->headerSize != sizeof(SnapshotHeader) || candidate->headerChecksum != headerChecksum(*candidate)) {
+        error = "Uszkodzony nagłówek snapshotu: " + fileName;
+        return false;
+    }
+    if (candidate->fieldCount != Record::fieldCount) {
+        error = "Nieobsługiwany układ kolumn snapshotu: " + fileName;
+        return false;
+    }
+    for (int f = 0; f < Record::fieldCount; ++f) {
+        if (std::strncmp(candidate->fieldNames[f], kFieldNames[f], sizeof(candidate->fieldNames[f])) != 0) {
+            error = "Nieobsługiwany układ kolumn snapshotu: " + fileName;
+            return false;
+        }
+    }
+
+    // Kontrola położenia i rozmiaru sekcji (liczności ograniczone rozmiarem pliku, więc iloczyny się nie przepełnią)
+    const std::uint64_t count = candidate->recordCount;
+    bool valid = candidate->fileSize == size && count <= size && candidate->dayCount <= size &&
+                 candidate->blockCount <= size;
+    if (candidate->encoding == static_cast<std::uint32_t>(SnapshotEncoding::Columns)) {
+        valid = valid && candidate->blockCount == 0 &&
+                candidate->timestampsOffset % kAlignment == 0 &&
+                candidate->timestampsOffset + count * sizeof(std::int32_t) <= size &&
+                candidate->daysOffset % kAlignment == 0 &&
+                candidate->daysOffset + candidate->dayCount * sizeof(SnapshotDay) <= size;
+        for (int f = 0; f < Record::fieldCount; ++f) {
+            valid = valid && candidate->columnOffsets[f] % kAlignment == 0 &&
+                    candidate->columnOffsets[f] + count * sizeof(double) <= size;
+        }
+    } else if (candidate->encoding == static_cast<std::uint32_t>(SnapshotEncoding::CompressedBlocks)) {
+        valid = valid && candidate->blockRecords > 0 &&
+                candidate->blocksOffset % kAlignment == 0 &&
+                candidate->blocksOffset + candidate->blockCount * sizeof(SnapshotBlock) <= size;
+    } else {
+        error = "Nieobsługiwany sposób zapisu snapshotu: " + std::to_string(candidate->encoding);
+        return false;
+    }
+    if (!valid) {
+        error = "Uszkodzony snapshot (niezgodne rozmiary sekcji): " + fileName;
+        return false;
+    }
+
+    header = candidate;
+    if (encoding() == SnapshotEncoding::Columns) {
+        timestampColumn = reinterpret_cast<const std::int32_t*>(base + header->timestampsOffset);
+        for (int f = 0; f < Record::fieldCount; ++f) {
+            columns[f] = reinterpret_cast<const double*>(base + header->columnOffsets[f]);
+        }
+        days = reinterpret_cast<const SnapshotDay*>(base + header->daysOffset);
+    } else {
+        blocks = reinterpret_cast<const SnapshotBlock*>(base + header->blocksOffset);
+        if (!validateBlocks()) {
+            header = nullptr;
+            blocks = nullptr;
+            error = "Uszkodzony snapshot (niepoprawny katalog bloków): " + fileName;
+            return false;
+        }
+    }
+    cache.reset(new SnapshotCache(residentLimit));
+    return true;
+}
+
+/**
+ * @brief Ustawia limit pamięci zdekodowanych bloków lub odczytanych miesięcy kolumn.
+ *
+ * @param bytes Limit w bajtach.
+ */
+void Snapshot::setResidentLimit(std::size_t bytes) {
+    residentLimit = bytes;
+    if (!cache) return;
+    std::vector<std::uint64_t> evicted;
+    cache->setLimit(bytes, evicted);
+    discardMonths(evicted);
+}
+
+/**
+ * @brief Zwraca stan pamięci podręcznej snapshotu.
+ */
+SnapshotResidency Snapshot::residency() const {
+    if (cache) return cache->state();
+    SnapshotResidency result;
+    result.limit = residentLimit;
+    return result;
+}
+
+/**
+ * @brief Zwraca zdekodowany blok z pamięci podręcznej lub dekoduje go w całości i zapamiętuje.
+ *
+ * @param block Wpis katalogu bloków.
+ * @return Zdekodowany blok (ważny także po usunięciu z pamięci podręcznej).
+ */
+std::shared_ptr<const DecodedBlock> Snapshot::decoded(const SnapshotBlock& block) const {
+    const std::uint64_t key = static_cast<std::uint64_t>(&block - blocks);
+    bool found = false;
+    std::shared_ptr<const DecodedBlock> cached = cache->find(key, found);
+    if (cached) return cached;
+
+    std::shared_ptr<DecodedBlock> result = std::make_shared<DecodedBlock>();
+    decodeTimestamps(block, result->timestamps);
+    const std::size_t count = result->timestamps.size();
+    const std::uint8_t* base = reinterpret_cast<const std::uint8_t*>(file->data());
+    std::vector<double> prediction;
+    for (int f = 0; f < Record::fieldCount; ++f) {
+        // Kolumny bazowe przewidywania mają mniejsze indeksy, więc są już zdekodowane
+        const int a = kPredictors[f][0], b = kPredictors[f][1];
+        if (a >= 0) {
+            prediction.resize(count);
+            for (std::size_t i = 0; i < count; ++i) prediction[i] = result->values[a][i] + result->values[b][i];
+        }
+        result->values[f].resize(count);
+        BlockCodec::decodeValues(base + block.offsets[f + 1],
+                                 static_cast<std::size_t>(block.offsets[f + 2] - block.offsets[f + 1]), count,
+                                 a >= 0 ? prediction.data() : nullptr, result->values[f].data());
+    }
+    const std::size_t bytes =
+        sizeof(DecodedBlock) + result->timestamps.size() * (sizeof(std::int32_t) + Record::fieldCount * sizeof(double));
+    // Usunięte bloki są zwalniane, gdy przestanie ich używać ostatnie zapytanie
+    std::vector<std::uint64_t> evicted;
+    cache->insert(key, bytes, result, evicted);
+    return result;
+}
+
+/**
+ * @brief Wyznacza przedział indeksów rekordów miesiąca (dwa wyszukiwania w tabeli dni).
+ *
+ * @param key Klucz miesiąca: `rok * 12 + miesiąc - 1`.
+ * @return Przedział indeksów `[first, last)`.
+ */
+std::pair<std::size_t, std::size_t> Snapshot::monthRange(std::int32_t key) const {
+    const int year = key / 12, month = key % 12 + 1;
+    const std::int32_t firstDay = Timestamp::daysFromCivil(year, month, 1);
+    const std::int32_t nextDay = month == 12 ? Timestamp::daysFromCivil(year + 1, 1, 1) : Timestamp::daysFromCivil(year, month + 1, 1);
+    const SnapshotDay* daysEnd = days + header->dayCount;
+    const auto byDay = [](const SnapshotDay& entry, std::int32_t day) { return entry.day < day; };
+    const SnapshotDay* begin = std::lower_bound(days, daysEnd, firstDay, byDay);
+    const SnapshotDay* end = std::lower_bound(begin, daysEnd, nextDay, byDay);
+    const std::size_t first = begin == daysEnd ? size() : static_cast<std::size_t>(begin->first);
+    const std::size_t last = end == daysEnd ? size() : static_cast<std::size_t>(end->first);
+    return std::make_pair(first, last);
+}
+
+/**
+ * @brief Oznacza miesiące rekordów `[first, last)` jako używane i zwalnia strony miesięcy ponad limit.
+ *
+ * Rozmiar miesiąca to rozmiar jego fragmentów kolumny znaczników czasu i kolumn wartości.
+ *
+ * @param first Indeks pierwszego rekordu.
+ * @param last Indeks za ostatnim rekordem.
+ */
+void Snapshot::touch(std::size_t first, std::size_t last) const {
+    std::vector<std::uint64_t> evicted;
+    while (first < last) {
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+        Timestamp::toDateTime(timestampColumn[first], year, month, day, hour, minute);
+        const std::int32_t key = year * 12 + month - 1;
+        bool found = false;
+        cache->find(static_cast<std::uint64_t>(key), found);
+        // Zakres w obrębie jednego miesiąca (typowa krawędź przedziału) nie wymaga wyszukiwania jego granic
+        const std::int32_t nextMonth = month == 12 ? Timestamp::fromDateTime(year + 1, 1, 1, 0, 0)
+                                                   : Timestamp::fromDateTime(year, month + 1, 1, 0, 0);
+        if (found && timestampColumn[last - 1] < nextMonth) break;
+        const std::pair<std::size_t, std::size_t> bounds = monthRange(key);
+        if (!found) {
+            const std::size_t bytes =
+                (bounds.second - bounds.first) * (sizeof(std::int32_t) + Record::fieldCount * sizeof(double));
+            cache->insert(static_cast<std::uint64_t>(key), bytes, nullptr, evicted);
+        }
+        first = std::max(bounds.second, first + 1);
+    }
+    discardMonths(evicted);
+}
+
+/**
+ * @brief Zwalnia strony zmapowanych kolumn miesięcy o podanych kluczach.
+ *
+ * @param keys Klucze miesięcy usuniętych z pamięci podręcznej.
+ */
+void Snapshot::discardMonths(const std::vector<std::uint64_t>& keys) const {
+    for (const std::uint64_t key : keys) {
+        const std::pair<std::size_t, std::size_t> month = monthRange(static_cast<std::int32_t>(key));
+        const std::size_t count = month.second - month.first;
+        file->discard(static_cast<std::size_t>(header->timestampsOffset) + month.first * sizeof(std::int32_t),
+                      count * sizeof(std::int32_t));
+        for (int f = 0; f < Record::fieldCount; ++f) {
+            file->discard(static_cast<std::size_t>(header->columnOffsets[f]) + month.first * sizeof(double),
+                          count * sizeof(double));
+        }
+    }
+}
+
+/**
+ * @brief Sprawdza katalog bloków: ciągłość indeksów rekordów, kolejność czasu i położenie strumieni.
+ *
+ * Po tej kontroli dekodowanie dowolnego bloku odczytuje wyłącznie pamięć wewnątrz pliku.
+ *
+ * @return true, jeśli katalog jest spójny z nagłówkiem.
+ */
+bool Snapshot::validateBlocks() const {
+    const std::uint64_t dataBegin = header->blocksOffset + header->blockCount * sizeof(SnapshotBlock);
+    std::uint64_t expectedFirst = 0;
+    for (std::uint64_t b = 0; b < header->blockCount; ++b) {
+        const SnapshotBlock& block = blocks[b];
+        if (block.first != expectedFirst || block.count == 0 || block.count > header->blockRecords ||
+            block.firstTimestamp > block.lastTimestamp ||
+            (b > 0 && block.firstTimestamp < blocks[b - 1].lastTimestamp)) {
+            return false;
+        }
+        if (block.offsets[0] < dataBegin || block.offsets[Record::fieldCount + 1] > header->fileSize) return false;
+        for (int s = 0; s <= Record::fieldCount; ++s) {
+            if (block.offsets[s] > block.offsets[s + 1]) return false;
+        }
+        expectedFirst += block.count;
+    }
+    return expectedFirst == header->recordCount;
+}
+
+/**
+ * @brief Sprawdza sumę kontrolną sekcji danych (odczytuje cały plik).
+ *
+ * @param error Opis błędu w przypadku niezgodności.
+ * @return true, jeśli suma kontrolna jest zgodna z zapisaną w nagłówku.
+ */
+bool Snapshot::verify(std::string& error) const {
+    if (header == nullptr) {
+        error = "Snapshot nie jest otwarty";
+        return false;
+    }
+    const std::uint64_t payloadOffset = alignUp(sizeof(SnapshotHeader));
+    Checksum payload;
+    payload.update(file->data() + payloadOffset, static_cast<std::size_t>(header->fileSize - payloadOffset));
+    if (payload.value() != header->payloadChecksum) {
+        error = "Niezgodna suma kontrolna danych snapshotu";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Dekoduje znaczniki czasu bloku do `timestamps`.
+ *
+ * Uszkodzone dane (wykrywane przez `verify`) dają nieokreślone wartości, ale nie powodują
+ * odczytu poza zmapowanym plikiem.
+ *
+ * @param block Wpis katalogu bloków.
+ * @param timestamps Bufor wyjściowy (zmieniany rozmiar na liczbę rekordów bloku).
+ */
+void Snapshot::decodeTimestamps(const SnapshotBlock& block, std::vector<std::int32_t>& timestamps) const {
+    const std::uint8_t* base = reinterpret_cast<const std::uint8_t*>(file->data());
+    timestamps.resize(static_cast<std::size_t>(block.count));
+    BlockCodec::decodeTimestamps(base + block.offsets[0], static_cast<std::size_t>(block.offsets[1] - block.offsets[0]),
+                                 timestamps.size(), timestamps.data());
+}
+
+/**
+ * @brief Dekoduje `count` pierwszych wartości kolumny bloku do `values`.
+ *
+ * Strumień jest dekodowany od początku, więc dla prawej krawędzi przedziału wystarcza
+ * zdekodowanie tylko potrzebnego początku bloku. Dla kolumn z przewidywaniem (`kPredictors`)
+ * najpierw dekodowane są obie kolumny bazowe.
+ *
+ * @param block Wpis katalogu bloków.
+ * @param field Indeks wielkości.
+ * @param count Liczba wartości do zdekodowania (nie większa niż liczba rekordów bloku).
+ * @param values Bufor wyjściowy (zmieniany rozmiar na `count`).
+ */
+void Snapshot::decodeColumn(const SnapshotBlock& block, int field, std::size_t count, std::vector<double>& values) const {
+    std::vector<double> prediction;
+    if (kPredictors[field][0] >= 0) {
+        std::vector<double> other;
+        decodeColumn(block, kPredictors[field][0], count, prediction);
+        decodeColumn(block, kPredictors[field][1], count, other);
+        for (std::size_t i = 0; i < count; ++i) prediction[i] += other[i];
+    }
+    const std::uint8_t* base = reinterpret_cast<const std::uint8_t*>(file->data());
+    values.resize(count);
+    BlockCodec::decodeValues(base + block.offsets[field + 1],
+                             static_cast<std::size_t>(block.offsets[field + 2] - block.offsets[field + 1]),
+                             count, prediction.empty() ? nullptr : prediction.data(), values.data());
+}
+
+/**
+ * @brief Dopisuje wszystkie rekordy snapshotu na koniec kolumn (dekodując bloki w razie potrzeby).
+ *
+ * @param timestamps Kolumna znaczników czasu.
+ * @param values Kolumny wartości.
+ */
+void Snapshot::copyTo(std::vector<std::int32_t>& timestamps, std::vector<double> (&values)[Record::fieldCount]) const {
+    if (encoding() == SnapshotEncoding::Columns) {
+        timestamps.insert(timestamps.end(), timestampColumn, timestampColumn + size());
+        for (int f = 0; f < Record::fieldCount; ++f) values[f].insert(values[f].end(), columns[f], columns[f] + size());
+        return;
+    }
+    std::vector<std::int32_t> blockTimestamps;
+    std::vector<double> blockValues;
+    for (std::uint64_t b = 0; b < header->blockCount; ++b) {
+        decodeTimestamps(blocks[b], blockTimestamps);
+        timestamps.insert(timestamps.end(), blockTimestamps.begin(), blockTimestamps.end());
+        for (int f = 0; f < Record::fieldCount; ++f) {
+            decodeColumn(blocks[b], f, static_cast<std::size_t>(blocks[b].count), blockValues);
+            values[f].insert(values[f].end(), blockValues.begin(), blockValues.end());
+        }
+    }
+}
+
+/**
+ * @brief Odtwarza rekord o podanym indeksie (ze zmapowanych kolumn lub dekodując jego blok).
+ *
+ * @param index Indeks rekordu.
+ * @return Record Rekord ze znacznikiem czasu i wartościami pomiarów.
+ */
+Record Snapshot::record(std::size_t index) const {
+    if (encoding() == SnapshotEncoding::Columns) {
+        return Record(timestampColumn[index], columns[0][index], columns[1][index], columns[2][index],
+                      columns[3][index], columns[4][index]);
+    }
+    const SnapshotBlock* end = blocks + header->blockCount;
+    const SnapshotBlock& block = *(std::upper_bound(blocks, end, index,
+                                                    [](std::size_t i, const SnapshotBlock& b) { return i < b.first; }) - 1);
+    return decoded(block)->record(index - static_cast<std::size_t>(block.first));
+}
+
+/**
+ * @brief Zwraca indeks pierwszego rekordu o czasie `>= timestamp` (lub `> timestamp` dla `after`).
+ *
+ * Dla skompresowanych bloków katalog wskazuje blok, w którym leży granica, i dekodowane są
+ * tylko znaczniki czasu tego bloku.
+ *
+ * @param timestamp Szukany znacznik czasu.
+ * @param after false - dolna granica, true - górna granica.
+ * @return std::size_t Indeks rekordu (`size()`, jeśli brak takiego rekordu).
+ */
+std::size_t Snapshot::bound(std::int32_t timestamp, bool after) const {
+    const auto before = [after, timestamp](std::int32_t value) { return after ? value <= timestamp : value < timestamp; };
+    if (encoding() == SnapshotEncoding::Columns) {
+        return static_cast<std::size_t>(std::partition_point(timestampColumn, timestampColumn + size(), before) -
+                                        timestampColumn);
+    }
+    const SnapshotBlock* end = blocks + header->blockCount;
+    const SnapshotBlock* block =
+        std::partition_point(blocks, end, [&before](const SnapshotBlock& b) { return before(b.lastTimestamp); });
+    if (block == end) return size();
+    if (!before(block->firstTimestamp)) return static_cast<std::size_t>(block->first);
+    const std::shared_ptr<const DecodedBlock> data = decoded(*block);
+    const std::vector<std::int32_t>& timestamps = data->timestamps;
+    return static_cast<std::size_t>(block->first) +
+           static_cast<std::size_t>(std::partition_point(timestamps.begin(), timestamps.end(), before) - timestamps.begin());
+}
+
+/**
+ * @brief Wyznacza przedział indeksów rekordów z zakresu czasu `[from, to]`.
+ *
+ * @param from Początek zakresu (włącznie).
+ * @param to Koniec zakresu (włącznie).
+ * @return Przedział indeksów `[first, last)`.
+ */
+std::pair<std::size_t, std::size_t> Snapshot::range(std::int32_t from, std::int32_t to) const {
+    if (to < from || size() == 0) return std::make_pair(std::size_t(0), std::size_t(0));
+    return std::make_pair(bound(from, false), bound(to, true));
+}
+
+/**
+ * @brief Wyznacza najmniejszy i największy znacznik czasu.
+ *
+ * Dla skompresowanych bloków zakres pochodzi z katalogu bloków.
+ *
+ * @param first Wyjściowy najmniejszy znacznik czasu.
+ * @param last Wyjściowy największy znacznik czasu.
+ * @return false, jeśli snapshot jest pusty.
+ */
+bool Snapshot::timeSpan(std::int32_t& first, std::int32_t& last) const {
+    if (size() == 0) return false;
+    if (encoding() == SnapshotEncoding::Columns) {
+        first = timestampColumn[0];
+        last = timestampColumn[size() - 1];
+    } else {
+        first = blocks[0].firstTimestamp;
+        last = blocks[header->blockCount - 1].lastTimestamp;
+    }
+    return true;
+}
+
+/**
+ * @brief Oblicza agregat wybranej wielkości w przedziale czasu `[from, to]`.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @return Aggregate Agregat wartości.
+ */
+Aggregate Snapshot::aggregate(std::int32_t from, std::int32_t to, int field) const {
+    if (to < from || size() == 0 || field < 0 || field >= Record::fieldCount) return Aggregate();
+    Aggregates result;
+    if (encoding() == SnapshotEncoding::Columns) columnsAggregate(from, to, field, field + 1, result);
+    else blocksAggregate(from, to, field, field + 1, result);
+    return result.fields[field];
+}
+
+/**
+ * @brief Oblicza agregaty wszystkich wielkości w przedziale czasu `[from, to]`.
+ *
+ * Granice przedziału (dni lub bloki na krawędziach) są wyznaczane raz dla wszystkich wielkości.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @return Aggregates Agregaty wszystkich wielkości.
+ */
+Aggregates Snapshot::aggregate(std::int32_t from, std::int32_t to) const {
+    Aggregates result;
+    if (to < from || size() == 0) return result;
+    if (encoding() == SnapshotEncoding::Columns) columnsAggregate(from, to, 0, Record::fieldCount, result);
+    else blocksAggregate(from, to, 0, Record::fieldCount, result);
+    return result;
+}
+
+/**
+ * @brief Agregaty przedziału dla nieskompresowanych kolumn.
+ *
+ * Dni w całości zawarte w przedziale wnoszą swoje zapisane podsumowania, a w dniach
+ * na krawędziach (początek i koniec przedziału) przeglądane są pojedyncze rekordy.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param firstField Pierwsza liczona wielkość.
+ * @param lastField Wielkość za ostatnią liczoną.
+ * @param result Agregaty wielkości `[firstField, lastField)`.
+ */
+void Snapshot::columnsAggregate(std::int32_t from, std::int32_t to, int firstField, int lastField,
+                                Aggregates& result) const {
+    // Pełne dni: od pierwszego dnia zaczynającego się nie wcześniej niż `from`
+    // do ostatniego dnia kończącego się nie później niż `to`
+    const std::int32_t firstFullDay = dayOf(from - 1) + 1;
+    const std::int32_t lastFullDay = dayOf(to + 1) - 1;
+    const SnapshotDay* daysEnd = days + header->dayCount;
+    const auto byDay = [](const SnapshotDay& entry, std::int32_t day) { return entry.day < day; };
+    const SnapshotDay* fullBegin = std::lower_bound(days, daysEnd, firstFullDay, byDay);
+    const SnapshotDay* fullEnd = std::lower_bound(fullBegin, daysEnd, lastFullDay + 1, byDay);
+
+    const auto scan = [&](std::size_t first, std::size_t last) {
+        touch(first, last);
+        for (int f = firstField; f < lastField; ++f) {
+            const double* values = columns[f];
+            for (std::size_t i = first; i < last; ++i) result.fields[f].add(values[i]);
+        }
+    };
+
+    if (fullBegin == fullEnd) {
+        // Brak pełnych dni - przegląd rekordów całego przedziału
+        const std::pair<std::size_t, std::size_t> bounds = range(from, to);
+        scan(bounds.first, bounds.second);
+        return;
+    }
+
+    // Lewa krawędź: rekordy od `from` do początku pierwszego pełnego dnia
+    const std::pair<std::size_t, std::size_t> all = range(from, to);
+    scan(all.first, static_cast<std::size_t>(fullBegin->first));
+    // Pełne dni z tabeli podsumowań
+    for (const SnapshotDay* day = fullBegin; day != fullEnd; ++day) {
+        for (int f = firstField; f < lastField; ++f) result.fields[f].merge(summaryAggregate(*day, f));
+    }
+    // Prawa krawędź: rekordy od końca ostatniego pełnego dnia do `to`
+    const SnapshotDay* lastFull = fullEnd - 1;
+    scan(static_cast<std::size_t>(lastFull->first + lastFull->count), all.second);
+}
+
+/**
+ * @brief Agregaty przedziału dla skompresowanych bloków.
+ *
+ * Bloki w całości zawarte w przedziale wnoszą podsumowania z katalogu; rekordy są
+ * czytane (z pamięci podręcznej lub po zdekodowaniu) tylko z bloków przecinających
+ * krawędzie przedziału.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param firstField Pierwsza liczona wielkość.
+ * @param lastField Wielkość za ostatnią liczoną.
+ * @param result Agregaty wielkości `[firstField, lastField)`.
+ */
+void Snapshot::blocksAggregate(std::int32_t from, std::int32_t to, int firstField, int lastField,
+                               Aggregates& result) const {
+    const SnapshotBlock* end = blocks + header->blockCount;
+    const SnapshotBlock* block =
+        std::partition_point(blocks, end, [from](const SnapshotBlock& b) { return b.lastTimestamp < from; });
+    for (; block != end && block->firstTimestamp <= to; ++block) {
+        if (block->firstTimestamp >= from && block->lastTimestamp <= to) {
+            for (int f = firstField; f < lastField; ++f) result.fields[f].merge(summaryAggregate(*block, f));
+            continue;
+        }
+        const std::shared_ptr<const DecodedBlock> data = decoded(*block);
+        const std::vector<std::int32_t>& timestamps = data->timestamps;
+        const std::size_t first = static_cast<std::size_t>(
+            std::lower_bound(timestamps.begin(), timestamps.end(), from) - timestamps.begin());
+        const std::size_t last = static_cast<std::size_t>(
+            std::upper_bound(timestamps.begin(), timestamps.end(), to) - timestamps.begin());
+        for (int f = firstField; f < lastField; ++f) {
+            const std::vector<double>& values = data->values[f];
+            for (std::size_t i = first; i < last; ++i) result.fields[f].add(values[i]);
+        }
+    }
+}
+
+/**
+ * @brief Wyszukuje rekordy z przedziału `[from, to]` o wartości `value ± tolerance`.
+ *
+ * Dla nieskompresowanych kolumn filtrowany jest jeden ciągły fragment kolumny. Dla bloków
+ * filtrowana jest kolumna wybranej wielkości zdekodowanego bloku (`decoded`), a rekordy
+ * są odtwarzane tylko dla trafień.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @param value Szukana wartość.
+ * @param tolerance Tolerancja.
+ * @param matches Lista wyjściowa.
+ */
+void Snapshot::search(std::int32_t from, std::int32_t to, int field, double value, double tolerance,
+                      std::vector<Record>& matches) const {
+    if (to < from || size() == 0 || field < 0 || field >= Record::fieldCount) return;
+    std::vector<std::uint64_t> bitmap;
+    std::vector<std::size_t> indices;
+
+    if (encoding() == SnapshotEncoding::Columns) {
+        const std::pair<std::size_t, std::size_t> bounds = range(from, to);
+        touch(bounds.first, bounds.second);
+        SearchKernel::match(columns[field] + bounds.first, bounds.second - bounds.first, value, tolerance, bitmap);
+        SearchKernel::indices(bitmap, bounds.first, indices);
+        for (const std::size_t i : indices) matches.push_back(record(i));
+        return;
+    }
+
+    const SnapshotBlock* end = blocks + header->blockCount;
+    const SnapshotBlock* block =
+        std::partition_point(blocks, end, [from](const SnapshotBlock& b) { return b.lastTimestamp < from; });
+    for (; block != end && block->firstTimestamp <= to; ++block) {
+        const std::shared_ptr<const DecodedBlock> data = decoded(*block);
+        const std::vector<std::int32_t>& timestamps = data->timestamps;
+        const std::size_t first = static_cast<std::size_t>(
+            std::lower_bound(timestamps.begin(), timestamps.end(), from) - timestamps.begin());
+        const std::size_t last = static_cast<std::size_t>(
+            std::upper_bound(timestamps.begin(), timestamps.end(), to) - timestamps.begin());
+        if (SearchKernel::match(data->values[field].data() + first, last - first, value, tolerance, bitmap) == 0) continue;
+
+        indices.clear();
+        SearchKernel::indices(bitmap, first, indices);
+        for (const std::size_t i : indices) matches.push_back(data->record(i));
+    }
+}
+
+/**
+ * @brief Dodaje do kopca najlepsze rekordy przedziału, przeglądając dni (bloki) od najlepszego podsumowania.
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param top Kopiec wyników.
+ * @param stats Liczniki przejrzanych i pominiętych rekordów.
+ */
+void Snapshot::top(std::int32_t from, std::int32_t to, TopK& top, ScanStats& stats) const {
+    const int field = top.fieldIndex();
+    if (to < from || size() == 0 || field < 0 || field >= Record::fieldCount) return;
+    const bool columnar = encoding() == SnapshotEncoding::Columns;
+
+    // Dni lub bloki przecinające przedział z podsumowaniem wielkości
+    struct Segment {
+        double bound;
+        Aggregate stats;
+        std::size_t index;
+    };
+    std::vector<Segment> segments;
+    const std::pair<std::size_t, std::size_t> bounds = columnar ? range(from, to) : std::make_pair(std::size_t(0), size());
+    if (columnar) {
+        const SnapshotDay* daysEnd = days + header->dayCount;
+        const SnapshotDay* day = std::partition_point(
+            days, daysEnd, [&bounds](const SnapshotDay& d) { return d.first + d.count <= bounds.first; });
+        for (; day != daysEnd && day->first < bounds.second; ++day) {
+            const Aggregate aggregate = summaryAggregate(*day, field);
+            segments.push_back(Segment{ top.bound(aggregate), aggregate, static_cast<std::size_t>(day - days) });
+        }
+    } else {
+        const SnapshotBlock* blocksEnd = blocks + header->blockCount;
+        const SnapshotBlock* block =
+            std::partition_point(blocks, blocksEnd, [from](const SnapshotBlock& b) { return b.lastTimestamp < from; });
+        for (; block != blocksEnd && block->firstTimestamp <= to; ++block) {
+            const Aggregate aggregate = summaryAggregate(*block, field);
+            segments.push_back(Segment{ top.bound(aggregate), aggregate, static_cast<std::size_t>(block - blocks) });
+        }
+    }
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) { return a.bound > b.bound; });
+
+    for (std::size_t s = 0; s < segments.size(); ++s) {
+        if (!top.admits(segments[s].stats)) {
+            // Pozostałe dni (bloki) mają gorsze ograniczenie
+            for (std::size_t rest = s; rest < segments.size(); ++rest) stats.skipped += segments[rest].stats.count;
+            return;
+        }
+        if (columnar) {
+            const SnapshotDay& day = days[segments[s].index];
+            const std::size_t first = std::max(static_cast<std::size_t>(day.first), bounds.first);
+            const std::size_t last = std::min(static_cast<std::size_t>(day.first + day.count), bounds.second);
+            const double* column = columns[field];
+            touch(first, last);
+            for (std::size_t i = first; i < last; ++i) {
+                ++stats.visited;
+                if (top.admits(column[i])) top.offer(record(i));
+            }
+            continue;
+        }
+
+        const std::shared_ptr<const DecodedBlock> data = decoded(blocks[segments[s].index]);
+        const std::vector<std::int32_t>& timestamps = data->timestamps;
+        const std::size_t first = static_cast<std::size_t>(
+            std::lower_bound(timestamps.begin(), timestamps.end(), from) - timestamps.begin());
+        const std::size_t last = static_cast<std::size_t>(
+            std::upper_bound(timestamps.begin(), timestamps.end(), to) - timestamps.begin());
+        const std::vector<double>& values = data->values[field];
+        for (std::size_t i = first; i < last; ++i) {
+            ++stats.visited;
+            if (top.admits(values[i])) top.offer(data->record(i));
+        }
+    }
+}
+
+/**
+ * @brief Dopisuje rekordy przedziału chronologicznie (ze zmapowanych kolumn lub dekodując bloki).
+ *
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param records Lista wyjściowa.
+ */
+void Snapshot::records(std::int32_t from, std::int32_t to, std::vector<Record>& records) const {
+    if (to < from || size() == 0) return;
+    if (encoding() == SnapshotEncoding::Columns) {
+        const std::pair<std::size_t, std::size_t> bounds = range(from, to);
+        touch(bounds.first, bounds.second);
+        for (std::size_t i = bounds.first; i < bounds.second; ++i) records.push_back(record(i));
+        return;
+    }
+
+    const SnapshotBlock* end = blocks + header->blockCount;
+    const SnapshotBlock* block =
+        std::partition_point(blocks, end, [from](const SnapshotBlock& b) { return b.lastTimestamp < from; });
+    for (; block != end && block->firstTimestamp <= to; ++block) {
+        const std::shared_ptr<const DecodedBlock> data = decoded(*block);
+        const std::vector<std::int32_t>& timestamps = data->timestamps;
+        const std::size_t first = static_cast<std::size_t>(
+            std::lower_bound(timestamps.begin(), timestamps.end(), from) - timestamps.begin());
+        const std::size_t last = static_cast<std::size_t>(
+            std::upper_bound(timestamps.begin(), timestamps.end(), to) - timestamps.begin());
+        for (std::size_t i = first; i < last; ++i) records.push_back(data->record(i));
+    }
+}
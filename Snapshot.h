@@ -0,0 +1,522 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Aggregate.h"
+#include "MappedFile.h"
+#include "Record.h"
+#include "SnapshotCache.h"
+
+class Tree;
+class TopK;
+struct ScanStats;
+
+/**
+ * @brief Sposób zapisu rekordów w snapshocie.
+ */
+enum class SnapshotEncoding : std::uint32_t {
+    /**
+     * @brief Nieskompresowane kolumny używane bezpośrednio ze zmapowanej pamięci.
+     */
+    Columns = 0,
+
+    /**
+     * @brief Niezależnie dekodowane, skompresowane bloki rekordów (patrz `BlockCodec`).
+     */
+    CompressedBlocks = 1
+};
+
+/**
+ * @brief Nagłówek pliku snapshotu (format binarny `saveToBinary`).
+ *
+ * Plik składa się z nagłówka i sekcji wyrównanych do 64 bajtów. W kodowaniu
+ * `SnapshotEncoding::Columns` są to:
+ * - kolumna znaczników czasu (`int32`, minuty od 2000-01-01, rosnąco),
+ * - pięć kolumn wartości (`double`) w kolejności `Record::fieldIndex`,
+ * - tabela podsumowań dni (`SnapshotDay`), po jednym wpisie na każdy dzień z danymi.
+ *
+ * W kodowaniu `SnapshotEncoding::CompressedBlocks` są to:
+ * - katalog bloków (`SnapshotBlock`) z położeniem strumieni i podsumowaniem każdego bloku,
+ * - skompresowane strumienie bloków (`BlockCodec`).
+ *
+ * Wszystkie liczby są zapisywane w porządku bajtów maszyny, która utworzyła plik;
+ * pole `byteOrder` pozwala odrzucić plik z maszyny o innym porządku.
+ */
+struct SnapshotHeader {
+    /**
+     * @brief Sygnatura pliku: "PVSNAP\0\0".
+     */
+    char magic[8];
+
+    /**
+     * @brief Wersja formatu (patrz `Snapshot::formatVersion`).
+     */
+    std::uint32_t version;
+
+    /**
+     * @brief Rozmiar nagłówka (`sizeof(SnapshotHeader)`) w chwili zapisu.
+     */
+    std::uint32_t headerSize;
+
+    /**
+     * @brief Znacznik porządku bajtów: 0x01020304 zapisane natywnie.
+     */
+    std::uint32_t byteOrder;
+
+    /**
+     * @brief Liczba kolumn wartości (5).
+     */
+    std::uint32_t fieldCount;
+
+    /**
+     * @brief Nazwy kolumn wartości.
+     */
+    char fieldNames[Record::fieldCount][16];
+
+    /**
+     * @brief Sposób zapisu rekordów (`SnapshotEncoding`).
+     */
+    std::uint32_t encoding;
+
+    /**
+     * @brief Największa liczba rekordów w bloku (tylko `SnapshotEncoding::CompressedBlocks`).
+     */
+    std::uint32_t blockRecords;
+
+    /**
+     * @brief Liczba rekordów.
+     */
+    std::uint64_t recordCount;
+
+    /**
+     * @brief Liczba wpisów w tabeli dni.
+     */
+    std::uint64_t dayCount;
+
+    /**
+     * @brief Przesunięcie kolumny znaczników czasu.
+     */
+    std::uint64_t timestampsOffset;
+
+    /**
+     * @brief Przesunięcia kolumn wartości.
+     */
+    std::uint64_t columnOffsets[Record::fieldCount];
+
+    /**
+     * @brief Przesunięcie tabeli dni.
+     */
+    std::uint64_t daysOffset;
+
+    /**
+     * @brief Liczba bloków w katalogu bloków.
+     */
+    std::uint64_t blockCount;
+
+    /**
+     * @brief Przesunięcie katalogu bloków.
+     */
+    std::uint64_t blocksOffset;
+
+    /**
+     * @brief Całkowity rozmiar pliku.
+     */
+    std::uint64_t fileSize;
+
+    /**
+     * @brief Suma kontrolna wszystkich sekcji danych.
+     */
+    std::uint64_t payloadChecksum;
+
+    /**
+     * @brief Suma kontrolna nagłówka (bez tego pola).
+     */
+    std::uint64_t headerChecksum;
+};
+
+/**
+ * @brief Podsumowanie jednego dnia w snapshocie.
+ *
+ * Pozwala odpowiadać na zapytania o przedziały bez przeglądania rekordów dni
+ * w całości zawartych w przedziale.
+ */
+struct SnapshotDay {
+    /**
+     * @brief Numer dnia (dni od 2000-01-01).
+     */
+    std::int32_t day;
+
+    /**
+     * @brief Wyrównanie (0).
+     */
+    std::uint32_t reserved;
+
+    /**
+     * @brief Indeks pierwszego rekordu dnia.
+     */
+    std::uint64_t first;
+
+    /**
+     * @brief Liczba rekordów dnia.
+     */
+    std::uint64_t count;
+
+    /**
+     * @brief Sumy wartości.
+     */
+    double sum[Record::fieldCount];
+
+    /**
+     * @brief Minima wartości.
+     */
+    double min[Record::fieldCount];
+
+    /**
+     * @brief Maksima wartości.
+     */
+    double max[Record::fieldCount];
+};
+
+/**
+ * @brief Wpis katalogu bloków skompresowanego snapshotu.
+ *
+ * Zawiera położenie strumieni bloku oraz podsumowanie jego wartości, dzięki czemu
+ * zapytanie o przedział dekoduje tylko bloki na jego krawędziach.
+ */
+struct SnapshotBlock {
+    /**
+     * @brief Znacznik czasu pierwszego rekordu bloku.
+     */
+    std::int32_t firstTimestamp;
+
+    /**
+     * @brief Znacznik czasu ostatniego rekordu bloku.
+     */
+    std::int32_t lastTimestamp;
+
+    /**
+     * @brief Indeks pierwszego rekordu bloku.
+     */
+    std::uint64_t first;
+
+    /**
+     * @brief Liczba rekordów bloku.
+     */
+    std::uint64_t count;
+
+    /**
+     * @brief Przesunięcia strumieni w pliku: znaczniki czasu, pięć kolumn wartości i koniec bloku.
+     */
+    std::uint64_t offsets[Record::fieldCount + 2];
+
+    /**
+     * @brief Sumy wartości.
+     */
+    double sum[Record::fieldCount];
+
+    /**
+     * @brief Minima wartości.
+     */
+    double min[Record::fieldCount];
+
+    /**
+     * @brief Maksima wartości.
+     */
+    double max[Record::fieldCount];
+};
+
+/**
+ * @brief Snapshot danych pomiarowych odwzorowany w pamięci.
+ *
+ * Plik jest mapowany przez `MappedFile` - otwarcie snapshotu sprawdza tylko nagłówek
+ * (i katalog bloków), bez deserializacji rekordów. Nieskompresowane kolumny są używane
+ * bezpośrednio w zmapowanej pamięci, a skompresowane bloki są dekodowane dopiero wtedy,
+ * gdy zapytanie potrzebuje ich rekordów.
+ *
+ * Pamięć zajmowana przez dane snapshotu jest ograniczona polityką LRU (`SnapshotCache`,
+ * limit `setResidentLimit`): zdekodowane bloki są przechowywane do ponownego użycia,
+ * a dla kolumn zapamiętywane są miesiące, z których zapytania czytały rekordy (granice
+ * miesięcy są wyszukiwane w tabeli dni). Strony najdawniej używanego miesiąca są
+ * zwalniane (`MappedFile::discard`), więc przy zapytaniach o ostatnie dane pamięć procesu
+ * zależy od zbioru roboczego, a nie od rozmiaru archiwum.
+ */
+class Snapshot {
+public:
+    /**
+     * @brief Bieżąca wersja formatu zapisywana przez `write`.
+     */
+    static constexpr std::uint32_t formatVersion = 2;
+
+    /**
+     * @brief Liczba rekordów w bloku przy zapisie `SnapshotEncoding::CompressedBlocks`.
+     */
+    static constexpr std::uint32_t blockRecords = 256;
+
+    /**
+     * @brief Domyślny limit pamięci zdekodowanych bloków lub odczytanych miesięcy kolumn (64 MiB).
+     */
+    static constexpr std::size_t defaultResidentLimit = std::size_t(64) << 20;
+
+    /**
+     * @brief Zapisuje dane do pliku snapshotu.
+     *
+     * Rekordy z `base` (jeśli podany) i z drzewa są łączone, stabilnie sortowane według czasu
+     * i zapisywane w wybranym kodowaniu wraz z podsumowaniami i sumami kontrolnymi.
+     *
+     * @param fileName Nazwa pliku docelowego.
+     * @param tree Drzewo z danymi.
+     * @param base Wcześniej wczytany snapshot, którego dane mają zostać dołączone (lub nullptr).
+     * @param encoding Sposób zapisu rekordów.
+     * @param error Opis błędu, jeśli zapis się nie powiódł.
+     * @return true, jeśli plik został zapisany.
+     */
+    static bool write(const std::string& fileName, const Tree& tree, const Snapshot* base,
+                      SnapshotEncoding encoding, std::string& error);
+
+    /**
+     * @brief Otwiera i mapuje plik snapshotu.
+     *
+     * Sprawdzane są: sygnatura, wersja formatu, porządek bajtów, układ kolumn, rozmiary sekcji
+     * oraz suma kontrolna nagłówka. Suma kontrolna danych jest sprawdzana osobno (`verify`),
+     * ponieważ wymaga odczytu całego pliku.
+     *
+     * @param fileName Nazwa pliku snapshotu.
+     * @param error Opis błędu, jeśli pliku nie da się użyć.
+     * @return true, jeśli snapshot jest gotowy do użycia.
+     */
+    bool open(const std::string& fileName, std::string& error);
+
+    /**
+     * @brief Sprawdza sumę kontrolną wszystkich sekcji danych.
+     *
+     * @param error Opis błędu w przypadku niezgodności.
+     * @return true, jeśli dane są nieuszkodzone.
+     */
+    bool verify(std::string& error) const;
+
+    /**
+     * @brief Ustawia limit pamięci zdekodowanych bloków lub odczytanych miesięcy kolumn.
+     *
+     * Może być wywołana przed `open` i w dowolnym momencie później (nadmiarowe elementy są
+     * od razu zwalniane). Limit 0 wyłącza przechowywanie bloków, a strony kolumn są zwalniane
+     * po każdym zapytaniu. Nie może być wywoływana równolegle z zapytaniami.
+     *
+     * @param bytes Limit w bajtach.
+     */
+    void setResidentLimit(std::size_t bytes);
+
+    /**
+     * @brief Zwraca stan pamięci podręcznej (limit, zajętość, trafienia i chybienia).
+     */
+    SnapshotResidency residency() const;
+
+    /**
+     * @brief Zwraca liczbę rekordów w snapshocie.
+     */
+    std::size_t size() const { return header == nullptr ? 0 : static_cast<std::size_t>(header->recordCount); }
+
+    /**
+     * @brief Zwraca sposób zapisu rekordów.
+     */
+    SnapshotEncoding encoding() const {
+        return header == nullptr ? SnapshotEncoding::Columns : static_cast<SnapshotEncoding>(header->encoding);
+    }
+
+    /**
+     * @brief Zwraca wskaźnik na kolumnę znaczników czasu (rosnąco).
+     *
+     * Dostępne tylko dla `SnapshotEncoding::Columns` (dla skompresowanych bloków nullptr).
+     */
+    const std::int32_t* timestamps() const { return timestampColumn; }
+
+    /**
+     * @brief Zwraca wskaźnik na kolumnę wielkości o podanym indeksie.
+     *
+     * Dostępne tylko dla `SnapshotEncoding::Columns` (dla skompresowanych bloków nullptr).
+     */
+    const double* column(int field) const { return columns[field]; }
+
+    /**
+     * @brief Dopisuje wszystkie rekordy snapshotu (rosnąco według czasu) na koniec kolumn.
+     *
+     * @param timestamps Kolumna znaczników czasu.
+     * @param values Kolumny wartości w kolejności `Record::fieldIndex`.
+     */
+    void copyTo(std::vector<std::int32_t>& timestamps, std::vector<double> (&values)[Record::fieldCount]) const;
+
+    /**
+     * @brief Odtwarza rekord o podanym indeksie.
+     */
+    Record record(std::size_t index) const;
+
+    /**
+     * @brief Wyznacza przedział indeksów `[first, last)` rekordów z zakresu czasu `[from, to]`.
+     */
+    std::pair<std::size_t, std::size_t> range(std::int32_t from, std::int32_t to) const;
+
+    /**
+     * @brief Wyznacza najmniejszy i największy znacznik czasu (bez dekodowania bloków).
+     *
+     * @return false, jeśli snapshot jest pusty.
+     */
+    bool timeSpan(std::int32_t& first, std::int32_t& last) const;
+
+    /**
+     * @brief Oblicza agregat wybranej wielkości w przedziale czasu `[from, to]`.
+     *
+     * Dni (lub bloki) w całości zawarte w przedziale są brane z podsumowań, a rekordy są
+     * przeglądane (dekodowane) tylko na krawędziach przedziału.
+     *
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości.
+     * @return Aggregate Agregat wartości w przedziale.
+     */
+    Aggregate aggregate(std::int32_t from, std::int32_t to, int field) const;
+
+    /**
+     * @brief Oblicza agregaty wszystkich wielkości w przedziale `[from, to]` (wspólne granice przedziału).
+     *
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @return Aggregates Agregaty wszystkich wielkości.
+     */
+    Aggregates aggregate(std::int32_t from, std::int32_t to) const;
+
+    /**
+     * @brief Wyszukuje rekordy z przedziału `[from, to]`, w których `|wartość - value| <= tolerance`.
+     *
+     * Ciągła kolumna wybranej wielkości (lub jej zdekodowany fragment bloku) jest filtrowana
+     * wektorowo (`SearchKernel`), a rekordy są odtwarzane tylko dla pasujących wartości.
+     *
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości.
+     * @param value Szukana wartość.
+     * @param tolerance Tolerancja.
+     * @param matches Lista, na której końcu zostaną dopisane pasujące rekordy (chronologicznie).
+     */
+    void search(std::int32_t from, std::int32_t to, int field, double value, double tolerance,
+                std::vector<Record>& matches) const;
+
+    /**
+     * @brief Dodaje do kopca najlepsze rekordy przedziału `[from, to]` (patrz `Tree::top`).
+     *
+     * Dni (lub bloki) są przeglądane od najlepszego maksimum (minimum) z podsumowań; dzień,
+     * który nie może pobić najgorszego rekordu pełnego kopca, kończy przegląd.
+     *
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param top Kopiec wyników (może już zawierać rekordy innych źródeł).
+     * @param stats Liczniki przejrzanych i pominiętych rekordów (zwiększane).
+     */
+    void top(std::int32_t from, std::int32_t to, TopK& top, ScanStats& stats) const;
+
+    /**
+     * @brief Dopisuje rekordy przedziału `[from, to]` (chronologicznie).
+     *
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param records Lista, na której końcu zostaną dopisane rekordy.
+     */
+    void records(std::int32_t from, std::int32_t to, std::vector<Record>& records) const;
+
+private:
+    /**
+     * @brief Zmapowany plik snapshotu.
+     */
+    std::unique_ptr<MappedFile> file;
+
+    /**
+     * @brief Nagłówek w zmapowanej pamięci.
+     */
+    const SnapshotHeader* header = nullptr;
+
+    /**
+     * @brief Kolumna znaczników czasu w zmapowanej pamięci.
+     */
+    const std::int32_t* timestampColumn = nullptr;
+
+    /**
+     * @brief Kolumny wartości w zmapowanej pamięci.
+     */
+    const double* columns[Record::fieldCount] = {};
+
+    /**
+     * @brief Tabela podsumowań dni w zmapowanej pamięci.
+     */
+    const SnapshotDay* days = nullptr;
+
+    /**
+     * @brief Katalog bloków w zmapowanej pamięci.
+     */
+    const SnapshotBlock* blocks = nullptr;
+
+    /**
+     * @brief Limit pamięci podręcznej (patrz `setResidentLimit`).
+     */
+    std::size_t residentLimit = defaultResidentLimit;
+
+    /**
+     * @brief Pamięć podręczna LRU: zdekodowane bloki lub odczytane miesiące kolumn.
+     */
+    std::unique_ptr<SnapshotCache> cache;
+
+    /**
+     * @brief Sprawdza katalog bloków skompresowanego snapshotu.
+     */
+    bool validateBlocks() const;
+
+    /**
+     * @brief Dekoduje znaczniki czasu bloku.
+     */
+    void decodeTimestamps(const SnapshotBlock& block, std::vector<std::int32_t>& timestamps) const;
+
+    /**
+     * @brief Dekoduje `count` pierwszych wartości wybranej kolumny bloku.
+     */
+    void decodeColumn(const SnapshotBlock& block, int field, std::size_t count, std::vector<double>& values) const;
+
+    /**
+     * @brief Zwraca zdekodowany blok z pamięci podręcznej lub dekoduje go i zapamiętuje.
+     */
+    std::shared_ptr<const DecodedBlock> decoded(const SnapshotBlock& block) const;
+
+    /**
+     * @brief Wyznacza przedział indeksów rekordów miesiąca o kluczu `rok * 12 + miesiąc - 1` (z tabeli dni).
+     */
+    std::pair<std::size_t, std::size_t> monthRange(std::int32_t key) const;
+
+    /**
+     * @brief Oznacza miesiące rekordów `[first, last)` kolumn jako używane i zwalnia strony miesięcy ponad limit.
+     */
+    void touch(std::size_t first, std::size_t last) const;
+
+    /**
+     * @brief Zwalnia strony zmapowanych kolumn usuniętych z pamięci podręcznej miesięcy.
+     */
+    void discardMonths(const std::vector<std::uint64_t>& keys) const;
+
+    /**
+     * @brief Zwraca indeks pierwszego rekordu o czasie nie mniejszym (`after` = false)
+     * lub większym (`after` = true) niż `timestamp`.
+     */
+    std::size_t bound(std::int32_t timestamp, bool after) const;
+
+    /**
+     * @brief Agregaty wielkości `[firstField, lastField)` w przedziale dla nieskompresowanych kolumn (tabela dni).
+     */
+    void columnsAggregate(std::int32_t from, std::int32_t to, int firstField, int lastField, Aggregates& result) const;
+
+    /**
+     * @brief Agregaty wielkości `[firstField, lastField)` w przedziale dla skompresowanych bloków (katalog bloków).
+     */
+    void blocksAggregate(std::int32_t from, std::int32_t to, int firstField, int lastField, Aggregates& result) const;
+};
+
+#endif // SNAPSHOT_H
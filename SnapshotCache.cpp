@@ -0,0 +1,111 @@
+#include "SnapshotCache.h"
+#include "Metrics.h"
+
+/**
+ * @brief Zwalnia elementy i odejmuje ich rozmiar od `MemoryPool::SnapshotCache`.
+ */
+SnapshotCache::~SnapshotCache() {
+    Metrics::addMemory(MemoryPool::SnapshotCache, -static_cast<std::int64_t>(resident));
+}
+
+/**
+ * @brief Oznacza element jako ostatnio używany i zwraca jego blok.
+ *
+ * @param key Klucz elementu.
+ * @param found Informacja, czy element był w pamięci.
+ * @return Zdekodowany blok lub nullptr.
+ */
+std::shared_ptr<const DecodedBlock> SnapshotCache::find(std::uint64_t key, bool& found) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto it = entries.find(key);
+    found = it != entries.end();
+    if (!found) {
+        ++misses;
+        return nullptr;
+    }
+    ++hits;
+    order.splice(order.begin(), order, it->second);
+    return it->second->block;
+}
+
+/**
+ * @brief Dodaje (lub zastępuje) element i usuwa najdawniej używane ponad limit.
+ *
+ * @param key Klucz elementu.
+ * @param bytes Rozmiar elementu w bajtach.
+ * @param block Zdekodowany blok (lub nullptr).
+ * @param evicted Klucze usuniętych elementów.
+ */
+void SnapshotCache::insert(std::uint64_t key, std::size_t bytes, std::shared_ptr<const DecodedBlock> block,
+                           std::vector<std::uint64_t>& evicted) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (limit == 0) {
+        // Nic nie jest zatrzymywane, więc element od razu jest "usunięty"
+        evicted.push_back(key);
+        return;
+    }
+    const auto it = entries.find(key);
+    if (it != entries.end()) {
+        // Ten sam element dodany równolegle przez inny wątek
+        resident -= it->second->bytes;
+        Metrics::addMemory(MemoryPool::SnapshotCache, -static_cast<std::int64_t>(it->second->bytes));
+        order.erase(it->second);
+    }
+    order.push_front(Entry{ key, bytes, std::move(block) });
+    entries[key] = order.begin();
+    resident += bytes;
+    Metrics::addMemory(MemoryPool::SnapshotCache, static_cast<std::int64_t>(bytes));
+    evict(evicted);
+}
+
+/**
+ * @brief Zmienia limit i usuwa najdawniej używane elementy ponad nowy limit.
+ *
+ * @param bytes Nowy limit w bajtach.
+ * @param evicted Klucze usuniętych elementów.
+ */
+void SnapshotCache::setLimit(std::size_t bytes, std::vector<std::uint64_t>& evicted) {
+    std::lock_guard<std::mutex> lock(mutex);
+    limit = bytes;
+    evict(evicted);
+    if (limit == 0 && !order.empty()) {
+        // Przy zerowym limicie nie zostaje także najnowszy element
+        evicted.push_back(order.front().key);
+        resident -= order.front().bytes;
+        Metrics::addMemory(MemoryPool::SnapshotCache, -static_cast<std::int64_t>(order.front().bytes));
+        entries.clear();
+        order.clear();
+    }
+}
+
+/**
+ * @brief Zwraca bieżący stan pamięci podręcznej.
+ */
+SnapshotResidency SnapshotCache::state() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    SnapshotResidency result;
+    result.limit = limit;
+    result.resident = resident;
+    result.entries = entries.size();
+    result.hits = hits;
+    result.misses = misses;
+    return result;
+}
+
+/**
+ * @brief Usuwa najdawniej używane elementy (poza najnowszym), dopóki zajętość przekracza limit.
+ *
+ * @param evicted Klucze usuniętych elementów.
+ */
+void SnapshotCache::evict(std::vector<std::uint64_t>& evicted) {
+    std::int64_t released = 0;
+    while (resident > limit && order.size() > 1) {
+        const Entry& oldest = order.back();
+        evicted.push_back(oldest.key);
+        resident -= oldest.bytes;
+        released += static_cast<std::int64_t>(oldest.bytes);
+        entries.erase(oldest.key);
+        order.pop_back();
+    }
+    if (released > 0) Metrics::addMemory(MemoryPool::SnapshotCache, -released);
+}
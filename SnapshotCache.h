@@ -0,0 +1,168 @@
+#ifndef SNAPSHOTCACHE_H
+#define SNAPSHOTCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Record.h"
+
+/**
+ * @brief Zdekodowany blok skompresowanego snapshotu (wszystkie kolumny).
+ */
+struct DecodedBlock {
+    /**
+     * @brief Znaczniki czasu rekordów bloku (rosnąco).
+     */
+    std::vector<std::int32_t> timestamps;
+
+    /**
+     * @brief Kolumny wartości w kolejności `Record::fieldIndex`.
+     */
+    std::vector<double> values[Record::fieldCount];
+
+    /**
+     * @brief Odtwarza rekord o podanym indeksie w bloku.
+     */
+    Record record(std::size_t i) const {
+        return Record(timestamps[i], values[0][i], values[1][i], values[2][i], values[3][i], values[4][i]);
+    }
+};
+
+/**
+ * @brief Stan pamięci podręcznej snapshotu (patrz `Snapshot::residency`).
+ */
+struct SnapshotResidency {
+    /**
+     * @brief Limit pamięci w bajtach.
+     */
+    std::size_t limit = 0;
+
+    /**
+     * @brief Bajty zajmowane przez zdekodowane bloki lub odczytane miesiące kolumn.
+     */
+    std::size_t resident = 0;
+
+    /**
+     * @brief Liczba elementów (bloków lub miesięcy) w pamięci.
+     */
+    std::size_t entries = 0;
+
+    /**
+     * @brief Liczba odwołań do elementów, które były w pamięci.
+     */
+    std::uint64_t hits = 0;
+
+    /**
+     * @brief Liczba odwołań do elementów, które trzeba było wczytać (zdekodować) z pliku.
+     */
+    std::uint64_t misses = 0;
+};
+
+/**
+ * @brief Pamięć podręczna LRU części snapshotu z limitem rozmiaru w bajtach.
+ *
+ * Elementy są identyfikowane kluczem (numer bloku lub miesiąca) i mają rozmiar w bajtach;
+ * element może przechowywać zdekodowany blok albo tylko oznaczać, że dany fragment
+ * zmapowanego pliku jest w pamięci. Po przekroczeniu limitu usuwane są najdawniej używane
+ * elementy, a ich klucze są zwracane wywołującemu (np. do zwolnienia stron pliku).
+ * Ostatnio dodany element nie jest usuwany, nawet jeśli sam przekracza limit.
+ *
+ * Wszystkie metody są bezpieczne dla wielu wątków. Zwrócony zdekodowany blok pozostaje
+ * ważny po usunięciu go z pamięci podręcznej (wspólna własność).
+ */
+class SnapshotCache {
+public:
+    /**
+     * @brief Tworzy pustą pamięć podręczną.
+     *
+     * @param limit Limit rozmiaru w bajtach (0 - nic nie jest zatrzymywane).
+     */
+    explicit SnapshotCache(std::size_t limit) : limit(limit) {}
+
+    /**
+     * @brief Zwalnia elementy (i ich udział w `MemoryPool::SnapshotCache`).
+     */
+    ~SnapshotCache();
+
+    SnapshotCache(const SnapshotCache&) = delete;
+    SnapshotCache& operator=(const SnapshotCache&) = delete;
+
+    /**
+     * @brief Oznacza element jako ostatnio używany i zwraca jego blok.
+     *
+     * @param key Klucz elementu.
+     * @param found Informacja, czy element był w pamięci.
+     * @return Zdekodowany blok (nullptr, jeśli brak elementu lub element bez bloku).
+     */
+    std::shared_ptr<const DecodedBlock> find(std::uint64_t key, bool& found);
+
+    /**
+     * @brief Dodaje (lub zastępuje) element i usuwa najdawniej używane ponad limit.
+     *
+     * @param key Klucz elementu.
+     * @param bytes Rozmiar elementu w bajtach.
+     * @param block Zdekodowany blok (nullptr dla elementu bez danych).
+     * @param evicted Lista, na której końcu zostaną dopisane klucze usuniętych elementów.
+     */
+    void insert(std::uint64_t key, std::size_t bytes, std::shared_ptr<const DecodedBlock> block,
+                std::vector<std::uint64_t>& evicted);
+
+    /**
+     * @brief Zmienia limit i usuwa najdawniej używane elementy ponad nowy limit.
+     *
+     * @param bytes Nowy limit w bajtach.
+     * @param evicted Lista kluczy usuniętych elementów.
+     */
+    void setLimit(std::size_t bytes, std::vector<std::uint64_t>& evicted);
+
+    /**
+     * @brief Zwraca bieżący stan (limit, zajętość, trafienia i chybienia).
+     */
+    SnapshotResidency state() const;
+
+private:
+    /**
+     * @brief Element pamięci podręcznej.
+     */
+    struct Entry {
+        std::uint64_t key;
+        std::size_t bytes;
+        std::shared_ptr<const DecodedBlock> block;
+    };
+
+    /**
+     * @brief Usuwa najdawniej używane elementy (poza najnowszym), dopóki zajętość przekracza limit.
+     */
+    void evict(std::vector<std::uint64_t>& evicted);
+
+    /**
+     * @brief Synchronizacja dostępu z wielu wątków.
+     */
+    mutable std::mutex mutex;
+
+    /**
+     * @brief Elementy od ostatnio do najdawniej używanego.
+     */
+    std::list<Entry> order;
+
+    /**
+     * @brief Położenie elementów na liście według klucza.
+     */
+    std::unordered_map<std::uint64_t, std::list<Entry>::iterator> entries;
+
+    /**
+     * @brief Limit i bieżąca zajętość w bajtach.
+     */
+    std::size_t limit, resident = 0;
+
+    /**
+     * @brief Liczniki trafień i chybień.
+     */
+    std::uint64_t hits = 0, misses = 0;
+};
+
+#endif // SNAPSHOTCACHE_H
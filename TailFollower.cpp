@@ -0,0 +1,130 @@
+#include "TailFollower.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+/**
+ * @brief Tworzy obiekt śledzący plik; odczyt zacznie się od początku pliku.
+ *
+ * @param fileName Nazwa śledzonego pliku.
+ */
+TailFollower::TailFollower(const std::string& fileName) : name(fileName) {}
+
+/**
+ * @brief Zamyka deskryptor inotify.
+ */
+TailFollower::~TailFollower() {
+#ifdef __linux__
+    if (notifyFd >= 0) close(notifyFd);
+#endif
+}
+
+/**
+ * @brief Czyta pełne linie dopisane od poprzedniego odczytu.
+ *
+ * Zmiana numeru i-węzła (plik zastąpiony nowym) lub rozmiar mniejszy niż zapamiętane
+ * przesunięcie (plik skrócony) powodują odczyt od początku pliku.
+ *
+ * @param lines Bufor wyjściowy z nowymi liniami (pusty, jeśli nic nie dopisano).
+ * @param error Opis błędu.
+ * @return true, jeśli odczyt się powiódł.
+ */
+bool TailFollower::read(std::string& lines, std::string& error) {
+    lines.clear();
+
+#ifndef _WIN32
+    struct stat info;
+    if (stat(name.c_str(), &info) == 0) {
+        const std::uint64_t current = static_cast<std::uint64_t>(info.st_ino);
+        if (current != identity) {
+            if (identity != 0) {
+                consumed = 0;
+                consumedLines = 0;
+            }
+            identity = current;
+            watch();
+        }
+    }
+#endif
+
+    std::ifstream in(name, std::ios::binary);
+    if (!in) {
+        error = "Nie można otworzyć pliku: " + name;
+        return false;
+    }
+    in.seekg(0, std::ios::end);
+    const std::uint64_t size = static_cast<std::uint64_t>(in.tellg());
+    if (size < consumed) {
+        consumed = 0;
+        consumedLines = 0;
+    }
+    if (size == consumed) return true;
+
+    lines.resize(static_cast<std::size_t>(size - consumed));
+    in.seekg(static_cast<std::streamoff>(consumed));
+    if (!in.read(&lines[0], static_cast<std::streamsize>(lines.size()))) {
+        lines.clear();
+        error = "Błąd odczytu pliku: " + name;
+        return false;
+    }
+
+    // Niedokończona ostatnia linia zostaje do następnego odczytu
+    const std::size_t last = lines.rfind('\n');
+    if (last == std::string::npos) {
+        lines.clear();
+        return true;
+    }
+    lines.resize(last + 1);
+    consumed += last + 1;
+    consumedLines += static_cast<std::uint64_t>(std::count(lines.begin(), lines.end(), '\n'));
+    return true;
+}
+
+/**
+ * @brief Czeka na zmianę pliku (inotify) lub upływ czasu (odpytywanie).
+ *
+ * @param timeoutMs Maksymalny czas oczekiwania w milisekundach.
+ * @return true, jeśli plik mógł się zmienić.
+ */
+bool TailFollower::wait(int timeoutMs) {
+#ifdef __linux__
+    if (notifyFd >= 0 && watchId >= 0) {
+        pollfd descriptor = { notifyFd, POLLIN, 0 };
+        if (poll(&descriptor, 1, timeoutMs) <= 0) return false;
+        // Odczyt wszystkich zdarzeń - liczy się tylko to, że plik się zmienił
+        char events[4096];
+        while (::read(notifyFd, events, sizeof(events)) > 0) {
+        }
+        return true;
+    }
+#endif
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+    return true;
+}
+
+/**
+ * @brief Rejestruje (ponownie) obserwację inotify dla bieżącego pliku.
+ *
+ * Wywoływane po wykryciu nowego pliku - obserwacja dotyczy i-węzła, więc po rotacji
+ * musi zostać założona od nowa. Jeśli inotify jest niedostępne, `wait` odpytuje plik.
+ */
+void TailFollower::watch() {
+#ifdef __linux__
+    if (notifyFd < 0) notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (notifyFd < 0) return;
+    if (watchId >= 0) inotify_rm_watch(notifyFd, watchId);
+    watchId = inotify_add_watch(notifyFd, name.c_str(),
+                                IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+#endif
+}
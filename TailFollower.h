@@ -0,0 +1,102 @@
+#ifndef TAILFOLLOWER_H
+#define TAILFOLLOWER_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Śledzenie pliku dopisywanego na bieżąco (jak `tail -f`).
+ *
+ * Obiekt pamięta przesunięcie (w bajtach) końca ostatniej przeczytanej pełnej linii, więc
+ * `read` zwraca tylko linie dopisane od poprzedniego wywołania. Niedokończona ostatnia linia
+ * (bez znaku nowej linii) jest pozostawiana do następnego odczytu.
+ *
+ * Jeśli plik został skrócony lub zastąpiony nowym plikiem (rotacja eksportu), odczyt zaczyna
+ * się od początku - duplikaty odrzuca wtedy odbiorca (`Program::updateFromCSV`).
+ *
+ * `wait` czeka na zmianę pliku: na Linuksie przez inotify (powrót zaraz po dopisaniu danych),
+ * na pozostałych systemach przez odczekanie podanego czasu (odpytywanie).
+ */
+class TailFollower {
+public:
+    /**
+     * @brief Tworzy obiekt śledzący podany plik (plik nie musi jeszcze istnieć).
+     *
+     * @param fileName Nazwa śledzonego pliku.
+     */
+    explicit TailFollower(const std::string& fileName);
+
+    /**
+     * @brief Zamyka uchwyty powiadomień o zmianach pliku.
+     */
+    ~TailFollower();
+
+    TailFollower(const TailFollower&) = delete;
+    TailFollower& operator=(const TailFollower&) = delete;
+
+    /**
+     * @brief Zwraca nazwę śledzonego pliku.
+     */
+    const std::string& fileName() const { return name; }
+
+    /**
+     * @brief Zwraca przesunięcie końca ostatniej przeczytanej pełnej linii.
+     */
+    std::uint64_t offset() const { return consumed; }
+
+    /**
+     * @brief Zwraca liczbę przeczytanych pełnych linii (numer ostatniej z nich w pliku).
+     */
+    std::uint64_t lineCount() const { return consumedLines; }
+
+    /**
+     * @brief Czyta pełne linie dopisane od poprzedniego odczytu.
+     *
+     * @param lines Bufor wyjściowy (zastępowany) - kolejne linie zakończone znakiem nowej linii.
+     * @param error Opis błędu, jeśli pliku nie da się otworzyć lub przeczytać.
+     * @return true, jeśli odczyt się powiódł (również gdy nie było nowych linii).
+     */
+    bool read(std::string& lines, std::string& error);
+
+    /**
+     * @brief Czeka na zmianę pliku lub upływ czasu.
+     *
+     * @param timeoutMs Maksymalny czas oczekiwania w milisekundach.
+     * @return true, jeśli zgłoszono zmianę pliku (przy odpytywaniu zawsze true po upływie czasu).
+     */
+    bool wait(int timeoutMs);
+
+private:
+    /**
+     * @brief Rejestruje powiadomienia inotify dla bieżącego pliku (Linux).
+     */
+    void watch();
+
+    /**
+     * @brief Nazwa śledzonego pliku.
+     */
+    std::string name;
+
+    /**
+     * @brief Przesunięcie końca ostatniej przeczytanej pełnej linii.
+     */
+    std::uint64_t consumed = 0;
+
+    /**
+     * @brief Liczba przeczytanych pełnych linii.
+     */
+    std::uint64_t consumedLines = 0;
+
+    /**
+     * @brief Identyfikator pliku (numer i-węzła), pozwalający wykryć zastąpienie pliku.
+     */
+    std::uint64_t identity = 0;
+
+    /**
+     * @brief Deskryptor inotify i identyfikator obserwacji (-1, jeśli niedostępne).
+     */
+    int notifyFd = -1;
+    int watchId = -1;
+};
+
+#endif // TAILFOLLOWER_H
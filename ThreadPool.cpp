@@ -0,0 +1,83 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+/**
+ * @brief Tworzy pulę i uruchamia `threadCount - 1` wątków (wątek wywołujący jest ostatnim).
+ *
+ * @param threadCount Liczba wątków (0 - liczba dostępnych rdzeni).
+ */
+ThreadPool::ThreadPool(unsigned threadCount) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    workers.reserve(threadCount - 1);
+    for (unsigned i = 1; i < threadCount; ++i) workers.emplace_back(&ThreadPool::run, this);
+}
+
+/**
+ * @brief Budzi wątki z informacją o zamykaniu puli i czeka na ich zakończenie.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+/**
+ * @brief Wykonuje pętlę równolegle w wątkach puli i w wątku wywołującym.
+ *
+ * Pojedyncze iteracje i pula bez dodatkowych wątków są wykonywane bezpośrednio.
+ *
+ * @param count Liczba iteracji.
+ * @param body Ciało pętli.
+ */
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& body) {
+    if (count == 0) return;
+    if (count == 1 || workers.empty()) {
+        for (std::size_t i = 0; i < count; ++i) body(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> serial(job);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->body = &body;
+        this->count = count;
+        next.store(0, std::memory_order_relaxed);
+        pending = workers.size();
+        ++generation;
+    }
+    wakeup.notify_all();
+
+    for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) body(i);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return pending == 0; });
+    this->body = nullptr;
+}
+
+/**
+ * @brief Pętla wątku puli.
+ *
+ * Każdy wątek zgłasza zakończenie każdego zadania (także gdy nie pobrał żadnej iteracji),
+ * więc po powrocie z `parallelFor` żaden wątek nie odwołuje się już do ciała pętli.
+ */
+void ThreadPool::run() {
+    std::uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wakeup.wait(lock, [this, seen] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        const std::function<void(std::size_t)>& task = *body;
+        const std::size_t total = count;
+        lock.unlock();
+
+        for (std::size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < total;) task(i);
+
+        lock.lock();
+        if (--pending == 0) done.notify_one();
+    }
+}
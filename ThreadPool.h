@@ -0,0 +1,116 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Stała pula wątków wykonująca pętle równoległe (`parallelFor`).
+ *
+ * Wątki są tworzone raz, w konstruktorze, i czekają na kolejne zadania, więc krótkie zapytania
+ * (np. agregat jednego miesiąca dla każdej instalacji floty) nie płacą kosztu uruchamiania
+ * wątków. Indeksy pętli są pobierane z atomowego licznika po jednym, dzięki czemu nierówne
+ * koszty iteracji rozkładają się między wątki; wątek wywołujący również wykonuje iteracje.
+ *
+ * Pętle zlecane równocześnie z kilku wątków są wykonywane kolejno. Ciało pętli nie może
+ * zlecać zagnieżdżonej pętli tej samej puli ani zgłaszać wyjątków.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Tworzy pulę.
+     *
+     * @param threadCount Liczba wątków razem z wątkiem wywołującym (0 - liczba dostępnych rdzeni).
+     */
+    explicit ThreadPool(unsigned threadCount = 0);
+
+    /**
+     * @brief Kończy i dołącza wątki puli.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Zwraca liczbę wątków wykonujących pętle (razem z wątkiem wywołującym).
+     */
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    /**
+     * @brief Wywołuje `body(i)` dla każdego `i` z `[0, count)` i czeka na zakończenie wszystkich wywołań.
+     *
+     * @param count Liczba iteracji.
+     * @param body Ciało pętli (wywoływane równolegle z różnymi indeksami).
+     */
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)>& body);
+
+private:
+    /**
+     * @brief Pętla wątku puli: czeka na zadanie i wykonuje jego iteracje.
+     */
+    void run();
+
+    /**
+     * @brief Wątki puli.
+     */
+    std::vector<std::thread> workers;
+
+    /**
+     * @brief Muteks szeregujący pętle zlecane z różnych wątków.
+     */
+    std::mutex job;
+
+    /**
+     * @brief Muteks chroniący stan bieżącego zadania.
+     */
+    std::mutex mutex;
+
+    /**
+     * @brief Budzi wątki puli po zleceniu zadania lub przy zamykaniu puli.
+     */
+    std::condition_variable wakeup;
+
+    /**
+     * @brief Sygnalizuje zakończenie zadania przez wszystkie wątki puli.
+     */
+    std::condition_variable done;
+
+    /**
+     * @brief Ciało bieżącej pętli.
+     */
+    const std::function<void(std::size_t)>* body = nullptr;
+
+    /**
+     * @brief Liczba iteracji bieżącej pętli.
+     */
+    std::size_t count = 0;
+
+    /**
+     * @brief Następny niepobrany indeks bieżącej pętli.
+     */
+    std::atomic<std::size_t> next{ 0 };
+
+    /**
+     * @brief Liczba wątków puli, które nie zakończyły jeszcze bieżącego zadania.
+     */
+    std::size_t pending = 0;
+
+    /**
+     * @brief Numer bieżącego zadania (wątek rozpoznaje po nim nowe zadanie).
+     */
+    std::uint64_t generation = 0;
+
+    /**
+     * @brief Informacja, że pula jest zamykana.
+     */
+    bool stopping = false;
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,222 @@
+#ifndef TIMESTAMP_H
+#define TIMESTAMP_H
+
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Zwarta reprezentacja znacznika czasu pomiaru.
+ *
+ * Znacznik czasu jest przechowywany jako liczba minut od 2000-01-01 00:00 (32-bitowa liczba
+ * całkowita). Dzięki temu porównanie dwóch chwil to porównanie dwóch liczb, a kolumna
+ * znaczników zajmuje 4 bajty na rekord zamiast dwóch obiektów `std::string`.
+ *
+ * Klasa zawiera wyłącznie funkcje statyczne do konwersji między tą reprezentacją
+ * a datą (rok, miesiąc, dzień) i godziną (godzina, minuta).
+ */
+class Timestamp {
+public:
+    /**
+     * @brief Liczba minut w ciągu doby.
+     */
+    static constexpr std::int32_t minutesPerDay = 24 * 60;
+
+    /**
+     * @brief Zamienia datę kalendarzową na liczbę dni od 2000-01-01.
+     *
+     * Algorytm "days from civil" (H. Hinnant) - poprawny dla kalendarza gregoriańskiego
+     * bez tablic i pętli.
+     *
+     * @param year Rok (np. 2021).
+     * @param month Miesiąc (1-12).
+     * @param day Dzień miesiąca (1-31).
+     * @return std::int32_t Liczba dni od 2000-01-01 (może być ujemna).
+     */
+    static constexpr std::int32_t daysFromCivil(int year, int month, int day) {
+        year -= month <= 2;
+        const int era = (year >= 0 ? year : year - 399) / 400;
+        const int yearOfEra = year - era * 400;
+        const int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+        const int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+        return era * 146097 + dayOfEra - 730425; // 730425 = dni od 0000-03-01 do 2000-01-01
+    }
+
+    /**
+     * @brief Zamienia liczbę dni od 2000-01-01 na datę kalendarzową.
+     *
+     * @param days Liczba dni od 2000-01-01.
+     * @param year Wyjściowy rok.
+     * @param month Wyjściowy miesiąc (1-12).
+     * @param day Wyjściowy dzień (1-31).
+     */
+    static constexpr void civilFromDays(std::int32_t days, int& year, int& month, int& day) {
+        days += 730425;
+        const int era = (days >= 0 ? days : days - 146096) / 146097;
+        const int dayOfEra = days - era * 146097;
+        const int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+        const int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+        const int monthIndex = (5 * dayOfYear + 2) / 153;
+        day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+        month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+        year = yearOfEra + era * 400 + (month <= 2);
+    }
+
+    /**
+     * @brief Zwraca liczbę dni miesiąca (z uwzględnieniem lat przestępnych).
+     *
+     * @param year Rok.
+     * @param month Miesiąc (1-12).
+     */
+    static constexpr int daysInMonth(int year, int month) {
+        if (month == 2) return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0 ? 29 : 28;
+        return month == 4 || month == 6 || month == 9 || month == 11 ? 30 : 31;
+    }
+
+    /**
+     * @brief Sprawdza, czy data i godzina istnieją w kalendarzu i mieszczą się w zakresie znaczników czasu.
+     *
+     * Znacznik czasu (minuty od 2000-01-01 w `std::int32_t`) sięga ok. roku 6083, dlatego
+     * późniejsze lata są odrzucane.
+     *
+     * @return true, jeśli `fromDateTime` zwróci znacznik odpowiadający dokładnie tej dacie i godzinie.
+     */
+    static constexpr bool isValid(int year, int month, int day, int hour, int minute) {
+        return year >= 0 && year <= 6000 && month >= 1 && month <= 12 && day >= 1 &&
+               day <= daysInMonth(year, month) && hour >= 0 && hour <= 23 && minute >= 0 && minute <= 59;
+    }
+
+    /**
+     * @brief Tworzy znacznik czasu z daty i godziny.
+     *
+     * @param year Rok.
+     * @param month Miesiąc (1-12).
+     * @param day Dzień miesiąca (1-31).
+     * @param hour Godzina (0-23).
+     * @param minute Minuta (0-59).
+     * @return std::int32_t Liczba minut od 2000-01-01 00:00.
+     */
+    static constexpr std::int32_t fromDateTime(int year, int month, int day, int hour, int minute) {
+        return daysFromCivil(year, month, day) * minutesPerDay + hour * 60 + minute;
+    }
+
+    /**
+     * @brief Rozkłada znacznik czasu na datę i godzinę.
+     *
+     * @param timestamp Liczba minut od 2000-01-01 00:00.
+     * @param year Wyjściowy rok.
+     * @param month Wyjściowy miesiąc (1-12).
+     * @param day Wyjściowy dzień (1-31).
+     * @param hour Wyjściowa godzina (0-23).
+     * @param minute Wyjściowa minuta (0-59).
+     */
+    static constexpr void toDateTime(std::int32_t timestamp, int& year, int& month, int& day,
+                                     int& hour, int& minute) {
+        std::int32_t days = timestamp / minutesPerDay;
+        std::int32_t minuteOfDay = timestamp % minutesPerDay;
+        if (minuteOfDay < 0) {
+            minuteOfDay += minutesPerDay;
+            --days;
+        }
+        civilFromDays(days, year, month, day);
+        hour = minuteOfDay / 60;
+        minute = minuteOfDay % 60;
+    }
+
+    /**
+     * @brief Parsuje datę `YYYY-MM-DD` i godzinę `HH:MM` do znacznika czasu.
+     *
+     * Parser czyta cyfry bezpośrednio (bez `sscanf`); godzina może być jedno- lub dwucyfrowa.
+     * Dzień jest sprawdzany z rzeczywistą długością miesiąca (`isValid`), więc np. 2023-02-31
+     * jest odrzucane, a nie przenoszone na początek marca.
+     *
+     * @param date Data w formacie YYYY-MM-DD.
+     * @param time Godzina w formacie HH:MM lub H:MM.
+     * @param timestamp Wyjściowy znacznik czasu.
+     * @return true, jeśli oba napisy mają poprawny format i opisują istniejącą datę, false w przeciwnym razie.
+     */
+    static bool parse(const std::string& date, const std::string& time, std::int32_t& timestamp) {
+        const char* p = date.data();
+        const char* end = p + date.size();
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+        if (!readNumber(p, end, 4, 4, year) || p == end || *p++ != '-') return false;
+        if (!readNumber(p, end, 1, 2, month) || p == end || *p++ != '-') return false;
+        if (!readNumber(p, end, 1, 2, day) || p != end) return false;
+
+        p = time.data();
+        end = p + time.size();
+        if (!readNumber(p, end, 1, 2, hour) || p == end || *p++ != ':') return false;
+        if (!readNumber(p, end, 2, 2, minute) || p != end) return false;
+
+        if (!isValid(year, month, day, hour, minute)) return false;
+        timestamp = fromDateTime(year, month, day, hour, minute);
+        return true;
+    }
+
+    /**
+     * @brief Czyta liczbę złożoną z `minDigits`-`maxDigits` cyfr i przesuwa wskaźnik.
+     *
+     * @param p Wskaźnik na bieżący znak (przesuwany za ostatnią cyfrę).
+     * @param end Koniec bufora.
+     * @param minDigits Minimalna liczba cyfr.
+     * @param maxDigits Maksymalna liczba cyfr.
+     * @param value Wyjściowa wartość.
+     * @return true, jeśli wczytano co najmniej `minDigits` cyfr.
+     */
+    static bool readNumber(const char*& p, const char* end, int minDigits, int maxDigits, int& value) {
+        int digits = 0;
+        value = 0;
+        while (p < end && digits < maxDigits && *p >= '0' && *p <= '9') {
+            value = value * 10 + (*p - '0');
+            ++p;
+            ++digits;
+        }
+        return digits >= minDigits;
+    }
+
+    /**
+     * @brief Formatuje datę znacznika czasu jako `YYYY-MM-DD`.
+     *
+     * @param timestamp Liczba minut od 2000-01-01 00:00.
+     * @return std::string Data w formacie YYYY-MM-DD.
+     */
+    static std::string formatDate(std::int32_t timestamp) {
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+        toDateTime(timestamp, year, month, day, hour, minute);
+        char buffer[10] = { 0, 0, 0, 0, '-', 0, 0, '-', 0, 0 };
+        writeDigits(buffer, year, 4);
+        writeDigits(buffer + 5, month, 2);
+        writeDigits(buffer + 8, day, 2);
+        return std::string(buffer, sizeof(buffer));
+    }
+
+    /**
+     * @brief Formatuje godzinę znacznika czasu jako `HH:MM`.
+     *
+     * @param timestamp Liczba minut od 2000-01-01 00:00.
+     * @return std::string Godzina w formacie HH:MM.
+     */
+    static std::string formatTime(std::int32_t timestamp) {
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+        toDateTime(timestamp, year, month, day, hour, minute);
+        char buffer[5] = { 0, 0, ':', 0, 0 };
+        writeDigits(buffer, hour, 2);
+        writeDigits(buffer + 3, minute, 2);
+        return std::string(buffer, sizeof(buffer));
+    }
+
+    /**
+     * @brief Zapisuje liczbę jako `width` cyfr z wiodącymi zerami.
+     *
+     * @param out Bufor wyjściowy (co najmniej `width` znaków).
+     * @param value Liczba nieujemna do zapisania.
+     * @param width Liczba cyfr.
+     */
+    static void writeDigits(char* out, int value, int width) {
+        for (int i = width - 1; i >= 0; --i) {
+            out[i] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        }
+    }
+};
+
+#endif // TIMESTAMP_H
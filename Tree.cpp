@@ -1,13 +1,89 @@
+#include "Tree.h"
+#include "Anomaly.h"
+#include "SearchKernel.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <numeric>
+#include <utility>
+
+/**
+ * @brief Tworzy puste drzewo z własną areną.
+ */
+Tree::Tree() : Tree(std::make_shared<Arena>()) {}
+
+/**
+ * @brief Tworzy puste drzewo alokujące węzły i kolumny z podanego zasobu.
+ * 
+ * @param memory Zasób pamięci.
+ */
+Tree::Tree(std::shared_ptr<std::pmr::memory_resource> memory)
+    : memory(std::move(memory)), years(allocator_type(this->memory.get())) {}
+
+/**
+ * @brief Kopiuje drzewo do nowej areny.
+ * 
+ * @param other Drzewo źródłowe.
+ */
+Tree::Tree(const Tree& other)
+    : memory(std::make_shared<Arena>()), years(other.years, allocator_type(memory.get())), stats(other.stats) {}
+
+/**
+ * @brief Przenosi drzewo; arena jest współdzielona, więc przeniesione węzły pozostają ważne,
+ * a drzewo źródłowe (puste) nadal może być używane.
+ * 
+ * @param other Drzewo źródłowe.
+ */
+Tree::Tree(Tree&& other) noexcept
+    : memory(other.memory), years(std::move(other.years)), stats(other.stats) {
+    other.years.clear();
+    other.stats = Aggregates();
+}
+
+/**
+ * @brief Kopiuje dane drzewa `other` do areny bieżącego drzewa.
+ * 
+ * @param other Drzewo źródłowe.
+ * @return Tree& Bieżące drzewo.
+ */
+Tree& Tree::operator=(const Tree& other) {
+    if (this != &other) {
+        years = other.years;
+        stats = other.stats;
+    }
+    return *this;
+}
+
+/**
+ * @brief Przenosi dane drzewa `other` (bez kopiowania przy wspólnej arenie).
+ * 
+ * Alokator mapy `std::pmr` nie zmienia się przy przypisaniu, więc przy różnych arenach
+ * węzły są przenoszone pojedynczo, a kolumny kopiowane do areny bieżącego drzewa.
+ * 
+ * @param other Drzewo źródłowe (po operacji puste).
+ * @return Tree& Bieżące drzewo.
+ */
+Tree& Tree::operator=(Tree&& other) {
+    if (this != &other) {
+        years = std::move(other.years);
+        stats = other.stats;
+        other.years.clear();
+        other.stats = Aggregates();
+    }
+    return *this;
+}
+
 /**
  * @brief Dodaje rekord do odpowiedniego miejsca w strukturze drzewa.
  * 
- * Funkcja przetwarza datę i godzinę rekordu, aby umieścić go w odpowiednim roku, miesiącu, dniu 
- * i ćwiartce dnia w strukturze drzewa. Struktura ta jest hierarchiczna: lata -> miesiące -> dni -> ćwiartki dnia.
+ * Funkcja rozkłada znacznik czasu rekordu (bez parsowania napisów), aby umieścić go w odpowiednim
+ * roku, miesiącu, dniu i ćwiartce dnia w strukturze drzewa. Struktura ta jest hierarchiczna: lata -> miesiące -> dni -> ćwiartki dnia.
+ * W ćwiartce zapisywany jest znacznik czasu (minuty od 2000-01-01) oraz wartości pomiarowe w osobnych kolumnach.
  * 
  * @param record Obiekt klasy `Record`, który zawiera dane do dodania.
  * 
  * Przykład działania:
- * - Jeśli rekord zawiera datę `2025-01-27` i godzinę `13:45`,
+ * - Jeśli znacznik czasu rekordu odpowiada dacie `2025-01-27` i godzinie `13:45`,
  *   to zostanie umieszczony w:
  *   - roku: `2025`,
  *   - miesiącu: `1` (styczeń),
@@ -15,16 +91,330 @@
  *   - ćwiartce dnia: `2` (popołudnie: godziny 12:00-18:00).
  */
 void Tree::addRecord(const Record& record) {
-    int year, month, day;
-
-    // Parsowanie daty w formacie YYYY-MM-DD na rok, miesiąc i dzień
-    sscanf(record.date.c_str(), "%d-%d-%d", &year, &month, &day);
+    // Rozkład znacznika czasu na rok, miesiąc, dzień i godzinę (bez parsowania napisów)
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    Timestamp::toDateTime(record.timestamp, year, month, day, hour, minute);
 
     // Wyznaczenie ćwiartki dnia na podstawie czasu
-    int quarter = getQuarter(record.time);
+    const int quarter = getQuarter(record.timestamp);
 
     // Dodanie rekordu do odpowiedniej ćwiartki w strukturze drzewa
-    years[year].months[month].days[day].quarters[quarter].records.push_back(record);
+    Year& yearNode = years[year];
+    Month& monthNode = yearNode.months[month];
+    Day& dayNode = monthNode.days[day];
+    dayNode.quarters[quarter].push_back(record.timestamp, record);
+
+    // Aktualizacja agregatów na ścieżce od ćwiartki do korzenia
+    dayNode.stats.add(record);
+    monthNode.stats.add(record);
+    yearNode.stats.add(record);
+    stats.add(record);
+}
+
+/**
+ * @brief Tworzy pustą ćwiartkę z kolumnami w podanej arenie.
+ * 
+ * @param allocator Alokator kolumn.
+ */
+Tree::Quarter::Quarter(const allocator_type& allocator)
+    : timestamps(allocator), autokonsumpcja(allocator), eksport(allocator), import_(allocator),
+      pobor(allocator), produkcja(allocator) {}
+
+/**
+ * @brief Kopiuje ćwiartkę do podanej areny.
+ * 
+ * @param other Ćwiartka źródłowa.
+ * @param allocator Alokator kolumn.
+ */
+Tree::Quarter::Quarter(const Quarter& other, const allocator_type& allocator)
+    : timestamps(other.timestamps, allocator), autokonsumpcja(other.autokonsumpcja, allocator),
+      eksport(other.eksport, allocator), import_(other.import_, allocator), pobor(other.pobor, allocator),
+      produkcja(other.produkcja, allocator), stats(other.stats) {}
+
+/**
+ * @brief Przenosi ćwiartkę do podanej areny (bez kopiowania kolumn, jeśli arena jest ta sama).
+ * 
+ * @param other Ćwiartka źródłowa.
+ * @param allocator Alokator kolumn.
+ */
+Tree::Quarter::Quarter(Quarter&& other, const allocator_type& allocator)
+    : timestamps(std::move(other.timestamps), allocator), autokonsumpcja(std::move(other.autokonsumpcja), allocator),
+      eksport(std::move(other.eksport), allocator), import_(std::move(other.import_), allocator),
+      pobor(std::move(other.pobor), allocator), produkcja(std::move(other.produkcja), allocator),
+      stats(other.stats) {}
+
+/**
+ * @brief Dopisuje rekord na końcu kolumn ćwiartki.
+ * 
+ * @param timestamp Znacznik czasu rekordu (minuty od 2000-01-01 00:00).
+ * @param record Rekord z wartościami pomiarowymi.
+ */
+void Tree::Quarter::push_back(std::int32_t timestamp, const Record& record) {
+    // Ćwiartka zwykle ma 24 pomiary (6 godzin co 15 minut) - rezerwacja od razu
+    // zapobiega realokacjom i nadmiarowej pojemności kolumn
+    if (timestamps.capacity() == 0) {
+        const std::size_t expected = 24;
+        timestamps.reserve(expected);
+        autokonsumpcja.reserve(expected);
+        eksport.reserve(expected);
+        import_.reserve(expected);
+        pobor.reserve(expected);
+        produkcja.reserve(expected);
+    }
+    timestamps.push_back(timestamp);
+    autokonsumpcja.push_back(record.autokonsumpcja);
+    eksport.push_back(record.eksport);
+    import_.push_back(record.import_);
+    pobor.push_back(record.pobor);
+    produkcja.push_back(record.produkcja);
+    stats.add(record);
+}
+
+/**
+ * @brief Dopisuje kolumny innej ćwiartki na końcu kolumn bieżącej ćwiartki.
+ * 
+ * Jeśli bieżąca ćwiartka jest pusta, kolumny są przenoszone bez kopiowania.
+ * 
+ * @param other Ćwiartka źródłowa (po operacji może być pusta).
+ */
+void Tree::Quarter::append(Quarter&& other) {
+    if (empty()) {
+        *this = std::move(other);
+        return;
+    }
+    timestamps.insert(timestamps.end(), other.timestamps.begin(), other.timestamps.end());
+    autokonsumpcja.insert(autokonsumpcja.end(), other.autokonsumpcja.begin(), other.autokonsumpcja.end());
+    eksport.insert(eksport.end(), other.eksport.begin(), other.eksport.end());
+    import_.insert(import_.end(), other.import_.begin(), other.import_.end());
+    pobor.insert(pobor.end(), other.pobor.begin(), other.pobor.end());
+    produkcja.insert(produkcja.end(), other.produkcja.begin(), other.produkcja.end());
+    stats.merge(other.stats);
+}
+
+/**
+ * @brief Odtwarza rekord o podanym indeksie z kolumn ćwiartki.
+ * 
+ * Rekord ma ten sam znacznik czasu i wartości, co rekord przekazany wcześniej do `Tree::addRecord`.
+ * 
+ * @param index Indeks rekordu.
+ * @return Record Odtworzony rekord.
+ */
+Record Tree::Quarter::record(std::size_t index) const {
+    return Record(timestamps[index], autokonsumpcja[index], eksport[index], import_[index], pobor[index],
+                  produkcja[index]);
+}
+
+/**
+ * @brief Zwraca kolumnę wielkości pomiarowej o podanym indeksie.
+ * 
+ * @param field Indeks wielkości (0 - autokonsumpcja, 1 - eksport, 2 - import, 3 - pobór, 4 - produkcja).
+ * @return const std::pmr::vector<double>& Kolumna wartości.
+ */
+const std::pmr::vector<double>& Tree::Quarter::column(int field) const {
+    switch (field) {
+        case 0: return autokonsumpcja;
+        case 1: return eksport;
+        case 2: return import_;
+        case 3: return pobor;
+        default: return produkcja;
+    }
+}
+
+/**
+ * @brief Scala drzewo `other` z bieżącym drzewem.
+ * 
+ * Funkcja schodzi rekurencyjnie po poziomach rok -> miesiąc -> dzień -> ćwiartka.
+ * Jeśli dany węzeł nie istnieje w bieżącym drzewie, jest przenoszony w całości.
+ * W przeciwnym razie scalanie jest kontynuowane poziom niżej, a rekordy ćwiartek
+ * są dopisywane na końcu istniejących kolumn.
+ * 
+ * @param other Drzewo do scalenia; po zakończeniu jest puste.
+ */
+void Tree::merge(Tree&& other) {
+    stats.merge(other.stats);
+    for (auto& [yearKey, otherYear] : other.years) {
+        auto yearIt = years.find(yearKey);
+        if (yearIt == years.end()) {
+            years.emplace(yearKey, std::move(otherYear));
+            continue;
+        }
+        yearIt->second.stats.merge(otherYear.stats);
+        for (auto& [monthKey, otherMonth] : otherYear.months) {
+            auto monthIt = yearIt->second.months.find(monthKey);
+            if (monthIt == yearIt->second.months.end()) {
+                yearIt->second.months.emplace(monthKey, std::move(otherMonth));
+                continue;
+            }
+            monthIt->second.stats.merge(otherMonth.stats);
+            for (auto& [dayKey, otherDay] : otherMonth.days) {
+                auto dayIt = monthIt->second.days.find(dayKey);
+                if (dayIt == monthIt->second.days.end()) {
+                    monthIt->second.days.emplace(dayKey, std::move(otherDay));
+                    continue;
+                }
+                dayIt->second.stats.merge(otherDay.stats);
+                for (auto& [quarterKey, otherQuarter] : otherDay.quarters) {
+                    dayIt->second.quarters[quarterKey].append(std::move(otherQuarter));
+                }
+            }
+        }
+    }
+    other.years.clear();
+    other.stats = Aggregates();
+}
+
+namespace {
+
+/**
+ * @brief Liczba ćwiartek, o którą wyszukiwanie (`Tree::search`) wyprzedza wczesnym pobraniem kolumn.
+ */
+constexpr std::size_t searchPrefetch = 8;
+
+/**
+ * @brief Zleca wczesne pobranie kolumny ćwiartki do pamięci podręcznej (GCC/Clang; w pozostałych nic).
+ */
+void prefetchColumn(const double* values, std::size_t count) {
+#if defined(__GNUC__) || defined(__clang__)
+    const char* const data = reinterpret_cast<const char*>(values);
+    for (std::size_t offset = 0; offset < count * sizeof(double); offset += 64) __builtin_prefetch(data + offset);
+#else
+    (void)values;
+    (void)count;
+#endif
+}
+
+/**
+ * @brief Kernel agregacji jednej wielkości `Field` (stała czasu kompilacji): kolumna i agregat
+ * węzła są wybierane bez indeksu w czasie wykonania.
+ */
+template <int Field>
+struct FieldKernel {
+    Aggregate result;
+
+    void node(const Aggregates& stats) { result.merge(stats.fields[Field]); }
+
+    void records(const Tree::Quarter& quarter, std::int32_t from, std::int32_t end) {
+        const double* values = quarter.column<Field>().data();
+        for (std::size_t i = 0; i < quarter.size(); ++i) {
+            if (quarter.timestamps[i] >= from && quarter.timestamps[i] < end) result.add(values[i]);
+        }
+    }
+};
+
+/**
+ * @brief Kernel agregacji wszystkich wielkości w jednym przeglądzie drzewa.
+ */
+struct AllFieldsKernel {
+    Aggregates result;
+
+    void node(const Aggregates& stats) { result.merge(stats); }
+
+    void records(const Tree::Quarter& quarter, std::int32_t from, std::int32_t end) {
+        const double* const columns[Record::fieldCount] = { quarter.autokonsumpcja.data(), quarter.eksport.data(),
+                                                            quarter.import_.data(), quarter.pobor.data(),
+                                                            quarter.produkcja.data() };
+        for (std::size_t i = 0; i < quarter.size(); ++i) {
+            if (quarter.timestamps[i] < from || quarter.timestamps[i] >= end) continue;
+            for (int f = 0; f < Record::fieldCount; ++f) result.fields[f].add(columns[f][i]);
+        }
+    }
+};
+
+/**
+ * @brief Przegląda węzły drzewa pokrywające przedział `[from, end)`.
+ *
+ * Węzły w całości zawarte w przedziale trafiają do `kernel.node` (zapamiętane agregaty),
+ * a ćwiartki na krawędziach przedziału - do `kernel.records`. Szablon jest konkretyzowany
+ * osobno dla każdego kernela (i każdej wielkości `FieldKernel`), więc wybór wielkości odbywa
+ * się w czasie kompilacji.
+ */
+template <typename Kernel>
+void visitRange(const Tree& tree, std::int32_t from, std::int32_t end, Kernel& kernel) {
+    int fromYear = 0, month = 0, day = 0, hour = 0, minute = 0, toYear = 0;
+    Timestamp::toDateTime(from, fromYear, month, day, hour, minute);
+    Timestamp::toDateTime(end - 1, toYear, month, day, hour, minute);
+
+    for (auto yearIt = tree.years.lower_bound(fromYear); yearIt != tree.years.end() && yearIt->first <= toYear; ++yearIt) {
+        const int y = yearIt->first;
+        const Tree::Year& yearNode = yearIt->second;
+        if (from <= Timestamp::fromDateTime(y, 1, 1, 0, 0) && Timestamp::fromDateTime(y + 1, 1, 1, 0, 0) <= end) {
+            kernel.node(yearNode.stats);
+            continue;
+        }
+        for (const auto& [m, monthNode] : yearNode.months) {
+            const std::int32_t monthStart = Timestamp::fromDateTime(y, m, 1, 0, 0);
+            const std::int32_t monthEnd = m == 12 ? Timestamp::fromDateTime(y + 1, 1, 1, 0, 0)
+                                                  : Timestamp::fromDateTime(y, m + 1, 1, 0, 0);
+            if (monthEnd <= from || end <= monthStart) continue;
+            if (from <= monthStart && monthEnd <= end) {
+                kernel.node(monthNode.stats);
+                continue;
+            }
+            for (const auto& [d, dayNode] : monthNode.days) {
+                const std::int32_t dayStart = Timestamp::fromDateTime(y, m, d, 0, 0);
+                const std::int32_t dayEnd = dayStart + Timestamp::minutesPerDay;
+                if (dayEnd <= from || end <= dayStart) continue;
+                if (from <= dayStart && dayEnd <= end) {
+                    kernel.node(dayNode.stats);
+                    continue;
+                }
+                for (const auto& [q, quarterNode] : dayNode.quarters) {
+                    const std::int32_t quarterStart = dayStart + q * 6 * 60;
+                    const std::int32_t quarterEnd = quarterStart + 6 * 60;
+                    if (quarterEnd <= from || end <= quarterStart) continue;
+                    if (from <= quarterStart && quarterEnd <= end) {
+                        kernel.node(quarterNode.stats);
+                        continue;
+                    }
+                    // Ćwiartka na krawędzi przedziału - przegląd pojedynczych rekordów
+                    kernel.records(quarterNode, from, end);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+/**
+ * @brief Oblicza agregat wybranej wielkości w przedziale czasu `[from, to]`.
+ * 
+ * Dla każdego poziomu drzewa wyznaczany jest przedział czasu węzła `[start, end)`:
+ * - węzeł rozłączny z zapytaniem jest pomijany,
+ * - węzeł w całości zawarty w zapytaniu wnosi swój zapamiętany agregat,
+ * - węzeł częściowo pokryty (co najwyżej dwa na poziom) jest rozwijany poziom niżej.
+ * Na poziomie ćwiartek częściowo pokrytych przeglądane są pojedyncze rekordy.
+ * 
+ * Przykład: suma eksportu za październik 2021 to odczyt jednego agregatu miesiąca,
+ * bez przeglądania ok. 3000 rekordów.
+ * 
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości pomiarowej.
+ * @return Aggregate Agregat wartości w przedziale (pusty, jeśli brak rekordów).
+ */
+Aggregate Tree::aggregate(std::int32_t from, std::int32_t to, int field) const {
+    if (to < from || field < 0 || field >= Record::fieldCount) return Aggregate();
+    return Record::withField(field, [&](auto f) {
+        FieldKernel<decltype(f)::value> kernel;
+        // Zapytanie w postaci półotwartej [from, end)
+        visitRange(*this, from, to + 1, kernel);
+        return kernel.result;
+    });
+}
+
+/**
+ * @brief Oblicza agregaty wszystkich wielkości w przedziale czasu `[from, to]` jednym przeglądem drzewa.
+ * 
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @return Aggregates Agregaty wszystkich wielkości.
+ */
+Aggregates Tree::aggregate(std::int32_t from, std::int32_t to) const {
+    AllFieldsKernel kernel;
+    if (to < from) return kernel.result;
+    visitRange(*this, from, to + 1, kernel);
+    return kernel.result;
 }
 
 /**
@@ -36,7 +426,7 @@ void Tree::addRecord(const Record& record) {
  * - Ćwiartka 2: godziny od 12:00 do 17:59,
  * - Ćwiartka 3: godziny od 18:00 do 23:59.
  * 
- * @param time Czas w formacie HH:MM.
+ * @param timestamp Znacznik czasu (minuty od 2000-01-01 00:00).
  * @return Numer ćwiartki dnia:
  * - 0: noc,
  * - 1: poranek,
@@ -47,15 +437,352 @@ void Tree::addRecord(const Record& record) {
  * - Dla czasu `05:45` funkcja zwraca `0`.
  * - Dla czasu `13:30` funkcja zwraca `2`.
  */
-int Tree::getQuarter(const std::string& time) {
-    int hour, minute;
+int Tree::getQuarter(std::int32_t timestamp) {
+    // Minuta doby (także dla znaczników sprzed 2000 roku)
+    std::int32_t minuteOfDay = timestamp % Timestamp::minutesPerDay;
+    if (minuteOfDay < 0) minuteOfDay += Timestamp::minutesPerDay;
+
+    // Noc: 00:00 - 05:59, poranek: 06:00 - 11:59, popołudnie: 12:00 - 17:59, wieczór: 18:00 - 23:59
+    return minuteOfDay / (6 * 60);
+}
 
-    // Parsowanie czasu w formacie HH:MM na godziny i minuty
-    sscanf(time.c_str(), "%d:%d", &hour, &minute);
+/**
+ * @brief Wyszukuje rekordy z przedziału `[from, to]` o wartości `value ± tolerance`.
+ * 
+ * Przeglądane są tylko lata, miesiące, dni i ćwiartki przecinające przedział. Ćwiartki miesiąca
+ * są najpierw zbierane, a potem filtrowane (`SearchKernel`) z wczesnym pobraniem kolumn
+ * `searchPrefetch` ćwiartek naprzód - bez tego czas zajmuje oczekiwanie na pamięć, nie filtr.
+ * W ćwiartkach na krawędziach przedziału pasujące rekordy są dodatkowo sprawdzane pod kątem czasu.
+ * Dopasowania ćwiartki z rekordami poza kolejnością (dopisanymi przez `merge` lub `addRecord`)
+ * są sortowane według znacznika czasu, jak w `records`.
+ * 
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @param value Szukana wartość.
+ * @param tolerance Tolerancja.
+ * @param matches Lista wyjściowa.
+ * @param isa Implementacja filtra.
+ */
+void Tree::search(std::int32_t from, std::int32_t to, int field, double value, double tolerance,
+                  std::vector<Record>& matches, SearchKernel::Isa isa) const {
+    if (to < from || field < 0 || field >= Record::fieldCount) return;
+    if (!SearchKernel::supported(isa)) isa = SearchKernel::Isa::Scalar;
 
-    // Wyznaczanie ćwiartki dnia na podstawie godziny
-    if (hour < 6) return 0;           // Noc: 00:00 - 05:59
-    else if (hour < 12) return 1;     // Poranek: 06:00 - 11:59
-    else if (hour < 18) return 2;     // Popołudnie: 12:00 - 17:59
-    else return 3;                    // Wieczór: 18:00 - 23:59
+    const std::int32_t end = to + 1;
+    int fromYear = 0, month = 0, day = 0, hour = 0, minute = 0, toYear = 0;
+    Timestamp::toDateTime(from, fromYear, month, day, hour, minute);
+    Timestamp::toDateTime(to, toYear, month, day, hour, minute);
+
+    // Ćwiartki miesiąca z przedziału są filtrowane po zebraniu, z wczesnym pobraniem kolumn
+    // kolejnych ćwiartek (każda to osobna alokacja, więc bez tego każda ćwiartka czeka na pamięć)
+    struct Pending {
+        const Quarter* quarter;
+        const double* values;
+        std::size_t count;
+        bool inside;
+    };
+    std::vector<Pending> quarters;
+    std::vector<std::uint64_t> bitmap;
+    std::vector<std::size_t> indices;
+    const auto earlier = [](const Record& a, const Record& b) { return a.timestamp < b.timestamp; };
+    for (auto yearIt = years.lower_bound(fromYear); yearIt != years.end() && yearIt->first <= toYear; ++yearIt) {
+        const int y = yearIt->first;
+        for (const auto& [m, monthNode] : yearIt->second.months) {
+            const std::int32_t monthStart = Timestamp::fromDateTime(y, m, 1, 0, 0);
+            const std::int32_t monthEnd = m == 12 ? Timestamp::fromDateTime(y + 1, 1, 1, 0, 0)
+                                                  : Timestamp::fromDateTime(y, m + 1, 1, 0, 0);
+            if (monthEnd <= from || end <= monthStart) continue;
+            quarters.clear();
+            for (const auto& [d, dayNode] : monthNode.days) {
+                const std::int32_t dayStart = Timestamp::fromDateTime(y, m, d, 0, 0);
+                if (dayStart + Timestamp::minutesPerDay <= from || end <= dayStart) continue;
+                for (const auto& [q, quarterNode] : dayNode.quarters) {
+                    const std::int32_t quarterStart = dayStart + q * 6 * 60;
+                    const std::int32_t quarterEnd = quarterStart + 6 * 60;
+                    if (quarterEnd <= from || end <= quarterStart) continue;
+                    quarters.push_back(Pending{ &quarterNode, quarterNode.column(field).data(), quarterNode.size(),
+                                                from <= quarterStart && quarterEnd <= end });
+                }
+            }
+
+            for (std::size_t k = 0; k < quarters.size(); ++k) {
+                if (k + searchPrefetch < quarters.size()) {
+                    const Pending& next = quarters[k + searchPrefetch];
+                    prefetchColumn(next.values, next.count);
+                }
+                const Quarter& quarterNode = *quarters[k].quarter;
+                // Mapa bitowa w buforze zapytania - bez zmiany rozmiaru dla każdej ćwiartki
+                const std::size_t words = (quarters[k].count + 63) / 64;
+                if (bitmap.size() < words) bitmap.resize(words);
+                if (SearchKernel::match(quarters[k].values, quarters[k].count, value, tolerance, bitmap.data(), isa) == 0) {
+                    continue;
+                }
+                indices.clear();
+                SearchKernel::indices(bitmap.data(), words, 0, indices);
+                const bool inside = quarters[k].inside;
+                const auto first = static_cast<std::ptrdiff_t>(matches.size());
+                for (const std::size_t i : indices) {
+                    if (inside || (quarterNode.timestamps[i] >= from && quarterNode.timestamps[i] < end)) {
+                        matches.push_back(quarterNode.record(i));
+                    }
+                }
+                // Ćwiartka wypełniona przez `merge` lub dopisywanie może mieć rekordy poza kolejnością
+                if (!std::is_sorted(matches.begin() + first, matches.end(), earlier)) {
+                    std::stable_sort(matches.begin() + first, matches.end(), earlier);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Dodaje do kopca najlepsze rekordy przedziału, przeglądając węzły od najlepszego agregatu.
+ * 
+ * Węzły czekają w kolejce priorytetowej według najlepszej możliwej wartości (`TopK::bound`).
+ * Zdjęty węzeł, który nie może już pobić najgorszego rekordu kopca, kończy przegląd - wszystkie
+ * pozostałe węzły mają gorsze ograniczenie. Np. 100 największych importów roku to przegląd
+ * kilku ćwiartek z największymi maksimami zamiast ok. 35 tys. rekordów.
+ * 
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param top Kopiec wyników.
+ * @param stats Liczniki przejrzanych i pominiętych rekordów.
+ */
+void Tree::top(std::int32_t from, std::int32_t to, TopK& top, ScanStats& stats) const {
+    const int field = top.fieldIndex();
+    if (to < from || field < 0 || field >= Record::fieldCount) return;
+    const std::int32_t end = to + 1;
+
+    // Węzeł w kolejce: poziom wyznacza, który wskaźnik jest ustawiony
+    struct Node {
+        double bound = 0.0;
+        const Aggregate* stats = nullptr;
+        const Year* year = nullptr;
+        const Month* month = nullptr;
+        const Day* day = nullptr;
+        const Quarter* quarter = nullptr;
+        int y = 0, m = 0;
+        std::int32_t start = 0;
+    };
+    std::vector<Node> queue;
+    const auto byBound = [](const Node& a, const Node& b) { return a.bound < b.bound; };
+    const auto push = [&](Node node, const Aggregates& aggregates, std::int32_t nodeEnd) {
+        if (nodeEnd <= from || end <= node.start) return;
+        node.stats = &aggregates.fields[field];
+        if (!top.admits(*node.stats)) {
+            stats.skipped += node.stats->count;
+            return;
+        }
+        node.bound = top.bound(*node.stats);
+        queue.push_back(node);
+        std::push_heap(queue.begin(), queue.end(), byBound);
+    };
+
+    for (const auto& [y, yearNode] : years) {
+        Node node;
+        node.year = &yearNode;
+        node.y = y;
+        node.start = Timestamp::fromDateTime(y, 1, 1, 0, 0);
+        push(node, yearNode.stats, Timestamp::fromDateTime(y + 1, 1, 1, 0, 0));
+    }
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), byBound);
+        const Node node = queue.back();
+        queue.pop_back();
+        if (!top.admits(*node.stats)) {
+            // Kopiec zapełnił się od dodania węzła - pozostałe węzły mają gorsze ograniczenie
+            stats.skipped += node.stats->count;
+            for (const Node& rest : queue) stats.skipped += rest.stats->count;
+            return;
+        }
+        if (node.year != nullptr) {
+            for (const auto& [m, monthNode] : node.year->months) {
+                Node child;
+                child.month = &monthNode;
+                child.y = node.y;
+                child.m = m;
+                child.start = Timestamp::fromDateTime(node.y, m, 1, 0, 0);
+                push(child, monthNode.stats,
+                     m == 12 ? Timestamp::fromDateTime(node.y + 1, 1, 1, 0, 0) : Timestamp::fromDateTime(node.y, m + 1, 1, 0, 0));
+            }
+        } else if (node.month != nullptr) {
+            for (const auto& [d, dayNode] : node.month->days) {
+                Node child;
+                child.day = &dayNode;
+                child.start = Timestamp::fromDateTime(node.y, node.m, d, 0, 0);
+                push(child, dayNode.stats, child.start + Timestamp::minutesPerDay);
+            }
+        } else if (node.day != nullptr) {
+            for (const auto& [q, quarterNode] : node.day->quarters) {
+                Node child;
+                child.quarter = &quarterNode;
+                child.start = node.start + q * 6 * 60;
+                push(child, quarterNode.stats, child.start + 6 * 60);
+            }
+        } else {
+            const Quarter& quarter = *node.quarter;
+            const double* values = quarter.column(field).data();
+            for (std::size_t i = 0; i < quarter.size(); ++i) {
+                if (quarter.timestamps[i] < from || quarter.timestamps[i] >= end) continue;
+                ++stats.visited;
+                if (top.admits(values[i])) top.offer(quarter.record(i));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Wyznacza dni, w których wartości wielkości w oknie doby nie przekraczają `limit`.
+ * 
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param field Indeks wielkości.
+ * @param limit Największa wartość uznawana za zerową.
+ * @param firstMinute Początek okna doby (włącznie).
+ * @param lastMinute Koniec okna doby (włącznie).
+ * @param days Początki znalezionych dni.
+ * @param stats Liczniki przejrzanych i pominiętych rekordów.
+ */
+void Tree::flatDays(std::int32_t from, std::int32_t to, int field, double limit, int firstMinute, int lastMinute,
+                    std::vector<std::int32_t>& days, ScanStats& stats) const {
+    if (to < from || field < 0 || field >= Record::fieldCount || lastMinute < firstMinute) return;
+    const std::int32_t end = to + 1;
+    int fromYear = 0, month = 0, day = 0, hour = 0, minute = 0, toYear = 0;
+    Timestamp::toDateTime(from, fromYear, month, day, hour, minute);
+    Timestamp::toDateTime(to, toYear, month, day, hour, minute);
+
+    for (auto yearIt = years.lower_bound(fromYear); yearIt != years.end() && yearIt->first <= toYear; ++yearIt) {
+        const int y = yearIt->first;
+        for (const auto& [m, monthNode] : yearIt->second.months) {
+            const std::int32_t monthStart = Timestamp::fromDateTime(y, m, 1, 0, 0);
+            const std::int32_t monthEnd = m == 12 ? Timestamp::fromDateTime(y + 1, 1, 1, 0, 0)
+                                                  : Timestamp::fromDateTime(y, m + 1, 1, 0, 0);
+            if (monthEnd <= from || end <= monthStart) continue;
+            // Żadna wartość miesiąca nie jest "zerowa"
+            if (monthNode.stats[field].min > limit) {
+                stats.skipped += monthNode.stats[field].count;
+                continue;
+            }
+            for (const auto& [d, dayNode] : monthNode.days) {
+                const std::int32_t dayStart = Timestamp::fromDateTime(y, m, d, 0, 0);
+                const std::int32_t windowStart = std::max(dayStart + firstMinute, from);
+                const std::int32_t windowEnd = std::min(dayStart + lastMinute + 1, end);
+                if (windowEnd <= windowStart) continue;
+                if (dayNode.stats[field].min > limit) {
+                    stats.skipped += dayNode.stats[field].count;
+                    continue;
+                }
+
+                bool measured = false, flat = true;
+                for (const auto& [q, quarterNode] : dayNode.quarters) {
+                    const std::int32_t quarterStart = dayStart + q * 6 * 60;
+                    const std::int32_t quarterEnd = quarterStart + 6 * 60;
+                    if (quarterEnd <= windowStart || windowEnd <= quarterStart) continue;
+                    const Aggregate& quarterStats = quarterNode.stats[field];
+                    const bool inside = windowStart <= quarterStart && quarterEnd <= windowEnd;
+                    if (inside && quarterStats.max <= limit) {
+                        // Cała ćwiartka w oknie i bez wartości powyżej limitu
+                        measured = measured || quarterStats.count > 0;
+                        stats.skipped += quarterStats.count;
+                        continue;
+                    }
+                    const double* values = quarterNode.column(field).data();
+                    for (std::size_t i = 0; i < quarterNode.size() && flat; ++i) {
+                        if (quarterNode.timestamps[i] < windowStart || quarterNode.timestamps[i] >= windowEnd) continue;
+                        ++stats.visited;
+                        measured = true;
+                        // NaN nie jest wartością zerową
+                        flat = values[i] <= limit;
+                    }
+                    if (!flat) break;
+                }
+                if (measured && flat) days.push_back(dayStart);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Dopisuje rekordy przedziału chronologicznie.
+ * 
+ * Ćwiartki są przeglądane w kolejności czasu; rekordy ćwiartki (zwykle już uporządkowane,
+ * ale po scalaniu drzew niekoniecznie) są porządkowane według znaczników czasu.
+ * 
+ * @param from Początek przedziału (włącznie).
+ * @param to Koniec przedziału (włącznie).
+ * @param records Lista wyjściowa.
+ */
+void Tree::records(std::int32_t from, std::int32_t to, std::vector<Record>& records) const {
+    if (to < from) return;
+    const std::int32_t end = to + 1;
+    int fromYear = 0, month = 0, day = 0, hour = 0, minute = 0, toYear = 0;
+    Timestamp::toDateTime(from, fromYear, month, day, hour, minute);
+    Timestamp::toDateTime(to, toYear, month, day, hour, minute);
+
+    std::vector<std::size_t> order;
+    for (auto yearIt = years.lower_bound(fromYear); yearIt != years.end() && yearIt->first <= toYear; ++yearIt) {
+        const int y = yearIt->first;
+        for (const auto& [m, monthNode] : yearIt->second.months) {
+            for (const auto& [d, dayNode] : monthNode.days) {
+                const std::int32_t dayStart = Timestamp::fromDateTime(y, m, d, 0, 0);
+                if (dayStart + Timestamp::minutesPerDay <= from || end <= dayStart) continue;
+                for (const auto& [q, quarterNode] : dayNode.quarters) {
+                    const std::pmr::vector<std::int32_t>& timestamps = quarterNode.timestamps;
+                    order.resize(quarterNode.size());
+                    std::iota(order.begin(), order.end(), std::size_t(0));
+                    if (!std::is_sorted(timestamps.begin(), timestamps.end())) {
+                        std::sort(order.begin(), order.end(),
+                                  [&timestamps](std::size_t a, std::size_t b) { return timestamps[a] < timestamps[b]; });
+                    }
+                    for (const std::size_t i : order) {
+                        if (timestamps[i] >= from && timestamps[i] < end) records.push_back(quarterNode.record(i));
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Sprawdza, czy drzewo zawiera rekord o podanym znaczniku czasu.
+ * 
+ * @param timestamp Znacznik czasu.
+ * @return true, jeśli ćwiartka znacznika zawiera rekord o tym znaczniku.
+ */
+bool Tree::contains(std::int32_t timestamp) const {
+    int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+    Timestamp::toDateTime(timestamp, year, month, day, hour, minute);
+
+    const auto yearIt = years.find(year);
+    if (yearIt == years.end()) return false;
+    const auto monthIt = yearIt->second.months.find(month);
+    if (monthIt == yearIt->second.months.end()) return false;
+    const auto dayIt = monthIt->second.days.find(day);
+    if (dayIt == monthIt->second.days.end()) return false;
+    const auto quarterIt = dayIt->second.quarters.find(hour / 6);
+    if (quarterIt == dayIt->second.quarters.end()) return false;
+
+    const std::pmr::vector<std::int32_t>& timestamps = quarterIt->second.timestamps;
+    return std::find(timestamps.begin(), timestamps.end(), timestamp) != timestamps.end();
+}
+
+/**
+ * @brief Wyznacza przedział znaczników czasu rekordów drzewa.
+ * 
+ * Mapy są uporządkowane, więc skrajne rekordy leżą w pierwszej i ostatniej ćwiartce;
+ * w ćwiartce rekordy mogą być w dowolnej kolejności.
+ * 
+ * @param first Najwcześniejszy znacznik czasu.
+ * @param last Najpóźniejszy znacznik czasu.
+ * @return true, jeśli drzewo nie jest puste.
+ */
+bool Tree::timeSpan(std::int32_t& first, std::int32_t& last) const {
+    if (years.empty()) return false;
+    const Quarter& head = years.begin()->second.months.begin()->second.days.begin()->second.quarters.begin()->second;
+    const Quarter& tail = years.rbegin()->second.months.rbegin()->second.days.rbegin()->second.quarters.rbegin()->second;
+    if (head.empty() || tail.empty()) return false;
+    first = *std::min_element(head.timestamps.begin(), head.timestamps.end());
+    last = *std::max_element(tail.timestamps.begin(), tail.timestamps.end());
+    return true;
 }
@@ -1,10 +1,21 @@
 #ifndef TREE_H
 #define TREE_H
 
+#include <cstddef>
+#include <cstdint>
 #include <map>
+#include <memory>
+#include <memory_resource>
 #include <vector>
 #include <string>
+#include "Aggregate.h"
+#include "Arena.h"
 #include "Record.h"
+#include "SearchKernel.h"
+#include "Timestamp.h"
+
+class TopK;
+struct ScanStats;
 
 /**
  * @brief Klasa reprezentująca hierarchiczne drzewo do przechowywania danych pomiarowych.
@@ -12,18 +23,141 @@
  * Drzewo organizuje dane według następującej struktury:
  * - Rok -> Miesiąc -> Dzień -> Ćwiartka (6-godzinny przedział czasowy).
  * 
- * Każda ćwiartka zawiera listę rekordów danych pomiarowych.
+ * Każda ćwiartka przechowuje dane pomiarowe kolumnowo (patrz `Quarter`), a każdy węzeł
+ * (ćwiartka, dzień, miesiąc, rok) przechowuje zagregowane statystyki swoich rekordów,
+ * aktualizowane przy każdym dodaniu rekordu.
+ * 
+ * Węzły map i kolumny ćwiartek są alokowane z areny drzewa (`Arena`, przez `std::pmr`):
+ * wczytanie całego pliku to kilka dużych alokacji, a zniszczenie drzewa zwalnia je naraz.
+ * Drzewa współdzielące arenę (`Tree(std::shared_ptr<std::pmr::memory_resource>)`) scalają się
+ * bez kopiowania danych; scalanie lub przypisanie między drzewami z różnymi arenami kopiuje
+ * przenoszone kolumny do areny drzewa docelowego.
  */
 class Tree {
+private:
+    /**
+     * @brief Zasób pamięci węzłów i kolumn (zadeklarowany przed `years`, więc zniszczony po nim).
+     */
+    std::shared_ptr<std::pmr::memory_resource> memory;
+
 public:
+    /**
+     * @brief Alokator węzłów i kolumn drzewa.
+     */
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
     /**
      * @brief Struktura reprezentująca dane w ćwiartce (6-godzinny przedział czasowy).
+     * 
+     * Dane są przechowywane kolumnowo (structure-of-arrays): osobna, ciągła tablica dla każdej
+     * wielkości pomiarowej oraz tablica znaczników czasu (minuty od 2000-01-01, patrz `Timestamp`).
+     * Element `i` każdej kolumny odpowiada temu samemu rekordowi. Agregacja po jednej wielkości
+     * przegląda więc tylko 8 bajtów na rekord, bez odwołań do napisów na stercie.
+     * 
+     * Obiekty `Record` nie są przechowywane - `record(i)` odtwarza je na żądanie.
      */
     struct Quarter {
         /**
-         * @brief Wektor przechowujący rekordy danych dla danej ćwiartki.
+         * @brief Znaczniki czasu rekordów (minuty od 2000-01-01 00:00).
+         */
+        std::pmr::vector<std::int32_t> timestamps;
+
+        /**
+         * @brief Kolumna wartości autokonsumpcji [W].
+         */
+        std::pmr::vector<double> autokonsumpcja;
+
+        /**
+         * @brief Kolumna wartości eksportu [W].
+         */
+        std::pmr::vector<double> eksport;
+
+        /**
+         * @brief Kolumna wartości importu [W].
+         */
+        std::pmr::vector<double> import_;
+
+        /**
+         * @brief Kolumna wartości poboru [W].
+         */
+        std::pmr::vector<double> pobor;
+
+        /**
+         * @brief Kolumna wartości produkcji [W].
+         */
+        std::pmr::vector<double> produkcja;
+
+        /**
+         * @brief Agregaty (suma, liczba, min, max) wszystkich rekordów ćwiartki.
+         */
+        Aggregates stats;
+
+        /**
+         * @brief Konstruktory z alokatorem (używane przez mapy `std::pmr` przy tworzeniu węzłów).
+         */
+        using allocator_type = Tree::allocator_type;
+        Quarter() = default;
+        explicit Quarter(const allocator_type& allocator);
+        Quarter(const Quarter& other, const allocator_type& allocator);
+        Quarter(Quarter&& other, const allocator_type& allocator);
+        Quarter(const Quarter&) = default;
+        Quarter(Quarter&&) = default;
+        Quarter& operator=(const Quarter&) = default;
+        Quarter& operator=(Quarter&&) = default;
+
+        /**
+         * @brief Zwraca liczbę rekordów w ćwiartce.
+         */
+        std::size_t size() const { return timestamps.size(); }
+
+        /**
+         * @brief Sprawdza, czy ćwiartka jest pusta.
+         */
+        bool empty() const { return timestamps.empty(); }
+
+        /**
+         * @brief Dopisuje rekord na końcu wszystkich kolumn.
+         * 
+         * @param timestamp Znacznik czasu rekordu (minuty od 2000-01-01 00:00).
+         * @param record Rekord, którego wartości pomiarowe zostaną dopisane.
+         */
+        void push_back(std::int32_t timestamp, const Record& record);
+
+        /**
+         * @brief Dopisuje wszystkie rekordy innej ćwiartki na końcu kolumn.
+         * 
+         * @param other Ćwiartka, której dane zostaną przeniesione.
+         */
+        void append(Quarter&& other);
+
+        /**
+         * @brief Odtwarza rekord o podanym indeksie.
+         * 
+         * @param index Indeks rekordu (0 - `size()-1`).
+         * @return Record Rekord ze znacznikiem czasu i wartościami pomiarów.
+         */
+        Record record(std::size_t index) const;
+
+        /**
+         * @brief Zwraca kolumnę wielkości pomiarowej o podanym indeksie.
+         * 
+         * @param field Indeks wielkości (patrz `Record::fieldIndex`).
+         * @return const std::pmr::vector<double>& Kolumna wartości.
          */
-        std::vector<Record> records; 
+        const std::pmr::vector<double>& column(int field) const;
+
+        /**
+         * @brief Zwraca kolumnę wielkości `Field` wybranej w czasie kompilacji.
+         */
+        template <int Field>
+        const std::pmr::vector<double>& column() const {
+            static_assert(Field >= 0 && Field < Record::fieldCount, "niepoprawny indeks wielkości");
+            if constexpr (Field == 0) return autokonsumpcja;
+            else if constexpr (Field == 1) return eksport;
+            else if constexpr (Field == 2) return import_;
+            else if constexpr (Field == 3) return pobor;
+            else return produkcja;
+        }
     };
 
     /**
@@ -39,7 +173,25 @@ public:
         /**
          * @brief Mapa przechowująca ćwiartki (klucz: numer ćwiartki, wartość: dane ćwiartki).
          */
-        std::map<int, Quarter> quarters; 
+        std::pmr::map<int, Quarter> quarters;
+
+        /**
+         * @brief Agregaty (suma, liczba, min, max) wszystkich rekordów dnia.
+         */
+        Aggregates stats;
+
+        /**
+         * @brief Konstruktory z alokatorem (używane przez mapy `std::pmr` przy tworzeniu węzłów).
+         */
+        using allocator_type = Tree::allocator_type;
+        Day() = default;
+        explicit Day(const allocator_type& allocator) : quarters(allocator) {}
+        Day(const Day& other, const allocator_type& allocator) : quarters(other.quarters, allocator), stats(other.stats) {}
+        Day(Day&& other, const allocator_type& allocator) : quarters(std::move(other.quarters), allocator), stats(other.stats) {}
+        Day(const Day&) = default;
+        Day(Day&&) = default;
+        Day& operator=(const Day&) = default;
+        Day& operator=(Day&&) = default;
     };
 
     /**
@@ -53,7 +205,25 @@ public:
         /**
          * @brief Mapa przechowująca dni miesiąca.
          */
-        std::map<int, Day> days; 
+        std::pmr::map<int, Day> days;
+
+        /**
+         * @brief Agregaty (suma, liczba, min, max) wszystkich rekordów miesiąca.
+         */
+        Aggregates stats;
+
+        /**
+         * @brief Konstruktory z alokatorem (używane przez mapy `std::pmr` przy tworzeniu węzłów).
+         */
+        using allocator_type = Tree::allocator_type;
+        Month() = default;
+        explicit Month(const allocator_type& allocator) : days(allocator) {}
+        Month(const Month& other, const allocator_type& allocator) : days(other.days, allocator), stats(other.stats) {}
+        Month(Month&& other, const allocator_type& allocator) : days(std::move(other.days), allocator), stats(other.stats) {}
+        Month(const Month&) = default;
+        Month(Month&&) = default;
+        Month& operator=(const Month&) = default;
+        Month& operator=(Month&&) = default;
     };
 
     /**
@@ -67,7 +237,25 @@ public:
         /**
          * @brief Mapa przechowująca miesiące roku.
          */
-        std::map<int, Month> months; 
+        std::pmr::map<int, Month> months;
+
+        /**
+         * @brief Agregaty (suma, liczba, min, max) wszystkich rekordów roku.
+         */
+        Aggregates stats;
+
+        /**
+         * @brief Konstruktory z alokatorem (używane przez mapy `std::pmr` przy tworzeniu węzłów).
+         */
+        using allocator_type = Tree::allocator_type;
+        Year() = default;
+        explicit Year(const allocator_type& allocator) : months(allocator) {}
+        Year(const Year& other, const allocator_type& allocator) : months(other.months, allocator), stats(other.stats) {}
+        Year(Year&& other, const allocator_type& allocator) : months(std::move(other.months), allocator), stats(other.stats) {}
+        Year(const Year&) = default;
+        Year(Year&&) = default;
+        Year& operator=(const Year&) = default;
+        Year& operator=(Year&&) = default;
     };
 
     /**
@@ -76,7 +264,53 @@ public:
      * Klucz: numer roku (np. 2021).
      * Wartość: dane roku.
      */
-    std::map<int, Year> years; 
+    std::pmr::map<int, Year> years;
+
+    /**
+     * @brief Agregaty wszystkich rekordów drzewa.
+     */
+    Aggregates stats;
+
+    /**
+     * @brief Tworzy puste drzewo z własną areną.
+     */
+    Tree();
+
+    /**
+     * @brief Tworzy puste drzewo alokujące z podanego zasobu pamięci.
+     * 
+     * Drzewa współdzielące zasób można scalać bez kopiowania kolumn. Zasób nie musi być areną -
+     * np. `std::pmr::new_delete_resource()` (opakowany w `std::shared_ptr` bez usuwania) daje
+     * zwykłe alokacje na stercie.
+     * 
+     * @param memory Zasób pamięci (utrzymywany przy życiu przez drzewo).
+     */
+    explicit Tree(std::shared_ptr<std::pmr::memory_resource> memory);
+
+    /**
+     * @brief Kopiuje drzewo do nowej areny.
+     */
+    Tree(const Tree& other);
+
+    /**
+     * @brief Przenosi drzewo razem z jego areną.
+     */
+    Tree(Tree&& other) noexcept;
+
+    /**
+     * @brief Kopiuje dane drzewa `other` do areny bieżącego drzewa.
+     */
+    Tree& operator=(const Tree& other);
+
+    /**
+     * @brief Przenosi dane drzewa `other`; przy innej arenie dane są kopiowane do areny bieżącego drzewa.
+     */
+    Tree& operator=(Tree&& other);
+
+    /**
+     * @brief Zwraca zasób pamięci drzewa (np. do utworzenia drzewa współdzielącego arenę).
+     */
+    const std::shared_ptr<std::pmr::memory_resource>& resource() const { return memory; }
 
     /**
      * @brief Dodaje rekord pomiarowy do odpowiedniego miejsca w drzewie.
@@ -87,6 +321,128 @@ public:
      */
     void addRecord(const Record& record);
 
+    /**
+     * @brief Scala inne drzewo z bieżącym, przenosząc jego dane.
+     * 
+     * Węzły, których nie ma w bieżącym drzewie, są przenoszone w całości (bez kopiowania rekordów),
+     * a rekordy z istniejących ćwiartek są dopisywane na końcu. Kolejność rekordów jest więc taka,
+     * jakby rekordy z `other` zostały dodane przez `addRecord` po rekordach bieżącego drzewa.
+     * 
+     * @param other Drzewo do scalenia (po operacji pozostaje puste).
+     */
+    void merge(Tree&& other);
+
+    /**
+     * @brief Oblicza agregat wybranej wielkości dla rekordów z przedziału czasu `[from, to]`.
+     * 
+     * Węzły (rok, miesiąc, dzień, ćwiartka) w całości zawarte w przedziale są uwzględniane
+     * przez swoje zapamiętane agregaty, bez przeglądania rekordów. Pojedyncze rekordy są
+     * przeglądane tylko w ćwiartkach na obu krawędziach przedziału.
+     * 
+     * @param from Początek przedziału (minuty od 2000-01-01 00:00, włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości (patrz `Record::fieldIndex`).
+     * @return Aggregate Suma, liczba, minimum i maksimum wartości w przedziale.
+     */
+    Aggregate aggregate(std::int32_t from, std::int32_t to, int field) const;
+
+    /**
+     * @brief Oblicza agregaty wszystkich wielkości w przedziale `[from, to]`.
+     * 
+     * Wynik jest równy pięciu wywołaniom `aggregate(from, to, field)`, ale drzewo jest przeglądane
+     * raz, a rekordy ćwiartek na krawędziach przedziału - jednym przejściem po kolumnach.
+     * 
+     * @param from Początek przedziału (minuty od 2000-01-01 00:00, włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @return Aggregates Agregaty wszystkich wielkości (indeksy jak w `Record::fieldIndex`).
+     */
+    Aggregates aggregate(std::int32_t from, std::int32_t to) const;
+
+    /**
+     * @brief Wyszukuje rekordy z przedziału `[from, to]`, w których `|wartość - value| <= tolerance`.
+     * 
+     * Kolumna wybranej wielkości każdej ćwiartki z przedziału jest filtrowana wektorowo
+     * (`SearchKernel`, implementacja wybierana raz na zapytanie, wspólny bufor mapy bitowej);
+     * rekordy są odtwarzane tylko dla pasujących wartości.
+     * 
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości (patrz `Record::fieldIndex`).
+     * @param value Szukana wartość.
+     * @param tolerance Tolerancja.
+     * @param matches Lista, na której końcu zostaną dopisane pasujące rekordy (chronologicznie).
+     * @param isa Implementacja filtra (domyślnie najszybsza; nieobsługiwana jest zastępowana skalarną).
+     */
+    void search(std::int32_t from, std::int32_t to, int field, double value, double tolerance,
+                std::vector<Record>& matches, SearchKernel::Isa isa = SearchKernel::best()) const;
+
+    /**
+     * @brief Dodaje do kopca `top` rekordy z przedziału `[from, to]` o największych (najmniejszych) wartościach.
+     * 
+     * Węzły są przeglądane od najlepszego maksimum (minimum) wielkości, a węzeł, którego agregat
+     * nie może pobić najgorszego rekordu pełnego kopca, jest pomijany razem z poddrzewem. Rekordy
+     * są przeglądane tylko w ćwiartkach, które przeszły ten test.
+     * 
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param top Kopiec wyników (może już zawierać rekordy innych źródeł).
+     * @param stats Liczniki przejrzanych i pominiętych rekordów (zwiększane; pominięte węzły
+     *        na krawędziach przedziału liczą się w całości).
+     */
+    void top(std::int32_t from, std::int32_t to, TopK& top, ScanStats& stats) const;
+
+    /**
+     * @brief Wyznacza dni, w których wszystkie wartości wielkości w oknie doby nie przekraczają `limit`.
+     * 
+     * Okno doby to minuty `[firstMinute, lastMinute]` (np. 9:00-15:00 dla dnia bez produkcji).
+     * Dzień musi mieć w oknie co najmniej jeden pomiar. Miesiące i dni o minimum większym niż
+     * `limit` są pomijane bez przeglądania, ćwiartki o maksimum nie większym niż `limit` - bez
+     * czytania wartości, a przegląd dnia kończy się na pierwszej wartości powyżej `limit`.
+     * 
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param field Indeks wielkości.
+     * @param limit Największa wartość uznawana za zerową.
+     * @param firstMinute Początek okna doby (minuta doby, włącznie).
+     * @param lastMinute Koniec okna doby (minuta doby, włącznie).
+     * @param days Lista, na której końcu zostaną dopisane początki dni (chronologicznie).
+     * @param stats Liczniki przejrzanych i pominiętych rekordów (zwiększane).
+     */
+    void flatDays(std::int32_t from, std::int32_t to, int field, double limit, int firstMinute, int lastMinute,
+                  std::vector<std::int32_t>& days, ScanStats& stats) const;
+
+    /**
+     * @brief Dopisuje rekordy z przedziału `[from, to]` w kolejności znaczników czasu.
+     * 
+     * @param from Początek przedziału (włącznie).
+     * @param to Koniec przedziału (włącznie).
+     * @param records Lista, na której końcu zostaną dopisane rekordy.
+     */
+    void records(std::int32_t from, std::int32_t to, std::vector<Record>& records) const;
+
+    /**
+     * @brief Sprawdza, czy drzewo zawiera rekord o podanym znaczniku czasu.
+     * 
+     * Wyszukiwanie schodzi bezpośrednio do ćwiartki znacznika i przegląda tylko jej znaczniki
+     * (najwyżej kilkadziesiąt), więc nadaje się do sprawdzania duplikatów przy dopisywaniu danych.
+     * 
+     * @param timestamp Znacznik czasu (minuty od 2000-01-01 00:00).
+     * @return true, jeśli rekord o tym znaczniku istnieje.
+     */
+    bool contains(std::int32_t timestamp) const;
+
+    /**
+     * @brief Wyznacza najwcześniejszy i najpóźniejszy znacznik czasu w drzewie.
+     * 
+     * Przeglądane są tylko pierwsza i ostatnia ćwiartka drzewa (np. do unieważnienia
+     * zestawień obejmujących dopisane rekordy).
+     * 
+     * @param first Najwcześniejszy znacznik czasu.
+     * @param last Najpóźniejszy znacznik czasu.
+     * @return true, jeśli drzewo zawiera rekordy.
+     */
+    bool timeSpan(std::int32_t& first, std::int32_t& last) const;
+
     /**
      * @brief Funkcja pomocnicza do określenia ćwiartki na podstawie czasu.
      * 
@@ -96,10 +452,10 @@ public:
      * - Ćwiartka 2: 12:00 - 17:45
      * - Ćwiartka 3: 18:00 - 23:45
      * 
-     * @param time Czas w formacie HH:MM.
+     * @param timestamp Znacznik czasu (minuty od 2000-01-01 00:00).
      * @return int Numer ćwiartki (0-3).
      */
-    static int getQuarter(const std::string& time);
+    static int getQuarter(std::int32_t timestamp);
 };
 
 #endif // TREE_H
@@ -0,0 +1,1100 @@
+#include <benchmark/benchmark.h>
+#include "Program.h"
+#include "BatchQuery.h"
+#include "MappedFile.h"
+#include "PrefixSumIndex.h"
+#include "Rollup.h"
+#include "RowValidator.h"
+#include "SearchKernel.h"
+#include "Snapshot.h"
+#include "ConcurrentTree.h"
+#include "FlatTree.h"
+#include "Fleet.h"
+#include "Timestamp.h"
+#include "Tree.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <new>
+#include <random>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+// Pomiary wydajności (Google Benchmark).
+//
+// Dane wejściowe są generowane przez `SolarGenerator` (dzień i noc, pory roku, zachmurzenie;
+// moc kalibrowana na ChartExport.csv) z kolejnymi 15-minutowymi znacznikami czasu.
+// Pomiary wczytywania obejmują pliki od 2^12 wierszy do BENCH_MAX_ROWS (domyślnie 2^20).
+//
+// Liczniki: `items_per_second` (wiersze lub zapytania na sekundę), czas iteracji (ns/zapytanie)
+// i `peak_rss_MB`. Wyniki trafiają także do benchmark_results.json (chyba że podano
+// `--benchmark_out`); dwa takie pliki porównuje `tools/compare.py` z Google Benchmark.
+
+// Liczniki alokacji sterty (globalny operator new) dla porównania areny drzewa ze zwykłymi alokacjami.
+static std::atomic<std::size_t> heapAllocations{ 0 };
+static std::atomic<std::size_t> heapBytes{ 0 };
+
+// GCC po wstawieniu operatora delete widzi `free` na wskaźniku z `operator new` i ostrzega, choć oba
+// operatory są tu zastąpione parą malloc/free
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(std::size_t size) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    heapBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* pointer = std::malloc(size == 0 ? 1 : size)) return pointer;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    heapBytes.fetch_add(size, std::memory_order_relaxed);
+    const std::size_t align = static_cast<std::size_t>(alignment);
+    if (void* pointer = std::aligned_alloc(align, (size + align - 1) / align * align)) return pointer;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { std::free(pointer); }
+
+namespace {
+
+const char* const kSourceCsv = "ChartExport.csv";
+
+/**
+ * @brief Generator realistycznych pomiarów instalacji fotowoltaicznej co 15 minut.
+ *
+ * Moc szczytowa produkcji i średni pobór są kalibrowane na ChartExport.csv. Produkcja jest
+ * zerowa w nocy, a w dzień ma kształt sinusa o długości dnia zależnej od pory roku
+ * (ok. 7,5 h w grudniu i 16,5 h w czerwcu na szerokości Polski). Jest mnożona przez losowe
+ * zachmurzenie dnia i szum pomiaru. Pobór to obciążenie podstawowe z porannym i wieczornym
+ * szczytem. Autokonsumpcja, eksport i import wynikają z bilansu produkcji i poboru (jak w
+ * eksporcie falownika). Generator jest deterministyczny (stałe ziarno), więc wyniki kolejnych
+ * wydań są porównywalne.
+ */
+class SolarGenerator {
+public:
+    SolarGenerator() : rng(2020) {
+        std::ifstream source(kSourceCsv);
+        std::string line;
+        Record record;
+        double consumption = 0.0;
+        long count = 0;
+        while (std::getline(source, line)) {
+            if (!Program::parseLine(line.data(), line.data() + line.size(), record)) continue;
+            peak = std::max(peak, record.produkcja);
+            consumption += record.pobor;
+            ++count;
+        }
+        if (count > 0) baseLoad = consumption / static_cast<double>(count);
+    }
+
+    /**
+     * @brief Zwraca pomiar o podanym znaczniku czasu (kolejne wywołania - kolejne 15-minutowe interwały).
+     */
+    Record next(std::int32_t timestamp) {
+        const std::int32_t day = timestamp / Timestamp::minutesPerDay;
+        if (day != currentDay) {
+            currentDay = day;
+            clouds = std::uniform_real_distribution<double>(0.15, 1.0)(rng);
+        }
+        constexpr double pi = 3.14159265358979323846;
+        const double hour = (timestamp % Timestamp::minutesPerDay) / 60.0;
+        const double season = std::sin(2.0 * pi * (dayOfYear(timestamp) - 80) / 365.25); // -1 w grudniu, 1 w czerwcu
+        const double daylight = 12.0 + 4.5 * season;
+        const double sunrise = 12.5 - daylight / 2.0;
+
+        double produkcja = 0.0;
+        if (hour > sunrise && hour < sunrise + daylight) {
+            const double elevation = std::sin(pi * (hour - sunrise) / daylight);
+            produkcja = peak * (0.6 + 0.4 * season) * elevation * elevation * clouds * noise(rng);
+        }
+        const double pobor = baseLoad * (0.55 + 0.7 * std::exp(-(hour - 7.0) * (hour - 7.0)) +
+                                         1.1 * std::exp(-(hour - 19.5) * (hour - 19.5) / 2.0)) * noise(rng);
+        const double autokonsumpcja = std::min(produkcja, pobor);
+        return Record(timestamp, round(autokonsumpcja), round(produkcja - autokonsumpcja),
+                      round(pobor - autokonsumpcja), round(pobor), round(produkcja));
+    }
+
+private:
+    static int dayOfYear(std::int32_t timestamp) {
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+        Timestamp::toDateTime(timestamp, year, month, day, hour, minute);
+        return Timestamp::daysFromCivil(year, month, day) - Timestamp::daysFromCivil(year, 1, 1);
+    }
+
+    // Cztery miejsca po przecinku, jak w eksporcie falownika
+    static double round(double value) { return std::round(value * 1e4) / 1e4; }
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> noise{ 0.85, 1.0 };
+    double peak = 6000.0;
+    double baseLoad = 400.0;
+    double clouds = 1.0;
+    std::int32_t currentDay = -1;
+};
+
+/**
+ * @brief Tworzy plik CSV z `rows` wierszami danych w formacie eksportu falownika.
+ *
+ * Pomiary pochodzą z `SolarGenerator`, a daty rosną co 15 minut od 01.01.2000 0:00.
+ * Plik jest generowany tylko raz dla danej liczby wierszy i zapisywany strumieniowo,
+ * więc można tworzyć pliki od tysięcy do setek milionów wierszy (ok. 68 B na wiersz;
+ * 32-bitowe znaczniki czasu wystarczają na ok. 140 mln wierszy).
+ */
+std::string scaledCsv(long rows) {
+    const std::string fileName = "bench_solar_" + std::to_string(rows) + ".csv";
+    if (std::ifstream(fileName).good()) return fileName;
+
+    SolarGenerator generator;
+    std::ofstream out(fileName, std::ios::binary);
+    out << "Time,Autokonsumpcja (W),Eksport (W),Import (W),Pobór (W),Produkcja (W)\n";
+    char line[160];
+    for (long i = 0; i < rows; ++i) {
+        const std::int32_t timestamp = static_cast<std::int32_t>(i * 15);
+        const Record record = generator.next(timestamp);
+        int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+        Timestamp::toDateTime(timestamp, year, month, day, hour, minute);
+        const int length = std::snprintf(line, sizeof(line),
+                                         "%02d.%02d.%04d %d:%02d,\"%.4f\",\"%.4f\",\"%.4f\",\"%.4f\",\"%.4f\"\n", day,
+                                         month, year, hour, minute, record.autokonsumpcja, record.eksport,
+                                         record.import_, record.pobor, record.produkcja);
+        out.write(line, length);
+    }
+    return fileName;
+}
+
+/**
+ * @brief Zwraca bieżący rozmiar pamięci rezydentnej procesu w bajtach (0, jeśli niedostępny).
+ */
+std::size_t residentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    std::size_t pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0;
+    return resident * 4096;
+}
+
+/**
+ * @brief Zwraca szczytowy rozmiar pamięci rezydentnej procesu w bajtach (0, jeśli niedostępny).
+ */
+std::size_t peakResidentBytes() {
+#ifndef _WIN32
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+    return 0;
+}
+
+/**
+ * @brief Zapisuje szczytową pamięć rezydentną procesu jako licznik `peak_rss_MB`.
+ *
+ * Szczyt dotyczy całego procesu od jego startu - dla pomiaru pojedynczego wariantu
+ * należy uruchomić go osobno (`--benchmark_filter`).
+ */
+void reportPeakMemory(benchmark::State& state) {
+    state.counters["peak_rss_MB"] = static_cast<double>(peakResidentBytes()) / (1 << 20);
+}
+
+/**
+ * @brief Największa liczba wierszy w pomiarach wczytywania (zmienna środowiskowa BENCH_MAX_ROWS,
+ * domyślnie 2^20), np. BENCH_MAX_ROWS=100000000 dla pomiaru na setkach milionów wierszy.
+ */
+long maxRows() {
+    const char* value = std::getenv("BENCH_MAX_ROWS");
+    const long rows = value != nullptr ? std::atol(value) : 0;
+    return rows > 0 ? rows : 1 << 20;
+}
+
+/**
+ * @brief Rozmiary danych pomiarów wczytywania: od tysięcy wierszy do `maxRows()`.
+ */
+void ingestSizes(benchmark::internal::Benchmark* bench) {
+    for (long rows = 1 << 12; rows < maxRows(); rows *= 16) bench->Arg(rows);
+    bench->Arg(maxRows());
+}
+
+/**
+ * @brief Program z wczytanym plikiem `scaledCsv(rows)` (wczytywany raz na proces).
+ */
+Program& loadedProgram(long rows) {
+    static std::map<long, std::unique_ptr<Program>> programs;
+    std::unique_ptr<Program>& program = programs[rows];
+    if (!program) {
+        std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+        program = std::make_unique<Program>();
+        program->setLogLevel(LogLevel::None);
+        program->loadCSV(scaledCsv(rows));
+        std::cout.rdbuf(coutBuffer);
+    }
+    return *program;
+}
+
+/**
+ * @brief Referencyjny parser w stylu getline/istringstream (stan sprzed mapowania pliku).
+ */
+bool legacyParseLine(const std::string& line, Record& record) {
+    std::istringstream iss(line);
+    std::string stamp, field;
+    if (!std::getline(iss, stamp, ',')) return false;
+
+    std::istringstream stampStream(stamp);
+    std::string date, time;
+    if (!(stampStream >> date >> time)) return false;
+
+    double* const fields[] = { &record.autokonsumpcja, &record.eksport, &record.import_,
+                               &record.pobor, &record.produkcja };
+    for (double* value : fields) {
+        if (!std::getline(iss, field, ',')) return false;
+        if (field.size() >= 2 && field.front() == '"') field = field.substr(1, field.size() - 2);
+        try {
+            *value = std::stod(field);
+        } catch (...) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BM_ParseLegacyGetline(benchmark::State& state) {
+    const std::string fileName = scaledCsv(state.range(0));
+    long rows = 0;
+    for (auto _ : state) {
+        std::ifstream file(fileName);
+        std::string line;
+        Record record;
+        rows = 0;
+        while (std::getline(file, line)) {
+            if (legacyParseLine(line, record)) ++rows;
+        }
+        benchmark::DoNotOptimize(rows);
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+
+void BM_ParseMapped(benchmark::State& state) {
+    const std::string fileName = scaledCsv(state.range(0));
+    long rows = 0;
+    for (auto _ : state) {
+        MappedFile file(fileName);
+        const char* p = file.data();
+        const char* const end = p + file.size();
+        Record record;
+        rows = 0;
+        while (p < end) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            if (eol == nullptr) eol = end;
+            if (Program::parseLine(p, eol, record)) ++rows;
+            p = eol + 1;
+        }
+        benchmark::DoNotOptimize(rows);
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+
+void BM_LoadCSV(benchmark::State& state) {
+    const std::string fileName = scaledCsv(state.range(0));
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    for (auto _ : state) {
+        Program program;
+        program.loadCSV(fileName);
+    }
+    std::cout.rdbuf(coutBuffer);
+    reportPeakMemory(state);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_LoadCSVParallel(benchmark::State& state) {
+    const std::string fileName = scaledCsv(state.range(0));
+    const unsigned threads = static_cast<unsigned>(state.range(1));
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    for (auto _ : state) {
+        Program program;
+        program.loadCSV(fileName, threads);
+    }
+    std::cout.rdbuf(coutBuffer);
+    reportPeakMemory(state);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Sprawdzanie jakości wierszy paczkami (RowValidator) bez parsowania i wstawiania do drzewa -
+// koszt etapu, który przy wczytywaniu dochodzi do parsowania (BM_ParseMapped) na każdy wiersz;
+// range(1) == 1 - dodatkowo bilans mocy
+void BM_ValidateRows(benchmark::State& state) {
+    const std::string fileName = scaledCsv(state.range(0));
+    std::vector<Record> records;
+    {
+        MappedFile file(fileName);
+        const char* p = file.data();
+        const char* const end = p + file.size();
+        Record record;
+        while (p < end) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            if (eol == nullptr) eol = end;
+            if (Program::parseLine(p, eol, record)) records.push_back(record);
+            p = eol + 1;
+        }
+    }
+    ValidationRules rules;
+    rules.checkBalance = state.range(1) != 0;
+    std::unique_ptr<RowBatch> batch(new RowBatch());
+    const Tree accepted;
+    std::size_t rejected = 0;
+    for (auto _ : state) {
+        RowValidator validator(rules);
+        rejected = 0;
+        for (std::size_t i = 0; i < records.size(); i += RowBatch::capacity) {
+            batch->size = 0;
+            const std::size_t last = std::min(records.size(), i + RowBatch::capacity);
+            for (std::size_t j = i; j < last; ++j) batch->add(records[j], RejectReason::None, nullptr, 0, j + 1);
+            validator.validate(*batch, accepted);
+            for (std::size_t j = 0; j < batch->size; ++j) rejected += batch->reasons[j] != RejectReason::None;
+        }
+        benchmark::DoNotOptimize(rejected);
+    }
+    state.counters["rejected"] = static_cast<double>(rejected);
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(records.size()));
+}
+
+void BM_LoadCSVLogLevel(benchmark::State& state) {
+    const std::string fileName = scaledCsv(state.range(0));
+    const LogLevel level = static_cast<LogLevel>(state.range(1));
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    for (auto _ : state) {
+        Program program;
+        program.setLogLevel(level);
+        program.loadCSV(fileName);
+    }
+    std::cout.rdbuf(coutBuffer);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_UpdateFromCSV(benchmark::State& state) {
+    // Kopia pliku, do której w każdej iteracji dopisywany jest jeden nowy pomiar
+    const std::string fileName = "bench_follow.csv";
+    {
+        std::ifstream in(scaledCsv(state.range(0)), std::ios::binary);
+        std::ofstream(fileName, std::ios::binary | std::ios::trunc) << in.rdbuf();
+    }
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.enablePrefixIndex(true);
+    int added = 0, duplicates = 0;
+    program.updateFromCSV(fileName, added, duplicates);
+
+    std::int32_t timestamp = Timestamp::fromDateTime(2090, 1, 1, 0, 0);
+    for (auto _ : state) {
+        state.PauseTiming();
+        int year, month, day, hour, minute;
+        Timestamp::toDateTime(timestamp, year, month, day, hour, minute);
+        char line[96];
+        std::snprintf(line, sizeof(line), "%02d.%02d.%04d %d:%02d,\"1\",\"0\",\"2\",\"3\",\"1\"\n",
+                      day, month, year, hour, minute);
+        std::ofstream(fileName, std::ios::app) << line;
+        timestamp += 15;
+        state.ResumeTiming();
+        program.updateFromCSV(fileName, added, duplicates);
+    }
+    std::cout.rdbuf(coutBuffer);
+    std::remove(fileName.c_str());
+}
+
+/**
+ * @brief Generuje `count` rekordów (`SolarGenerator`) co 15 minut począwszy od 2000-01-01 00:00.
+ */
+std::vector<Record> syntheticRecords(long count) {
+    SolarGenerator generator;
+    std::vector<Record> records;
+    records.reserve(static_cast<std::size_t>(count));
+    for (long i = 0; i < count; ++i) records.push_back(generator.next(static_cast<std::int32_t>(i * 15)));
+    return records;
+}
+
+/**
+ * @brief Suma produkcji w zakresie `[from, to]` liczona przez przejście map drzewa.
+ */
+double treeRangeSum(const Tree& tree, std::int32_t from, std::int32_t to) {
+    int fromYear, fromMonth, fromDay, toYear, toMonth, toDay, hour, minute;
+    Timestamp::toDateTime(from, fromYear, fromMonth, fromDay, hour, minute);
+    Timestamp::toDateTime(to, toYear, toMonth, toDay, hour, minute);
+    const int fromKey = fromYear * 10000 + fromMonth * 100 + fromDay;
+    const int toKey = toYear * 10000 + toMonth * 100 + toDay;
+
+    double sum = 0.0;
+    for (auto y = tree.years.lower_bound(fromYear); y != tree.years.end() && y->first <= toYear; ++y)
+        for (const auto& [monthKey, month] : y->second.months)
+            for (const auto& [dayKey, day] : month.days) {
+                const int key = y->first * 10000 + monthKey * 100 + dayKey;
+                if (key < fromKey || key > toKey) continue;
+                for (const auto& [quarterKey, quarter] : day.quarters)
+                    for (std::size_t i = 0; i < quarter.size(); ++i)
+                        if (quarter.timestamps[i] >= from && quarter.timestamps[i] <= to) sum += quarter.produkcja[i];
+            }
+    return sum;
+}
+
+void BM_TreeInsert(benchmark::State& state) {
+    const std::vector<Record> records = syntheticRecords(state.range(0));
+    for (auto _ : state) {
+        Tree tree;
+        for (const Record& record : records) tree.addRecord(record);
+        benchmark::DoNotOptimize(tree.years.size());
+    }
+    reportPeakMemory(state);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_TreeArena(benchmark::State& state) {
+    // Wczytanie przeskalowanego ChartExport.csv do drzewa: range(1) == 0 - zwykłe alokacje
+    // (`new_delete_resource`), range(1) == 1 - arena drzewa. Czas iteracji to parsowanie i budowa
+    // drzewa; liczniki: alokacje sterty i zaalokowane bajty podczas wczytywania, czas zniszczenia
+    // drzewa oraz szczytowa pamięć rezydentna procesu (porównywalna tylko przy uruchomieniu
+    // jednego wariantu, np. --benchmark_filter=BM_TreeArena/1048576/0).
+    const std::string fileName = scaledCsv(state.range(0));
+    const bool arena = state.range(1) != 0;
+
+    double allocations = 0.0, bytes = 0.0, teardown = 0.0;
+    std::int64_t rows = 0;
+    for (auto _ : state) {
+        const std::size_t allocationsBefore = heapAllocations.load();
+        const std::size_t bytesBefore = heapBytes.load();
+        std::unique_ptr<Tree> tree = arena
+            ? std::make_unique<Tree>()
+            : std::make_unique<Tree>(std::shared_ptr<std::pmr::memory_resource>(std::shared_ptr<void>(),
+                                                                                  std::pmr::new_delete_resource()));
+        MappedFile file(fileName);
+        const char* p = file.data();
+        const char* const end = p + file.size();
+        Record record;
+        rows = 0;
+        while (p < end) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            if (eol == nullptr) eol = end;
+            if (Program::parseLine(p, eol, record)) {
+                tree->addRecord(record);
+                ++rows;
+            }
+            p = eol + 1;
+        }
+        benchmark::DoNotOptimize(tree->years.size());
+
+        state.PauseTiming();
+        allocations = static_cast<double>(heapAllocations.load() - allocationsBefore);
+        bytes = static_cast<double>(heapBytes.load() - bytesBefore);
+        const auto start = std::chrono::steady_clock::now();
+        tree.reset();
+        teardown = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        state.ResumeTiming();
+    }
+    state.counters["allocs"] = allocations;
+    state.counters["heap_MB"] = bytes / (1 << 20);
+    state.counters["teardown_ms"] = teardown;
+    reportPeakMemory(state);
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+
+void BM_FlatTreeInsert(benchmark::State& state) {
+    const std::vector<Record> records = syntheticRecords(state.range(0));
+    for (auto _ : state) {
+        FlatTree flat;
+        for (const Record& record : records) flat.addRecord(record);
+        benchmark::DoNotOptimize(flat.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_TreeRangeSum(benchmark::State& state) {
+    Tree tree;
+    for (const Record& record : syntheticRecords(state.range(0))) tree.addRecord(record);
+    const std::int32_t span = static_cast<std::int32_t>(state.range(0) * 15);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::int32_t> start(0, span - 7 * Timestamp::minutesPerDay);
+    for (auto _ : state) {
+        const std::int32_t from = start(rng);
+        benchmark::DoNotOptimize(treeRangeSum(tree, from, from + 7 * Timestamp::minutesPerDay));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_FlatTreeRangeSum(benchmark::State& state) {
+    FlatTree flat;
+    for (const Record& record : syntheticRecords(state.range(0))) flat.addRecord(record);
+    const std::int32_t span = static_cast<std::int32_t>(state.range(0) * 15);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::int32_t> start(0, span - 7 * Timestamp::minutesPerDay);
+    for (auto _ : state) {
+        const std::int32_t from = start(rng);
+        const FlatTree::Range range = flat.range(from, from + 7 * Timestamp::minutesPerDay);
+        double sum = 0.0;
+        for (std::size_t i = range.first; i < range.second; ++i) sum += flat.produkcja[i];
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_TreeAggregateRange(benchmark::State& state) {
+    Tree tree;
+    for (const Record& record : syntheticRecords(state.range(0))) tree.addRecord(record);
+    const std::int32_t span = static_cast<std::int32_t>(state.range(0) * 15);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::int32_t> start(0, span - 7 * Timestamp::minutesPerDay);
+    for (auto _ : state) {
+        const std::int32_t from = start(rng);
+        benchmark::DoNotOptimize(tree.aggregate(from, from + 7 * Timestamp::minutesPerDay, 4));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_TreeAggregateFields(benchmark::State& state) {
+    // Agregaty wszystkich wielkości tygodnia: range(1) == 0 - pięć zapytań o jedną wielkość,
+    // 1 - jeden przegląd drzewa (`Tree::aggregate(from, to)`)
+    Tree tree;
+    for (const Record& record : syntheticRecords(state.range(0))) tree.addRecord(record);
+    const std::int32_t span = static_cast<std::int32_t>(state.range(0) * 15);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::int32_t> start(0, span - 7 * Timestamp::minutesPerDay);
+    for (auto _ : state) {
+        const std::int32_t from = start(rng), to = from + 7 * Timestamp::minutesPerDay;
+        if (state.range(1) == 0) {
+            for (int field = 0; field < Record::fieldCount; ++field) benchmark::DoNotOptimize(tree.aggregate(from, to, field));
+        } else {
+            benchmark::DoNotOptimize(tree.aggregate(from, to));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_TreeAggregateMonth(benchmark::State& state) {
+    Tree tree;
+    for (const Record& record : syntheticRecords(state.range(0))) tree.addRecord(record);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> month(0, static_cast<int>(state.range(0) / (96 * 31)) - 1);
+    for (auto _ : state) {
+        const int index = month(rng);
+        const int year = 2000 + index / 12, m = index % 12 + 1;
+        const std::int32_t from = Timestamp::fromDateTime(year, m, 1, 0, 0);
+        const std::int32_t to = (m == 12 ? Timestamp::fromDateTime(year + 1, 1, 1, 0, 0)
+                                         : Timestamp::fromDateTime(year, m + 1, 1, 0, 0)) - 1;
+        benchmark::DoNotOptimize(tree.aggregate(from, to, 1));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RollupSeries(benchmark::State& state) {
+    // Szereg dobowy (range(1) == 0) lub miesięczny (1) dla całych danych (ok. 30 lat przy 2^20
+    // rekordach); range(2) == 0 - pusta pamięć okien w każdej iteracji, 1 - okna z pamięci
+    static Tree tree;
+    if (tree.years.empty()) {
+        for (const Record& record : syntheticRecords(state.range(0))) tree.addRecord(record);
+    }
+    const RollupCache::Source source = [](std::int32_t from, std::int32_t to) { return tree.aggregate(from, to); };
+    const Resolution resolution = state.range(1) == 0 ? Resolution::daily() : Resolution::monthly();
+    const std::int32_t to = static_cast<std::int32_t>(state.range(0) * 15) - 1;
+    RollupCache warm;
+    std::size_t buckets = 0;
+    for (auto _ : state) {
+        RollupCache cold;
+        RollupCache& cache = state.range(2) == 0 ? cold : warm;
+        const std::vector<RollupBucket> series = cache.resample(0, to, resolution, source, cache.generation());
+        buckets = series.size();
+        benchmark::DoNotOptimize(series.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(buckets));
+}
+
+/**
+ * @brief Wsad 1000 zapytań (sumy, średnie, porównania i wyszukiwania) na danych z pliku 2^20 wierszy.
+ *
+ * Przedziały są losowane z puli 200 okresów (dzień do roku), więc część z nich się powtarza -
+ * licznik `unique` podaje liczbę faktycznie policzonych przedziałów. range(1) - liczba wątków;
+ * `items_per_second` to przepustowość w zapytaniach na sekundę.
+ */
+void BM_BatchQueries(benchmark::State& state) {
+    const Program& program = loadedProgram(state.range(0));
+    const std::int32_t span = static_cast<std::int32_t>(state.range(0) * 15);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::int32_t> day(0, span / Timestamp::minutesPerDay - 366);
+    std::uniform_int_distribution<int> length(1, 365), pick(0, 199), kind(0, 19), field(0, Record::fieldCount - 1);
+    std::vector<std::string> periods;
+    for (int i = 0; i < 200; ++i) {
+        const std::int32_t from = day(rng) * Timestamp::minutesPerDay;
+        const std::int32_t to = from + length(rng) * Timestamp::minutesPerDay - 1;
+        periods.push_back(Timestamp::formatDate(from) + " " + Timestamp::formatTime(from) + " " +
+                          Timestamp::formatDate(to) + " " + Timestamp::formatTime(to));
+    }
+    std::ostringstream text;
+    for (int i = 0; i < 1000; ++i) {
+        const int k = kind(rng);
+        const std::string type = Record::fieldName(field(rng));
+        if (k < 8) text << "sum " << type << " " << periods[pick(rng)] << "\n";
+        else if (k < 16) text << "avg " << type << " " << periods[pick(rng)] << "\n";
+        else if (k < 19) text << "compare " << type << " " << periods[pick(rng)] << " " << periods[pick(rng)] << "\n";
+        else text << "search pobor 400 0.5 " << periods[pick(rng)] << "\n";
+    }
+    std::istringstream input(text.str());
+    std::vector<BatchQuery::Query> queries;
+    BatchQuery::parse(input, queries);
+
+    std::vector<BatchQuery::Result> results;
+    BatchQuery::Stats stats;
+    for (auto _ : state) {
+        stats = BatchQuery::execute(program, queries, results, static_cast<unsigned>(state.range(1)));
+        benchmark::DoNotOptimize(results.data());
+    }
+    state.counters["unique"] = static_cast<double>(stats.uniqueRanges);
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(queries.size()));
+}
+
+void BM_PrefixSumRange(benchmark::State& state) {
+    Tree tree;
+    for (const Record& record : syntheticRecords(state.range(0))) tree.addRecord(record);
+    PrefixSumIndex index;
+    index.build(tree);
+    const std::int32_t span = static_cast<std::int32_t>(state.range(0) * 15);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::int32_t> point(0, span);
+    for (auto _ : state) {
+        std::int32_t from = point(rng), to = point(rng);
+        if (to < from) std::swap(from, to);
+        benchmark::DoNotOptimize(index.sum(from, to, 4));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Pojedyncze zapytanie programu na danych z pliku `range(0)` wierszy: suma (range(1) == 0),
+ * średnia (1), porównanie dwóch przedziałów (2) lub wyszukiwanie (3).
+ *
+ * Mierzona jest pełna ścieżka zapytania: parsowanie dat, agregacja lub przeszukanie i wypisanie
+ * wyniku (wyjście wyciszone). Przedziały tygodniowe losowane z całych danych; `ns/zapytanie`
+ * to czas iteracji.
+ */
+void BM_ProgramQuery(benchmark::State& state) {
+    Program& program = loadedProgram(state.range(0));
+    const std::int32_t span = static_cast<std::int32_t>(state.range(0) * 15);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<std::int32_t> day(0, span / Timestamp::minutesPerDay - 8);
+    struct Period {
+        std::string startDate, startTime, endDate, endTime;
+    };
+    std::vector<Period> periods;
+    for (int i = 0; i < 256; ++i) {
+        const std::int32_t from = day(rng) * Timestamp::minutesPerDay;
+        const std::int32_t to = from + 7 * Timestamp::minutesPerDay - 15;
+        periods.push_back({ Timestamp::formatDate(from), Timestamp::formatTime(from), Timestamp::formatDate(to),
+                            Timestamp::formatTime(to) });
+    }
+
+    const long kind = state.range(1);
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const Period& p = periods[i++ % periods.size()];
+        const Period& q = periods[(i * 31) % periods.size()];
+        switch (kind) {
+        case 0: program.calculateSum(p.startDate, p.startTime, p.endDate, p.endTime, "produkcja"); break;
+        case 1: program.calculateAverage(p.startDate, p.startTime, p.endDate, p.endTime, "pobor"); break;
+        case 2:
+            program.compareRanges(p.startDate, p.startTime, p.endDate, p.endTime, q.startDate, q.startTime, q.endDate,
+                                  q.endTime, "eksport");
+            break;
+        default: program.searchRecords(400.0, 0.5, p.startDate, p.startTime, p.endDate, p.endTime, "pobor"); break;
+        }
+    }
+    std::cout.rdbuf(coutBuffer);
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Zapytania o cały zakres danych (ok. 30 lat przy 1M rekordów): suma (range(1) == 0)
+ *        lub wyszukiwanie z tolerancją (1), z `range(2)` wątkami zapytań.
+ *
+ * Przedział jest dzielony na miesiące liczone w puli wątków; wynik nie zależy od liczby wątków.
+ */
+void BM_ParallelRange(benchmark::State& state) {
+    Program& program = loadedProgram(state.range(0));
+    program.setQueryThreads(static_cast<unsigned>(state.range(2)));
+    const std::int32_t to = static_cast<std::int32_t>(state.range(0) * 15);
+    const int pobor = Record::fieldIndex("pobor");
+    for (auto _ : state) {
+        if (state.range(1) == 0) benchmark::DoNotOptimize(program.aggregate(0, to, pobor));
+        else benchmark::DoNotOptimize(program.findRecords(400.0, 0.5, 0, to, pobor));
+    }
+    program.setQueryThreads(0);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * @brief Zapytania o anomalie w przedziałach 30-dniowych: top-10 poboru z sieci (range(1) == 0),
+ *        dni bez produkcji 10:00-14:00 (1) i odchylenia eksportu o 3 sigma od okna doby (2).
+ *
+ * Licznik `visited` to średnia liczba rekordów przejrzanych mimo przycinania po minimach
+ * i maksimach węzłów (przedział ma ok. 2880 rekordów; odchylenia przeglądają wszystkie).
+ */
+void BM_AnomalyQuery(benchmark::State& state) {
+    Program& program = loadedProgram(state.range(0));
+    const std::int32_t span = static_cast<std::int32_t>(state.range(0) * 15);
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<std::int32_t> day(0, span / Timestamp::minutesPerDay - 31);
+    std::vector<std::int32_t> starts;
+    for (int i = 0; i < 64; ++i) starts.push_back(day(rng) * Timestamp::minutesPerDay);
+
+    const long kind = state.range(1);
+    const int pobor = Record::fieldIndex("pobor"), produkcja = Record::fieldIndex("produkcja");
+    const int eksport = Record::fieldIndex("eksport");
+    double visited = 0.0;
+    std::size_t i = 0;
+    for (auto _ : state) {
+        const std::int32_t from = starts[i++ % starts.size()];
+        const std::int32_t to = from + 30 * Timestamp::minutesPerDay - 1;
+        ScanStats stats;
+        switch (kind) {
+        case 0: benchmark::DoNotOptimize(program.topRecords(from, to, pobor, 10, true, &stats)); break;
+        case 1: benchmark::DoNotOptimize(program.flatDays(from, to, produkcja, 0.0, 10 * 60, 14 * 60, &stats)); break;
+        default: benchmark::DoNotOptimize(program.findDeviations(from, to, eksport, 96, 3.0)); break;
+        }
+        visited += static_cast<double>(stats.visited);
+    }
+    state.counters["visited"] = benchmark::Counter(visited, benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Zapis danych do pliku binarnego: kolumny (range(1) == 0) lub skompresowane bloki (1).
+ *
+ * Liczniki: rozmiar pliku i szczytowa pamięć rezydentna procesu.
+ */
+void BM_SaveBinary(benchmark::State& state) {
+    Program& program = loadedProgram(state.range(0));
+    const std::string binaryName = "bench_save_" + std::to_string(state.range(0)) + ".bin";
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    program.enableCompression(state.range(1) != 0);
+    for (auto _ : state) program.saveToBinary(binaryName);
+    program.enableCompression(false);
+    std::cout.rdbuf(coutBuffer);
+    std::error_code error;
+    state.counters["bytes"] = static_cast<double>(std::filesystem::file_size(binaryName, error));
+    std::remove(binaryName.c_str());
+    reportPeakMemory(state);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * @brief Wczytanie danych z pliku binarnego (mapowanie snapshotu) w porównaniu z `BM_LoadCSV`.
+ *
+ * Czas nie powinien zależeć od liczby rekordów - sprawdzany jest tylko nagłówek.
+ */
+void BM_LoadBinary(benchmark::State& state) {
+    const std::string csvName = scaledCsv(state.range(0));
+    const std::string binaryName = "bench_" + std::to_string(state.range(0)) + ".bin";
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    {
+        Program program;
+        program.loadCSV(csvName);
+        program.saveToBinary(binaryName);
+    }
+    for (auto _ : state) {
+        Program program;
+        program.loadFromBinary(binaryName);
+        benchmark::DoNotOptimize(program.getValidRecords());
+    }
+    std::cout.rdbuf(coutBuffer);
+    std::remove(binaryName.c_str());
+    reportPeakMemory(state);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * @brief Agregat tygodniowego przedziału ze snapshotu: kolumny (argument 0) lub skompresowane bloki (1).
+ *
+ * Licznik `bytes` podaje rozmiar pliku snapshotu - do porównania stopnia kompresji.
+ */
+void BM_SnapshotAggregate(benchmark::State& state) {
+    const SnapshotEncoding encoding = static_cast<SnapshotEncoding>(state.range(1));
+    const std::string csvName = scaledCsv(state.range(0));
+    const std::string binaryName = "bench_aggregate_" + std::to_string(state.range(1)) + ".bin";
+    std::string error;
+    {
+        std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+        Program program;
+        program.loadCSV(csvName);
+        std::cout.rdbuf(coutBuffer);
+        Snapshot::write(binaryName, program.getTree(), nullptr, encoding, error);
+    }
+    Snapshot snapshot;
+    if (!snapshot.open(binaryName, error)) {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    std::vector<std::int32_t> timestamps;
+    std::vector<double> values[Record::fieldCount];
+    snapshot.copyTo(timestamps, values);
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<std::int32_t> start(timestamps.front(), timestamps.back() - 7 * Timestamp::minutesPerDay);
+    for (auto _ : state) {
+        const std::int32_t from = start(rng);
+        benchmark::DoNotOptimize(snapshot.aggregate(from, from + 7 * Timestamp::minutesPerDay, 3));
+    }
+    std::ifstream size(binaryName, std::ios::binary | std::ios::ate);
+    state.counters["bytes"] = static_cast<double>(size.tellg());
+    std::remove(binaryName.c_str());
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Kolumna wartości do benchmarków wyszukiwania (wartości z eksportu powtarzane cyklicznie).
+ */
+const std::vector<double>& searchColumn(std::size_t count) {
+    static std::vector<double> column;
+    if (column.size() != count) {
+        const std::vector<Record> records = syntheticRecords(static_cast<long>(count));
+        column.resize(count);
+        for (std::size_t i = 0; i < count; ++i) column[i] = records[i].pobor;
+    }
+    return column;
+}
+
+/**
+ * @brief Filtr `|x - value| <= tolerance` w wybranej implementacji (`SearchKernel::Isa`) - mapa bitowa.
+ */
+void BM_SearchKernel(benchmark::State& state) {
+    const SearchKernel::Isa isa = static_cast<SearchKernel::Isa>(state.range(1));
+    if (!SearchKernel::supported(isa)) {
+        state.SkipWithError("implementacja nieobsługiwana przez procesor");
+        return;
+    }
+    const std::vector<double>& column = searchColumn(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::uint64_t> bitmap;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(SearchKernel::match(column.data(), column.size(), 400.0, 25.0, bitmap, isa));
+    }
+    state.SetLabel(SearchKernel::name(isa));
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<std::int64_t>(sizeof(double)));
+}
+
+/**
+ * @brief Punkt odniesienia: prosta pętla skalarna zbierająca indeksy pasujących wartości.
+ */
+void BM_SearchScalarLoop(benchmark::State& state) {
+    const std::vector<double>& column = searchColumn(static_cast<std::size_t>(state.range(0)));
+    std::vector<std::size_t> indices;
+    for (auto _ : state) {
+        indices.clear();
+        for (std::size_t i = 0; i < column.size(); ++i) {
+            if (std::fabs(column[i] - 400.0) <= 25.0) indices.push_back(i);
+        }
+        benchmark::DoNotOptimize(indices.data());
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<std::int64_t>(sizeof(double)));
+}
+
+/**
+ * @brief Wyszukiwanie z tolerancją w drzewie (`Tree::search`, ścieżka `findRecords` i `searchRecords`).
+ *
+ * Kolumny ćwiartek (do 24 wartości) są filtrowane w wybranej implementacji (`SearchKernel::Isa`);
+ * implementacja skalarna jest punktem odniesienia.
+ */
+void BM_TreeSearch(benchmark::State& state) {
+    const SearchKernel::Isa isa = static_cast<SearchKernel::Isa>(state.range(1));
+    if (!SearchKernel::supported(isa)) {
+        state.SkipWithError("implementacja nieobsługiwana przez procesor");
+        return;
+    }
+    static Tree tree;
+    if (tree.years.empty()) {
+        for (const Record& record : syntheticRecords(state.range(0))) tree.addRecord(record);
+    }
+    const std::int32_t to = static_cast<std::int32_t>(state.range(0) * 15) - 1;
+    std::vector<Record> matches;
+    for (auto _ : state) {
+        matches.clear();
+        tree.search(0, to, 3, 400.0, 0.5, matches, isa);
+        benchmark::DoNotOptimize(matches.data());
+    }
+    state.SetLabel(SearchKernel::name(isa));
+    state.counters["matches"] = static_cast<double>(matches.size());
+    state.SetBytesProcessed(state.iterations() * state.range(0) * static_cast<std::int64_t>(sizeof(double)));
+}
+
+/**
+ * @brief Drzewo współdzielone przez wątki benchmarku odczytów.
+ */
+ConcurrentTree& sharedConcurrentTree() {
+    static ConcurrentTree* tree = [] {
+        ConcurrentTree* result = new ConcurrentTree();
+        Tree batch;
+        for (const Record& record : syntheticRecords(1 << 18)) batch.addRecord(record);
+        result->merge(std::move(batch));
+        return result;
+    }();
+    return *tree;
+}
+
+void BM_ConcurrentTreeReaders(benchmark::State& state) {
+    // Odczyty jednodniowych przedziałów z wielu wątków; przy range(0) == 1 wątek 0 równocześnie
+    // dopisuje rekordy (każda paczka to nowa wersja drzewa)
+    ConcurrentTree& tree = sharedConcurrentTree();
+    const bool writing = state.range(0) != 0 && state.thread_index() == 0;
+    std::int32_t appended = 1 << 22;
+    std::int64_t day = state.thread_index() * 37;
+    for (auto _ : state) {
+        if (writing) {
+            Tree batch;
+            const std::int32_t timestamp = (appended += 15);
+            batch.addRecord(Record(timestamp, 1, 1, 1, 1, 1));
+            tree.merge(std::move(batch));
+            continue;
+        }
+        const std::int32_t from = static_cast<std::int32_t>(day++ % 2700) * Timestamp::minutesPerDay;
+        benchmark::DoNotOptimize(tree.view().aggregate(from, from + Timestamp::minutesPerDay - 1, 4));
+    }
+    if (!writing) state.SetItemsProcessed(state.iterations());
+}
+
+void BM_MutexTreeReaders(benchmark::State& state) {
+    // Punkt odniesienia: zwykłe drzewo chronione muteksem
+    static Tree tree = [] {
+        Tree result;
+        for (const Record& record : syntheticRecords(1 << 18)) result.addRecord(record);
+        return result;
+    }();
+    static std::mutex mutex;
+    std::int64_t day = state.thread_index() * 37;
+    for (auto _ : state) {
+        const std::int32_t from = static_cast<std::int32_t>(day++ % 2700) * Timestamp::minutesPerDay;
+        std::lock_guard<std::mutex> lock(mutex);
+        benchmark::DoNotOptimize(tree.aggregate(from, from + Timestamp::minutesPerDay - 1, 4));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * @brief Tworzy katalog z `sites` eksportami instalacji (dowiązania do ChartExport.csv).
+ */
+std::string fleetDirectory(long sites) {
+    const std::string directory = "bench_fleet_" + std::to_string(sites);
+    if (std::filesystem::exists(directory)) return directory;
+    std::filesystem::create_directory(directory);
+    const std::filesystem::path source = std::filesystem::absolute(kSourceCsv);
+    for (long s = 0; s < sites; ++s) {
+        std::filesystem::create_symlink(source, directory + "/site" + std::to_string(s) + ".csv");
+    }
+    return directory;
+}
+
+void BM_FleetLoad(benchmark::State& state) {
+    // Wczytanie katalogu eksportów; licznik rss_per_site_KB to przyrost pamięci rezydentnej
+    // na instalację po wczytaniu (drzewo instalacji z ok. 6000 rekordów)
+    const std::string directory = fleetDirectory(state.range(0));
+    double perSite = 0.0;
+    for (auto _ : state) {
+        const std::size_t before = residentBytes();
+        Fleet fleet;
+        std::string error;
+        fleet.loadDirectory(directory, error);
+        benchmark::DoNotOptimize(fleet.size());
+        state.PauseTiming();
+        const std::size_t after = residentBytes();
+        perSite = after > before ? static_cast<double>(after - before) / 1024.0 / static_cast<double>(state.range(0)) : 0.0;
+        state.ResumeTiming();
+    }
+    state.counters["rss_per_site_KB"] = perSite;
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_FleetAggregate(benchmark::State& state) {
+    // Suma produkcji całej floty za jeden miesiąc (zapytanie rozdzielane między wątki puli)
+    static Fleet fleet;
+    static const bool loaded = [] {
+        std::string error;
+        return fleet.loadDirectory(fleetDirectory(1000), error);
+    }();
+    benchmark::DoNotOptimize(loaded);
+    const std::int32_t from = Timestamp::fromDateTime(2021, 6, 1, 0, 0);
+    const std::int32_t to = Timestamp::fromDateTime(2021, 7, 1, 0, 0) - 1;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fleet.aggregate(from, to, 4));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(fleet.size()));
+}
+
+} // namespace
+
+BENCHMARK(BM_ParseLegacyGetline)->Arg(1 << 20)->Arg(4 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ParseMapped)->Apply(ingestSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadCSV)->Apply(ingestSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadCSVLogLevel)->ArgsProduct({ { 1 << 20 }, { 0, 1, 2, 3 } })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ValidateRows)->ArgsProduct({ { 1 << 20 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_UpdateFromCSV)->Arg(1 << 20)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LoadCSVParallel)
+    ->ArgsProduct({ { 4 << 20 }, { 1, 2, 4, 8, 16, 32 } })
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_TreeInsert)->Apply(ingestSizes)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TreeArena)->ArgsProduct({ { 1 << 20 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FlatTreeInsert)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TreeRangeSum)->Arg(1 << 20);
+BENCHMARK(BM_FlatTreeRangeSum)->Arg(1 << 20);
+BENCHMARK(BM_TreeAggregateRange)->Arg(1 << 20);
+BENCHMARK(BM_TreeAggregateMonth)->Arg(1 << 20);
+BENCHMARK(BM_TreeAggregateFields)->ArgsProduct({ { 1 << 20 }, { 0, 1 } });
+BENCHMARK(BM_RollupSeries)->ArgsProduct({ { 1 << 20 }, { 0, 1 }, { 0, 1 } })->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BatchQueries)->ArgsProduct({ { 1 << 20 }, { 1, 4 } })->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ProgramQuery)->ArgsProduct({ { 1 << 20 }, { 0, 1, 2, 3 } });
+BENCHMARK(BM_ParallelRange)->ArgsProduct({ { 1 << 20 }, { 0, 1 }, { 1, 2, 4 } })->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_AnomalyQuery)->ArgsProduct({ { 1 << 20 }, { 0, 1, 2 } })->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_PrefixSumRange)->Arg(1 << 20);
+BENCHMARK(BM_SnapshotAggregate)->Args({ 1 << 20, 0 })->Args({ 1 << 20, 1 });
+BENCHMARK(BM_SearchKernel)->ArgsProduct({ { 4 << 20 }, { 0, 1, 2 } });
+BENCHMARK(BM_SearchScalarLoop)->Arg(4 << 20);
+BENCHMARK(BM_TreeSearch)->ArgsProduct({ { 1 << 20 }, { 0, 1, 2 } });
+BENCHMARK(BM_ConcurrentTreeReaders)->Arg(0)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_ConcurrentTreeReaders)->Arg(1)->ThreadRange(2, 16)->UseRealTime();
+BENCHMARK(BM_MutexTreeReaders)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_FleetLoad)->Arg(1000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FleetAggregate)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_LoadBinary)->Arg(1 << 20)->Arg(4 << 20)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SaveBinary)->ArgsProduct({ { 1 << 20 }, { 0, 1 } })->Unit(benchmark::kMillisecond);
+
+/**
+ * @brief Uruchamia pomiary; bez `--benchmark_out` wyniki są zapisywane także do benchmark_results.json.
+ */
+int main(int argc, char** argv) {
+    std::vector<char*> args(argv, argv + argc);
+    bool hasOutput = false;
+    for (int i = 1; i < argc; ++i) hasOutput = hasOutput || std::strncmp(argv[i], "--benchmark_out=", 16) == 0;
+    char out[] = "--benchmark_out=benchmark_results.json";
+    char format[] = "--benchmark_out_format=json";
+    if (!hasOutput) {
+        args.push_back(out);
+        args.push_back(format);
+    }
+    int count = static_cast<int>(args.size());
+
+    benchmark::Initialize(&count, args.data());
+    if (benchmark::ReportUnrecognizedArguments(count, args.data())) return 1;
+    benchmark::AddCustomContext("max_rows", std::to_string(maxRows()));
+    benchmark::AddCustomContext("data", "SolarGenerator (kalibracja: ChartExport.csv)");
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,8 @@
+#include "BatchQuery.h"
+
+/**
+ * @brief Punkt wejścia programu: tryb wsadowy (patrz `BatchQuery::commandLine`).
+ */
+int main(int argc, char* argv[]) {
+    return BatchQuery::commandLine(argc, argv);
+}
@@ -1,101 +1,1662 @@
 #include <gtest/gtest.h>
-#include "lineData.hpp"
-#include "treeData.hpp"
+#include "Program.h"
+#include "Anomaly.h"
+#include "Arena.h"
+#include "BatchQuery.h"
+#include "BlockCodec.h"
+#include "ConcurrentTree.h"
+#include "FlatTree.h"
+#include "Fleet.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "PrefixSumIndex.h"
+#include "RowValidator.h"
+#include "SearchKernel.h"
+#include "Snapshot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <memory_resource>
 #include <sstream>
+#include <thread>
 
-// Testy dla klasy LineData
+// Testy dla klasy Record (dawniej LineData)
 class LineDataTest : public ::testing::Test {
 protected:
-    LineData lineData;
+    Record record;
     
     void SetUp() override {
         // Inicjalizacja przykładowych danych
-        lineData = LineData("01.01.2023 12:30", 100.0f, 50.0f, 30.0f, 120.0f, 80.0f);
+        record = Record("2023-01-01", "12:30", 100.0, 50.0, 30.0, 120.0, 80.0);
     }
 };
 
 TEST_F(LineDataTest, GettersTest) {
-    EXPECT_EQ(lineData.getDate(), "01.01.2023 12:30");
-    EXPECT_FLOAT_EQ(lineData.getAutokonsumpcja(), 100.0f);
-    EXPECT_FLOAT_EQ(lineData.getEksport(), 50.0f);
-    EXPECT_FLOAT_EQ(lineData.getImport(), 30.0f);
-    EXPECT_FLOAT_EQ(lineData.getPobor(), 120.0f);
-    EXPECT_FLOAT_EQ(lineData.getProdukcja(), 80.0f);
+    EXPECT_EQ(record.date(), "2023-01-01");
+    EXPECT_EQ(record.time(), "12:30");
+    EXPECT_EQ(record.timestamp, Timestamp::fromDateTime(2023, 1, 1, 12, 30));
+    EXPECT_DOUBLE_EQ(record.autokonsumpcja, 100.0);
+    EXPECT_DOUBLE_EQ(record.eksport, 50.0);
+    EXPECT_DOUBLE_EQ(record.import_, 30.0);
+    EXPECT_DOUBLE_EQ(record.pobor, 120.0);
+    EXPECT_DOUBLE_EQ(record.produkcja, 80.0);
+    EXPECT_DOUBLE_EQ(record.field(Record::fieldIndex("import")), 30.0);
+    EXPECT_DOUBLE_EQ(record.get<2>(), 30.0);
+    for (int field = 0; field < Record::fieldCount; ++field) {
+        EXPECT_DOUBLE_EQ(Record::withField(field, [&](auto f) { return record.get<decltype(f)::value>(); }),
+                         record.field(field));
+    }
 }
 
-TEST_F(LineDataTest, SerializeTest) {
-    std::ostringstream oss;
-    lineData.serialize(oss);
-    EXPECT_EQ(oss.str(), "01.01.2023 12:30,100.0,50.0,30.0,120.0,80.0\n");
+TEST_F(LineDataTest, ToStringTest) {
+    EXPECT_EQ(record.toString(),
+              "Record(date=2023-01-01, time=12:30, autokonsumpcja=100, eksport=50, import=30, pobor=120, produkcja=80)");
 }
 
-// Testy dla klasy TreeData
+// Testy dla klasy Tree (dawniej TreeData)
 class TreeDataTest : public ::testing::Test {
 protected:
-    TreeData treeData;
+    Tree tree;
 
     void SetUp() override {
         // Dodanie przykładowych danych do drzewa
-        LineData lineData1("01.01.2023 12:30", 100.0f, 50.0f, 30.0f, 120.0f, 80.0f);
-        LineData lineData2("01.01.2023 13:30", 110.0f, 55.0f, 35.0f, 130.0f, 85.0f);
-        treeData.addData(lineData1);
-        treeData.addData(lineData2);
+        tree.addRecord(Record("2023-01-01", "12:30", 100.0, 50.0, 30.0, 120.0, 80.0));
+        tree.addRecord(Record("2023-01-01", "13:30", 110.0, 55.0, 35.0, 130.0, 85.0));
     }
+
+    static std::int32_t at(int hour, int minute) { return Timestamp::fromDateTime(2023, 1, 1, hour, minute); }
 };
 
 TEST_F(TreeDataTest, AddDataTest) {
     // Test dodawania danych
-    const auto& years = treeData.getYears();
-    ASSERT_EQ(years.size(), 1);  // Sprawdzamy, czy dodany został jeden rok
-    const auto& year = years.begin()->second;
+    ASSERT_EQ(tree.years.size(), 1);  // Sprawdzamy, czy dodany został jeden rok
+    const auto& year = tree.years.begin()->second;
     ASSERT_EQ(year.months.size(), 1);  // Jeden miesiąc
     const auto& month = year.months.begin()->second;
     ASSERT_EQ(month.days.size(), 1);  // Jeden dzień
     const auto& day = month.days.begin()->second;
-    ASSERT_EQ(day.quarters.size(), 2);  // Dwa kwartały
+    ASSERT_EQ(day.quarters.size(), 1);  // Jedna ćwiartka (12:00 - 17:45)
+    EXPECT_EQ(day.quarters.begin()->second.size(), 2);  // Dwa rekordy
 }
 
 TEST_F(TreeDataTest, CalculateSumsBetweenDatesTest) {
     // Test obliczania sum dla danych w danym przedziale czasowym
-    float autokonsumpcjaSum = 0.0f, eksportSum = 0.0f, importSum = 0.0f, poborSum = 0.0f, produkcjaSum = 0.0f;
-    treeData.calculateSumsBetweenDates("01.01.2023 12:00", "01.01.2023 14:00", autokonsumpcjaSum, eksportSum, importSum, poborSum, produkcjaSum);
-
-    EXPECT_FLOAT_EQ(autokonsumpcjaSum, 210.0f);
-    EXPECT_FLOAT_EQ(eksportSum, 105.0f);
-    EXPECT_FLOAT_EQ(importSum, 65.0f);
-    EXPECT_FLOAT_EQ(poborSum, 250.0f);
-    EXPECT_FLOAT_EQ(produkcjaSum, 165.0f);
+    const Aggregates sums = tree.aggregate(at(12, 0), at(14, 0));
+    EXPECT_DOUBLE_EQ(sums[0].sum, 210.0);
+    EXPECT_DOUBLE_EQ(sums[1].sum, 105.0);
+    EXPECT_DOUBLE_EQ(sums[2].sum, 65.0);
+    EXPECT_DOUBLE_EQ(sums[3].sum, 250.0);
+    EXPECT_DOUBLE_EQ(sums[4].sum, 165.0);
 }
 
 TEST_F(TreeDataTest, CalculateAveragesBetweenDatesTest) {
     // Test obliczania średnich dla danych w danym przedziale czasowym
-    float autokonsumpcjaAvg = 0.0f, eksportAvg = 0.0f, importAvg = 0.0f, poborAvg = 0.0f, produkcjaAvg = 0.0f;
-    treeData.calculateAveragesBetweenDates("01.01.2023 12:00", "01.01.2023 14:00", autokonsumpcjaAvg, eksportAvg, importAvg, poborAvg, produkcjaAvg);
-
-    EXPECT_FLOAT_EQ(autokonsumpcjaAvg, 105.0f);
-    EXPECT_FLOAT_EQ(eksportAvg, 52.5f);
-    EXPECT_FLOAT_EQ(importAvg, 32.5f);
-    EXPECT_FLOAT_EQ(poborAvg, 125.0f);
-    EXPECT_FLOAT_EQ(produkcjaAvg, 82.5f);
+    const Aggregates averages = tree.aggregate(at(12, 0), at(14, 0));
+    EXPECT_DOUBLE_EQ(averages[0].average(), 105.0);
+    EXPECT_DOUBLE_EQ(averages[1].average(), 52.5);
+    EXPECT_DOUBLE_EQ(averages[2].average(), 32.5);
+    EXPECT_DOUBLE_EQ(averages[3].average(), 125.0);
+    EXPECT_DOUBLE_EQ(averages[4].average(), 82.5);
 }
 
 TEST_F(TreeDataTest, CompareDataBetweenDatesTest) {
-    // Test porównania danych dla dwóch przedziałów czasowych
-    float autokonsumpcjaDiff = 0.0f, eksportDiff = 0.0f, importDiff = 0.0f, poborDiff = 0.0f, produkcjaDiff = 0.0f;
-    treeData.compareDataBetweenDates("01.01.2023 12:00", "01.01.2023 14:00", "01.01.2023 12:30", "01.01.2023 13:30", autokonsumpcjaDiff, eksportDiff, importDiff, poborDiff, produkcjaDiff);
-
-    EXPECT_FLOAT_EQ(autokonsumpcjaDiff, 10.0f);  // 110 - 100
-    EXPECT_FLOAT_EQ(eksportDiff, 5.0f);         // 55 - 50
-    EXPECT_FLOAT_EQ(importDiff, 5.0f);          // 35 - 30
-    EXPECT_FLOAT_EQ(poborDiff, 10.0f);          // 130 - 120
-    EXPECT_FLOAT_EQ(produkcjaDiff, 5.0f);       // 85 - 80
+    // Test porównania danych dla dwóch przedziałów czasowych (pojedyncze pomiary 13:30 i 12:30)
+    const Aggregates first = tree.aggregate(at(12, 30), at(12, 30));
+    const Aggregates second = tree.aggregate(at(13, 30), at(13, 30));
+    EXPECT_DOUBLE_EQ(second[0].sum - first[0].sum, 10.0);  // 110 - 100
+    EXPECT_DOUBLE_EQ(second[1].sum - first[1].sum, 5.0);   // 55 - 50
+    EXPECT_DOUBLE_EQ(second[2].sum - first[2].sum, 5.0);   // 35 - 30
+    EXPECT_DOUBLE_EQ(second[3].sum - first[3].sum, 10.0);  // 130 - 120
+    EXPECT_DOUBLE_EQ(second[4].sum - first[4].sum, 5.0);   // 85 - 80
 }
 
 TEST_F(TreeDataTest, SearchRecordsWithToleranceTest) {
     // Test wyszukiwania danych z tolerancją
-    auto result = treeData.searchRecordsWithTolerance("01.01.2023 12:00", "01.01.2023 14:00", 100.0f, 15.0f);
+    std::vector<Record> result;
+    tree.search(at(12, 0), at(14, 0), Record::fieldIndex("autokonsumpcja"), 100.0, 15.0, result);
     
     ASSERT_EQ(result.size(), 2);  // Sprawdzamy, czy są dwa rekordy w przedziale
-    EXPECT_FLOAT_EQ(result[0].getAutokonsumpcja(), 100.0f);
-    EXPECT_FLOAT_EQ(result[1].getAutokonsumpcja(), 110.0f);
+    EXPECT_DOUBLE_EQ(result[0].autokonsumpcja, 100.0);
+    EXPECT_DOUBLE_EQ(result[1].autokonsumpcja, 110.0);
+}
+
+// Testy dla klasy Program (wczytywanie danych z CSV)
+
+// Spłaszcza drzewo do listy rekordów w kolejności przechodzenia (rok, miesiąc, dzień, ćwiartka)
+static std::vector<std::string> flattenTree(const Tree& tree) {
+    std::vector<std::string> result;
+    for (const auto& [yearKey, year] : tree.years)
+        for (const auto& [monthKey, month] : year.months)
+            for (const auto& [dayKey, day] : month.days)
+                for (const auto& [quarterKey, quarter] : day.quarters)
+                    for (std::size_t i = 0; i < quarter.size(); ++i)
+                        result.push_back(quarter.record(i).toString());
+    return result;
+}
+
+TEST(ProgramTest, ParseLineExportFormat) {
+    Record record;
+    const std::string line = "01.10.2020 6:15,\"12.5\",\"0\",\"403.5656\",\"416.0656\",\"12.5\"";
+    ASSERT_TRUE(Program::parseLine(line.data(), line.data() + line.size(), record));
+    EXPECT_EQ(record.date(), "2020-10-01");
+    EXPECT_EQ(record.time(), "06:15");
+    EXPECT_DOUBLE_EQ(record.autokonsumpcja, 12.5);
+    EXPECT_DOUBLE_EQ(record.eksport, 0.0);
+    EXPECT_DOUBLE_EQ(record.import_, 403.5656);
+    EXPECT_DOUBLE_EQ(record.pobor, 416.0656);
+    EXPECT_DOUBLE_EQ(record.produkcja, 12.5);
+
+    const std::string bad = "07.10.2021 17:30,\"xxxx\",\"xxxx\",\"yyyy\",\"yyyy\"";
+    EXPECT_FALSE(Program::parseLine(bad.data(), bad.data() + bad.size(), record));
+    const std::string truncated = "15.10.2021 11:00,\"363.4795\",\"0\",\"363.4795\",\"4473\"";
+    EXPECT_FALSE(Program::parseLine(truncated.data(), truncated.data() + truncated.size(), record));
+}
+
+TEST(ProgramTest, ParallelLoadMatchesSerial) {
+    // Plik większy niż kilka MB, aby wczytywanie równoległe faktycznie podzieliło go na fragmenty
+    const std::string fileName = "test_parallel_load.csv";
+    {
+        std::ofstream out(fileName);
+        out << "Time,Autokonsumpcja (W),Eksport (W),Import (W),Pobór (W),Produkcja (W)\n";
+        char line[128];
+        for (int i = 0; i < 100000; ++i) {
+            const int day = i / 96 % 28 + 1, month = i / (96 * 28) % 12 + 1, minutes = i % 96 * 15;
+            const int year = 2021 + i / (96 * 28 * 12);
+            std::snprintf(line, sizeof(line), "%02d.%02d.%d %d:%02d,\"%d\",\"0\",\"%d.25\",\"1\",\"2\"\r\n",
+                          day, month, year, minutes / 60, minutes % 60, i, i % 7);
+            out << line;
+            if (i % 9973 == 0) out << "01.01.2021 0:00,\"x\"\n\n";
+        }
+    }
+
+    Program serial;
+    serial.loadCSV(fileName, 1);
+    Program parallel;
+    parallel.loadCSV(fileName, 4);
+    std::remove(fileName.c_str());
+
+    EXPECT_EQ(serial.getValidRecords(), 100000);
+    EXPECT_EQ(serial.getInvalidRecords(), 11);
+    EXPECT_EQ(parallel.getValidRecords(), serial.getValidRecords());
+    EXPECT_EQ(parallel.getInvalidRecords(), serial.getInvalidRecords());
+    EXPECT_EQ(flattenTree(parallel.getTree()), flattenTree(serial.getTree()));
+}
+
+TEST(ProgramTest, UpdateFromCSVReadsOnlyAppendedRows) {
+    const std::string fileName = "test_follow.csv";
+    const auto row = [](int minutes, int value) {
+        char line[96];
+        std::snprintf(line, sizeof(line), "02.05.2021 %d:%02d,\"%d\",\"0\",\"1\",\"2\",\"%d\"\n",
+                      minutes / 60, minutes % 60, value, value);
+        return std::string(line);
+    };
+    const auto append = [&fileName](const std::string& text) { std::ofstream(fileName, std::ios::app) << text; };
+    std::ofstream(fileName, std::ios::trunc) << "Time,Autokonsumpcja (W),Eksport (W),Import (W),Pobór (W),Produkcja (W)\n"
+                                             << row(600, 1) << row(615, 2) << row(630, 3);
+
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.loadCSV(fileName);
+    program.enablePrefixIndex(true);
+    std::cout.rdbuf(coutBuffer);
+
+    // Ponowny odczyt wczytanego już pliku nie dubluje danych
+    int added = 0, duplicates = 0;
+    ASSERT_TRUE(program.updateFromCSV(fileName, added, duplicates));
+    EXPECT_EQ(added, 0);
+    EXPECT_EQ(duplicates, 3);
+
+    // Niedokończona linia czeka na znak nowej linii
+    const std::string partial = row(675, 5);
+    append(row(645, 4) + partial.substr(0, 20));
+    ASSERT_TRUE(program.updateFromCSV(fileName, added, duplicates));
+    EXPECT_EQ(added, 1);
+    append(partial.substr(20) + row(615, 2) + "02.05.2021 11:30,\"x\"\n");
+    ASSERT_TRUE(program.updateFromCSV(fileName, added, duplicates));
+    EXPECT_EQ(added, 1);
+    EXPECT_EQ(duplicates, 1);
+    EXPECT_EQ(program.getValidRecords(), 5);
+    EXPECT_EQ(program.getInvalidRecords(), 1);
+
+    // Plik zastąpiony krótszym (rotacja) jest czytany od początku
+    std::ofstream(fileName, std::ios::trunc) << row(690, 6);
+    ASSERT_TRUE(program.updateFromCSV(fileName, added, duplicates));
+    EXPECT_EQ(added, 1);
+
+    const std::int32_t from = Timestamp::fromDateTime(2021, 5, 2, 0, 0), to = Timestamp::fromDateTime(2021, 5, 2, 23, 45);
+    const Aggregate produkcja = program.getTree().aggregate(from, to, 4);
+    EXPECT_EQ(produkcja.count, 6u);
+    EXPECT_DOUBLE_EQ(produkcja.sum, 21.0);
+    std::ostringstream output;
+    std::cout.rdbuf(output.rdbuf());
+    program.calculateSum("2021-05-02", "00:00", "2021-05-02", "23:45", "produkcja");
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_NE(output.str().find(": 21 (rekordów: 6)"), std::string::npos) << output.str();
+
+    // Tryb śledzenia widzi dopisane rekordy bez ponownego wczytywania pliku
+    std::atomic<bool> stop{ false };
+    std::cout.rdbuf(nullptr);
+    std::thread follow([&program, &fileName, &stop] { program.followCSV(fileName, stop, 20); });
+    append(row(705, 7));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    stop = true;
+    follow.join();
+    std::cout.rdbuf(coutBuffer);
+    EXPECT_EQ(program.getValidRecords(), 7);
+    std::remove(fileName.c_str());
+}
+
+// Testy dla klasy Logger
+
+// Wczytuje linie pliku tekstowego
+static std::vector<std::string> readLines(const std::string& fileName) {
+    std::vector<std::string> lines;
+    std::ifstream in(fileName);
+    for (std::string line; std::getline(in, line);) lines.push_back(line);
+    return lines;
+}
+
+TEST(LoggerTest, ConcurrentProducersKeepEveryEntry) {
+    const int threads = 4, perThread = 20000;
+    {
+        // Mały bufor wymusza czekanie producentów na wątek zapisujący
+        Logger logger("test_logger_data.txt", "test_logger_error.txt", LogLevel::All, 64);
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t) {
+            producers.emplace_back([&logger, t] {
+                for (int i = 0; i < perThread; ++i) {
+                    const std::string line = std::to_string(t) + ":" + std::to_string(i);
+                    if (i % 10 == 0) logger.invalidRecord(line.data(), line.size());
+                    else logger.validRecord(line.data(), line.size());
+                }
+            });
+        }
+        for (std::thread& producer : producers) producer.join();
+        const std::string longLine(300, 'x');
+        logger.validRecord(longLine.data(), longLine.size());
+        logger.flush();
+        EXPECT_EQ(readLines("test_logger_data.txt").size(), static_cast<std::size_t>(threads * perThread * 9 / 10 + 1));
+    }
+
+    const std::vector<std::string> data = readLines("test_logger_data.txt");
+    const std::vector<std::string> errors = readLines("test_logger_error.txt");
+    ASSERT_EQ(errors.size(), static_cast<std::size_t>(threads * perThread / 10));
+    EXPECT_EQ(data.back(), "Poprawny rekord: " + std::string(300, 'x'));
+
+    // Wpisy każdego wątku zachowują kolejność
+    std::vector<int> next(threads, 1);
+    for (std::size_t i = 0; i + 1 < data.size(); ++i) {
+        int t = 0, index = 0;
+        ASSERT_EQ(std::sscanf(data[i].c_str(), "Poprawny rekord: %d:%d", &t, &index), 2);
+        ASSERT_EQ(index, next[t]);
+        next[t] = index % 10 == 9 ? index + 2 : index + 1;
+    }
+    EXPECT_EQ(errors.front().rfind("Błędny rekord: ", 0), 0u);
+    std::remove("test_logger_data.txt");
+    std::remove("test_logger_error.txt");
+}
+
+TEST(LoggerTest, LoadCSVRespectsLogLevel) {
+    const std::string fileName = "test_log_level.csv";
+    {
+        std::ofstream out(fileName);
+        out << "01.10.2020 6:15,\"1\",\"0\",\"2\",\"3\",\"1\"\n";
+        out << "01.10.2020 6:30,\"x\"\n";
+        out << "01.10.2020 6:45,\"1\",\"0\",\"2\",\"3\",\"1\"\n";
+    }
+    const std::string summary = "Podsumowanie: poprawne rekordy: 2, błędne rekordy: 1";
+
+    Program all;
+    all.loadCSV(fileName);
+    EXPECT_EQ(readLines("log_data.txt"), (std::vector<std::string>{ "Poprawny rekord: 01.10.2020 6:15,\"1\",\"0\",\"2\",\"3\",\"1\"",
+                                                                    "Poprawny rekord: 01.10.2020 6:45,\"1\",\"0\",\"2\",\"3\",\"1\"",
+                                                                    summary }));
+    EXPECT_EQ(readLines("log_error_data.txt"), std::vector<std::string>{ "Błędny rekord (linia 2, niepoprawny format): 01.10.2020 6:30,\"x\"" });
+
+    Program errors;
+    errors.setLogLevel(LogLevel::Errors);
+    errors.loadCSV(fileName);
+    EXPECT_EQ(readLines("log_data.txt"), std::vector<std::string>{ summary });
+    EXPECT_EQ(readLines("log_error_data.txt").size(), 1u);
+
+    Program counters;
+    counters.setLogLevel(LogLevel::Summary);
+    counters.loadCSV(fileName);
+    EXPECT_EQ(readLines("log_data.txt"), std::vector<std::string>{ summary });
+    EXPECT_TRUE(readLines("log_error_data.txt").empty());
+    EXPECT_EQ(counters.getValidRecords(), 2);
+    std::remove(fileName.c_str());
+}
+
+// Testy dla klasy Tree (kolumnowe ćwiartki)
+
+TEST(TreeTest, TimestampRoundTrip) {
+    EXPECT_EQ(Timestamp::fromDateTime(2000, 1, 1, 0, 0), 0);
+    EXPECT_EQ(Timestamp::fromDateTime(2000, 3, 1, 0, 0), (31 + 29) * Timestamp::minutesPerDay);
+    const std::int32_t ts = Timestamp::fromDateTime(2024, 2, 29, 23, 45);
+    EXPECT_EQ(Timestamp::formatDate(ts), "2024-02-29");
+    EXPECT_EQ(Timestamp::formatTime(ts), "23:45");
+    EXPECT_EQ(Timestamp::formatDate(Timestamp::fromDateTime(1999, 12, 31, 12, 0)), "1999-12-31");
+}
+
+TEST(TreeTest, TimestampParseRejectsDaysPastMonthEnd) {
+    std::int32_t ts = -1;
+    EXPECT_FALSE(Timestamp::parse("2023-02-31", "12:00", ts));
+    EXPECT_FALSE(Timestamp::parse("2023-02-29", "12:00", ts));
+    EXPECT_FALSE(Timestamp::parse("2023-04-31", "12:00", ts));
+    EXPECT_EQ(ts, -1);
+    ASSERT_TRUE(Timestamp::parse("2024-02-29", "12:00", ts));
+    EXPECT_EQ(ts, Timestamp::fromDateTime(2024, 2, 29, 12, 0));
+    ASSERT_TRUE(Timestamp::parse("2023-01-31", "9:05", ts));
+    EXPECT_EQ(Timestamp::formatDate(ts), "2023-01-31");
+}
+
+TEST(TreeTest, ColumnarQuarterKeepsRecords) {
+    Tree tree;
+    tree.addRecord(Record("2021-10-15", "13:45", 1.0, 2.0, 3.0, 4.0, 5.0));
+    tree.addRecord(Record("2021-10-15", "12:00", 6.0, 7.0, 8.0, 9.0, 10.0));
+    tree.addRecord(Record("2021-10-15", "05:45", 0.5, 0.0, 0.0, 0.0, 0.0));
+
+    const Tree::Day& day = tree.years.at(2021).months.at(10).days.at(15);
+    ASSERT_EQ(day.quarters.size(), 2u);
+    const Tree::Quarter& afternoon = day.quarters.at(2);
+    ASSERT_EQ(afternoon.size(), 2u);
+    EXPECT_DOUBLE_EQ(afternoon.produkcja[1], 10.0);
+    EXPECT_EQ(afternoon.record(0).toString(), Record("2021-10-15", "13:45", 1.0, 2.0, 3.0, 4.0, 5.0).toString());
+    EXPECT_EQ(day.quarters.at(0).record(0).time(), "05:45");
+}
+
+TEST(TreeTest, ArenaKeepsDataAcrossCopiesAndMerges) {
+    // Punkt odniesienia: drzewo ze zwykłymi alokacjami na stercie
+    Tree reference(std::shared_ptr<std::pmr::memory_resource>(std::shared_ptr<void>(), std::pmr::new_delete_resource()));
+    Tree first;
+    Tree second(first.resource());
+    const int count = 400 * 96;
+    for (int i = 0; i < count; ++i) {
+        const std::int32_t ts = Timestamp::fromDateTime(2021, 1, 1, 0, 0) + i * 15;
+        const Record record(Timestamp::formatDate(ts), Timestamp::formatTime(ts), i % 7, i % 11, 1.0, 2.0, i % 13);
+        reference.addRecord(record);
+        (i < count / 2 ? first : second).addRecord(record);
+    }
+
+    // Scalanie drzew ze wspólną areną przenosi węzły
+    first.merge(std::move(second));
+    EXPECT_TRUE(second.years.empty());
+    const std::vector<std::string> expected = flattenTree(reference);
+    EXPECT_EQ(flattenTree(first), expected);
+    const Arena& arena = dynamic_cast<const Arena&>(*first.resource());
+    EXPECT_LT(arena.blockCount(), 20u);
+    EXPECT_GE(arena.reservedBytes(), arena.allocatedBytes());
+
+    // Kopia, przeniesienie i przypisanie między różnymi arenami
+    Tree assigned;
+    {
+        Tree copy = first;
+        EXPECT_NE(copy.resource(), first.resource());
+        Tree moved(std::move(copy));
+        assigned = moved;
+    }
+    EXPECT_EQ(flattenTree(assigned), expected);
+    Tree other;
+    other.addRecord(Record("2020-06-01", "12:00", 1.0, 1.0, 1.0, 1.0, 1.0));
+    other.merge(std::move(assigned));
+    EXPECT_EQ(other.stats[4].count, static_cast<std::size_t>(count + 1));
+    EXPECT_DOUBLE_EQ(other.aggregate(0, Timestamp::fromDateTime(2030, 1, 1, 0, 0), 4).sum,
+                     reference.stats[4].sum + 1.0);
+}
+
+// Testy dla klasy ConcurrentTree
+
+TEST(ConcurrentTreeTest, ReadersSeeConsistentVersions) {
+    // Piszący dodaje dzień po dniu (96 rekordów o wartości 1), czytelnicy sprawdzają,
+    // że każda wersja zawiera całe dni i że dane w obrębie widoku się nie zmieniają
+    ConcurrentTree tree;
+    const int days = 400;
+    const std::int32_t from = Timestamp::fromDateTime(2020, 1, 1, 0, 0);
+    const std::int32_t to = from + days * Timestamp::minutesPerDay;
+    std::atomic<bool> done{ false };
+    std::atomic<int> failures{ 0 };
+    std::atomic<long> reads{ 0 };
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 4; ++r) {
+        readers.emplace_back([&] {
+            std::size_t previous = 0;
+            while (!done.load()) {
+                const ConcurrentTree::View view = tree.view();
+                const Aggregate all = view.aggregate(from, to, 4);
+                const std::int32_t middle = from + static_cast<std::int32_t>(all.count / 96 / 2) * Timestamp::minutesPerDay;
+                const Aggregate head = view.aggregate(from, middle - 1, 4), tail = view.aggregate(middle, to, 4);
+                if (all.count % 96 != 0 || all.count < previous || all.sum != static_cast<double>(all.count) ||
+                    head.count + tail.count != all.count || view.size() != all.count ||
+                    (all.count > 0 && !view.contains(from + static_cast<std::int32_t>(all.count / 96 - 1) * Timestamp::minutesPerDay))) {
+                    failures++;
+                }
+                previous = all.count;
+                reads++;
+            }
+        });
+    }
+
+    for (int d = 0; d < days; ++d) {
+        Tree batch;
+        for (int i = 0; i < 96; ++i) {
+            const std::int32_t timestamp = from + d * Timestamp::minutesPerDay + i * 15;
+            batch.addRecord(Record(timestamp, 1, 1, 1, 1, 1));
+        }
+        tree.merge(std::move(batch));
+    }
+    done = true;
+    for (std::thread& reader : readers) reader.join();
+
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_GT(reads.load(), 0);
+    const ConcurrentTree::View view = tree.view();
+    EXPECT_EQ(view.size(), static_cast<std::size_t>(days * 96));
+    EXPECT_EQ(view.copy().stats[4].count, static_cast<std::size_t>(days * 96));
+
+    // Dopisanie do istniejącego miesiąca nie zmienia wersji przypiętej wcześniej
+    tree.add(Record("2020-01-01", "00:05", 5, 5, 5, 5, 5));
+    EXPECT_EQ(view.aggregate(from, to, 4).count, static_cast<std::size_t>(days * 96));
+    EXPECT_EQ(tree.view().aggregate(from, to, 4).count, static_cast<std::size_t>(days * 96 + 1));
+    EXPECT_DOUBLE_EQ(tree.view().aggregate(from, from + 10, 4).max, 5.0);
+}
+
+TEST(ConcurrentTreeTest, ManyReadersAndReclaimOnRelease) {
+    // Więcej równocześnie czytających wątków niż stałych miejsc czytelników
+    ConcurrentTree tree;
+    tree.add(Record("2022-03-01", "10:00", 1, 1, 1, 1, 1));
+    const int threads = 300;
+    std::atomic<int> pinned{ 0 };
+    std::atomic<bool> release{ false };
+    std::vector<std::thread> readers;
+    for (int t = 0; t < threads; ++t) {
+        readers.emplace_back([&] {
+            const ConcurrentTree::View view = tree.view();
+            pinned++;
+            while (!release.load()) std::this_thread::yield();
+            if (view.size() != 1) pinned += 1000;
+        });
+    }
+    while (pinned.load() < threads) std::this_thread::yield();
+    tree.add(Record("2022-03-01", "10:15", 1, 1, 1, 1, 1));
+    release = true;
+    for (std::thread& reader : readers) reader.join();
+    EXPECT_EQ(pinned.load(), threads);
+    EXPECT_EQ(tree.view().size(), 2u);
+
+    // Nowy miesiąc z paczki, która dopisuje też do istniejącego miesiąca, jest kopiowany
+    // do własnej areny - arena paczki nie jest przez niego utrzymywana
+    std::weak_ptr<std::pmr::memory_resource> arena;
+    {
+        Tree batch;
+        batch.addRecord(Record("2022-04-01", "10:00", 1, 1, 1, 1, 1));
+        batch.addRecord(Record("2022-03-01", "10:30", 1, 1, 1, 1, 1));
+        arena = batch.resource();
+        tree.merge(std::move(batch));
+    }
+    EXPECT_TRUE(arena.expired());
+    EXPECT_EQ(tree.retiredVersions(), 0u);
+
+    // Paczka z samymi nowymi miesiącami jest przenoszona razem z areną
+    {
+        Tree batch;
+        batch.addRecord(Record("2022-05-01", "10:00", 1, 1, 1, 1, 1));
+        arena = batch.resource();
+        tree.merge(std::move(batch));
+    }
+    EXPECT_FALSE(arena.expired());
+
+    // Wersja wycofana w czasie życia widoku jest zwalniana po jego zniszczeniu, bez kolejnego zapisu
+    {
+        const ConcurrentTree::View view = tree.view();
+        tree.clear();
+        EXPECT_EQ(view.size(), 5u);
+        EXPECT_EQ(tree.retiredVersions(), 1u);
+        EXPECT_FALSE(arena.expired());
+    }
+    EXPECT_EQ(tree.retiredVersions(), 0u);
+    EXPECT_TRUE(arena.expired());
+}
+
+TEST(ConcurrentTreeTest, PrefixIndexMatchesPinnedVersion) {
+    // Suma z indeksów miesięcy widoku musi być równa agregatowi tego samego widoku także
+    // wtedy, gdy piszący równocześnie dopisuje rekordy do tych samych miesięcy
+    ConcurrentTree tree;
+    tree.enablePrefixIndex(true);
+    const std::int32_t from = Timestamp::fromDateTime(2021, 1, 1, 0, 0);
+    const std::int32_t to = Timestamp::fromDateTime(2021, 12, 31, 23, 59);
+    std::atomic<bool> done{ false };
+    std::atomic<int> failures{ 0 };
+    std::thread reader([&] {
+        while (!done.load()) {
+            const ConcurrentTree::View view = tree.view();
+            const Aggregate indexed = view.prefixAggregate(from, to, 2);
+            const Aggregate scanned = view.aggregate(from, to, 2);
+            if (!view.indexed() || indexed.count != scanned.count || indexed.sum != scanned.sum) failures++;
+        }
+    });
+    for (int i = 0; i < 2000; ++i) {
+        // Znaczniki rozrzucone po roku - zapisy trafiają do istniejących miesięcy
+        tree.add(Record(from + (i * 7919) % (365 * 96) * 15, 0, 0, i % 13, 0, 0));
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(failures.load(), 0);
+
+    const ConcurrentTree::View view = tree.view();
+    const Aggregate before = view.prefixAggregate(from, to, 2);
+    EXPECT_EQ(before.count, 2000u);
+    tree.add(Record(to, 0, 0, 100, 0, 0));
+    EXPECT_EQ(view.prefixAggregate(from, to, 2).count, 2000u);
+    EXPECT_DOUBLE_EQ(tree.view().prefixAggregate(from, to, 2).sum, before.sum + 100.0);
+    tree.clear();
+    EXPECT_TRUE(tree.view().indexed());
+    tree.enablePrefixIndex(false);
+    EXPECT_FALSE(tree.view().indexed());
+}
+
+TEST(ConcurrentTreeTest, PrefixAggregateTimeDoesNotGrowWithRange) {
+    // 20 lat pomiarów godzinowych z przerwą (brak 2011 roku); dopisanie do środka historii
+    // przelicza sumy narastające od zmienionego miesiąca
+    ConcurrentTree tree;
+    tree.enablePrefixIndex(true);
+    const std::int32_t start = Timestamp::fromDateTime(2005, 1, 1, 0, 0);
+    const std::int32_t gapFrom = Timestamp::fromDateTime(2011, 1, 1, 0, 0), gapTo = Timestamp::fromDateTime(2012, 1, 1, 0, 0);
+    Tree batch;
+    for (int i = 0; i < 20 * 365 * 24; ++i) {
+        const std::int32_t ts = start + i * 60;
+        if (ts < gapFrom || ts >= gapTo) batch.addRecord(Record(ts, i % 7, 0, (i * 31) % 1000 * 0.25, 0, 0));
+    }
+    tree.merge(std::move(batch));
+    tree.add(Record(Timestamp::fromDateTime(2015, 6, 10, 12, 5), 0, 0, 1000.5, 0, 0));
+
+    const ConcurrentTree::View view = tree.view();
+    const std::int32_t end = start + 20 * 365 * 24 * 60;
+    const std::vector<std::pair<std::int32_t, std::int32_t>> ranges = {
+        { start - 1000, end + 1000 }, { start + 17, start + 5000 }, { gapFrom - 7, gapTo + 7 },
+        { gapFrom + 60, gapTo - 60 }, { Timestamp::fromDateTime(2015, 6, 10, 12, 5), Timestamp::fromDateTime(2015, 6, 10, 12, 5) },
+        { Timestamp::fromDateTime(2008, 2, 28, 13, 30), Timestamp::fromDateTime(2019, 11, 3, 1, 0) }, { end + 5, end + 50 } };
+    for (const auto& [from, to] : ranges) {
+        const Aggregate indexed = view.prefixAggregate(from, to, 2);
+        const Aggregate scanned = view.aggregate(from, to, 2);
+        EXPECT_EQ(indexed.count, scanned.count);
+        EXPECT_NEAR(indexed.sum, scanned.sum, 1e-6 * (1.0 + std::fabs(scanned.sum)));
+    }
+
+    // Najlepszy czas serii zapytań o jeden dzień i o 20 lat - bez zależności od liczby miesięcy
+    const auto bestTime = [&view](std::int32_t from, std::int32_t to) {
+        double best = std::numeric_limits<double>::max();
+        for (int repeat = 0; repeat < 7; ++repeat) {
+            const auto begin = std::chrono::steady_clock::now();
+            double sum = 0.0;
+            for (int i = 0; i < 2000; ++i) sum += view.prefixAggregate(from + i % 60, to - i % 60, 2).sum;
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+            EXPECT_GT(sum, 0.0);
+            best = std::min(best, elapsed.count());
+        }
+        return best;
+    };
+    const std::int32_t day = Timestamp::fromDateTime(2015, 6, 10, 0, 0);
+    const double shortRange = bestTime(day, day + Timestamp::minutesPerDay);
+    const double longRange = bestTime(start + 60, end - 60);
+    EXPECT_LT(longRange, shortRange * 3.0 + 1e-4);
+}
+
+// Testy dla floty instalacji
+
+TEST(FleetTest, DirectoryLoadAndFleetAggregates) {
+    const std::string directory = "test_fleet";
+    std::filesystem::create_directory(directory);
+    const int siteCount = 40;
+    Tree reference;
+    for (int s = 0; s < siteCount; ++s) {
+        std::ofstream out(directory + "/site" + std::to_string(s) + ".csv");
+        out << "Time,Autokonsumpcja (W),Eksport (W),Import (W),Pobór (W),Produkcja (W)\n";
+        for (int i = 0; i < 96 * 45; ++i) {
+            const std::int32_t ts = Timestamp::fromDateTime(2021, 5, 20, 0, 0) + i * 15;
+            int year = 0, month = 0, day = 0, hour = 0, minute = 0;
+            Timestamp::toDateTime(ts, year, month, day, hour, minute);
+            const double produkcja = (i + s) % 17;
+            out << day / 10 << day % 10 << '.' << month / 10 << month % 10 << '.' << year << ' ' << hour << ':'
+                << minute / 10 << minute % 10 << ",\"1\",\"0\",\"2\",\"3\",\"" << produkcja << "\"\n";
+            reference.addRecord(Record(ts, 1, 0, 2, 3, produkcja));
+        }
+        if (s == 0) out << "01.06.2021 0:00,\"x\"\n";
+    }
+    std::ofstream(directory + "/notes.txt") << "nie CSV\n";
+
+    Fleet fleet(3);
+    std::string error;
+    ASSERT_TRUE(fleet.loadDirectory(directory, error)) << error;
+    std::filesystem::remove_all(directory);
+
+    ASSERT_EQ(fleet.size(), static_cast<std::size_t>(siteCount));
+    EXPECT_EQ(fleet.siteIds().front(), "site0");
+    ASSERT_NE(fleet.site("site7"), nullptr);
+    EXPECT_EQ(fleet.site("site7")->validRecords.load(), 96 * 45);
+    EXPECT_EQ(fleet.site("site0")->invalidRecords.load(), 1);
+    EXPECT_EQ(fleet.site("brak"), nullptr);
+
+    // Suma produkcji całej floty za czerwiec 2021 = suma po instalacjach = wynik jednego drzewa
+    const std::int32_t from = Timestamp::fromDateTime(2021, 6, 1, 0, 0);
+    const std::int32_t to = Timestamp::fromDateTime(2021, 7, 1, 0, 0) - 1;
+    const Aggregate total = fleet.aggregate(from, to, 4);
+    const Aggregate expected = reference.aggregate(from, to, 4);
+    EXPECT_EQ(total.count, expected.count);
+    EXPECT_DOUBLE_EQ(total.sum, expected.sum);
+    EXPECT_DOUBLE_EQ(total.max, 16.0);
+
+    const std::map<std::string, Aggregate> bySite = fleet.aggregateBySite(from, to, 4);
+    ASSERT_EQ(bySite.size(), static_cast<std::size_t>(siteCount));
+    double sum = 0.0;
+    for (const auto& [id, aggregate] : bySite) sum += aggregate.sum;
+    EXPECT_DOUBLE_EQ(sum, total.sum);
+
+    EXPECT_FALSE(fleet.loadSite("site0", "test_fleet_missing.csv", error));
+    EXPECT_FALSE(fleet.loadDirectory("test_fleet_missing", error));
+}
+
+// Testy dla klasy FlatTree
+
+TEST(FlatTreeTest, RangesMatchTreeNavigation) {
+    FlatTree flat;
+    flat.addRecord(Record("2021-10-15", "13:45", 1.0, 2.0, 3.0, 4.0, 5.0));
+    flat.addRecord(Record("2021-10-15", "12:00", 6.0, 7.0, 8.0, 9.0, 10.0));
+    flat.addRecord(Record("2021-10-16", "00:00", 0.5, 0.0, 0.0, 0.0, 0.0));
+    flat.addRecord(Record("2021-11-01", "06:15", 0.0, 0.0, 1.0, 1.0, 0.0));
+
+    ASSERT_EQ(flat.size(), 4u);
+    EXPECT_EQ(flat.record(0).time(), "12:00"); // wstawiony przed późniejszym rekordem
+    EXPECT_EQ(flat.monthRange(2021, 10), FlatTree::Range(0, 3));
+    EXPECT_EQ(flat.dayRange(2021, 10, 15), FlatTree::Range(0, 2));
+    EXPECT_EQ(flat.quarterRange(2021, 10, 15, 2), FlatTree::Range(0, 2));
+    EXPECT_EQ(flat.quarterRange(2021, 10, 15, 3), FlatTree::Range(2, 2));
+    EXPECT_EQ(flat.yearRange(2021), FlatTree::Range(0, 4));
+    EXPECT_EQ(flat.find(Timestamp::fromDateTime(2021, 10, 15, 13, 45)), 1u);
+    EXPECT_EQ(flat.find(Timestamp::fromDateTime(2021, 10, 15, 13, 30)), flat.size());
+    EXPECT_EQ(flat.range(Timestamp::fromDateTime(2021, 10, 15, 13, 45), Timestamp::fromDateTime(2021, 10, 16, 0, 0)),
+              FlatTree::Range(1, 3));
+}
+
+// Testy dla agregatów drzewa
+
+TEST(TreeTest, RangeAggregateMatchesScan) {
+    Tree tree;
+    std::vector<std::pair<std::int32_t, double>> samples;
+    const std::int32_t start = Timestamp::fromDateTime(2020, 12, 30, 0, 0);
+    for (int i = 0; i < 96 * 70; ++i) {
+        const std::int32_t ts = start + i * 15;
+        const double value = (i * 37) % 101 - 20.0;
+        tree.addRecord(Record(ts, 0.0, value, 0.0, 0.0, 0.0));
+        samples.emplace_back(ts, value);
+    }
+    EXPECT_EQ(tree.stats[1].count, samples.size());
+
+    const std::int32_t bounds[][2] = {
+        { Timestamp::fromDateTime(2021, 1, 1, 0, 0), Timestamp::fromDateTime(2021, 1, 31, 23, 45) },
+        { Timestamp::fromDateTime(2020, 12, 31, 17, 15), Timestamp::fromDateTime(2021, 2, 3, 6, 0) },
+        { Timestamp::fromDateTime(2021, 1, 5, 7, 0), Timestamp::fromDateTime(2021, 1, 5, 7, 0) },
+        { Timestamp::fromDateTime(2019, 1, 1, 0, 0), Timestamp::fromDateTime(2030, 1, 1, 0, 0) },
+    };
+    for (const auto& range : bounds) {
+        Aggregate expected;
+        for (const auto& [ts, value] : samples)
+            if (ts >= range[0] && ts <= range[1]) expected.add(value);
+        const Aggregate actual = tree.aggregate(range[0], range[1], 1);
+        EXPECT_EQ(actual.count, expected.count);
+        EXPECT_NEAR(actual.sum, expected.sum, 1e-6);
+        EXPECT_EQ(actual.min, expected.min);
+        EXPECT_EQ(actual.max, expected.max);
+    }
+}
+
+TEST(TreeTest, AllFieldsAggregateMatchesSingleField) {
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.loadCSV("ChartExport.csv");
+    std::cout.rdbuf(coutBuffer);
+    const Tree tree = program.getTree();
+
+    std::string error;
+    const SnapshotEncoding encodings[] = { SnapshotEncoding::Columns, SnapshotEncoding::CompressedBlocks };
+    Snapshot snapshots[2];
+    for (int e = 0; e < 2; ++e) {
+        const std::string fileName = "snapshot_fields_" + std::to_string(e) + ".bin";
+        ASSERT_TRUE(Snapshot::write(fileName, tree, nullptr, encodings[e], error)) << error;
+        ASSERT_TRUE(snapshots[e].open(fileName, error)) << error;
+        std::remove(fileName.c_str());
+    }
+
+    std::int32_t first = 0, last = 0;
+    ASSERT_TRUE(tree.timeSpan(first, last));
+    for (std::int32_t from = first - 100; from < last; from += 9973) {
+        const std::int32_t to = from + 30011;
+        const Aggregates all = tree.aggregate(from, to);
+        for (int f = 0; f < Record::fieldCount; ++f) {
+            const Aggregate expected = tree.aggregate(from, to, f);
+            EXPECT_EQ(all[f].count, expected.count);
+            EXPECT_DOUBLE_EQ(all[f].sum, expected.sum);
+            EXPECT_EQ(all[f].min, expected.min);
+            EXPECT_EQ(all[f].max, expected.max);
+        }
+        for (const Snapshot& snapshot : snapshots) {
+            const Aggregates fromSnapshot = snapshot.aggregate(from, to);
+            for (int f = 0; f < Record::fieldCount; ++f) {
+                EXPECT_EQ(fromSnapshot[f].count, all[f].count);
+                EXPECT_NEAR(fromSnapshot[f].sum, all[f].sum, 1e-6 * (1.0 + std::fabs(all[f].sum)));
+                EXPECT_EQ(fromSnapshot[f].max, all[f].max);
+            }
+        }
+    }
+}
+
+// Testy dla zestawień (resampling)
+
+TEST(RollupTest, CacheComputesOnlyMissingWindows) {
+    int calls = 0;
+    const RollupCache::Source source = [&calls](std::int32_t from, std::int32_t to) {
+        ++calls;
+        Aggregates result;
+        for (int field = 0; field < Record::fieldCount; ++field) result.fields[field].add(static_cast<double>(to - from + 1 + field));
+        return result;
+    };
+    RollupCache cache;
+    const std::int32_t day = Timestamp::fromDateTime(2021, 5, 1, 0, 0);
+    EXPECT_EQ(Resolution::daily().bucketStart(-1), -Timestamp::minutesPerDay);
+    EXPECT_EQ(Resolution::monthly().bucketEnd(Timestamp::fromDateTime(2021, 12, 1, 0, 0)), Timestamp::fromDateTime(2022, 1, 1, 0, 0));
+
+    const std::vector<RollupBucket> hours = cache.resample(day + 30, day + 3 * 60, Resolution::hourly(), source, cache.generation());
+    ASSERT_EQ(hours.size(), 4u);
+    EXPECT_EQ(hours.front().start, day);
+    EXPECT_EQ(hours.back().end, day + 4 * 60);
+    EXPECT_DOUBLE_EQ(hours[1].stats[4].sum, 64.0);
+    EXPECT_EQ(calls, 4);
+
+    // Drugie zapytanie (i zapytanie o część przedziału) korzysta wyłącznie z pamięci
+    cache.resample(day, day + 2 * 60, Resolution::hourly(), source, cache.generation());
+    EXPECT_EQ(calls, 4);
+    EXPECT_EQ(cache.size(), 4u);
+
+    // Unieważnienie usuwa tylko okna obejmujące przedział
+    cache.invalidate(day + 65, day + 70);
+    EXPECT_EQ(cache.size(), 3u);
+    cache.resample(day, day + 3 * 60, Resolution::hourly(), source, cache.generation());
+    EXPECT_EQ(calls, 5);
+
+    // Okna policzone przed unieważnieniem nie są zapamiętywane
+    const std::uint64_t stale = cache.generation();
+    cache.invalidate(day, day);
+    cache.resample(day + 5 * 60, day + 5 * 60, Resolution::hourly(), source, stale);
+    EXPECT_EQ(cache.size(), 3u);
+}
+
+TEST(RollupTest, ProgramResampleMatchesTreeAndFollowsAppends) {
+    const std::string fileName = "test_rollup.csv";
+    const auto row = [](int day, int minutes, int value) {
+        char line[96];
+        std::snprintf(line, sizeof(line), "%02d.05.2021 %d:%02d,\"1\",\"0\",\"2\",\"3\",\"%d\"\n", day, minutes / 60,
+                      minutes % 60, value);
+        return std::string(line);
+    };
+    {
+        std::ofstream out(fileName);
+        out << "Time,Autokonsumpcja (W),Eksport (W),Import (W),Pobór (W),Produkcja (W)\n";
+        for (int day = 1; day <= 3; ++day)
+            for (int minutes = 0; minutes < 24 * 60; minutes += 15) out << row(day, minutes, (day * 7 + minutes / 15) % 10 * 100);
+    }
+
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.setLogLevel(LogLevel::None);
+    program.loadCSV(fileName);
+    std::cout.rdbuf(coutBuffer);
+
+    const std::int32_t from = Timestamp::fromDateTime(2021, 5, 1, 0, 0);
+    const std::int32_t to = Timestamp::fromDateTime(2021, 5, 4, 0, 0) - 1;
+    const Tree tree = program.getTree();
+    const std::vector<RollupBucket> days = program.resample(from, to, Resolution::daily());
+    ASSERT_EQ(days.size(), 3u);
+    double total = 0.0;
+    for (const RollupBucket& bucket : days) {
+        const Aggregate expected = tree.aggregate(bucket.start, bucket.end - 1, 4);
+        EXPECT_EQ(bucket.stats[4].count, 96u);
+        EXPECT_DOUBLE_EQ(bucket.stats[4].sum, expected.sum);
+        EXPECT_DOUBLE_EQ(bucket.stats[4].max, 900.0);
+        EXPECT_DOUBLE_EQ(bucket.energy(4), expected.sum * 0.25 / 1000.0);
+        total += bucket.stats[4].sum;
+    }
+    const std::vector<RollupBucket> hours = program.resample(from, to, Resolution::hourly());
+    ASSERT_EQ(hours.size(), 72u);
+    double hourly = 0.0;
+    for (const RollupBucket& bucket : hours) hourly += bucket.stats[4].sum;
+    EXPECT_DOUBLE_EQ(hourly, total);
+    ASSERT_EQ(program.resample(from, to, Resolution::monthly()).size(), 1u);
+
+    // Dopisane rekordy są widoczne w unieważnionym oknie miesięcznym i w nowym oknie dobowym
+    std::ofstream(fileName, std::ios::app) << row(4, 0, 500) << row(4, 15, 700);
+    int added = 0, duplicates = 0;
+    ASSERT_TRUE(program.updateFromCSV(fileName, added, duplicates));
+    std::remove(fileName.c_str());
+    EXPECT_EQ(added, 2);
+    const std::vector<RollupBucket> months = program.resample(from, to, Resolution::monthly());
+    ASSERT_EQ(months.size(), 1u);
+    EXPECT_EQ(months[0].stats[4].count, 3u * 96u + 2u);
+    EXPECT_DOUBLE_EQ(months[0].stats[4].sum, total + 1200.0);
+    EXPECT_EQ(program.resample(from, to + 1, Resolution::daily()).back().stats[4].count, 2u);
+    EXPECT_EQ(program.resample(from, to, Resolution::daily())[2].stats[4].count, 96u);
+}
+
+// Testy dla trybu wsadowego
+
+TEST(BatchQueryTest, ExecutesFileAndSharesIdenticalRanges) {
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.setLogLevel(LogLevel::None);
+    program.loadCSV("ChartExport.csv");
+    std::cout.rdbuf(coutBuffer);
+
+    std::istringstream input(
+        "# wsad testowy\n"
+        "sum produkcja 2020-10-01 00:00 2020-10-31 23:59\n"
+        "\n"
+        "avg pobor 2020-10-01 00:00 2020-10-31 23:59\n"
+        "compare produkcja 2020-10-01 00:00 2020-10-31 23:59 2020-11-01 00:00 2020-11-30 23:59\n"
+        "search pobor 400 50 2020-10-03 07:30 2020-11-20 12:00\n"
+        "sum moc 2020-10-01 00:00 2020-10-31 23:59\n"
+        "avg produkcja 2020-13-01 00:00 2020-10-31 23:59\n");
+    std::vector<BatchQuery::Query> queries;
+    EXPECT_FALSE(BatchQuery::parse(input, queries));
+    ASSERT_EQ(queries.size(), 6u);
+    EXPECT_EQ(queries[0].line, 2);
+    EXPECT_EQ(queries[1].line, 4);
+    EXPECT_FALSE(queries[4].error.empty());
+    EXPECT_FALSE(queries[5].error.empty());
+
+    std::vector<BatchQuery::Result> results;
+    const BatchQuery::Stats stats = BatchQuery::execute(program, queries, results, 3);
+    EXPECT_EQ(stats.queries, 6u);
+    EXPECT_EQ(stats.uniqueRanges, 3u); // październik produkcji jest liczony raz dla sum i compare
+    ASSERT_EQ(results.size(), 6u);
+
+    const Tree tree = program.getTree();
+    const std::int32_t october = Timestamp::fromDateTime(2020, 10, 1, 0, 0);
+    const std::int32_t november = Timestamp::fromDateTime(2020, 11, 1, 0, 0);
+    const std::int32_t december = Timestamp::fromDateTime(2020, 12, 1, 0, 0);
+    EXPECT_DOUBLE_EQ(results[0].first.sum, tree.aggregate(october, november - 1, 4).sum);
+    EXPECT_EQ(results[1].first.count, tree.aggregate(october, november - 1, 3).count);
+    EXPECT_DOUBLE_EQ(results[2].first.sum, results[0].first.sum);
+    EXPECT_DOUBLE_EQ(results[2].second.sum, tree.aggregate(november, december - 1, 4).sum);
+    EXPECT_EQ(results[3].matches.size(),
+              program.findRecords(400.0, 50.0, queries[3].from, queries[3].to, Record::fieldIndex("pobor")).size());
+    EXPECT_FALSE(results[3].matches.empty());
+    EXPECT_EQ(results[4].error, "Nieznany typ danych: moc");
+
+    // Każdy wiersz CSV ma tyle kolumn co nagłówek
+    std::ostringstream csv;
+    BatchQuery::writeCsv(csv, queries, results);
+    std::istringstream rows(csv.str());
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(rows, line);) lines.push_back(line);
+    ASSERT_EQ(lines.size(), 7u);
+    for (const std::string& line : lines) EXPECT_EQ(std::count(line.begin(), line.end(), ','), 16) << line;
+    EXPECT_EQ(lines[3].rfind("5,compare,produkcja,2020-10-01 00:00,2020-10-31 23:59,2020-11-01 00:00,", 0), 0u);
+
+    std::ostringstream json;
+    BatchQuery::writeJson(json, queries, results);
+    EXPECT_NE(json.str().find("\"zapytanie\": \"search\""), std::string::npos);
+    EXPECT_NE(json.str().find("\"blad\": \"Nieznany typ danych: moc\""), std::string::npos);
+    EXPECT_EQ(json.str().front(), '[');
+}
+
+// Testy dla metryk
+
+TEST(MetricsTest, LoadAndQueriesAreCountedAndReported) {
+    if (!Metrics::enabled) GTEST_SKIP() << "Metryki wyłączone (METRICS_ENABLED=0)";
+    Metrics::reset();
+    const std::int64_t mappedBefore = Metrics::memory(MemoryPool::Mapped);
+    {
+        std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+        Program program;
+        program.setLogLevel(LogLevel::None);
+        program.loadCSV("ChartExport.csv");
+        program.calculateSum("2020-10-01", "00:00", "2020-10-31", "23:59", "produkcja");
+        program.searchRecords(400, 50, "2020-10-01", "00:00", "2020-10-31", "23:59", "pobor");
+        std::cout.rdbuf(coutBuffer);
+
+        const std::uint64_t lines = static_cast<std::uint64_t>(program.getValidRecords() + program.getInvalidRecords());
+        EXPECT_EQ(Metrics::items(Metric::Parse), lines);
+        EXPECT_EQ(Metrics::items(Metric::LoadCSV), lines);
+        EXPECT_EQ(Metrics::items(Metric::TreeInsert), static_cast<std::uint64_t>(program.getValidRecords()));
+        EXPECT_EQ(Metrics::samples(Metric::Parse), (lines + Metrics::sampleInterval - 1) / Metrics::sampleInterval);
+        EXPECT_EQ(Metrics::samples(Metric::LoadCSV), 1u);
+        EXPECT_EQ(Metrics::samples(Metric::Aggregate), 1u);
+        EXPECT_EQ(Metrics::samples(Metric::Search), 1u);
+        EXPECT_GT(Metrics::memory(MemoryPool::Tree), 0);
+        // Przy wyłączonym logowaniu żaden wpis nie trafia do loggera
+        EXPECT_EQ(Metrics::items(Metric::Logging), 0u);
+        EXPECT_EQ(Metrics::samples(Metric::Logging), 0u);
+
+        // Na poziomie `LogLevel::Errors` liczone są tylko błędne rekordy
+        std::cout.rdbuf(nullptr);
+        Program errors;
+        errors.setLogLevel(LogLevel::Errors);
+        errors.loadCSV("ChartExport.csv");
+        std::cout.rdbuf(coutBuffer);
+        EXPECT_EQ(Metrics::items(Metric::Logging), static_cast<std::uint64_t>(errors.getInvalidRecords()));
+        EXPECT_EQ(Metrics::samples(Metric::Logging), 0u);
+    }
+    // Zmapowany plik CSV jest zwalniany po wczytaniu
+    EXPECT_EQ(Metrics::memory(MemoryPool::Mapped), mappedBefore);
+
+    const std::string text = Metrics::prometheus();
+    EXPECT_NE(text.find("# TYPE pv_stage_duration_seconds histogram"), std::string::npos);
+    EXPECT_NE(text.find("pv_stage_duration_seconds_count{stage=\"load_csv\"} 2\n"), std::string::npos);
+
+    // Raport okresowy: plik JSON istnieje po zakończeniu reportera
+    const std::string fileName = "test_metrics.json";
+    std::remove(fileName.c_str());
+    { MetricsReporter reporter(fileName, 10); }
+    std::ifstream file(fileName);
+    const std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(json.front(), '{');
+    EXPECT_NE(json.find("\"load_csv\":{\"items\":"), std::string::npos);
+    EXPECT_NE(json.find("\"memory_bytes\":{\"tree\":"), std::string::npos);
+    file.close();
+    std::remove(fileName.c_str());
+}
+
+// Testy dla indeksu sum prefiksowych
+
+TEST(PrefixSumIndexTest, MatchesTreeAggregates) {
+    Tree tree;
+    const std::int32_t start = Timestamp::fromDateTime(2021, 3, 1, 0, 0);
+    for (int i = 0; i < 96 * 40; ++i) {
+        const std::int32_t ts = start + i * 15;
+        tree.addRecord(Record(ts, 0.1 * i, 0.0, 0.0, 1e6, 0.0));
+    }
+    PrefixSumIndex index;
+    index.build(tree);
+    ASSERT_EQ(index.size(), 96u * 40u);
+
+    const std::int32_t from = Timestamp::fromDateTime(2021, 3, 7, 5, 30), to = Timestamp::fromDateTime(2021, 3, 21, 17, 45);
+    EXPECT_EQ(index.count(from, to), tree.aggregate(from, to, 0).count);
+    EXPECT_NEAR(index.sum(from, to, 0), tree.aggregate(from, to, 0).sum, 1e-6);
+    EXPECT_DOUBLE_EQ(index.average(from, to, 3), 1e6);
+
+    // Dopisanie na końcu oraz pomiar spoza kolejności
+    const std::int32_t late = start + 96 * 40 * 15;
+    index.append(late, Record(late, 5.0, 0.0, 0.0, 0.0, 0.0));
+    index.append(from, Record(from, 2.5, 0.0, 0.0, 0.0, 0.0));
+    EXPECT_NEAR(index.sum(late, late, 0), 5.0, 1e-9);
+    EXPECT_NEAR(index.sum(from, from, 0), tree.aggregate(from, from, 0).sum + 2.5, 1e-9);
+    EXPECT_NEAR(index.sum(from, to, 0), tree.aggregate(from, to, 0).sum + 2.5, 1e-6);
+}
+
+// Testy dla snapshotu binarnego
+
+TEST(SnapshotTest, RoundTripAndRejectsBadFiles) {
+    const std::string fileName = "snapshot_test.bin";
+    Tree tree;
+    const std::int32_t start = Timestamp::fromDateTime(2021, 6, 28, 0, 0);
+    for (int i = 0; i < 96 * 10; ++i) {
+        const std::int32_t ts = start + i * 15;
+        tree.addRecord(Record(ts, 0.5 * i, i % 7, 1.0, 2.0, -0.25 * i));
+    }
+    std::string error;
+    ASSERT_TRUE(Snapshot::write(fileName, tree, nullptr, SnapshotEncoding::Columns, error)) << error;
+
+    Snapshot snapshot;
+    ASSERT_TRUE(snapshot.open(fileName, error)) << error;
+    ASSERT_TRUE(snapshot.verify(error)) << error;
+    ASSERT_EQ(snapshot.size(), 96u * 10u);
+    EXPECT_EQ(snapshot.record(5).time(), "01:15");
+    EXPECT_EQ(snapshot.record(5).date(), "2021-06-28");
+
+    const std::int32_t from = Timestamp::fromDateTime(2021, 6, 29, 13, 15), to = Timestamp::fromDateTime(2021, 7, 5, 2, 0);
+    for (int f = 0; f < Record::fieldCount; ++f) {
+        const Aggregate expected = tree.aggregate(from, to, f), actual = snapshot.aggregate(from, to, f);
+        EXPECT_EQ(actual.count, expected.count);
+        EXPECT_NEAR(actual.sum, expected.sum, 1e-6);
+        EXPECT_EQ(actual.min, expected.min);
+        EXPECT_EQ(actual.max, expected.max);
+    }
+
+    // Program: zapis drzewa razem z wczytanym snapshotem, odczyt zastępuje dane
+    Program program;
+    program.loadFromBinary(fileName);
+    EXPECT_EQ(program.getValidRecords(), 96 * 10);
+    EXPECT_TRUE(program.getTree().years.empty());
+    program.saveToBinary(fileName);
+    Snapshot saved;
+    ASSERT_TRUE(saved.open(fileName, error)) << error;
+    EXPECT_EQ(saved.size(), 96u * 10u);
+
+    // Nieobsługiwana wersja formatu
+    std::vector<char> bytes;
+    {
+        std::ifstream in(fileName, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    std::vector<char> patched = bytes;
+    patched[offsetof(SnapshotHeader, version)] = 99;
+    std::ofstream(fileName, std::ios::binary | std::ios::trunc).write(patched.data(), static_cast<std::streamsize>(patched.size()));
+    Snapshot future;
+    EXPECT_FALSE(future.open(fileName, error));
+    EXPECT_NE(error.find("99"), std::string::npos) << error;
+
+    // Uszkodzone dane: nagłówek poprawny, suma kontrolna danych niezgodna
+    patched = bytes;
+    patched[patched.size() - 1] ^= 0x40;
+    std::ofstream(fileName, std::ios::binary | std::ios::trunc).write(patched.data(), static_cast<std::streamsize>(patched.size()));
+    Snapshot corrupted;
+    ASSERT_TRUE(corrupted.open(fileName, error)) << error;
+    EXPECT_FALSE(corrupted.verify(error));
+
+    std::remove(fileName.c_str());
+}
+
+// Testy dla skompresowanego snapshotu
+
+TEST(BlockCodecTest, RoundTripIsBitExact) {
+    const std::int32_t timestamps[] = { 1000, 1015, 1030, 1030, 1045, 1200, 1215, 100000, 100015 };
+    std::vector<std::uint8_t> stream;
+    BlockCodec::encodeTimestamps(timestamps, 9, stream);
+    std::int32_t decodedTimestamps[9] = {};
+    ASSERT_TRUE(BlockCodec::decodeTimestamps(stream.data(), stream.size(), 9, decodedTimestamps));
+    EXPECT_TRUE(std::equal(timestamps, timestamps + 9, decodedTimestamps));
+
+    // Tryb dziesiętny (4 cyfry po przecinku) oraz tryb XOR (wartości bez skończonego rozwinięcia)
+    const std::vector<std::vector<double>> columns = {
+        { 0.0, 0.0, 406.8323, 403.5656, 403.5656, 0.0, -12.5, 0.0, 0.0, 0.0, 1e9 },
+        { 1.0 / 3.0, 0.0, 0.0, -0.0, 2.0 / 3.0, 2.0 / 3.0, 1e300, std::numeric_limits<double>::quiet_NaN(), 0.0 },
+    };
+    for (const std::vector<double>& values : columns) {
+        stream.clear();
+        BlockCodec::encodeValues(values.data(), values.size(), nullptr, stream);
+        std::vector<double> decoded(values.size());
+        ASSERT_TRUE(BlockCodec::decodeValues(stream.data(), stream.size(), values.size(), nullptr, decoded.data()));
+        EXPECT_EQ(std::memcmp(values.data(), decoded.data(), values.size() * sizeof(double)), 0);
+        EXPECT_FALSE(BlockCodec::decodeValues(stream.data(), stream.size() / 2, values.size(), nullptr, decoded.data()));
+    }
+
+    // Wartości zapisane względem przewidywania (bilans: pobór = autokonsumpcja + import)
+    const double autokonsumpcja[] = { 0.0, 201.0, 299.6667, 277.8208, 0.0 };
+    const double import_[] = { 406.8323, 190.8185, 80.6204, 0.0, 0.0 };
+    const double pobor[] = { 406.8323, 391.8185, 380.287, 277.8208, 0.0 };
+    double prediction[5], decoded[5];
+    for (int i = 0; i < 5; ++i) prediction[i] = autokonsumpcja[i] + import_[i];
+    std::vector<std::uint8_t> plain;
+    BlockCodec::encodeValues(pobor, 5, nullptr, plain);
+    stream.clear();
+    BlockCodec::encodeValues(pobor, 5, prediction, stream);
+    EXPECT_LT(stream.size(), plain.size());
+    ASSERT_TRUE(BlockCodec::decodeValues(stream.data(), stream.size(), 5, prediction, decoded));
+    EXPECT_EQ(std::memcmp(pobor, decoded, sizeof(pobor)), 0);
+    EXPECT_FALSE(BlockCodec::decodeValues(stream.data(), stream.size(), 5, nullptr, decoded));
+}
+
+TEST(SnapshotTest, CompressedBlocksMatchColumns) {
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.loadCSV("ChartExport.csv");
+    std::cout.rdbuf(coutBuffer);
+    ASSERT_GT(program.getValidRecords(), 0);
+
+    std::string error;
+    ASSERT_TRUE(Snapshot::write("snapshot_columns.bin", program.getTree(), nullptr, SnapshotEncoding::Columns, error)) << error;
+    ASSERT_TRUE(Snapshot::write("snapshot_blocks.bin", program.getTree(), nullptr, SnapshotEncoding::CompressedBlocks, error)) << error;
+    Snapshot columns, blocks;
+    ASSERT_TRUE(columns.open("snapshot_columns.bin", error)) << error;
+    ASSERT_TRUE(blocks.open("snapshot_blocks.bin", error)) << error;
+    ASSERT_TRUE(blocks.verify(error)) << error;
+    EXPECT_EQ(blocks.encoding(), SnapshotEncoding::CompressedBlocks);
+    EXPECT_EQ(blocks.timestamps(), nullptr);
+
+    // Rozmiar: co najmniej 5 razy mniej niż nieskompresowane kolumny
+    std::ifstream columnsFile("snapshot_columns.bin", std::ios::binary | std::ios::ate);
+    std::ifstream blocksFile("snapshot_blocks.bin", std::ios::binary | std::ios::ate);
+    EXPECT_GE(columnsFile.tellg(), 5 * blocksFile.tellg());
+
+    // Dane odtwarzane bit w bit
+    std::vector<std::int32_t> expectedTimestamps, actualTimestamps;
+    std::vector<double> expectedValues[Record::fieldCount], actualValues[Record::fieldCount];
+    columns.copyTo(expectedTimestamps, expectedValues);
+    blocks.copyTo(actualTimestamps, actualValues);
+    ASSERT_EQ(actualTimestamps, expectedTimestamps);
+    for (int f = 0; f < Record::fieldCount; ++f) EXPECT_EQ(actualValues[f], expectedValues[f]);
+    EXPECT_EQ(blocks.record(3000).time(), columns.record(3000).time());
+    EXPECT_EQ(blocks.record(3000).pobor, columns.record(3000).pobor);
+
+    // Zapytania o przedziały (krawędzie wewnątrz bloków i na granicach dni)
+    const std::int32_t first = expectedTimestamps.front(), last = expectedTimestamps.back();
+    for (std::int32_t from = first - 100; from < last; from += 7919) {
+        const std::int32_t to = from + 20000;
+        EXPECT_EQ(blocks.range(from, to), columns.range(from, to));
+        for (int f = 0; f < Record::fieldCount; ++f) {
+            const Aggregate expected = columns.aggregate(from, to, f), actual = blocks.aggregate(from, to, f);
+            EXPECT_EQ(actual.count, expected.count);
+            EXPECT_NEAR(actual.sum, expected.sum, 1e-6 * (1.0 + std::fabs(expected.sum)));
+            EXPECT_EQ(actual.min, expected.min);
+            EXPECT_EQ(actual.max, expected.max);
+        }
+    }
+
+    // Program: zapis skompresowany i ponowny odczyt
+    program.enableCompression(true);
+    program.saveToBinary("snapshot_blocks.bin");
+    Program loaded;
+    loaded.loadFromBinary("snapshot_blocks.bin");
+    EXPECT_EQ(loaded.getValidRecords(), program.getValidRecords());
+
+    std::remove("snapshot_columns.bin");
+    std::remove("snapshot_blocks.bin");
+}
+
+// Testy dla częściowego wczytywania snapshotu
+
+TEST(SnapshotTest, ResidencyIsBoundedByLruLimit) {
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.loadCSV("ChartExport.csv");
+    std::cout.rdbuf(coutBuffer);
+
+    std::string error;
+    for (const SnapshotEncoding encoding : { SnapshotEncoding::Columns, SnapshotEncoding::CompressedBlocks }) {
+        ASSERT_TRUE(Snapshot::write("residency_test.bin", program.getTree(), nullptr, encoding, error)) << error;
+        Snapshot unlimited, limited;
+        ASSERT_TRUE(unlimited.open("residency_test.bin", error)) << error;
+        // Limit mieszczący jeden miesiąc kolumn lub kilka bloków
+        const std::size_t limit = 160 * 1024;
+        limited.setResidentLimit(limit);
+        ASSERT_TRUE(limited.open("residency_test.bin", error)) << error;
+        EXPECT_EQ(limited.residency().resident, 0u);
+
+        // Tygodnie października 2020, 2021 i ponownie 2020: wyniki jak bez limitu, zajętość w granicach limitu
+        std::vector<std::int32_t> weeks;
+        for (const int year : { 2020, 2021, 2020 })
+            for (int week = 0; week < 4; ++week)
+                weeks.push_back(Timestamp::fromDateTime(year, 10, 1 + 7 * week, 1, 30));
+        const std::int32_t length = 7 * Timestamp::minutesPerDay - 180;
+        for (std::size_t week = 0; week < weeks.size(); ++week) {
+            const std::int32_t from = weeks[week], to = from + length;
+            std::vector<Record> expected, actual;
+            unlimited.records(from, to, expected);
+            limited.records(from, to, actual);
+            ASSERT_EQ(actual.size(), expected.size()) << week;
+            for (std::size_t i = 0; i < actual.size(); ++i) {
+                EXPECT_EQ(actual[i].timestamp, expected[i].timestamp);
+                EXPECT_EQ(actual[i].produkcja, expected[i].produkcja);
+            }
+            EXPECT_EQ(limited.aggregate(from, to, 4).sum, unlimited.aggregate(from, to, 4).sum);
+            EXPECT_LE(limited.residency().resident, limit);
+        }
+        // Ponowne zapytanie o ostatni tydzień korzysta z pamięci podręcznej
+        const SnapshotResidency before = limited.residency();
+        std::vector<Record> again;
+        limited.records(weeks.back(), weeks.back() + length, again);
+        EXPECT_FALSE(again.empty());
+        EXPECT_GT(limited.residency().hits, before.hits);
+        EXPECT_EQ(limited.residency().misses, before.misses);
+        // Elementy były usuwane (wczytano więcej, niż mieści limit)
+        EXPECT_GT(before.entries, 0u);
+        EXPECT_GT(before.misses, before.entries);
+
+        limited.setResidentLimit(0);
+        EXPECT_EQ(limited.residency().resident, 0u);
+        EXPECT_EQ(limited.residency().entries, 0u);
+    }
+
+    // Program: limit przekazywany do wczytywanego snapshotu
+    std::cout.rdbuf(nullptr);
+    program.enableCompression(true);
+    program.saveToBinary("residency_test.bin");
+    Program loaded;
+    loaded.setSnapshotMemoryLimit(64 * 1024);
+    loaded.loadFromBinary("residency_test.bin");
+    std::cout.rdbuf(coutBuffer);
+    const std::int32_t from = Timestamp::fromDateTime(2020, 10, 1, 0, 0), to = Timestamp::fromDateTime(2021, 3, 31, 23, 59);
+    EXPECT_EQ(loaded.findRecords(400.0, 50.0, from, to, 3).size(), program.findRecords(400.0, 50.0, from, to, 3).size());
+    std::remove("residency_test.bin");
+}
+
+// Testy dla wyszukiwania z tolerancją
+
+TEST(SearchKernelTest, AllPathsMatchScalar) {
+    std::vector<double> values;
+    for (int i = 0; i < 1000; ++i) values.push_back((i * 7919) % 503 * 0.5 - 50.0);
+    values[3] = std::numeric_limits<double>::quiet_NaN();
+    values[64] = -0.0;
+    values[65] = std::numeric_limits<double>::infinity();
+    values[130] = 10.0 + 2.5;
+
+    // Krótkie kolumny (do 24 wartości - ćwiartka drzewa) i niepełne słowa sprawdzają końcówki wersji wektorowych
+    for (const std::size_t count : { std::size_t(0), std::size_t(1), std::size_t(2), std::size_t(3), std::size_t(5),
+                                     std::size_t(24), std::size_t(64), std::size_t(67), std::size_t(131), values.size() }) {
+        std::vector<std::uint64_t> expected;
+        std::size_t expectedCount = 0;
+        for (std::size_t i = 0; i < count; ++i) expectedCount += std::fabs(values[i] - 10.0) <= 2.5;
+        ASSERT_EQ(SearchKernel::match(values.data(), count, 10.0, 2.5, expected, SearchKernel::Isa::Scalar), expectedCount);
+        for (const SearchKernel::Isa isa : { SearchKernel::Isa::Sse2, SearchKernel::Isa::Avx2 }) {
+            if (!SearchKernel::supported(isa)) continue;
+            std::vector<std::uint64_t> bitmap;
+            EXPECT_EQ(SearchKernel::match(values.data(), count, 10.0, 2.5, bitmap, isa), expectedCount) << SearchKernel::name(isa);
+            EXPECT_EQ(bitmap, expected) << SearchKernel::name(isa);
+        }
+        std::vector<std::size_t> indices;
+        SearchKernel::indices(expected, 100, indices);
+        ASSERT_EQ(indices.size(), expectedCount);
+        for (const std::size_t index : indices) EXPECT_LE(std::fabs(values[index - 100] - 10.0), 2.5);
+    }
+}
+
+TEST(TreeTest, SearchSortsOutOfOrderQuarters) {
+    // Rekordy jednej ćwiartki dodane od najpóźniejszego, druga ćwiartka dopisana przez `merge`
+    Tree tree;
+    for (int minute = 5 * 60 + 45; minute >= 0; minute -= 15) {
+        tree.addRecord(Record(Timestamp::fromDateTime(2023, 5, 1, 0, 0) + minute, 1.0, 0.0, 0.0, 0.0, 0.0));
+    }
+    Tree later;
+    later.addRecord(Record(Timestamp::fromDateTime(2023, 5, 1, 3, 10), 1.0, 0.0, 0.0, 0.0, 0.0));
+    tree.merge(std::move(later));
+
+    std::vector<Record> matches;
+    tree.search(Timestamp::fromDateTime(2023, 5, 1, 0, 0), Timestamp::fromDateTime(2023, 5, 1, 23, 59), 0, 1.0, 0.0, matches);
+    ASSERT_EQ(matches.size(), 25u);
+    EXPECT_TRUE(std::is_sorted(matches.begin(), matches.end(),
+                               [](const Record& a, const Record& b) { return a.timestamp < b.timestamp; }));
+}
+
+TEST(TreeTest, SearchPathsMatchScalar) {
+    // Ćwiartki mają do 24 wartości, więc wersje wektorowe filtrują wyłącznie niepełne słowa mapy
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.loadCSV("ChartExport.csv");
+    std::cout.rdbuf(coutBuffer);
+    const Tree tree = program.getTree();
+    std::int32_t from = 0, to = 0;
+    ASSERT_TRUE(tree.timeSpan(from, to));
+
+    const auto timestamps = [](const std::vector<Record>& records) {
+        std::vector<std::int32_t> result;
+        for (const Record& record : records) result.push_back(record.timestamp);
+        return result;
+    };
+    for (int field = 0; field < Record::fieldCount; ++field) {
+        std::vector<Record> expected;
+        tree.search(from + 7, to - 7, field, 300.0, 150.0, expected, SearchKernel::Isa::Scalar);
+        ASSERT_FALSE(expected.empty());
+        for (const SearchKernel::Isa isa : { SearchKernel::Isa::Sse2, SearchKernel::Isa::Avx2 }) {
+            if (!SearchKernel::supported(isa)) continue;
+            std::vector<Record> matches;
+            tree.search(from + 7, to - 7, field, 300.0, 150.0, matches, isa);
+            EXPECT_EQ(timestamps(matches), timestamps(expected)) << SearchKernel::name(isa);
+        }
+    }
+}
+
+TEST(ProgramTest, FindRecordsMatchesScan) {
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.loadCSV("ChartExport.csv");
+    std::cout.rdbuf(coutBuffer);
+
+    const std::int32_t from = Timestamp::fromDateTime(2020, 10, 3, 7, 30), to = Timestamp::fromDateTime(2020, 11, 20, 12, 0);
+    const int field = Record::fieldIndex("pobor");
+    std::vector<std::string> expected;
+    for (const auto& [y, year] : program.getTree().years)
+        for (const auto& [m, month] : year.months)
+            for (const auto& [d, day] : month.days)
+                for (const auto& [q, quarter] : day.quarters)
+                    for (std::size_t i = 0; i < quarter.size(); ++i) {
+                        const std::int32_t timestamp = quarter.timestamps[i];
+                        if (timestamp >= from && timestamp <= to && std::fabs(quarter.pobor[i] - 400.0) <= 50.0) {
+                            expected.push_back(Timestamp::formatDate(timestamp) + " " + Timestamp::formatTime(timestamp));
+                        }
+                    }
+    ASSERT_FALSE(expected.empty());
+    std::sort(expected.begin(), expected.end());
+
+    const auto found = [&](const Program& source) {
+        std::vector<std::string> result;
+        for (const Record& record : source.findRecords(400.0, 50.0, from, to, field)) {
+            EXPECT_LE(std::fabs(record.pobor - 400.0), 50.0);
+            result.push_back(record.date() + " " + record.time());
+        }
+        return result;
+    };
+    EXPECT_EQ(found(program), expected);
+
+    // Te same wyniki ze snapshotu (kolumny i skompresowane bloki)
+    for (const bool compressed : { false, true }) {
+        std::cout.rdbuf(nullptr);
+        program.enableCompression(compressed);
+        program.saveToBinary("search_test.bin");
+        Program loaded;
+        loaded.loadFromBinary("search_test.bin");
+        std::cout.rdbuf(coutBuffer);
+        EXPECT_EQ(found(loaded), expected) << compressed;
+    }
+    std::remove("search_test.bin");
+}
+
+// Testy dla zapytań top-K i anomalii
+TEST(AnomalyTest, TopKFlatDaysAndDeviationsMatchScan) {
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.loadCSV("ChartExport.csv");
+    std::cout.rdbuf(coutBuffer);
+
+    std::vector<Record> all;
+    for (const auto& [y, year] : program.getTree().years)
+        for (const auto& [m, month] : year.months)
+            for (const auto& [d, day] : month.days)
+                for (const auto& [q, quarter] : day.quarters)
+                    for (std::size_t i = 0; i < quarter.size(); ++i) all.push_back(quarter.record(i));
+    std::sort(all.begin(), all.end(), [](const Record& a, const Record& b) { return a.timestamp < b.timestamp; });
+    ASSERT_GT(all.size(), 1000u);
+    const std::int32_t from = Timestamp::fromDateTime(2020, 10, 3, 7, 30), to = Timestamp::fromDateTime(2021, 3, 20, 12, 0);
+
+    // Top-K: największy import i najmniejsza produkcja w przedziale
+    const auto expectedTop = [&](int field, std::size_t k, bool largest) {
+        std::vector<Record> sorted;
+        for (const Record& record : all)
+            if (record.timestamp >= from && record.timestamp <= to) sorted.push_back(record);
+        std::stable_sort(sorted.begin(), sorted.end(), [&](const Record& a, const Record& b) {
+            return largest ? a.field(field) > b.field(field) : a.field(field) < b.field(field);
+        });
+        sorted.resize(std::min(k, sorted.size()));
+        return sorted;
+    };
+    const auto sameRecords = [](const std::vector<Record>& actual, const std::vector<Record>& expected) {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < actual.size(); ++i) {
+            EXPECT_EQ(actual[i].timestamp, expected[i].timestamp) << i;
+            EXPECT_EQ(actual[i].import_, expected[i].import_) << i;
+            EXPECT_EQ(actual[i].produkcja, expected[i].produkcja) << i;
+        }
+    };
+    const int importField = Record::fieldIndex("import"), productionField = Record::fieldIndex("produkcja");
+    ScanStats stats;
+    sameRecords(program.topRecords(from, to, importField, 10, true, &stats), expectedTop(importField, 10, true));
+    // Przycinanie: przejrzana jest niewielka część przedziału
+    EXPECT_GT(stats.skipped, 10 * stats.visited);
+    sameRecords(program.topRecords(from, to, productionField, 25, false), expectedTop(productionField, 25, false));
+    EXPECT_TRUE(program.topRecords(from, to, importField, 0, true).empty());
+
+    // Dni bez produkcji między 10:00 a 14:00
+    const int firstMinute = 10 * 60, lastMinute = 14 * 60;
+    std::map<std::int32_t, bool> windowDays;
+    for (const Record& record : all) {
+        if (record.timestamp < from || record.timestamp > to) continue;
+        const std::int32_t minute = record.timestamp % Timestamp::minutesPerDay;
+        if (minute < firstMinute || minute > lastMinute) continue;
+        auto inserted = windowDays.emplace(record.timestamp - minute, true);
+        inserted.first->second = inserted.first->second && record.produkcja <= 0.0;
+    }
+    std::vector<std::int32_t> expectedDays;
+    for (const auto& [day, flat] : windowDays)
+        if (flat) expectedDays.push_back(day);
+    EXPECT_EQ(program.flatDays(from, to, productionField, 0.0, firstMinute, lastMinute), expectedDays);
+
+    // Odchylenia od średniej okna 96 poprzednich rekordów
+    const std::size_t window = 96;
+    std::vector<std::int32_t> expectedDeviations;
+    std::vector<double> values;
+    for (const Record& record : all)
+        if (record.timestamp >= from && record.timestamp <= to) values.push_back(record.eksport);
+    std::size_t v = 0;
+    for (const Record& record : all) {
+        if (record.timestamp < from || record.timestamp > to) continue;
+        if (v >= window) {
+            double mean = 0.0, squares = 0.0;
+            for (std::size_t i = v - window; i < v; ++i) mean += values[i];
+            mean /= window;
+            for (std::size_t i = v - window; i < v; ++i) squares += (values[i] - mean) * (values[i] - mean);
+            const double sigma = std::sqrt(squares / window);
+            if (sigma > 1e-9 && std::fabs(values[v] - mean) > 3.0 * sigma * (1.0 + 1e-9)) expectedDeviations.push_back(record.timestamp);
+        }
+        ++v;
+    }
+    std::vector<std::int32_t> actualDeviations;
+    for (const Deviation& deviation : program.findDeviations(from, to, Record::fieldIndex("eksport"), window, 3.0))
+        actualDeviations.push_back(deviation.record.timestamp);
+    ASSERT_FALSE(expectedDeviations.empty());
+    EXPECT_EQ(actualDeviations, expectedDeviations);
+
+    // Te same wyniki ze snapshotu (kolumny i skompresowane bloki)
+    for (const bool compressed : { false, true }) {
+        std::cout.rdbuf(nullptr);
+        program.enableCompression(compressed);
+        program.saveToBinary("anomaly_test.bin");
+        Program loaded;
+        loaded.loadFromBinary("anomaly_test.bin");
+        std::cout.rdbuf(coutBuffer);
+        ScanStats snapshotStats;
+        sameRecords(loaded.topRecords(from, to, importField, 10, true, &snapshotStats), expectedTop(importField, 10, true));
+        EXPECT_GT(snapshotStats.skipped, snapshotStats.visited) << compressed;
+        EXPECT_EQ(loaded.flatDays(from, to, productionField, 0.0, firstMinute, lastMinute), expectedDays) << compressed;
+        EXPECT_EQ(loaded.findDeviations(from, to, Record::fieldIndex("eksport"), window, 3.0).size(),
+                  expectedDeviations.size()) << compressed;
+    }
+
+    // Rekordy przeplatane między snapshotem (parzyste wiersze) a drzewem (nieparzyste) w każdym
+    // miesiącu - okno przechodzi przez granice miesięcy i źródeł w kolejności czasu
+    {
+        std::ifstream source("ChartExport.csv");
+        std::ofstream even("anomaly_even.csv"), odd("anomaly_odd.csv");
+        std::string line;
+        std::getline(source, line);
+        even << line << '\n';
+        odd << line << '\n';
+        for (std::size_t i = 0; std::getline(source, line); ++i) (i % 2 == 0 ? even : odd) << line << '\n';
+    }
+    std::cout.rdbuf(nullptr);
+    Program half;
+    half.loadCSV("anomaly_even.csv");
+    half.saveToBinary("anomaly_test.bin");
+    Program mixed;
+    mixed.loadFromBinary("anomaly_test.bin");
+    mixed.loadCSV("anomaly_odd.csv");
+    std::cout.rdbuf(coutBuffer);
+    std::vector<std::int32_t> mixedDeviations;
+    for (const Deviation& deviation : mixed.findDeviations(from, to, Record::fieldIndex("eksport"), window, 3.0))
+        mixedDeviations.push_back(deviation.record.timestamp);
+    EXPECT_EQ(mixedDeviations, expectedDeviations);
+    std::remove("anomaly_even.csv");
+    std::remove("anomaly_odd.csv");
+    std::remove("anomaly_test.bin");
+}
+
+// Testy dla równoległych zapytań o długie przedziały
+
+TEST(ProgramTest, ParallelRangeQueriesAreBitReproducible) {
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.loadCSV("ChartExport.csv");
+    program.saveToBinary("parallel_test.bin");
+    Program loaded;
+    loaded.loadFromBinary("parallel_test.bin");
+    std::cout.rdbuf(coutBuffer);
+    std::remove("parallel_test.bin");
+
+    // 13 miesięcy - zapytania są dzielone na miesiące i liczone w puli
+    const std::int32_t from = Timestamp::fromDateTime(2020, 10, 2, 6, 0), to = Timestamp::fromDateTime(2021, 10, 30, 18, 0);
+    for (Program* source : { &program, &loaded }) {
+        source->setQueryThreads(1);
+        Aggregate expected[Record::fieldCount];
+        for (int f = 0; f < Record::fieldCount; ++f) expected[f] = source->aggregate(from, to, f);
+        const std::vector<Record> expectedMatches = source->findRecords(400.0, 50.0, from, to, 3);
+        ASSERT_GT(expected[3].count, 0u);
+        ASSERT_FALSE(expectedMatches.empty());
+
+        for (const unsigned threads : { 2u, 3u, 8u }) {
+            source->setQueryThreads(threads);
+            for (int f = 0; f < Record::fieldCount; ++f) {
+                const Aggregate actual = source->aggregate(from, to, f);
+                // Identyczne bit w bit, a nie tylko w granicach błędu zaokrągleń
+                EXPECT_EQ(actual.sum, expected[f].sum) << threads;
+                EXPECT_EQ(actual.count, expected[f].count);
+                EXPECT_EQ(actual.min, expected[f].min);
+                EXPECT_EQ(actual.max, expected[f].max);
+            }
+            const std::vector<Record> matches = source->findRecords(400.0, 50.0, from, to, 3);
+            ASSERT_EQ(matches.size(), expectedMatches.size()) << threads;
+            for (std::size_t i = 0; i < matches.size(); ++i) EXPECT_EQ(matches[i].timestamp, expectedMatches[i].timestamp);
+
+            // Tryb wsadowy (miesiące liczone kolejno w wątkach innej puli) daje te same sumy
+            ThreadPool pool(threads);
+            std::vector<Aggregate> results;
+            source->aggregateRanges({ RangeQuery{ from, to, 4 } }, results, pool);
+            EXPECT_EQ(results[0].sum, expected[4].sum);
+        }
+    }
+    const double sum = program.aggregate(from, to, 3).sum;
+    EXPECT_NEAR(loaded.aggregate(from, to, 3).sum, sum, 1e-9 * std::fabs(sum));
+}
+
+// Testy dla klasy RowValidator
+
+TEST(RowValidatorTest, RejectionsAreClassifiedAndLoggedWithLineNumbers) {
+    const std::string fileName = "test_validation.csv";
+    std::ofstream(fileName, std::ios::trunc) << "Time,Autokonsumpcja (W),Eksport (W),Import (W),Pobór (W),Produkcja (W)\n"
+                                             << "01.10.2020 6:00,\"1\",\"0\",\"2\",\"3\",\"1\"\n"
+                                             << "01.10.2020 6:15,\"x\"\n"
+                                             << "31.09.2020 6:30,\"1\",\"0\",\"2\",\"3\",\"1\"\n"
+                                             << "01.10.2020 6:45,\"nan\",\"0\",\"2\",\"3\",\"1\"\n"
+                                             << "\n"
+                                             << "01.10.2020 7:00,\"1\",\"-4\",\"2\",\"3\",\"1\"\n"
+                                             << "01.10.2020 6:00,\"5\",\"0\",\"2\",\"7\",\"5\"\n"
+                                             << "01.10.2020 7:15,\"1\",\"0\",\"2\",\"9\",\"1\"\n"
+                                             << "29.02.2020 7:30,\"1\",\"0\",\"2\",\"3\",\"1\"\n";
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.setLogLevel(LogLevel::Errors);
+    ValidationRules rules;
+    rules.checkBalance = true;
+    program.setValidationRules(rules);
+    program.loadCSV(fileName);
+    std::cout.rdbuf(coutBuffer);
+
+    EXPECT_EQ(program.getValidRecords(), 2);
+    EXPECT_EQ(program.getInvalidRecords(), 6);
+    for (RejectReason reason : { RejectReason::Format, RejectReason::Date, RejectReason::NotANumber,
+                                 RejectReason::Negative, RejectReason::Duplicate, RejectReason::Balance }) {
+        EXPECT_EQ(program.getInvalidRecords(reason), 1) << rejectReasonName(reason);
+    }
+    const std::vector<std::string> errors = readLines("log_error_data.txt");
+    ASSERT_EQ(errors.size(), 6u);
+    EXPECT_EQ(errors[0], "Błędny rekord (linia 3, niepoprawny format): 01.10.2020 6:15,\"x\"");
+    EXPECT_EQ(errors[1].rfind("Błędny rekord (linia 4, niepoprawna data lub godzina): 31.09.2020", 0), 0u);
+    EXPECT_EQ(errors[2].rfind("Błędny rekord (linia 5, wartość nieliczbowa)", 0), 0u);
+    EXPECT_EQ(errors[3].rfind("Błędny rekord (linia 7, ujemna moc)", 0), 0u);
+    EXPECT_EQ(errors[4].rfind("Błędny rekord (linia 8, powtórzony znacznik czasu)", 0), 0u);
+    EXPECT_EQ(errors[5].rfind("Błędny rekord (linia 9, niezgodny bilans mocy)", 0), 0u);
+    // Pierwszy z powtórzonych pomiarów zostaje w danych
+    const std::int32_t six = Timestamp::fromDateTime(2020, 10, 1, 6, 0);
+    EXPECT_DOUBLE_EQ(program.getTree().aggregate(six, six, 0).sum, 1.0);
+
+    // Dopisane wiersze są sprawdzane tak samo, z numerami linii w całym pliku
+    // (pierwsze wywołanie czyta cały plik, więc błędne wiersze są liczone ponownie)
+    int added = 0, duplicates = 0;
+    ASSERT_TRUE(program.updateFromCSV(fileName, added, duplicates));
+    EXPECT_EQ(program.getInvalidRecords(RejectReason::Negative), 2);
+    std::ofstream(fileName, std::ios::app) << "01.10.2020 7:45,\"1\",\"0\",\"2\",\"-3\",\"1\"\n"
+                                           << "01.10.2020 7:30,\"1\",\"0\",\"2\",\"3\",\"1\"\n";
+    ASSERT_TRUE(program.updateFromCSV(fileName, added, duplicates));
+    EXPECT_EQ(added, 1);
+    EXPECT_EQ(program.getInvalidRecords(RejectReason::Negative), 3);
+    EXPECT_EQ(readLines("log_error_data.txt").back().rfind("Błędny rekord (linia 11, ujemna moc)", 0), 0u);
+    std::remove(fileName.c_str());
+}
+
+TEST(RowValidatorTest, ReloadingFileRejectsRecordsAlreadyLoaded) {
+    const std::string fileName = "test_validation_reload.csv";
+    {
+        std::ofstream out(fileName);
+        for (int i = 0; i < 96; ++i) {
+            out << "05.03.2021 " << i * 15 / 60 << ":" << (i * 15 % 60 < 10 ? "0" : "") << i * 15 % 60 << ",\"" << i
+                << "\",\"0\",\"1\",\"2\",\"3\"\n";
+        }
+    }
+    const std::int32_t from = Timestamp::fromDateTime(2021, 3, 5, 0, 0);
+    const std::int32_t to = Timestamp::fromDateTime(2021, 3, 5, 23, 45);
+
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program program;
+    program.setLogLevel(LogLevel::None);
+    program.loadCSV(fileName);
+    const Aggregate loaded = program.aggregate(from, to, 0);
+    // Ponowne wczytanie tego samego pliku nie zmienia danych - wszystkie wiersze są duplikatami
+    program.loadCSV(fileName);
+    const Aggregate reloaded = program.aggregate(from, to, 0);
+
+    // To samo względem danych wczytanych ze snapshotu
+    program.saveToBinary("test_validation_reload.bin");
+    Program restored;
+    restored.setLogLevel(LogLevel::None);
+    restored.loadFromBinary("test_validation_reload.bin");
+    restored.loadCSV(fileName);
+    std::cout.rdbuf(coutBuffer);
+    std::remove(fileName.c_str());
+    std::remove("test_validation_reload.bin");
+
+    EXPECT_EQ(loaded.count, 96u);
+    EXPECT_DOUBLE_EQ(loaded.sum, 95 * 96 / 2);
+    EXPECT_EQ(reloaded.count, loaded.count);
+    EXPECT_DOUBLE_EQ(reloaded.sum, loaded.sum);
+    EXPECT_EQ(program.getValidRecords(), 96);
+    EXPECT_EQ(program.getInvalidRecords(RejectReason::Duplicate), 96);
+    EXPECT_EQ(restored.aggregate(from, to, 0).count, loaded.count);
+    EXPECT_DOUBLE_EQ(restored.aggregate(from, to, 0).sum, loaded.sum);
+    EXPECT_EQ(restored.getInvalidRecords(RejectReason::Duplicate), 96);
+}
+
+TEST(RowValidatorTest, ParallelLoadRejectsDuplicatesAcrossChunks) {
+    // Znaczniki czasu powtarzają się co 32256 wierszy, więc drugi fragment pliku powtarza pierwszy
+    const std::string fileName = "test_validation_parallel.csv";
+    {
+        std::ofstream out(fileName);
+        char line[128];
+        for (int i = 0; i < 40000; ++i) {
+            const int day = i / 96 % 28 + 1, month = i / (96 * 28) % 12 + 1, minutes = i % 96 * 15;
+            std::snprintf(line, sizeof(line), "%02d.%02d.2021 %d:%02d,\"%d\",\"0\",\"%d.25\",\"1\",\"2\"\n",
+                          day, month, minutes / 60, minutes % 60, i % 1000 == 7 ? -i : i, i % 7);
+            out << line;
+        }
+    }
+
+    std::streambuf* const coutBuffer = std::cout.rdbuf(nullptr);
+    Program serial;
+    serial.loadCSV(fileName, 1);
+    const std::vector<std::string> serialErrors = readLines("log_error_data.txt");
+    std::vector<std::string> serialValid = readLines("log_data.txt");
+    Program parallel;
+    parallel.loadCSV(fileName, 4);
+    std::vector<std::string> parallelValid = readLines("log_data.txt");
+    std::cout.rdbuf(coutBuffer);
+    std::remove(fileName.c_str());
+
+    // Odrzucony wiersz nie zajmuje znacznika czasu - 8 powtórzeń ujemnych wierszy jest poprawnych
+    EXPECT_EQ(serial.getValidRecords(), 32256 - 33 + 8);
+    EXPECT_EQ(serial.getInvalidRecords(RejectReason::Negative), 40);
+    EXPECT_EQ(serial.getInvalidRecords(RejectReason::Duplicate), 40000 - 32256 - 7 - 8);
+    EXPECT_EQ(parallel.getValidRecords(), serial.getValidRecords());
+    EXPECT_EQ(parallel.getInvalidRecords(RejectReason::Duplicate), serial.getInvalidRecords(RejectReason::Duplicate));
+    EXPECT_EQ(flattenTree(parallel.getTree()), flattenTree(serial.getTree()));
+    // Błędne rekordy są logowane w kolejności linii niezależnie od liczby wątków
+    EXPECT_EQ(readLines("log_error_data.txt"), serialErrors);
+    // Wiersz odrzucony przy scalaniu fragmentów nie trafia do logu poprawnych rekordów
+    // (wpisy fragmentów mogą się przeplatać, więc porównywane są posortowane)
+    std::sort(serialValid.begin(), serialValid.end());
+    std::sort(parallelValid.begin(), parallelValid.end());
+    EXPECT_EQ(parallelValid.size(), static_cast<std::size_t>(serial.getValidRecords()) + 1);
+    EXPECT_EQ(parallelValid, serialValid);
 }